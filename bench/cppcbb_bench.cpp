@@ -0,0 +1,1108 @@
+//Copyright(C) 2020 Henry Bullingham
+//This file is subject to the license terms in the LICENSE file
+//found in the top - level directory of this distribution.
+
+#include "cppcbb_bench.hpp"
+
+#include "cppcbb/cbb_vector.hpp"
+#include "cppcbb/cbb_map.hpp"
+#include "cppcbb/cbb_sparse_set.hpp"
+#include "cppcbb/cbb_heap.hpp"
+#include "cppcbb/cbb_parallel.hpp"
+#include "cppcbb/cbb_persistent_vector.hpp"
+#include "cppcbb/cbb_packed_vector.hpp"
+#include "cppcbb/cbb_soa_vector.hpp"
+#include "cppcbb/cbb_frozen_map.hpp"
+#include "cppcbb/cbb_deque.hpp"
+#include "cppcbb/cbb_cache_map.hpp"
+#include "cppcbb/cbb_pool.hpp"
+#include "cppcbb/cbb_simd.hpp"
+#include "cppcbb/cbb_btree_map.hpp"
+
+#include <deque>
+#include <functional>
+#include <iterator>
+#include <map>
+#include <memory>
+#include <string>
+#include <thread>
+#include <queue>
+#include <random>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+using cppcbb::bench::do_not_optimize;
+using cppcbb::bench::registry;
+using cppcbb::bench::stopwatch;
+
+/*
+
+    Capacity of the static containers, sizes above this are skipped for them
+
+*/
+static constexpr size_t k_static_capacity = 4096;
+
+//Linear search maps & shifting erases are quadratic, so keep them to sizes that finish
+static constexpr size_t k_linear_max_size = 8192;
+static constexpr size_t k_shifting_max_size = 2097152;
+static constexpr size_t k_unlimited = SIZE_MAX;
+
+static constexpr unsigned k_seed = 12345;
+
+/*
+
+    Input generation (never timed)
+
+*/
+
+static std::vector<int> random_values(size_t count)
+{
+    std::mt19937 generator(k_seed);
+    std::uniform_int_distribution<int> dist;
+    std::vector<int> values(count);
+    for (int& value : values)
+    {
+        value = dist(generator);
+    }
+    return values;
+}
+
+//0 or 1, with one in eight set, salt picks a different sequence
+static std::vector<int> random_flags(size_t count, unsigned salt)
+{
+    std::mt19937 generator(k_seed + salt);
+    std::vector<int> flags(count);
+    for (int& flag : flags)
+    {
+        flag = (generator() % 8) == 0 ? 1 : 0;
+    }
+    return flags;
+}
+
+//Distinct keys in [0, 4 * count), one per block of 4, shuffled
+//Misses use a different key from each block, so they are never present
+static std::pair<std::vector<int>, std::vector<int>> random_keys(size_t count)
+{
+    std::mt19937 generator(k_seed);
+    std::vector<int> hits(count);
+    std::vector<int> misses(count);
+    for (size_t i = 0; i < count; i++)
+    {
+        int offset = (int)(generator() % 4);
+        hits[i] = (int)(i * 4) + offset;
+        misses[i] = (int)(i * 4) + (offset + 1) % 4;
+    }
+    std::shuffle(hits.begin(), hits.end(), generator);
+    std::shuffle(misses.begin(), misses.end(), generator);
+    return std::make_pair(std::move(hits), std::move(misses));
+}
+
+//Positions to erase from a container shrinking from size, one at a time
+static std::vector<size_t> random_erase_positions(size_t size, size_t count)
+{
+    std::mt19937 generator(k_seed);
+    std::vector<size_t> positions(count);
+    for (size_t i = 0; i < count; i++)
+    {
+        positions[i] = generator() % (size - i);
+    }
+    return positions;
+}
+
+/*
+
+    Adapters, so std containers and cbb containers share the benchmark code
+
+*/
+
+template<typename Vector, typename Pred>
+static size_t erase_if(Vector& v, Pred pred)
+{
+    return v.erase_if(pred);
+}
+
+template<typename Elem, typename Pred>
+static size_t erase_if(std::vector<Elem>& v, Pred pred)
+{
+    size_t old_size = v.size();
+    v.erase(std::remove_if(v.begin(), v.end(), pred), v.end());
+    return old_size - v.size();
+}
+
+template<typename Queue>
+static void pop_top(Queue& queue)
+{
+    queue.pop_top();
+}
+
+template<typename Elem>
+static void pop_top(std::priority_queue<Elem>& queue)
+{
+    queue.pop();
+}
+
+static size_t count_set(const cppcbb::cbb_bit_vector& v)
+{
+    return v.count(true);
+}
+
+static size_t count_set(const std::vector<bool>& v)
+{
+    return (size_t)std::count(v.begin(), v.end(), true);
+}
+
+static void and_assign(cppcbb::cbb_bit_vector& v, const cppcbb::cbb_bit_vector& other)
+{
+    v &= other;
+}
+
+static void and_assign(std::vector<bool>& v, const std::vector<bool>& other)
+{
+    for (size_t i = 0; i < v.size(); i++)
+    {
+        v[i] = v[i] && other[i];
+    }
+}
+
+template<typename Vector>
+static std::unique_ptr<Vector> filled_vector(const std::vector<int>& values)
+{
+    std::unique_ptr<Vector> v(new Vector());
+    for (int value : values)
+    {
+        v->push_back(value);
+    }
+    return v;
+}
+
+template<typename Map>
+static std::unique_ptr<Map> filled_map(const std::vector<int>& keys)
+{
+    std::unique_ptr<Map> map(new Map());
+    for (int key : keys)
+    {
+        (*map)[key] = key;
+    }
+    return map;
+}
+
+/*
+
+    Vector benchmarks
+
+*/
+
+template<typename Vector>
+static void add_random_erase(registry& benchmarks, const std::string& name, size_t max_size, std::random_access_iterator_tag)
+{
+    benchmarks.add(name, "random_erase", max_size, [](size_t size, stopwatch& watch)
+    {
+        size_t count = std::min<size_t>(size / 2, 1024);
+        std::unique_ptr<Vector> v = filled_vector<Vector>(random_values(size));
+        std::vector<size_t> positions = random_erase_positions(size, count);
+
+        watch.start();
+        for (size_t position : positions)
+        {
+            v->erase(v->begin() + position);
+        }
+        watch.stop();
+
+        do_not_optimize(v->size());
+        return count;
+    });
+}
+
+//Positional erase would be dominated by walking the iterator, so it isn't measured
+template<typename Vector>
+static void add_random_erase(registry& benchmarks, const std::string& name, size_t max_size, std::forward_iterator_tag)
+{
+}
+
+template<typename Vector>
+static void add_vector_benchmarks(registry& benchmarks, const std::string& name, size_t max_size, size_t erase_max_size)
+{
+    benchmarks.add(name, "push_back", max_size, [](size_t size, stopwatch& watch)
+    {
+        std::vector<int> values = random_values(size);
+        std::unique_ptr<Vector> v(new Vector());
+
+        watch.start();
+        for (int value : values)
+        {
+            v->push_back(value);
+        }
+        watch.stop();
+
+        do_not_optimize(v->size());
+        return size;
+    });
+
+    benchmarks.add(name, "bulk_fill", max_size, [](size_t size, stopwatch& watch)
+    {
+        std::unique_ptr<Vector> v(new Vector());
+
+        watch.start();
+        v->resize(size);
+        for (size_t i = 0; i < size; i++)
+        {
+            (*v)[i] = (int)i;
+        }
+        watch.stop();
+
+        do_not_optimize(v->size());
+        return size;
+    });
+
+    benchmarks.add(name, "iterate", max_size, [](size_t size, stopwatch& watch)
+    {
+        std::unique_ptr<Vector> v = filled_vector<Vector>(random_values(size));
+
+        watch.start();
+        long long sum = 0;
+        for (int value : *v)
+        {
+            sum += value;
+        }
+        do_not_optimize(sum);
+        watch.stop();
+
+        return size;
+    });
+
+    add_random_erase<Vector>(benchmarks, name, std::min(max_size, erase_max_size)
+        , typename std::iterator_traits<typename Vector::iterator>::iterator_category());
+
+    benchmarks.add(name, "erase_if", max_size, [](size_t size, stopwatch& watch)
+    {
+        std::unique_ptr<Vector> v = filled_vector<Vector>(random_values(size));
+
+        watch.start();
+        size_t removed = erase_if(*v, [](int value) { return (value & 1) != 0; });
+        watch.stop();
+
+        do_not_optimize(removed);
+        return size;
+    });
+
+    benchmarks.add(name, "copy", max_size, [](size_t size, stopwatch& watch)
+    {
+        std::unique_ptr<Vector> v = filled_vector<Vector>(random_values(size));
+
+        watch.start();
+        std::unique_ptr<Vector> copy(new Vector(*v));
+        watch.stop();
+
+        do_not_optimize(copy->size());
+        return size;
+    });
+
+    benchmarks.add(name, "move", max_size, [](size_t size, stopwatch& watch)
+    {
+        std::unique_ptr<Vector> v = filled_vector<Vector>(random_values(size));
+
+        watch.start();
+        std::unique_ptr<Vector> moved(new Vector(std::move(*v)));
+        watch.stop();
+
+        do_not_optimize(moved->size());
+        return size;
+    });
+}
+
+/*
+
+    Map benchmarks
+
+*/
+
+template<typename Map>
+static void add_map_benchmarks(registry& benchmarks, const std::string& name, size_t max_size)
+{
+    benchmarks.add(name, "insert", max_size, [](size_t size, stopwatch& watch)
+    {
+        std::vector<int> keys = random_keys(size).first;
+        std::unique_ptr<Map> map(new Map());
+
+        watch.start();
+        for (int key : keys)
+        {
+            (*map)[key] = key;
+        }
+        watch.stop();
+
+        do_not_optimize(map->size());
+        return size;
+    });
+
+    benchmarks.add(name, "find_hit", max_size, [](size_t size, stopwatch& watch)
+    {
+        std::vector<int> keys = random_keys(size).first;
+        std::unique_ptr<Map> map = filled_map<Map>(keys);
+        std::shuffle(keys.begin(), keys.end(), std::mt19937(k_seed + 1));
+
+        watch.start();
+        size_t found = 0;
+        for (int key : keys)
+        {
+            found += map->find(key) != map->end() ? 1 : 0;
+        }
+        do_not_optimize(found);
+        watch.stop();
+
+        return size;
+    });
+
+    benchmarks.add(name, "find_miss", max_size, [](size_t size, stopwatch& watch)
+    {
+        std::pair<std::vector<int>, std::vector<int>> keys = random_keys(size);
+        std::unique_ptr<Map> map = filled_map<Map>(keys.first);
+
+        watch.start();
+        size_t found = 0;
+        for (int key : keys.second)
+        {
+            found += map->find(key) != map->end() ? 1 : 0;
+        }
+        do_not_optimize(found);
+        watch.stop();
+
+        return size;
+    });
+
+    benchmarks.add(name, "iterate", max_size, [](size_t size, stopwatch& watch)
+    {
+        std::unique_ptr<Map> map = filled_map<Map>(random_keys(size).first);
+        const Map& const_map = *map;
+
+        watch.start();
+        long long sum = 0;
+        for (auto it = const_map.begin(); it != const_map.end(); ++it)
+        {
+            sum += it->second;
+        }
+        do_not_optimize(sum);
+        watch.stop();
+
+        return size;
+    });
+
+    benchmarks.add(name, "random_erase", max_size, [](size_t size, stopwatch& watch)
+    {
+        std::vector<int> keys = random_keys(size).first;
+        std::unique_ptr<Map> map = filled_map<Map>(keys);
+        std::shuffle(keys.begin(), keys.end(), std::mt19937(k_seed + 1));
+        keys.resize(size / 2);
+
+        watch.start();
+        for (int key : keys)
+        {
+            map->erase(map->find(key));
+        }
+        watch.stop();
+
+        do_not_optimize(map->size());
+        return keys.size();
+    });
+
+    benchmarks.add(name, "copy", max_size, [](size_t size, stopwatch& watch)
+    {
+        std::unique_ptr<Map> map = filled_map<Map>(random_keys(size).first);
+
+        watch.start();
+        std::unique_ptr<Map> copy(new Map(*map));
+        watch.stop();
+
+        do_not_optimize(copy->size());
+        return size;
+    });
+
+    benchmarks.add(name, "move", max_size, [](size_t size, stopwatch& watch)
+    {
+        std::unique_ptr<Map> map = filled_map<Map>(random_keys(size).first);
+
+        watch.start();
+        std::unique_ptr<Map> moved(new Map(std::move(*map)));
+        watch.stop();
+
+        do_not_optimize(moved->size());
+        return size;
+    });
+}
+
+/*
+
+    Batched lookup benchmarks
+
+*/
+
+//Same keys as find_hit, looked up with one find_many call instead of one find each
+template<typename Map>
+static void add_find_many_benchmarks(registry& benchmarks, const std::string& name, size_t max_size)
+{
+    benchmarks.add(name, "find_many", max_size, [](size_t size, stopwatch& watch)
+    {
+        std::vector<int> keys = random_keys(size).first;
+        std::unique_ptr<Map> map = filled_map<Map>(keys);
+        std::shuffle(keys.begin(), keys.end(), std::mt19937(k_seed + 1));
+        std::vector<typename Map::const_iterator> results;
+
+        watch.start();
+        map->find_many(keys, results);
+        size_t found = 0;
+        for (typename Map::const_iterator it : results)
+        {
+            found += it != map->end() ? 1 : 0;
+        }
+        do_not_optimize(found);
+        watch.stop();
+
+        return size;
+    });
+}
+
+/*
+
+    Priority queue benchmarks
+
+*/
+
+template<typename Queue>
+static void add_queue_benchmarks(registry& benchmarks, const std::string& name, size_t max_size)
+{
+    benchmarks.add(name, "push", max_size, [](size_t size, stopwatch& watch)
+    {
+        std::vector<int> values = random_values(size);
+        std::unique_ptr<Queue> queue(new Queue());
+
+        watch.start();
+        for (int value : values)
+        {
+            queue->push(value);
+        }
+        watch.stop();
+
+        do_not_optimize(queue->size());
+        return size;
+    });
+
+    benchmarks.add(name, "pop_top", max_size, [](size_t size, stopwatch& watch)
+    {
+        std::vector<int> values = random_values(size);
+        std::unique_ptr<Queue> queue(new Queue());
+        for (int value : values)
+        {
+            queue->push(value);
+        }
+
+        watch.start();
+        long long sum = 0;
+        while (!queue->empty())
+        {
+            sum += queue->top();
+            pop_top(*queue);
+        }
+        do_not_optimize(sum);
+        watch.stop();
+
+        return size;
+    });
+}
+
+/*
+
+    Parallel algorithm benchmarks, one set per pool size up to the core count
+
+*/
+
+//1, 2, 4, ... threads, ending with the core count
+static std::vector<size_t> pool_sizes()
+{
+    size_t cores = cppcbb::thread_pool::default_thread_count();
+    std::vector<size_t> sizes;
+    for (size_t threads = 1; threads < cores; threads *= 2)
+    {
+        sizes.push_back(threads);
+    }
+    sizes.push_back(cores);
+    return sizes;
+}
+
+template<typename Vector>
+static void add_parallel_benchmarks(registry& benchmarks, const std::string& name, size_t max_size)
+{
+    for (size_t threads : pool_sizes())
+    {
+        std::shared_ptr<cppcbb::thread_pool> pool(new cppcbb::thread_pool(threads));
+        std::string suffix = "/" + std::to_string(threads) + "t";
+
+        benchmarks.add(name, "parallel_for_each" + suffix, max_size, [pool](size_t size, stopwatch& watch)
+        {
+            std::unique_ptr<Vector> v = filled_vector<Vector>(random_values(size));
+
+            watch.start();
+            cppcbb::parallel::for_each(*v, [](int& value) { value = value * 3 + 1; }, *pool);
+            watch.stop();
+
+            do_not_optimize((*v)[0]);
+            return size;
+        });
+
+        benchmarks.add(name, "parallel_transform" + suffix, max_size, [pool](size_t size, stopwatch& watch)
+        {
+            std::unique_ptr<Vector> v = filled_vector<Vector>(random_values(size));
+            std::unique_ptr<cppcbb::cbb_vector<long long>> out(new cppcbb::cbb_vector<long long>());
+            out->resize(size);
+
+            watch.start();
+            cppcbb::parallel::transform(*v, *out, [](int value) { return (long long)value * value; }, *pool);
+            watch.stop();
+
+            do_not_optimize((*out)[0]);
+            return size;
+        });
+
+        benchmarks.add(name, "parallel_reduce" + suffix, max_size, [pool](size_t size, stopwatch& watch)
+        {
+            std::unique_ptr<Vector> v = filled_vector<Vector>(random_values(size));
+
+            watch.start();
+            long long sum = cppcbb::parallel::reduce(*v, 0LL, [](long long a, long long b) { return a + b; }, *pool);
+            watch.stop();
+
+            do_not_optimize(sum);
+            return size;
+        });
+
+        benchmarks.add(name, "parallel_sort" + suffix, max_size, [pool](size_t size, stopwatch& watch)
+        {
+            std::unique_ptr<Vector> v = filled_vector<Vector>(random_values(size));
+
+            watch.start();
+            cppcbb::parallel::sort(*v, std::less<int>(), *pool);
+            watch.stop();
+
+            do_not_optimize((*v)[0]);
+            return size;
+        });
+
+        benchmarks.add(name, "parallel_stable_partition" + suffix, max_size, [pool](size_t size, stopwatch& watch)
+        {
+            std::unique_ptr<Vector> v = filled_vector<Vector>(random_values(size));
+
+            watch.start();
+            size_t matched = cppcbb::parallel::stable_partition(*v, [](int value) { return (value & 1) == 0; }, *pool);
+            watch.stop();
+
+            do_not_optimize(matched);
+            return size;
+        });
+
+        benchmarks.add(name, "parallel_erase_if" + suffix, max_size, [pool](size_t size, stopwatch& watch)
+        {
+            std::unique_ptr<Vector> v = filled_vector<Vector>(random_values(size));
+
+            watch.start();
+            size_t removed = cppcbb::parallel::erase_if(*v, [](int value) { return (value & 1) != 0; }, *pool);
+            watch.stop();
+
+            do_not_optimize(removed);
+            return size;
+        });
+    }
+}
+
+//Flag vectors, about one bit in eight set
+template<typename Vector>
+static void add_bit_vector_benchmarks(registry& benchmarks, const std::string& name, size_t max_size)
+{
+    benchmarks.add(name, "count", max_size, [](size_t size, stopwatch& watch)
+    {
+        std::unique_ptr<Vector> v = filled_vector<Vector>(random_flags(size, 0));
+
+        watch.start();
+        size_t count = count_set(*v);
+        watch.stop();
+
+        do_not_optimize(count);
+        return size;
+    });
+
+    benchmarks.add(name, "bitwise_and", max_size, [](size_t size, stopwatch& watch)
+    {
+        std::unique_ptr<Vector> v = filled_vector<Vector>(random_flags(size, 0));
+        std::unique_ptr<Vector> other = filled_vector<Vector>(random_flags(size, 1));
+
+        watch.start();
+        and_assign(*v, *other);
+        watch.stop();
+
+        do_not_optimize(v->size());
+        return size;
+    });
+}
+
+//Records with several fields, of which the kernel reads one
+class particle
+{
+public:
+    float x, y, z;
+    float vx, vy, vz;
+};
+
+static void add_field_benchmarks(registry& benchmarks, size_t max_size)
+{
+    benchmarks.add("cbb_vector<particle>", "sum_field", max_size, [](size_t size, stopwatch& watch)
+    {
+        std::vector<int> values = random_values(size);
+        cppcbb::cbb_vector<particle> v;
+        for (int value : values)
+        {
+            v.push_back(particle{ (float)value, 0, 0, 1, 1, 1 });
+        }
+
+        watch.start();
+        float sum = 0;
+        for (const particle& p : v)
+        {
+            sum += p.x;
+        }
+        watch.stop();
+
+        do_not_optimize(sum);
+        return size;
+    });
+
+    benchmarks.add("cbb_soa_vector<particle>", "sum_field", max_size, [](size_t size, stopwatch& watch)
+    {
+        std::vector<int> values = random_values(size);
+        cppcbb::cbb_soa_vector<float, float, float, float, float, float> v;
+        for (int value : values)
+        {
+            v.emplace_back((float)value, 0.0f, 0.0f, 1.0f, 1.0f, 1.0f);
+        }
+
+        watch.start();
+        float sum = 0;
+        for (float x : v.span<0>())
+        {
+            sum += x;
+        }
+        watch.stop();
+
+        do_not_optimize(sum);
+        return size;
+    });
+}
+
+static std::unique_ptr<cppcbb::cbb_frozen_map<uint64_t, uint32_t>> frozen_map(const std::vector<int>& keys)
+{
+    std::unique_ptr<cppcbb::cbb_sorted_vector_map<uint64_t, uint32_t>> map(new cppcbb::cbb_sorted_vector_map<uint64_t, uint32_t>());
+    for (int key : keys)
+    {
+        (*map)[(uint64_t)key] = (uint32_t)key;
+    }
+
+    std::unique_ptr<cppcbb::cbb_frozen_map<uint64_t, uint32_t>> frozen(new cppcbb::cbb_frozen_map<uint64_t, uint32_t>());
+    frozen->assign(*map);
+    return frozen;
+}
+
+static void add_frozen_map_benchmarks(registry& benchmarks, size_t max_size)
+{
+    const std::string name = "cbb_frozen_map";
+
+    benchmarks.add(name, "find_hit", max_size, [](size_t size, stopwatch& watch)
+    {
+        std::vector<int> keys = random_keys(size).first;
+        std::unique_ptr<cppcbb::cbb_frozen_map<uint64_t, uint32_t>> map = frozen_map(keys);
+        std::shuffle(keys.begin(), keys.end(), std::mt19937(k_seed + 1));
+
+        watch.start();
+        size_t found = 0;
+        for (int key : keys)
+        {
+            found += map->contains((uint64_t)key) ? 1 : 0;
+        }
+        do_not_optimize(found);
+        watch.stop();
+
+        return size;
+    });
+
+    benchmarks.add(name, "find_miss", max_size, [](size_t size, stopwatch& watch)
+    {
+        std::pair<std::vector<int>, std::vector<int>> keys = random_keys(size);
+        std::unique_ptr<cppcbb::cbb_frozen_map<uint64_t, uint32_t>> map = frozen_map(keys.first);
+
+        watch.start();
+        size_t found = 0;
+        for (int key : keys.second)
+        {
+            found += map->contains((uint64_t)key) ? 1 : 0;
+        }
+        do_not_optimize(found);
+        watch.stop();
+
+        return size;
+    });
+
+    benchmarks.add(name, "iterate", max_size, [](size_t size, stopwatch& watch)
+    {
+        std::unique_ptr<cppcbb::cbb_frozen_map<uint64_t, uint32_t>> map = frozen_map(random_keys(size).first);
+
+        watch.start();
+        long long sum = 0;
+        map->for_each([&](uint64_t key, uint32_t value) { sum += (long long)key + value; });
+        do_not_optimize(sum);
+        watch.stop();
+
+        return size;
+    });
+}
+
+template<typename Deque>
+static void add_deque_benchmarks(registry& benchmarks, const std::string& name, size_t max_size)
+{
+    benchmarks.add(name, "push_back", max_size, [](size_t size, stopwatch& watch)
+    {
+        std::vector<int> values = random_values(size);
+        std::unique_ptr<Deque> d(new Deque());
+
+        watch.start();
+        for (int value : values)
+        {
+            d->push_back(value);
+        }
+        watch.stop();
+
+        do_not_optimize(d->size());
+        return size;
+    });
+
+    benchmarks.add(name, "push_front", max_size, [](size_t size, stopwatch& watch)
+    {
+        std::vector<int> values = random_values(size);
+        std::unique_ptr<Deque> d(new Deque());
+
+        watch.start();
+        for (int value : values)
+        {
+            d->push_front(value);
+        }
+        watch.stop();
+
+        do_not_optimize(d->size());
+        return size;
+    });
+
+    //Steady state queue, a push & a pop per op
+    benchmarks.add(name, "queue", max_size, [](size_t size, stopwatch& watch)
+    {
+        std::vector<int> values = random_values(size);
+        std::unique_ptr<Deque> d(new Deque());
+        for (size_t i = 0; i < size / 2 + 1; i++)
+        {
+            d->push_back(values[i]);
+        }
+
+        watch.start();
+        for (int value : values)
+        {
+            d->push_back(value);
+            d->pop_front();
+        }
+        watch.stop();
+
+        do_not_optimize(d->size());
+        return size;
+    });
+
+    benchmarks.add(name, "random_access", max_size, [](size_t size, stopwatch& watch)
+    {
+        std::vector<int> values = random_values(size);
+        std::unique_ptr<Deque> d(new Deque());
+        for (int value : values)
+        {
+            d->push_back(value);
+        }
+
+        watch.start();
+        long long sum = 0;
+        for (int value : values)
+        {
+            sum += (*d)[(size_t)value % size];
+        }
+        do_not_optimize(sum);
+        watch.stop();
+
+        return size;
+    });
+}
+
+//Skewed keys over twice the capacity, a miss puts the key
+template<typename Cache>
+static void add_cache_benchmarks(registry& benchmarks, const std::string& name, size_t max_size)
+{
+    benchmarks.add(name, "get_or_put", max_size, [](size_t size, stopwatch& watch)
+    {
+        std::unique_ptr<Cache> cache(new Cache());
+        std::mt19937 generator(k_seed);
+        std::vector<int> keys(size);
+        for (int& key : keys)
+        {
+            //Squaring a uniform value favours small keys
+            uint64_t r = generator() % 1024;
+            key = (int)(r * r * cache->capacity() * 2 / (1024 * 1024));
+        }
+
+        watch.start();
+        for (int key : keys)
+        {
+            if (cache->get(key) == nullptr)
+            {
+                cache->put(key, key);
+            }
+        }
+        watch.stop();
+
+        do_not_optimize(cache->counters().hits);
+        return size;
+    });
+}
+
+//Whole vector kernels, aligned storage takes the blocked path & other storage the scalar one
+template<typename Vector>
+static void add_simd_benchmarks(registry& benchmarks, const std::string& name, size_t max_size)
+{
+    benchmarks.add(name, "simd_sum", max_size, [](size_t size, stopwatch& watch)
+    {
+        std::unique_ptr<Vector> v(new Vector());
+        for (int value : random_values(size))
+        {
+            v->push_back((float)(value % 1000));
+        }
+
+        watch.start();
+        float sum = cppcbb::simd::sum(*v);
+        watch.stop();
+
+        do_not_optimize(sum);
+        return size;
+    });
+
+    benchmarks.add(name, "simd_find_miss", max_size, [](size_t size, stopwatch& watch)
+    {
+        std::unique_ptr<Vector> v(new Vector());
+        for (int value : random_values(size))
+        {
+            v->push_back((float)(value % 1000));
+        }
+
+        watch.start();
+        size_t index = cppcbb::simd::find(*v, -1.0f);
+        watch.stop();
+
+        do_not_optimize(index);
+        return size;
+    });
+
+    benchmarks.add(name, "simd_max", max_size, [](size_t size, stopwatch& watch)
+    {
+        std::unique_ptr<Vector> v(new Vector());
+        for (int value : random_values(size))
+        {
+            v->push_back((float)(value % 1000));
+        }
+
+        watch.start();
+        float max = cppcbb::simd::max_value(*v);
+        watch.stop();
+
+        do_not_optimize(max);
+        return size;
+    });
+}
+
+//Pool interface over the general purpose allocator
+template<typename Elem>
+class new_delete_pool
+{
+public:
+    template<typename ... Args>
+    Elem* create(Args&& ... args) { return new Elem(std::forward<Args>(args)...); }
+    void destroy(Elem* ptr) { delete ptr; }
+};
+
+//Keeps a window of live objects, replacing a random one per operation
+template<typename Pool>
+static void add_pool_benchmarks(registry& benchmarks, const std::string& name, size_t max_size)
+{
+    benchmarks.add(name, "churn", max_size, [](size_t size, stopwatch& watch)
+    {
+        std::unique_ptr<Pool> pool(new Pool());
+        std::vector<int> values = random_values(size);
+        std::vector<particle*> live;
+        for (size_t i = 0; i < 1024; i++)
+        {
+            live.push_back(pool->create(particle{ (float)i, 0, 0, 1, 1, 1 }));
+        }
+
+        watch.start();
+        for (int value : values)
+        {
+            particle*& slot = live[(size_t)value % live.size()];
+            pool->destroy(slot);
+            slot = pool->create(particle{ (float)value, 0, 0, 1, 1, 1 });
+        }
+        watch.stop();
+
+        do_not_optimize(live[0]->x);
+        for (particle* p : live)
+        {
+            pool->destroy(p);
+        }
+        return size;
+    });
+}
+
+//Input has duplicate keys, so the build deduplicates too
+template<typename Map>
+static void add_parallel_build_benchmarks(registry& benchmarks, const std::string& name, size_t max_size)
+{
+    for (size_t threads : pool_sizes())
+    {
+        std::shared_ptr<cppcbb::thread_pool> pool(new cppcbb::thread_pool(threads));
+
+        benchmarks.add(name, "build_from/" + std::to_string(threads) + "t", max_size, [pool](size_t size, stopwatch& watch)
+        {
+            std::vector<int> keys = random_keys(size).first;
+            std::vector<std::pair<int, int>> entries;
+            for (size_t i = 0; i < size; i++)
+            {
+                entries.push_back(std::make_pair(keys[i % (size / 2 + 1)], (int)i));
+            }
+
+            watch.start();
+            Map map = cppcbb::parallel::build_from<Map>(entries, *pool);
+            watch.stop();
+
+            do_not_optimize(map.size());
+            return size;
+        });
+    }
+}
+
+static registry all_benchmarks()
+{
+    using namespace cppcbb;
+
+    registry benchmarks;
+
+    add_vector_benchmarks<std::vector<int>>(benchmarks, "std::vector", k_unlimited, k_shifting_max_size);
+    add_vector_benchmarks<cbb_vector<int>>(benchmarks, "cbb_vector", k_unlimited, k_shifting_max_size);
+    add_vector_benchmarks<cbb_static_vector<int, k_static_capacity>>(benchmarks, "cbb_static_vector", k_static_capacity, k_static_capacity);
+    add_vector_benchmarks<cbb_unordered_vector<int>>(benchmarks, "cbb_unordered_vector", k_unlimited, k_unlimited);
+    add_vector_benchmarks<cbb_static_unordered_vector<int, k_static_capacity>>(benchmarks, "cbb_static_unordered_vector", k_static_capacity, k_static_capacity);
+    add_vector_benchmarks<cbb_tombstone_vector<int>>(benchmarks, "cbb_tombstone_vector", k_unlimited, k_unlimited);
+    add_vector_benchmarks<cbb_static_tombstone_vector<int, k_static_capacity>>(benchmarks, "cbb_static_tombstone_vector", k_static_capacity, k_static_capacity);
+    add_vector_benchmarks<cbb_gap_vector<int>>(benchmarks, "cbb_gap_vector", k_unlimited, k_shifting_max_size);
+    add_vector_benchmarks<cbb_static_gap_vector<int, k_static_capacity>>(benchmarks, "cbb_static_gap_vector", k_static_capacity, k_static_capacity);
+    add_vector_benchmarks<cbb_persistent_vector<int>>(benchmarks, "cbb_persistent_vector", k_unlimited, k_unlimited);
+
+    add_field_benchmarks(benchmarks, k_unlimited);
+
+    add_deque_benchmarks<std::deque<int>>(benchmarks, "std::deque", k_unlimited);
+    add_deque_benchmarks<cbb_deque<int>>(benchmarks, "cbb_deque", k_unlimited);
+    add_deque_benchmarks<cbb_static_deque<int, k_static_capacity>>(benchmarks, "cbb_static_deque", k_static_capacity);
+
+    add_bit_vector_benchmarks<std::vector<bool>>(benchmarks, "std::vector<bool>", k_unlimited);
+    add_bit_vector_benchmarks<cbb_bit_vector>(benchmarks, "cbb_bit_vector", k_unlimited);
+
+    add_parallel_benchmarks<cbb_vector<int>>(benchmarks, "cbb_vector", k_unlimited);
+    add_parallel_benchmarks<cbb_tombstone_vector<int>>(benchmarks, "cbb_tombstone_vector", k_unlimited);
+    add_parallel_benchmarks<cbb_gap_vector<int>>(benchmarks, "cbb_gap_vector", k_unlimited);
+
+    add_parallel_build_benchmarks<cbb_sorted_vector_map<int, int>>(benchmarks, "cbb_sorted_vector_map", k_unlimited);
+    add_parallel_build_benchmarks<cbb_sparse_map<int, int>>(benchmarks, "cbb_sparse_map", k_unlimited);
+
+    add_map_benchmarks<std::map<int, int>>(benchmarks, "std::map", k_unlimited);
+    add_map_benchmarks<std::unordered_map<int, int>>(benchmarks, "std::unordered_map", k_unlimited);
+    add_map_benchmarks<cbb_vector_map<int, int>>(benchmarks, "cbb_vector_map", k_linear_max_size);
+    add_map_benchmarks<cbb_static_vector_map<int, int, k_static_capacity>>(benchmarks, "cbb_static_vector_map", k_static_capacity);
+    add_map_benchmarks<cbb_unordered_vector_map<int, int>>(benchmarks, "cbb_unordered_vector_map", k_linear_max_size);
+    add_map_benchmarks<cbb_static_unordered_vector_map<int, int, k_static_capacity>>(benchmarks, "cbb_static_unordered_vector_map", k_static_capacity);
+    add_map_benchmarks<cbb_sorted_vector_map<int, int>>(benchmarks, "cbb_sorted_vector_map", k_linear_max_size);
+    add_map_benchmarks<cbb_static_sorted_vector_map<int, int, k_static_capacity>>(benchmarks, "cbb_static_sorted_vector_map", k_static_capacity);
+    add_map_benchmarks<cbb_sparse_map<int, int>>(benchmarks, "cbb_sparse_map", k_unlimited);
+    add_map_benchmarks<cbb_static_sparse_map<int, int, k_static_capacity * 4, k_static_capacity>>(benchmarks, "cbb_static_sparse_map", k_static_capacity);
+    add_map_benchmarks<cbb_btree_map<int, int>>(benchmarks, "cbb_btree_map", k_unlimited);
+
+    add_find_many_benchmarks<cbb_sorted_vector_map<int, int>>(benchmarks, "cbb_sorted_vector_map", k_linear_max_size);
+    add_find_many_benchmarks<cbb_sparse_map<int, int>>(benchmarks, "cbb_sparse_map", k_unlimited);
+    add_find_many_benchmarks<cbb_btree_map<int, int>>(benchmarks, "cbb_btree_map", k_unlimited);
+
+    add_frozen_map_benchmarks(benchmarks, k_unlimited);
+
+    add_simd_benchmarks<cbb_vector<float>>(benchmarks, "cbb_vector<float>", k_unlimited);
+    add_simd_benchmarks<cbb_aligned_vector<float>>(benchmarks, "cbb_aligned_vector<float>", k_unlimited);
+
+    add_pool_benchmarks<new_delete_pool<particle>>(benchmarks, "new/delete", k_unlimited);
+    add_pool_benchmarks<cbb_pool<particle>>(benchmarks, "cbb_pool", k_unlimited);
+    add_pool_benchmarks<cbb_static_pool<particle, k_static_capacity>>(benchmarks, "cbb_static_pool", k_unlimited);
+
+    add_cache_benchmarks<cbb_lru_map<int, int, k_static_capacity>>(benchmarks, "cbb_lru_map", k_unlimited);
+    add_cache_benchmarks<cbb_clock_map<int, int, k_static_capacity>>(benchmarks, "cbb_clock_map", k_unlimited);
+
+    add_queue_benchmarks<std::priority_queue<int>>(benchmarks, "std::priority_queue", k_unlimited);
+    add_queue_benchmarks<cbb_priority_queue<int>>(benchmarks, "cbb_priority_queue", k_unlimited);
+    add_queue_benchmarks<cbb_static_priority_queue<int, k_static_capacity>>(benchmarks, "cbb_static_priority_queue", k_static_capacity);
+    add_queue_benchmarks<cbb_quad_priority_queue<int>>(benchmarks, "cbb_quad_priority_queue", k_unlimited);
+    add_queue_benchmarks<cbb_static_quad_priority_queue<int, k_static_capacity>>(benchmarks, "cbb_static_quad_priority_queue", k_static_capacity);
+
+    return benchmarks;
+}
+
+int main(int argc, char** argv)
+{
+    cppcbb::bench::options opts;
+    if (!opts.parse(argc, argv))
+    {
+        cppcbb::bench::options::print_usage(argv[0]);
+        return 1;
+    }
+
+    std::vector<cppcbb::bench::result> results = cppcbb::bench::run(all_benchmarks(), opts);
+
+    FILE* out = stdout;
+    if (!opts.out_path.empty())
+    {
+        out = fopen(opts.out_path.c_str(), "w");
+        if (out == nullptr)
+        {
+            fprintf(stderr, "Could not open %s\n", opts.out_path.c_str());
+            return 1;
+        }
+    }
+
+    if (opts.format == "csv")
+    {
+        cppcbb::bench::write_csv(out, results);
+    }
+    else if (opts.format == "json")
+    {
+        cppcbb::bench::write_json(out, results);
+    }
+    else
+    {
+        cppcbb::bench::write_table(out, results);
+    }
+
+    if (out != stdout)
+    {
+        fclose(out);
+    }
+
+    return 0;
+}
@@ -0,0 +1,338 @@
+//Copyright(C) 2020 Henry Bullingham
+//This file is subject to the license terms in the LICENSE file
+//found in the top - level directory of this distribution.
+
+#pragma once
+
+#if !defined (CPPCBB_BENCH_CPPCBB_BENCH_H)
+#define CPPCBB_BENCH_CPPCBB_BENCH_H
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <string>
+#include <vector>
+
+/*
+
+    Small self contained benchmark harness
+    Each benchmark times one operation over a container of a given size,
+    trials are repeated until they run long enough to measure, after warmup
+
+*/
+
+namespace cppcbb
+{
+    namespace bench
+    {
+        /// <summary>
+        /// Keeps the compiler from optimizing away a computed value
+        /// </summary>
+        template<typename T>
+        inline void do_not_optimize(const T& value);
+
+        /// <summary>
+        /// Accumulates time across start / stop pairs, so setup can be excluded
+        /// </summary>
+        class stopwatch;
+
+        /// <summary>
+        /// A registered benchmark
+        /// func(size, watch) runs the operation once over a container of size elements and returns how many operations it timed
+        /// </summary>
+        class benchmark;
+
+        /// <summary>
+        /// Timing summary for one benchmark at one size, all times are per operation
+        /// </summary>
+        class result;
+
+        /// <summary>
+        /// Command line options
+        /// </summary>
+        class options;
+
+        /// <summary>
+        /// Holds all benchmarks
+        /// </summary>
+        class registry;
+
+        /// <summary>
+        /// Sizes benchmarked, 8 to 10M
+        /// </summary>
+        inline std::vector<size_t> default_sizes();
+
+        /// <summary>
+        /// Runs every benchmark passing the filters at every size it supports
+        /// </summary>
+        inline std::vector<result> run(const registry& benchmarks, const options& opts);
+
+        inline void write_table(FILE* out, const std::vector<result>& results);
+        inline void write_csv(FILE* out, const std::vector<result>& results);
+        inline void write_json(FILE* out, const std::vector<result>& results);
+    }
+}
+
+/*
+
+    Implementation details
+
+*/
+
+namespace cppcbb
+{
+    namespace bench
+    {
+#if defined(_MSC_VER)
+        inline void escape_pointer(const volatile void* pointer)
+        {
+            static const volatile void* volatile sink;
+            sink = pointer;
+        }
+
+        template<typename T>
+        inline void do_not_optimize(const T& value)
+        {
+            escape_pointer(&value);
+        }
+#else
+        template<typename T>
+        inline void do_not_optimize(const T& value)
+        {
+            asm volatile("" : : "r,m"(value) : "memory");
+        }
+#endif
+
+        class stopwatch
+        {
+        private:
+            using clock = std::chrono::steady_clock;
+
+            clock::time_point m_start;
+            double m_elapsed_ns = 0.0;
+
+        public:
+            void start() { m_start = clock::now(); }
+
+            void stop()
+            {
+                m_elapsed_ns += (double)std::chrono::duration_cast<std::chrono::nanoseconds>(clock::now() - m_start).count();
+            }
+
+            double elapsed_ns() const { return m_elapsed_ns; }
+        };
+
+        class benchmark
+        {
+        public:
+            std::string container;
+            std::string operation;
+            size_t max_size;
+            std::function<size_t(size_t, stopwatch&)> func;
+        };
+
+        class result
+        {
+        public:
+            std::string container;
+            std::string operation;
+            size_t size = 0;
+            size_t trials = 0;
+            double min_ns = 0.0;
+            double p50_ns = 0.0;
+            double p90_ns = 0.0;
+            double p99_ns = 0.0;
+            double max_ns = 0.0;
+            double mean_ns = 0.0;
+            double stddev_ns = 0.0;
+        };
+
+        class options
+        {
+        public:
+            std::string filter;
+            size_t min_size = 0;
+            size_t max_size = 10000000;
+            size_t trials = 10;
+            size_t warmup = 2;
+            double min_trial_ns = 1000000.0;
+            std::string format = "table";
+            std::string out_path;
+
+            //Returns false on bad arguments
+            bool parse(int argc, char** argv)
+            {
+                for (int i = 1; i < argc; i++)
+                {
+                    std::string arg = argv[i];
+                    bool has_value = (i + 1) < argc;
+
+                    if (arg == "--filter" && has_value) { filter = argv[++i]; }
+                    else if (arg == "--min-size" && has_value) { min_size = std::strtoull(argv[++i], nullptr, 10); }
+                    else if (arg == "--max-size" && has_value) { max_size = std::strtoull(argv[++i], nullptr, 10); }
+                    else if (arg == "--trials" && has_value) { trials = std::strtoull(argv[++i], nullptr, 10); }
+                    else if (arg == "--warmup" && has_value) { warmup = std::strtoull(argv[++i], nullptr, 10); }
+                    else if (arg == "--min-trial-ms" && has_value) { min_trial_ns = std::atof(argv[++i]) * 1000000.0; }
+                    else if (arg == "--format" && has_value) { format = argv[++i]; }
+                    else if (arg == "--out" && has_value) { out_path = argv[++i]; }
+                    else { return false; }
+                }
+                return trials > 0 && (format == "table" || format == "csv" || format == "json");
+            }
+
+            static void print_usage(const char* program)
+            {
+                printf("Usage: %s [--filter text] [--min-size n] [--max-size n] [--trials n] [--warmup n]\n"
+                       "          [--min-trial-ms ms] [--format table|csv|json] [--out file]\n", program);
+            }
+        };
+
+        class registry
+        {
+        private:
+            std::vector<benchmark> m_benchmarks;
+
+        public:
+            void add(std::string container, std::string operation, size_t max_size, std::function<size_t(size_t, stopwatch&)> func)
+            {
+                m_benchmarks.push_back(benchmark{ std::move(container), std::move(operation), max_size, std::move(func) });
+            }
+
+            const std::vector<benchmark>& benchmarks() const { return m_benchmarks; }
+        };
+
+        inline std::vector<size_t> default_sizes()
+        {
+            return { 8, 64, 512, 4096, 32768, 262144, 2097152, 10000000 };
+        }
+
+        //Nearest rank percentile of sorted samples
+        inline double percentile(const std::vector<double>& sorted, double fraction)
+        {
+            size_t rank = (size_t)std::ceil(fraction * sorted.size());
+            return sorted[rank > 0 ? rank - 1 : 0];
+        }
+
+        //One trial repeats the benchmark until enough time has been measured, returns time per operation
+        inline double run_trial(const benchmark& bench, size_t size, double min_trial_ns)
+        {
+            stopwatch watch;
+            size_t operations = 0;
+            do
+            {
+                operations += bench.func(size, watch);
+            } while (watch.elapsed_ns() < min_trial_ns);
+
+            return watch.elapsed_ns() / (double)(operations > 0 ? operations : 1);
+        }
+
+        inline std::vector<result> run(const registry& benchmarks, const options& opts)
+        {
+            std::vector<result> results;
+
+            for (const benchmark& bench : benchmarks.benchmarks())
+            {
+                std::string name = bench.container + "/" + bench.operation;
+                if (!opts.filter.empty() && name.find(opts.filter) == std::string::npos)
+                {
+                    continue;
+                }
+
+                for (size_t size : default_sizes())
+                {
+                    if (size < opts.min_size || size > opts.max_size || size > bench.max_size)
+                    {
+                        continue;
+                    }
+
+                    for (size_t i = 0; i < opts.warmup; i++)
+                    {
+                        run_trial(bench, size, opts.min_trial_ns);
+                    }
+
+                    std::vector<double> samples;
+                    for (size_t i = 0; i < opts.trials; i++)
+                    {
+                        samples.push_back(run_trial(bench, size, opts.min_trial_ns));
+                    }
+                    std::sort(samples.begin(), samples.end());
+
+                    result r;
+                    r.container = bench.container;
+                    r.operation = bench.operation;
+                    r.size = size;
+                    r.trials = samples.size();
+                    r.min_ns = samples.front();
+                    r.max_ns = samples.back();
+                    r.p50_ns = percentile(samples, 0.50);
+                    r.p90_ns = percentile(samples, 0.90);
+                    r.p99_ns = percentile(samples, 0.99);
+
+                    double sum = 0.0;
+                    for (double sample : samples)
+                    {
+                        sum += sample;
+                    }
+                    r.mean_ns = sum / samples.size();
+
+                    double squares = 0.0;
+                    for (double sample : samples)
+                    {
+                        squares += (sample - r.mean_ns) * (sample - r.mean_ns);
+                    }
+                    r.stddev_ns = std::sqrt(squares / samples.size());
+
+                    results.push_back(r);
+
+                    //Progress goes to stderr so stdout stays machine readable
+                    fprintf(stderr, "%-40s %10zu %12.2f ns/op\n", name.c_str(), size, r.p50_ns);
+                }
+            }
+
+            return results;
+        }
+
+        inline void write_table(FILE* out, const std::vector<result>& results)
+        {
+            fprintf(out, "%-36s %-14s %10s %12s %12s %12s %12s %12s\n", "container", "operation", "size", "min ns", "p50 ns", "p90 ns", "p99 ns", "stddev ns");
+            for (const result& r : results)
+            {
+                fprintf(out, "%-36s %-14s %10zu %12.2f %12.2f %12.2f %12.2f %12.2f\n"
+                    , r.container.c_str(), r.operation.c_str(), r.size, r.min_ns, r.p50_ns, r.p90_ns, r.p99_ns, r.stddev_ns);
+            }
+        }
+
+        inline void write_csv(FILE* out, const std::vector<result>& results)
+        {
+            fprintf(out, "container,operation,size,trials,min_ns,p50_ns,p90_ns,p99_ns,max_ns,mean_ns,stddev_ns\n");
+            for (const result& r : results)
+            {
+                fprintf(out, "%s,%s,%zu,%zu,%.3f,%.3f,%.3f,%.3f,%.3f,%.3f,%.3f\n"
+                    , r.container.c_str(), r.operation.c_str(), r.size, r.trials
+                    , r.min_ns, r.p50_ns, r.p90_ns, r.p99_ns, r.max_ns, r.mean_ns, r.stddev_ns);
+            }
+        }
+
+        inline void write_json(FILE* out, const std::vector<result>& results)
+        {
+            fprintf(out, "[\n");
+            for (size_t i = 0; i < results.size(); i++)
+            {
+                const result& r = results[i];
+                fprintf(out, "  {\"container\": \"%s\", \"operation\": \"%s\", \"size\": %zu, \"trials\": %zu, "
+                             "\"min_ns\": %.3f, \"p50_ns\": %.3f, \"p90_ns\": %.3f, \"p99_ns\": %.3f, \"max_ns\": %.3f, "
+                             "\"mean_ns\": %.3f, \"stddev_ns\": %.3f}%s\n"
+                    , r.container.c_str(), r.operation.c_str(), r.size, r.trials
+                    , r.min_ns, r.p50_ns, r.p90_ns, r.p99_ns, r.max_ns, r.mean_ns, r.stddev_ns
+                    , (i + 1) < results.size() ? "," : "");
+            }
+            fprintf(out, "]\n");
+        }
+    }
+}
+
+#endif //CPPCBB_BENCH_CPPCBB_BENCH_H
@@ -0,0 +1,494 @@
+//Copyright(C) 2020 Henry Bullingham
+//This file is subject to the license terms in the LICENSE file
+//found in the top - level directory of this distribution.
+
+#include "cppcbb_bench.hpp"
+
+#include "cppcbb/cbb_map.hpp"
+#include "cppcbb/cbb_sparse_set.hpp"
+#include "cppcbb/cbb_trace.hpp"
+
+#include <atomic>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <new>
+#include <random>
+#include <unordered_map>
+#include <unordered_set>
+
+/*
+
+    Map workload replay tool
+    Replays a trace of map operations (see cbb_trace.hpp) against every map alias, reporting throughput & memory
+
+    cppcbb_replay generate --out file [--ops n] [--keys n] [--dist uniform|zipf|sequential] [--mix insert,find,erase] [--seed n]
+    cppcbb_replay replay file [--trials n] [--max-linear-keys n] [--format table|csv|json]
+
+*/
+
+using cppcbb::trace::op_type;
+using cppcbb::trace::operation;
+using cppcbb::bench::do_not_optimize;
+
+/*
+
+    Heap tracking, replacement global allocation functions count live & peak bytes
+    The size is stored in a header in front of each block, so frees know how much to subtract
+
+*/
+
+static std::atomic<size_t> s_live_bytes(0);
+static std::atomic<size_t> s_peak_bytes(0);
+
+static constexpr size_t k_size_header = sizeof(std::max_align_t);
+
+//The header is only reached through these helpers, which work on malloc's void* & are kept out of line,
+//so the compiler never sees free() on a pointer from operator new or a read before one
+#if defined(_MSC_VER)
+#define CPPCBB_REPLAY_NOINLINE __declspec(noinline)
+#else
+#define CPPCBB_REPLAY_NOINLINE __attribute__((noinline))
+#endif
+
+//Allocates size bytes behind a header holding size, returns the user pointer or nullptr
+static CPPCBB_REPLAY_NOINLINE void* allocate_tracked(size_t size)
+{
+    void* block = std::malloc(size + k_size_header);
+    if (block == nullptr)
+    {
+        return nullptr;
+    }
+    std::memcpy(block, &size, sizeof(size));
+
+    size_t live = s_live_bytes.fetch_add(size) + size;
+    size_t peak = s_peak_bytes.load();
+    while (live > peak && !s_peak_bytes.compare_exchange_weak(peak, live)) {}
+
+    return static_cast<unsigned char*>(block) + k_size_header;
+}
+
+//Frees a user pointer from allocate_tracked
+static CPPCBB_REPLAY_NOINLINE void free_tracked(void* ptr)
+{
+    void* block = reinterpret_cast<void*>(reinterpret_cast<uintptr_t>(ptr) - k_size_header);
+    size_t size = 0;
+    std::memcpy(&size, block, sizeof(size));
+    s_live_bytes.fetch_sub(size);
+    std::free(block);
+}
+
+void* operator new(size_t size)
+{
+    void* ptr = allocate_tracked(size);
+    if (ptr == nullptr)
+    {
+        throw std::bad_alloc();
+    }
+    return ptr;
+}
+
+void* operator new[](size_t size)
+{
+    return operator new(size);
+}
+
+void operator delete(void* ptr) noexcept
+{
+    if (ptr != nullptr)
+    {
+        free_tracked(ptr);
+    }
+}
+
+void operator delete[](void* ptr) noexcept
+{
+    operator delete(ptr);
+}
+
+void operator delete(void* ptr, size_t) noexcept
+{
+    operator delete(ptr);
+}
+
+void operator delete[](void* ptr, size_t) noexcept
+{
+    operator delete(ptr);
+}
+
+/*
+
+    Trace generation, standing in for an instrumented run
+    Generated traces are flagged synthetic in their header, and replay says so in its output
+
+*/
+
+class generate_options
+{
+public:
+    std::string out_path;
+    size_t ops = 1000000;
+    size_t keys = 4096;
+    std::string dist = "uniform";
+    double insert_share = 0.2;
+    double find_share = 0.7;
+    unsigned seed = 12345;
+
+    bool parse(int argc, char** argv)
+    {
+        for (int i = 2; i < argc; i++)
+        {
+            std::string arg = argv[i];
+            bool has_value = (i + 1) < argc;
+
+            if (arg == "--out" && has_value) { out_path = argv[++i]; }
+            else if (arg == "--ops" && has_value) { ops = std::strtoull(argv[++i], nullptr, 10); }
+            else if (arg == "--keys" && has_value) { keys = std::strtoull(argv[++i], nullptr, 10); }
+            else if (arg == "--dist" && has_value) { dist = argv[++i]; }
+            else if (arg == "--seed" && has_value) { seed = (unsigned)std::strtoul(argv[++i], nullptr, 10); }
+            else if (arg == "--mix" && has_value)
+            {
+                double insert = 0, find = 0, erase = 0;
+                if (sscanf(argv[++i], "%lf,%lf,%lf", &insert, &find, &erase) != 3 || insert + find + erase <= 0)
+                {
+                    return false;
+                }
+                insert_share = insert / (insert + find + erase);
+                find_share = find / (insert + find + erase);
+            }
+            else { return false; }
+        }
+        return !out_path.empty() && keys > 0 && (dist == "uniform" || dist == "zipf" || dist == "sequential");
+    }
+};
+
+//Draws key ranks with P(rank) proportional to 1 / (rank + 1), by inverting the cumulative weights
+class zipf_distribution
+{
+private:
+    std::vector<double> m_cumulative;
+
+public:
+    explicit zipf_distribution(size_t count)
+        : m_cumulative(count)
+    {
+        double sum = 0.0;
+        for (size_t i = 0; i < count; i++)
+        {
+            sum += 1.0 / (double)(i + 1);
+            m_cumulative[i] = sum;
+        }
+    }
+
+    template<typename Generator>
+    size_t operator()(Generator& generator)
+    {
+        double target = std::uniform_real_distribution<double>(0.0, m_cumulative.back())(generator);
+        return std::lower_bound(m_cumulative.begin(), m_cumulative.end(), target) - m_cumulative.begin();
+    }
+};
+
+static int generate(const generate_options& opts)
+{
+    cppcbb::trace::trace_writer writer;
+    if (!writer.open(opts.out_path.c_str(), cppcbb::trace::synthetic_trace))
+    {
+        fprintf(stderr, "Could not create %s\n", opts.out_path.c_str());
+        return 1;
+    }
+
+    std::mt19937_64 generator(opts.seed);
+    std::uniform_real_distribution<double> op_dist(0.0, 1.0);
+    std::uniform_int_distribution<size_t> uniform(0, opts.keys - 1);
+    zipf_distribution zipf(opts.dist == "zipf" ? opts.keys : 1);
+
+    //Ranks map to scattered keys, so hot keys aren't also the smallest
+    std::vector<uint64_t> keys(opts.keys);
+    for (size_t i = 0; i < opts.keys; i++)
+    {
+        keys[i] = i * 7 + 3;
+    }
+    std::shuffle(keys.begin(), keys.end(), generator);
+
+    size_t next_sequential = 0;
+    for (size_t i = 0; i < opts.ops; i++)
+    {
+        size_t rank = 0;
+        if (opts.dist == "zipf") { rank = zipf(generator); }
+        else if (opts.dist == "sequential") { rank = next_sequential++ % opts.keys; }
+        else { rank = uniform(generator); }
+
+        double pick = op_dist(generator);
+        op_type type = pick < opts.insert_share ? op_type::insert
+            : pick < opts.insert_share + opts.find_share ? op_type::find
+            : op_type::erase;
+        writer.record(type, keys[rank]);
+    }
+
+    writer.close();
+    fprintf(stderr, "Wrote a synthetic %s trace of %zu operations over %zu keys to %s\n", opts.dist.c_str(), opts.ops, opts.keys, opts.out_path.c_str());
+    return 0;
+}
+
+/*
+
+    Replay
+
+*/
+
+class replay_options
+{
+public:
+    std::string path;
+    size_t trials = 5;
+    size_t max_linear_keys = 20000;
+    std::string format = "table";
+
+    bool parse(int argc, char** argv)
+    {
+        for (int i = 2; i < argc; i++)
+        {
+            std::string arg = argv[i];
+            bool has_value = (i + 1) < argc;
+
+            if (arg == "--trials" && has_value) { trials = std::strtoull(argv[++i], nullptr, 10); }
+            else if (arg == "--max-linear-keys" && has_value) { max_linear_keys = std::strtoull(argv[++i], nullptr, 10); }
+            else if (arg == "--format" && has_value) { format = argv[++i]; }
+            else if (path.empty() && arg[0] != '-') { path = arg; }
+            else { return false; }
+        }
+        return !path.empty() && trials > 0 && (format == "table" || format == "csv" || format == "json");
+    }
+};
+
+class trace_summary
+{
+public:
+    size_t distinct_keys = 0;
+    uint64_t max_key = 0;
+    size_t counts[3] = {};
+
+    //Generated by cppcbb_replay generate, not recorded from a real run
+    bool synthetic = false;
+};
+
+class replay_result
+{
+public:
+    std::string container;
+    bool skipped = false;
+    std::string reason;
+    double best_ms = 0.0;
+    double mops_per_s = 0.0;
+    size_t peak_bytes = 0;
+    size_t object_bytes = 0;
+    size_t final_size = 0;
+};
+
+//Sparse maps allocate pages over the whole key range, so keys past this are skipped for them
+static constexpr uint64_t k_max_sparse_key = (uint64_t)1 << 26;
+
+template<typename Map>
+static size_t replay_once(const cppcbb::cbb_vector<operation>& ops, Map& map)
+{
+    size_t found = 0;
+    for (const operation& op : ops)
+    {
+        switch (op.type)
+        {
+        case op_type::insert:
+            map[op.key] = op.key;
+            break;
+        case op_type::find:
+            found += map.find(op.key) != map.end() ? 1 : 0;
+            break;
+        case op_type::erase:
+        {
+            auto it = map.find(op.key);
+            if (it != map.end())
+            {
+                map.erase(it);
+            }
+            break;
+        }
+        }
+    }
+    return found;
+}
+
+template<typename Map>
+static replay_result replay(const std::string& name, const cppcbb::cbb_vector<operation>& ops, const replay_options& opts)
+{
+    replay_result result;
+    result.container = name;
+    result.object_bytes = sizeof(Map);
+
+    double best_ns = 0.0;
+    for (size_t trial = 0; trial < opts.trials; trial++)
+    {
+        size_t baseline = s_live_bytes.load();
+        s_peak_bytes = baseline;
+
+        std::unique_ptr<Map> map(new Map());
+
+        cppcbb::bench::stopwatch watch;
+        watch.start();
+        size_t found = replay_once(ops, *map);
+        watch.stop();
+        do_not_optimize(found);
+
+        if (trial == 0 || watch.elapsed_ns() < best_ns)
+        {
+            best_ns = watch.elapsed_ns();
+        }
+        result.peak_bytes = s_peak_bytes.load() - baseline;
+        result.final_size = map->size();
+    }
+
+    result.best_ms = best_ns / 1000000.0;
+    result.mops_per_s = best_ns > 0.0 ? (double)ops.size() / best_ns * 1000.0 : 0.0;
+    return result;
+}
+
+static replay_result skipped(const std::string& name, const std::string& reason)
+{
+    replay_result result;
+    result.container = name;
+    result.skipped = true;
+    result.reason = reason;
+    return result;
+}
+
+static trace_summary summarize(const cppcbb::cbb_vector<operation>& ops)
+{
+    trace_summary summary;
+    std::unordered_set<uint64_t> keys;
+    for (const operation& op : ops)
+    {
+        keys.insert(op.key);
+        summary.max_key = op.key > summary.max_key ? op.key : summary.max_key;
+        summary.counts[(size_t)op.type]++;
+    }
+    summary.distinct_keys = keys.size();
+    return summary;
+}
+
+static void write_results(const replay_options& opts, const trace_summary& summary, size_t ops, std::vector<replay_result> results)
+{
+    //Fastest first, skipped last
+    std::stable_sort(results.begin(), results.end(), [](const replay_result& left, const replay_result& right)
+    {
+        if (left.skipped != right.skipped)
+        {
+            return right.skipped;
+        }
+        return left.mops_per_s > right.mops_per_s;
+    });
+
+    if (opts.format == "csv")
+    {
+        printf("container,synthetic_trace,skipped,best_ms,mops_per_s,peak_bytes,object_bytes,final_size\n");
+        for (const replay_result& r : results)
+        {
+            printf("%s,%d,%d,%.3f,%.3f,%zu,%zu,%zu\n", r.container.c_str(), summary.synthetic ? 1 : 0, r.skipped ? 1 : 0, r.best_ms, r.mops_per_s, r.peak_bytes, r.object_bytes, r.final_size);
+        }
+    }
+    else if (opts.format == "json")
+    {
+        printf("{\"trace\": \"%s\", \"synthetic\": %s, \"operations\": %zu, \"distinct_keys\": %zu, \"results\": [\n"
+            , opts.path.c_str(), summary.synthetic ? "true" : "false", ops, summary.distinct_keys);
+        for (size_t i = 0; i < results.size(); i++)
+        {
+            const replay_result& r = results[i];
+            printf("  {\"container\": \"%s\", \"skipped\": %s, \"best_ms\": %.3f, \"mops_per_s\": %.3f, \"peak_bytes\": %zu, \"object_bytes\": %zu, \"final_size\": %zu}%s\n"
+                , r.container.c_str(), r.skipped ? "true" : "false", r.best_ms, r.mops_per_s, r.peak_bytes, r.object_bytes, r.final_size
+                , (i + 1) < results.size() ? "," : "");
+        }
+        printf("]}\n");
+    }
+    else
+    {
+        printf("%s trace %s: %zu operations (%zu insert, %zu find, %zu erase), %zu distinct keys, max key %llu\n"
+            , summary.synthetic ? "Synthetic" : "Recorded", opts.path.c_str(), ops, summary.counts[0], summary.counts[1], summary.counts[2], summary.distinct_keys, (unsigned long long)summary.max_key);
+        if (summary.synthetic)
+        {
+            printf("Generated by cppcbb_replay generate, record a real run with trace::recording_map before choosing a policy\n");
+        }
+        printf("\n");
+        printf("%-28s %12s %12s %14s %12s %10s\n", "container", "best ms", "Mops/s", "peak heap B", "object B", "size");
+        for (const replay_result& r : results)
+        {
+            if (r.skipped)
+            {
+                printf("%-28s skipped: %s\n", r.container.c_str(), r.reason.c_str());
+                continue;
+            }
+            printf("%-28s %12.3f %12.3f %14zu %12zu %10zu\n", r.container.c_str(), r.best_ms, r.mops_per_s, r.peak_bytes, r.object_bytes, r.final_size);
+        }
+    }
+}
+
+static int replay_all(const replay_options& opts)
+{
+    using namespace cppcbb;
+
+    cbb_vector<operation> ops;
+    uint16_t flags = 0;
+    if (!trace::read_trace(opts.path.c_str(), ops, &flags))
+    {
+        fprintf(stderr, "Could not read trace %s\n", opts.path.c_str());
+        return 1;
+    }
+
+    trace_summary summary = summarize(ops);
+    summary.synthetic = (flags & trace::synthetic_trace) != 0;
+    bool linear_ok = summary.distinct_keys <= opts.max_linear_keys;
+    bool sparse_ok = summary.max_key < k_max_sparse_key;
+
+    std::vector<replay_result> results;
+
+    results.push_back(linear_ok ? replay<cbb_vector_map<uint64_t, uint64_t>>("cbb_vector_map", ops, opts) : skipped("cbb_vector_map", "too many keys for a linear search"));
+    results.push_back(linear_ok ? replay<cbb_unordered_vector_map<uint64_t, uint64_t>>("cbb_unordered_vector_map", ops, opts) : skipped("cbb_unordered_vector_map", "too many keys for a linear search"));
+    results.push_back(replay<cbb_sorted_vector_map<uint64_t, uint64_t>>("cbb_sorted_vector_map", ops, opts));
+    results.push_back(sparse_ok ? replay<cbb_sparse_map<uint64_t, uint64_t>>("cbb_sparse_map", ops, opts) : skipped("cbb_sparse_map", "keys too large for a sparse index"));
+    results.push_back(replay<std::map<uint64_t, uint64_t>>("std::map", ops, opts));
+    results.push_back(replay<std::unordered_map<uint64_t, uint64_t>>("std::unordered_map", ops, opts));
+
+    write_results(opts, summary, ops.size(), results);
+    return 0;
+}
+
+static void print_usage(const char* program)
+{
+    printf("Usage: %s generate --out file [--ops n] [--keys n] [--dist uniform|zipf|sequential] [--mix insert,find,erase] [--seed n]\n"
+           "       %s replay file [--trials n] [--max-linear-keys n] [--format table|csv|json]\n", program, program);
+}
+
+int main(int argc, char** argv)
+{
+    std::string command = argc > 1 ? argv[1] : "";
+
+    if (command == "generate")
+    {
+        generate_options opts;
+        if (opts.parse(argc, argv))
+        {
+            return generate(opts);
+        }
+    }
+    else if (command == "replay")
+    {
+        replay_options opts;
+        if (opts.parse(argc, argv))
+        {
+            return replay_all(opts);
+        }
+    }
+
+    print_usage(argv[0]);
+    return 1;
+}
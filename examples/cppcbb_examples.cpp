@@ -6,91 +6,55 @@
 
 #include "cppcbb/cbb_map.hpp"
 
-#include <chrono>
 #include <cstdio>
-#include <cmath>
-#include <numeric>
-#include <utility>
 
-template<typename Func>
-float measure_time(Func&& func)
-{
-    auto start = std::chrono::high_resolution_clock::now();
-
-    func();
+/*
 
-    auto end = std::chrono::high_resolution_clock::now();
+    Timing lives in the cppcbb_bench target, this only shows the containers in use
 
-    return (float)(end - start).count() / 1000000000.0f;
-}
+*/
 
 template<typename Vector>
-void run_sample(int seed, int num_values = 1000)
+void run_sample(const char* name, int num_values)
 {
     Vector v;
-    srand(seed);
 
-    // Add a bunch of random elements
+    // Add a bunch of elements
     for (int i = 0; i < num_values; i++)
     {
-        v.push_back(rand());
+        v.push_back(i);
     }
 
-    //Remove them from random indices
-    while (v.size() > 0)
-    {
-        int index = (int)((rand() / (float)RAND_MAX) * v.size());
-        v.erase(v.begin() + index);
-    }
-}
-
-/// <summary>
-/// 
-/// </summary>
-/// <typeparam name="Vector"></typeparam>
-/// <param name="seed"></param>
-/// <param name="num_values"></param>
-/// <param name="num_iterations"></param>
-/// <returns>average time and std dev of times</returns>
-template<typename Vector>
-std::pair<float,float> average_runtime(int seed, int num_values = 1000, int num_iterations = 10)
-{
-    cppcbb::cbb_vector<float> runtimes;
-
-    for (int i = 0; i < num_iterations; i++)
+    //Remove every odd element from the front half
+    for (int i = 0; i < num_values / 4; i++)
     {
-        runtimes.push_back(measure_time([=]()
-        {
-            run_sample<Vector>(seed, num_values);
-        }));
+        v.erase(v.begin() + i + 1);
     }
-    float average = std::accumulate(runtimes.begin(), runtimes.end(), 0.0f) / (float)runtimes.size();
-    float std_dev = sqrtf(
-        (float)std::transform_reduce(runtimes.begin(), runtimes.end(), 0.0f, std::plus<float>(), [=](float x) { return (x - average) * (x - average); })
-    );
 
-    return std::make_pair(average, std_dev);
+    printf("%-28s size %4zu, front %4d, back %4d\n", name, v.size(), v[0], v.back());
 }
 
 int main(int argc, char** argv)
 {
-    int seed = (int) std::chrono::high_resolution_clock::now().time_since_epoch().count();
     const int num_values = 1000;
-    int num_runs = 10;
 
     printf("CPPCBB Example Program: \n\n\n");
 
-    auto regular_vector = average_runtime<cppcbb::cbb_vector<int>>(seed, num_values, num_runs);
-    printf("Regular Vector:              Time %10f s StdDev %10f s\n\n", regular_vector.first, regular_vector.second);
-
-    auto static_vector = average_runtime<cppcbb::cbb_static_vector<int, num_values>>(seed, num_values, num_runs);
-    printf("Static Vector:               Time %10f s StdDev %10f s\n\n", static_vector.first, static_vector.second);
+    run_sample<cppcbb::cbb_vector<int>>("Regular Vector:", num_values);
+    run_sample<cppcbb::cbb_static_vector<int, num_values>>("Static Vector:", num_values);
+    run_sample<cppcbb::cbb_unordered_vector<int>>("Unordered Vector:", num_values);
+    run_sample<cppcbb::cbb_static_unordered_vector<int, num_values>>("Static Unordered Vector:", num_values);
 
-    auto unordered_vector = average_runtime<cppcbb::cbb_unordered_vector<int>>(seed, num_values, num_runs);
-    printf("Unordered Vector:            Time %10f s StdDev %10f s\n\n", unordered_vector.first, unordered_vector.second);
+    cppcbb::cbb_sorted_vector_map<int, const char*> map;
+    map[3] = "three";
+    map[1] = "one";
+    map[2] = "two";
 
-    auto static_u_vector = average_runtime<cppcbb::cbb_static_unordered_vector<int, num_values>>(seed, num_values, num_runs);
-    printf("Static Unordered Vector:     Time %10f s StdDev %10f s\n\n", static_u_vector.first, static_u_vector.second);
+    printf("\nSorted Vector Map:\n");
+    for (auto it = map.cbegin(); it != map.cend(); ++it)
+    {
+        printf("  %d -> %s\n", it->first, it->second);
+    }
 
     return 0;
-}
\ No newline at end of file
+}
@@ -0,0 +1,194 @@
+//Copyright(C) 2020 Henry Bullingham
+//This file is subject to the license terms in the LICENSE file
+//found in the top - level directory of this distribution.
+
+#pragma once
+
+#if !defined (CPPCBB_INCLUDE_CBB_AUTO_H)
+#define CPPCBB_INCLUDE_CBB_AUTO_H
+
+#include "cbb_common.hpp"
+#include "cbb_vector.hpp"
+#include "cbb_map.hpp"
+#include "cbb_sparse_set.hpp"
+
+#include <cstdint>
+#include <type_traits>
+
+namespace cppcbb
+{
+    /// <summary>
+    /// What is known at compile time about how a container will be used
+    /// Derive and hide the members that are known, e.g.
+    /// class my_hints : public default_container_hints { public: static constexpr size_t max_size = 16; };
+    /// </summary>
+    class default_container_hints
+    {
+    public:
+        //Upper bound on the number of elements, 0 if unknown
+        static constexpr size_t max_size = 0;
+
+        //Fraction of operations that are lookups rather than inserts / erases
+        static constexpr float read_ratio = 0.5f;
+
+        //Fraction of operations that erase
+        static constexpr float erase_ratio = 0.1f;
+
+        //Fraction of operations that insert before the end (vectors)
+        static constexpr float middle_insert_ratio = 0.0f;
+
+        //Vectors: elements must stay in insertion order
+        static constexpr bool keep_order = true;
+
+        //Maps: iteration must visit keys in sorted order
+        static constexpr bool sorted_keys = false;
+
+        //Integral keys are all in [0, max_key), 0 if unknown
+        static constexpr uint64_t max_key = 0;
+    };
+
+    /// <summary>
+    /// Thresholds used to pick policies
+    /// These are initial estimates, not measured on any particular machine or workload:
+    /// check them with cppcbb_bench & a recorded trace in cppcbb_replay, and override them in a derived class
+    /// </summary>
+    class default_auto_thresholds
+    {
+    public:
+        //Linear search beats binary search up to about this many trivially comparable keys
+        static constexpr size_t linear_max_size = 32;
+
+        //Write heavy maps keep linear storage for longer, as appends & swap erases avoid the sorted shifts
+        static constexpr size_t write_heavy_linear_max_size = 64;
+
+        //Keys that are expensive to compare or move favour linear search for fewer entries
+        static constexpr size_t nontrivial_linear_max_size = 8;
+
+        //Sorted storage pays for its O(n) inserts when at least this fraction of operations are lookups
+        static constexpr float read_mostly_ratio = 0.7f;
+
+        //Bounded containers up to this many bytes get static storage
+        static constexpr size_t static_max_bytes = 64 * 1024;
+
+        //Integral keys below this get a sparse index, paged when it doesn't fit static_max_bytes
+        static constexpr uint64_t sparse_max_key = (uint64_t)1 << 24;
+
+        //Ordered vectors with this fraction of middle inserts get a gap buffer
+        static constexpr float gap_insert_ratio = 0.05f;
+
+        //Ordered vectors with this fraction of erases get tombstones
+        static constexpr float tombstone_erase_ratio = 0.25f;
+    };
+
+    /// <summary>
+    /// Picks the vector policies for Elem from Hints, the chosen type is auto_vector_selector::type
+    /// </summary>
+    template<typename Elem, typename Hints = default_container_hints, typename Thresholds = default_auto_thresholds>
+    class auto_vector_selector;
+
+    /// <summary>
+    /// Picks the map policies for Key & Value from Hints, the chosen type is auto_map_selector::type
+    /// </summary>
+    template<typename Key, typename Value, typename Hints = default_container_hints, typename Thresholds = default_auto_thresholds>
+    class auto_map_selector;
+
+    /// <summary>
+    /// Vector with storage & management picked at compile time from usage hints
+    /// </summary>
+    template<typename Elem, typename Hints = default_container_hints, typename Thresholds = default_auto_thresholds>
+    using cbb_auto_vector = typename auto_vector_selector<Elem, Hints, Thresholds>::type;
+
+    /// <summary>
+    /// Map with storage & management picked at compile time from usage hints
+    /// </summary>
+    template<typename Key, typename Value, typename Hints = default_container_hints, typename Thresholds = default_auto_thresholds>
+    using cbb_auto_map = typename auto_map_selector<Key, Value, Hints, Thresholds>::type;
+}
+
+/*
+
+    Implementation details
+
+*/
+
+/// <summary>
+/// Auto Vector
+/// </summary>
+namespace cppcbb
+{
+    template<typename Elem, typename Hints, typename Thresholds>
+    class auto_vector_selector
+    {
+    private:
+        //Named types are never instantiated unless picked, but keep their capacities valid anyway
+        static constexpr size_t k_capacity = Hints::max_size > 0 ? Hints::max_size : 1;
+
+    public:
+        static constexpr bool is_static = Hints::max_size > 0 && Hints::max_size * sizeof(Elem) <= Thresholds::static_max_bytes;
+        static constexpr bool is_unordered = !Hints::keep_order;
+        static constexpr bool is_gap = !is_unordered && Hints::middle_insert_ratio >= Thresholds::gap_insert_ratio;
+        static constexpr bool is_tombstone = !is_unordered && !is_gap && Hints::erase_ratio >= Thresholds::tombstone_erase_ratio;
+
+        using type =
+            typename std::conditional<is_unordered,
+                typename std::conditional<is_static, cbb_static_unordered_vector<Elem, k_capacity>, cbb_unordered_vector<Elem>>::type,
+            typename std::conditional<is_gap,
+                typename std::conditional<is_static, cbb_static_gap_vector<Elem, k_capacity>, cbb_gap_vector<Elem>>::type,
+            typename std::conditional<is_tombstone,
+                typename std::conditional<is_static, cbb_static_tombstone_vector<Elem, k_capacity>, cbb_tombstone_vector<Elem>>::type,
+                typename std::conditional<is_static, cbb_static_vector<Elem, k_capacity>, cbb_vector<Elem>>::type
+            >::type>::type>::type;
+    };
+}
+
+/// <summary>
+/// Auto Map
+/// </summary>
+namespace cppcbb
+{
+    template<typename Key, typename Value, typename Hints, typename Thresholds>
+    class auto_map_selector
+    {
+    private:
+        using Elem = std::pair<Key, Value>;
+
+        static constexpr size_t k_capacity = Hints::max_size > 0 ? Hints::max_size : 1;
+        static constexpr size_t k_max_key = Hints::max_key > 0 ? (size_t)Hints::max_key : 1;
+
+    public:
+        static constexpr bool is_read_mostly = Hints::read_ratio >= Thresholds::read_mostly_ratio;
+
+    private:
+        static constexpr size_t k_linear_max_size = !std::is_trivially_copyable<Key>::value ? Thresholds::nontrivial_linear_max_size
+            : is_read_mostly ? Thresholds::linear_max_size
+            : Thresholds::write_heavy_linear_max_size;
+
+    public:
+        static constexpr bool is_static = Hints::max_size > 0 && Hints::max_size * sizeof(Elem) <= Thresholds::static_max_bytes;
+
+        //A sparse index is O(1) for every operation, for integral keys with a known, small enough range
+        static constexpr bool is_sparse = !Hints::sorted_keys
+            && std::is_integral<Key>::value
+            && Hints::max_key > 0 && Hints::max_key <= Thresholds::sparse_max_key;
+        static constexpr bool is_static_sparse = is_sparse && is_static
+            && Hints::max_key * sizeof(uint32_t) <= Thresholds::static_max_bytes;
+
+        //Few entries scan fastest, and unordered storage erases in O(1)
+        static constexpr bool is_linear = !Hints::sorted_keys && !is_sparse
+            && Hints::max_size > 0 && Hints::max_size <= k_linear_max_size;
+
+        //Everything else is sorted: operator[] searches before inserting, so past a few dozen entries linear storage
+        //is slower for every operation, while sorted storage only pays O(n) for inserts of new keys
+        static constexpr bool is_sorted = !is_sparse && !is_linear;
+
+        using type =
+            typename std::conditional<is_sparse,
+                typename std::conditional<is_static_sparse, cbb_static_sparse_map<Key, Value, k_max_key, k_capacity>, cbb_sparse_map<Key, Value>>::type,
+            typename std::conditional<is_linear,
+                typename std::conditional<is_static, cbb_static_unordered_vector_map<Key, Value, k_capacity>, cbb_unordered_vector_map<Key, Value>>::type,
+                typename std::conditional<is_static, cbb_static_sorted_vector_map<Key, Value, k_capacity>, cbb_sorted_vector_map<Key, Value>>::type
+            >::type>::type;
+    };
+}
+
+#endif //CPPCBB_INCLUDE_CBB_AUTO_H
@@ -0,0 +1,895 @@
+//Copyright(C) 2020 Henry Bullingham
+//This file is subject to the license terms in the LICENSE file
+//found in the top - level directory of this distribution.
+
+#pragma once
+
+#if !defined (CPPCBB_INCLUDE_CBB_BTREE_MAP_H)
+#define CPPCBB_INCLUDE_CBB_BTREE_MAP_H
+
+#include "cbb_common.hpp"
+#include "cbb_vector.hpp"
+#include "cbb_map.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <type_traits>
+#include <utility>
+
+namespace cppcbb
+{
+    /// <summary>
+    /// Data for B+ tree storage option
+    /// </summary>
+    class default_btree_params
+    {
+    public:
+        //Four cache lines per node
+        static constexpr size_t node_bytes = 256;
+    };
+
+    namespace btree
+    {
+        /// <summary>
+        /// Leaf node, holding sorted entries in a fixed array & linked to its neighbours
+        /// </summary>
+        /// <typeparam name="Elem"></typeparam>
+        /// <typeparam name="Capacity"></typeparam>
+        template<typename Elem, size_t Capacity>
+        class leaf_node;
+
+        /// <summary>
+        /// Branch node, holding sorted separator keys & one more child than keys
+        /// </summary>
+        /// <typeparam name="Key"></typeparam>
+        /// <typeparam name="Capacity">Most children per branch</typeparam>
+        template<typename Key, size_t Capacity>
+        class branch_node;
+
+        /// <summary>
+        /// Forward iterator walking the linked leaves in key order
+        /// </summary>
+        /// <typeparam name="Leaf"></typeparam>
+        /// <typeparam name="Elem">Element, const for a const_iterator</typeparam>
+        template<typename Leaf, typename Elem>
+        class leaf_iterator;
+    }
+
+    /// <summary>
+    /// Stores elements in the leaves of a B+ tree, with nodes sized to a few cache lines
+    /// O(log n) insert
+    /// O(log n) delete
+    /// O(log n) search
+    /// </summary>
+    /// <typeparam name="Key"></typeparam>
+    /// <typeparam name="Value"></typeparam>
+    /// <typeparam name="Params"></typeparam>
+    template<typename Key, typename Value, typename Params = default_btree_params>
+    class btree_pair_storage;
+
+    /// <summary>
+    /// Ordered map with B+ tree storage
+    /// </summary>
+    template<typename Key, typename Value, typename Params = default_btree_params>
+    using cbb_btree_map = cbb_map_impl<Key, Value, btree_pair_storage<Key, Value, Params>>;
+}
+
+/*
+
+    Implementation details
+
+*/
+
+/// <summary>
+/// BTree Nodes
+/// </summary>
+namespace cppcbb
+{
+    namespace btree
+    {
+        template<typename Elem, size_t Capacity>
+        class leaf_node
+        {
+        public:
+            cbb_static_vector<Elem, Capacity> entries;
+            leaf_node* prev = nullptr;
+            leaf_node* next = nullptr;
+        };
+
+        template<typename Key, size_t Capacity>
+        class branch_node
+        {
+        public:
+            //Child i holds keys below keys[i], child i + 1 keys from keys[i] up
+            cbb_static_vector<Key, Capacity - 1> keys;
+            cbb_static_vector<void*, Capacity> children;
+        };
+    }
+}
+
+/// <summary>
+/// BTree Leaf Iterator
+/// </summary>
+namespace cppcbb
+{
+    namespace btree
+    {
+        template<typename Leaf, typename Elem>
+        class leaf_iterator
+        {
+        private:
+            template<typename, typename> friend class leaf_iterator;
+
+            //End is a null leaf
+            Leaf* m_leaf = nullptr;
+            size_t m_idx = 0;
+
+        public:
+            using iterator_category = std::forward_iterator_tag;
+            using value_type = typename std::remove_const<Elem>::type;
+            using difference_type = std::ptrdiff_t;
+            using pointer = Elem*;
+            using reference = Elem&;
+
+            leaf_iterator() {}
+            leaf_iterator(Leaf* leaf, size_t idx)
+                : m_leaf(leaf)
+                , m_idx(idx)
+            {}
+
+            //Mutable to const conversion
+            template<typename OtherLeaf, typename OtherElem, typename = typename std::enable_if<std::is_convertible<OtherElem*, Elem*>::value>::type>
+            leaf_iterator(const leaf_iterator<OtherLeaf, OtherElem>& other)
+                : m_leaf(other.m_leaf)
+                , m_idx(other.m_idx)
+            {}
+
+            //Const to mutable conversion, for the casts in cbb_map_impl
+            explicit operator leaf_iterator<typename std::remove_const<Leaf>::type, value_type>() const
+            {
+                return leaf_iterator<typename std::remove_const<Leaf>::type, value_type>(const_cast<typename std::remove_const<Leaf>::type*>(m_leaf), m_idx);
+            }
+
+            Leaf* leaf() const { return m_leaf; }
+            size_t index() const { return m_idx; }
+
+            Elem& operator*() const { return m_leaf->entries[m_idx]; }
+            Elem* operator->() const { return &m_leaf->entries[m_idx]; }
+
+            leaf_iterator& operator++()
+            {
+                if (++m_idx == m_leaf->entries.size())
+                {
+                    m_leaf = m_leaf->next;
+                    m_idx = 0;
+                }
+                return *this;
+            }
+
+            leaf_iterator operator++(int) { leaf_iterator copy = *this; ++*this; return copy; }
+
+            bool operator==(const leaf_iterator& other) const { return m_leaf == other.m_leaf && m_idx == other.m_idx; }
+            bool operator!=(const leaf_iterator& other) const { return !(*this == other); }
+        };
+    }
+}
+
+/// <summary>
+/// BTree Pair Storage
+/// </summary>
+namespace cppcbb
+{
+    template<typename Key, typename Value, typename Params>
+    class btree_pair_storage
+    {
+    public:
+        using Elem = std::pair<Key, Value>;
+
+    private:
+        static constexpr size_t k_leaf_fit = Params::node_bytes / sizeof(Elem);
+        static constexpr size_t k_branch_fit = Params::node_bytes / (sizeof(Key) + sizeof(void*));
+
+    public:
+        //At least 4 entries / children, so splits & merges keep nodes half full
+        static constexpr size_t leaf_capacity = k_leaf_fit < 4 ? 4 : k_leaf_fit;
+        static constexpr size_t branch_capacity = k_branch_fit < 4 ? 4 : k_branch_fit;
+
+    private:
+        using leaf = btree::leaf_node<Elem, leaf_capacity>;
+        using branch = btree::branch_node<Key, branch_capacity>;
+
+        static constexpr size_t k_min_leaf = leaf_capacity / 2;
+        static constexpr size_t k_min_children = branch_capacity / 2;
+
+        //Branches hold at least 2 children, so a size_t count never needs more levels
+        static constexpr size_t k_max_height = 64;
+
+    public:
+        using iterator = btree::leaf_iterator<leaf, Elem>;
+        using const_iterator = btree::leaf_iterator<const leaf, const Elem>;
+
+    private:
+        //Root is a leaf while m_height is 0, null while empty
+        void* m_root = nullptr;
+        size_t m_height = 0;
+        leaf* m_first = nullptr;
+        size_t m_size = 0;
+
+        //Staging for bulk builds
+        std::unique_ptr<cbb_vector<Elem>> m_bulk;
+
+        //Line size prefetch_node steps by
+        static constexpr size_t k_cache_line = 64;
+
+        //Branches & child slots from the root down to a leaf
+        class path
+        {
+        public:
+            branch* branches[k_max_height];
+            size_t slots[k_max_height];
+        };
+
+        static size_t child_slot(const branch* node, const Key& key, size_t& probes)
+        {
+            return std::upper_bound(node->keys.begin(), node->keys.end(), key,
+                [&](const Key& left, const Key& right) { probes++; return left < right; }) - node->keys.begin();
+        }
+
+        static size_t entry_slot(const leaf* node, const Key& key, size_t& probes)
+        {
+            return std::lower_bound(node->entries.begin(), node->entries.end(), key,
+                [&](const Elem& left, const Key& right) { probes++; return left.first < right; }) - node->entries.begin();
+        }
+
+        //Leaf that would hold key, recording the branches on the way down
+        leaf* descend(const Key& key, path& trail, size_t& probes) const
+        {
+            void* node = m_root;
+            for (size_t level = 0; level < m_height; level++)
+            {
+                branch* parent = static_cast<branch*>(node);
+                size_t slot = child_slot(parent, key, probes);
+                trail.branches[level] = parent;
+                trail.slots[level] = slot;
+                node = parent->children[slot];
+            }
+            return static_cast<leaf*>(node);
+        }
+
+        //Requests every cache line of a node
+        static void prefetch_node(const void* node, size_t bytes)
+        {
+            const char* start = static_cast<const char*>(node);
+            for (size_t offset = 0; offset < bytes; offset += k_cache_line)
+            {
+                CPPCBB_PREFETCH(start + offset);
+            }
+        }
+
+        //Slot past the end of a leaf is the start of the next one
+        static const_iterator leaf_position(const leaf* node, size_t slot)
+        {
+            if (slot == node->entries.size())
+            {
+                return const_iterator(node->next, 0);
+            }
+            return const_iterator(node, slot);
+        }
+
+        void link_after(leaf* left, leaf* right)
+        {
+            right->prev = left;
+            right->next = left->next;
+            if (left->next != nullptr)
+            {
+                left->next->prev = right;
+            }
+            left->next = right;
+        }
+
+        void unlink(leaf* node)
+        {
+            (node->prev == nullptr ? m_first : node->prev->next) = node->next;
+            if (node->next != nullptr)
+            {
+                node->next->prev = node->prev;
+            }
+        }
+
+        //Adds right as the sibling after level's child, splitting full branches up to the root
+        void insert_into_parent(path& trail, size_t level, Key separator, void* right);
+
+        //Fixes an underfull leaf by borrowing from or merging with a sibling
+        void rebalance_leaf(path& trail, leaf* node);
+
+        //Fixes underfull branches from level up to the root
+        void rebalance_branches(path& trail, size_t level);
+
+        void free_node(void* node, size_t height);
+
+        template<typename Iterator>
+        void build(Iterator first, size_t count);
+
+    public:
+        btree_pair_storage() {}
+
+        btree_pair_storage(const btree_pair_storage& other)
+        {
+            build(other.cbegin(), other.m_size);
+        }
+
+        btree_pair_storage(btree_pair_storage&& other) noexcept
+            : m_root(other.m_root)
+            , m_height(other.m_height)
+            , m_first(other.m_first)
+            , m_size(other.m_size)
+        {
+            other.m_root = nullptr;
+            other.m_height = 0;
+            other.m_first = nullptr;
+            other.m_size = 0;
+        }
+
+        btree_pair_storage& operator=(const btree_pair_storage& other)
+        {
+            if (this != &other)
+            {
+                build(other.cbegin(), other.m_size);
+            }
+            return *this;
+        }
+
+        btree_pair_storage& operator=(btree_pair_storage&& other) noexcept
+        {
+            std::swap(m_root, other.m_root);
+            std::swap(m_height, other.m_height);
+            std::swap(m_first, other.m_first);
+            std::swap(m_size, other.m_size);
+            return *this;
+        }
+
+        ~btree_pair_storage()
+        {
+            clear();
+        }
+
+        iterator begin() { return iterator(m_first, 0); }
+        iterator end() { return iterator(); }
+
+        const_iterator cbegin() const { return const_iterator(m_first, 0); }
+        const_iterator cend() const { return const_iterator(); }
+
+        //Finds the iterator for the key
+        const_iterator find(const Key& key) const
+        {
+            size_t probes = 0;
+            return find(key, probes);
+        }
+
+        //Probes counts the keys compared on the way down
+        const_iterator find(const Key& key, size_t& probes) const
+        {
+            if (m_root == nullptr)
+            {
+                return cend();
+            }
+
+            void* node = m_root;
+            for (size_t level = 0; level < m_height; level++)
+            {
+                const branch* parent = static_cast<const branch*>(node);
+                node = parent->children[child_slot(parent, key, probes)];
+            }
+
+            const leaf* found = static_cast<const leaf*>(node);
+            size_t slot = entry_slot(found, key, probes);
+            if (slot != found->entries.size() && found->entries[slot].first == key)
+            {
+                return const_iterator(found, slot);
+            }
+            return cend();
+        }
+
+        //Descends every key of the group a level at a time, prefetching the node each key visits next
+        //so the misses of the whole group are in flight together
+        template<typename KeyIt, typename ResultIt>
+        void find_group(KeyIt keys, size_t count, ResultIt results, size_t* probes) const
+        {
+            if (m_root == nullptr)
+            {
+                for (size_t i = 0; i < count; i++)
+                {
+                    results[i] = cend();
+                }
+                return;
+            }
+
+            const void* nodes[k_find_many_group];
+            std::fill(nodes, nodes + count, m_root);
+            for (size_t level = 0; level < m_height; level++)
+            {
+                const size_t bytes = level + 1 == m_height ? sizeof(leaf) : sizeof(branch);
+                for (size_t i = 0; i < count; i++)
+                {
+                    const branch* parent = static_cast<const branch*>(nodes[i]);
+                    nodes[i] = parent->children[child_slot(parent, keys[i], probes[i])];
+                    prefetch_node(nodes[i], bytes);
+                }
+            }
+
+            for (size_t i = 0; i < count; i++)
+            {
+                const leaf* found = static_cast<const leaf*>(nodes[i]);
+                size_t slot = entry_slot(found, keys[i], probes[i]);
+                bool hit = slot != found->entries.size() && found->entries[slot].first == keys[i];
+                results[i] = hit ? const_iterator(found, slot) : cend();
+            }
+        }
+
+        //First entry with a key not less than key
+        const_iterator lower_bound(const Key& key, size_t& probes) const
+        {
+            if (m_root == nullptr)
+            {
+                return cend();
+            }
+
+            path trail;
+            const leaf* found = descend(key, trail, probes);
+            return leaf_position(found, entry_slot(found, key, probes));
+        }
+
+        //First entry with a key greater than key
+        const_iterator upper_bound(const Key& key, size_t& probes) const
+        {
+            if (m_root == nullptr)
+            {
+                return cend();
+            }
+
+            path trail;
+            const leaf* found = descend(key, trail, probes);
+            size_t slot = std::upper_bound(found->entries.begin(), found->entries.end(), key,
+                [&](const Key& left, const Elem& right) { probes++; return left < right.first; }) - found->entries.begin();
+            return leaf_position(found, slot);
+        }
+
+        //Inserts a new iterator for the key
+        iterator insert(Key key, Value value);
+
+        //Erases the item from the tree, returns the number of entries shifted within its leaf
+        size_t erase(const_iterator elem);
+
+        //Erases the items in [first, last), returns the number of entries shifted within their leaves
+        size_t erase(const_iterator first, const_iterator last);
+
+        //Bulk builds: returns a staging vector resized to size entries, to be filled with sorted unique keys
+        cbb_vector<Elem>& bulk_elements(size_t size)
+        {
+            clear();
+            m_bulk.reset(new cbb_vector<Elem>());
+            m_bulk->resize(size);
+            return *m_bulk;
+        }
+
+        //Builds the tree bottom up from the staged entries, with nodes filled evenly
+        void bulk_commit()
+        {
+            build(m_bulk->cbegin(), m_bulk->size());
+            m_bulk.reset();
+        }
+
+        void clear()
+        {
+            if (m_root != nullptr)
+            {
+                free_node(m_root, m_height);
+            }
+            m_root = nullptr;
+            m_height = 0;
+            m_first = nullptr;
+            m_size = 0;
+        }
+
+        size_t size() const
+        {
+            return m_size;
+        }
+    };
+
+    template<typename Key, typename Value, typename Params>
+    constexpr size_t btree_pair_storage<Key, Value, Params>::leaf_capacity;
+
+    template<typename Key, typename Value, typename Params>
+    constexpr size_t btree_pair_storage<Key, Value, Params>::branch_capacity;
+
+    template<typename Key, typename Value, typename Params>
+    constexpr size_t btree_pair_storage<Key, Value, Params>::k_cache_line;
+
+    template<typename Key, typename Value, typename Params>
+    inline typename btree_pair_storage<Key, Value, Params>::iterator btree_pair_storage<Key, Value, Params>::insert(Key key, Value value)
+    {
+        if (m_root == nullptr)
+        {
+            leaf* root = new leaf();
+            root->entries.push_back(Elem(std::move(key), std::move(value)));
+            m_root = root;
+            m_first = root;
+            m_size = 1;
+            return iterator(root, 0);
+        }
+
+        path trail;
+        size_t probes = 0;
+        leaf* node = descend(key, trail, probes);
+        size_t slot = entry_slot(node, key, probes);
+        if (slot != node->entries.size() && node->entries[slot].first == key)
+        {
+            return iterator(node, slot);
+        }
+
+        m_size++;
+        if (node->entries.size() < leaf_capacity)
+        {
+            node->entries.insert(node->entries.begin() + slot, Elem(std::move(key), std::move(value)));
+            return iterator(node, slot);
+        }
+
+        //Appending past the last leaf leaves it full, so ascending inserts pack the leaves
+        size_t keep = (slot == leaf_capacity && node->next == nullptr) ? leaf_capacity : (leaf_capacity + 1) / 2;
+
+        leaf* right = new leaf();
+        for (size_t i = keep; i < leaf_capacity; i++)
+        {
+            right->entries.push_back(std::move(node->entries[i]));
+        }
+        while (node->entries.size() > keep)
+        {
+            node->entries.pop_back();
+        }
+        link_after(node, right);
+
+        iterator result;
+        if (slot <= keep && keep < leaf_capacity)
+        {
+            node->entries.insert(node->entries.begin() + slot, Elem(std::move(key), std::move(value)));
+            result = iterator(node, slot);
+        }
+        else
+        {
+            right->entries.insert(right->entries.begin() + (slot - keep), Elem(std::move(key), std::move(value)));
+            result = iterator(right, slot - keep);
+        }
+
+        //Splitting branches moves no entries, so the result stays valid
+        insert_into_parent(trail, m_height, right->entries[0].first, right);
+        return result;
+    }
+
+    template<typename Key, typename Value, typename Params>
+    inline void btree_pair_storage<Key, Value, Params>::insert_into_parent(path& trail, size_t level, Key separator, void* right)
+    {
+        while (level > 0)
+        {
+            level--;
+            branch* parent = trail.branches[level];
+            size_t slot = trail.slots[level];
+            if (parent->children.size() < branch_capacity)
+            {
+                parent->keys.insert(parent->keys.begin() + slot, std::move(separator));
+                parent->children.insert(parent->children.begin() + slot + 1, right);
+                return;
+            }
+
+            //Lay out the overfull branch, then split it around the middle key
+            Key keys[branch_capacity];
+            void* children[branch_capacity + 1];
+            std::move(parent->keys.begin(), parent->keys.begin() + slot, keys);
+            keys[slot] = std::move(separator);
+            std::move(parent->keys.begin() + slot, parent->keys.end(), keys + slot + 1);
+            std::copy(parent->children.begin(), parent->children.begin() + slot + 1, children);
+            children[slot + 1] = right;
+            std::copy(parent->children.begin() + slot + 1, parent->children.end(), children + slot + 2);
+
+            const size_t mid = branch_capacity / 2;
+            branch* sibling = new branch();
+            parent->keys.clear();
+            parent->children.clear();
+            for (size_t i = 0; i < mid; i++)
+            {
+                parent->keys.push_back(std::move(keys[i]));
+                parent->children.push_back(children[i]);
+            }
+            parent->children.push_back(children[mid]);
+            for (size_t i = mid + 1; i < branch_capacity; i++)
+            {
+                sibling->keys.push_back(std::move(keys[i]));
+                sibling->children.push_back(children[i]);
+            }
+            sibling->children.push_back(children[branch_capacity]);
+
+            separator = std::move(keys[mid]);
+            right = sibling;
+        }
+
+        //Root split, the tree grows a level
+        branch* root = new branch();
+        root->keys.push_back(std::move(separator));
+        root->children.push_back(m_root);
+        root->children.push_back(right);
+        m_root = root;
+        m_height++;
+    }
+
+    template<typename Key, typename Value, typename Params>
+    inline size_t btree_pair_storage<Key, Value, Params>::erase(const_iterator elem)
+    {
+        path trail;
+        size_t probes = 0;
+        leaf* node = descend(elem->first, trail, probes);
+        size_t slot = elem.index();
+
+        size_t shifts = node->entries.size() - slot - 1;
+        node->entries.erase(node->entries.begin() + slot);
+        m_size--;
+
+        if (m_height == 0)
+        {
+            if (node->entries.size() == 0)
+            {
+                clear();
+            }
+        }
+        else if (node->entries.size() < k_min_leaf)
+        {
+            rebalance_leaf(trail, node);
+        }
+        return shifts;
+    }
+
+    template<typename Key, typename Value, typename Params>
+    inline size_t btree_pair_storage<Key, Value, Params>::erase(const_iterator first, const_iterator last)
+    {
+        size_t count = std::distance(first, last);
+        if (count == 0)
+        {
+            return 0;
+        }
+
+        //Erasing rebalances the leaves under any iterator, so each next entry is found again by key
+        size_t shifts = 0;
+        size_t probes = 0;
+        Key key = first->first;
+        for (size_t i = 0; i < count; i++)
+        {
+            const_iterator elem = lower_bound(key, probes);
+            key = elem->first;
+            shifts += erase(elem);
+        }
+        return shifts;
+    }
+
+    template<typename Key, typename Value, typename Params>
+    inline void btree_pair_storage<Key, Value, Params>::rebalance_leaf(path& trail, leaf* node)
+    {
+        const size_t level = m_height - 1;
+        branch* parent = trail.branches[level];
+        size_t slot = trail.slots[level];
+
+        if (slot + 1 < parent->children.size())
+        {
+            leaf* right = static_cast<leaf*>(parent->children[slot + 1]);
+            if (right->entries.size() > k_min_leaf)
+            {
+                node->entries.push_back(std::move(right->entries[0]));
+                right->entries.erase(right->entries.begin());
+                parent->keys[slot] = right->entries[0].first;
+                return;
+            }
+
+            for (Elem& entry : right->entries)
+            {
+                node->entries.push_back(std::move(entry));
+            }
+            unlink(right);
+            delete right;
+            parent->keys.erase(parent->keys.begin() + slot);
+            parent->children.erase(parent->children.begin() + slot + 1);
+        }
+        else
+        {
+            leaf* left = static_cast<leaf*>(parent->children[slot - 1]);
+            if (left->entries.size() > k_min_leaf)
+            {
+                node->entries.insert(node->entries.begin(), std::move(left->entries.back()));
+                left->entries.pop_back();
+                parent->keys[slot - 1] = node->entries[0].first;
+                return;
+            }
+
+            for (Elem& entry : node->entries)
+            {
+                left->entries.push_back(std::move(entry));
+            }
+            unlink(node);
+            delete node;
+            parent->keys.erase(parent->keys.begin() + slot - 1);
+            parent->children.erase(parent->children.begin() + slot);
+        }
+
+        rebalance_branches(trail, level);
+    }
+
+    template<typename Key, typename Value, typename Params>
+    inline void btree_pair_storage<Key, Value, Params>::rebalance_branches(path& trail, size_t level)
+    {
+        for (;;)
+        {
+            branch* node = trail.branches[level];
+            if (level == 0)
+            {
+                //Root with a single child, the tree loses a level
+                if (node->children.size() == 1)
+                {
+                    m_root = node->children[0];
+                    m_height--;
+                    delete node;
+                }
+                return;
+            }
+
+            if (node->children.size() >= k_min_children)
+            {
+                return;
+            }
+
+            branch* parent = trail.branches[level - 1];
+            size_t slot = trail.slots[level - 1];
+
+            if (slot + 1 < parent->children.size())
+            {
+                branch* right = static_cast<branch*>(parent->children[slot + 1]);
+                if (right->children.size() > k_min_children)
+                {
+                    //Rotate through the separator
+                    node->keys.push_back(std::move(parent->keys[slot]));
+                    node->children.push_back(right->children[0]);
+                    parent->keys[slot] = std::move(right->keys[0]);
+                    right->keys.erase(right->keys.begin());
+                    right->children.erase(right->children.begin());
+                    return;
+                }
+
+                node->keys.push_back(std::move(parent->keys[slot]));
+                for (size_t i = 0; i < right->keys.size(); i++)
+                {
+                    node->keys.push_back(std::move(right->keys[i]));
+                }
+                for (void* child : right->children)
+                {
+                    node->children.push_back(child);
+                }
+                delete right;
+                parent->keys.erase(parent->keys.begin() + slot);
+                parent->children.erase(parent->children.begin() + slot + 1);
+            }
+            else
+            {
+                branch* left = static_cast<branch*>(parent->children[slot - 1]);
+                if (left->children.size() > k_min_children)
+                {
+                    node->keys.insert(node->keys.begin(), std::move(parent->keys[slot - 1]));
+                    node->children.insert(node->children.begin(), left->children.back());
+                    parent->keys[slot - 1] = std::move(left->keys.back());
+                    left->keys.pop_back();
+                    left->children.pop_back();
+                    return;
+                }
+
+                left->keys.push_back(std::move(parent->keys[slot - 1]));
+                for (size_t i = 0; i < node->keys.size(); i++)
+                {
+                    left->keys.push_back(std::move(node->keys[i]));
+                }
+                for (void* child : node->children)
+                {
+                    left->children.push_back(child);
+                }
+                delete node;
+                parent->keys.erase(parent->keys.begin() + slot - 1);
+                parent->children.erase(parent->children.begin() + slot);
+            }
+
+            level--;
+        }
+    }
+
+    template<typename Key, typename Value, typename Params>
+    inline void btree_pair_storage<Key, Value, Params>::free_node(void* node, size_t height)
+    {
+        if (height == 0)
+        {
+            delete static_cast<leaf*>(node);
+            return;
+        }
+
+        branch* parent = static_cast<branch*>(node);
+        for (void* child : parent->children)
+        {
+            free_node(child, height - 1);
+        }
+        delete parent;
+    }
+
+    template<typename Key, typename Value, typename Params>
+    template<typename Iterator>
+    inline void btree_pair_storage<Key, Value, Params>::build(Iterator first, size_t count)
+    {
+        clear();
+        if (count == 0)
+        {
+            return;
+        }
+
+        //Spread the entries evenly, so every node is at least half full
+        size_t leaves = (count + leaf_capacity - 1) / leaf_capacity;
+        cbb_vector<void*> level;
+        cbb_vector<Key> lowest;
+        leaf* prev = nullptr;
+        for (size_t i = 0; i < leaves; i++)
+        {
+            leaf* node = new leaf();
+            size_t entries = count / leaves + (i < count % leaves ? 1 : 0);
+            for (size_t j = 0; j < entries; j++, ++first)
+            {
+                node->entries.push_back(*first);
+            }
+
+            if (prev == nullptr)
+            {
+                m_first = node;
+            }
+            else
+            {
+                link_after(prev, node);
+            }
+            prev = node;
+            level.push_back(node);
+            lowest.push_back(node->entries[0].first);
+        }
+
+        while (level.size() > 1)
+        {
+            size_t branches = (level.size() + branch_capacity - 1) / branch_capacity;
+            cbb_vector<void*> parents;
+            cbb_vector<Key> parent_lowest;
+            size_t child = 0;
+            for (size_t i = 0; i < branches; i++)
+            {
+                branch* node = new branch();
+                size_t children = level.size() / branches + (i < level.size() % branches ? 1 : 0);
+                parent_lowest.push_back(lowest[child]);
+                for (size_t j = 0; j < children; j++, child++)
+                {
+                    if (j > 0)
+                    {
+                        node->keys.push_back(lowest[child]);
+                    }
+                    node->children.push_back(level[child]);
+                }
+                parents.push_back(node);
+            }
+
+            level = std::move(parents);
+            lowest = std::move(parent_lowest);
+            m_height++;
+        }
+
+        m_root = level[0];
+        m_size = count;
+    }
+}
+
+#endif //CPPCBB_INCLUDE_CBB_BTREE_MAP_H
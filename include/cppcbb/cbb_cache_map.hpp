@@ -0,0 +1,396 @@
+//Copyright(C) 2020 Henry Bullingham
+//This file is subject to the license terms in the LICENSE file
+//found in the top - level directory of this distribution.
+
+#pragma once
+
+#if !defined (CPPCBB_INCLUDE_CBB_CACHE_MAP_H)
+#define CPPCBB_INCLUDE_CBB_CACHE_MAP_H
+
+#include "cbb_common.hpp"
+#include "cbb_stats.hpp"
+
+#include <cstdint>
+#include <functional>
+#include <utility>
+
+namespace cppcbb
+{
+    /// <summary>
+    /// Per cache counters, reset with reset_counters()
+    /// </summary>
+    class cache_counters
+    {
+    public:
+        uint64_t hits = 0;
+        uint64_t misses = 0;
+        uint64_t evictions = 0;
+    };
+
+    /// <summary>
+    /// Evicts the least recently used entry, kept in a list linked through slot indices
+    /// O(1) per hit, but each hit relinks the entry
+    /// </summary>
+    /// <typeparam name="Capacity"></typeparam>
+    template<size_t Capacity>
+    class lru_cache_eviction;
+
+    /// <summary>
+    /// Evicts the first entry a clock hand finds without its referenced bit (second chance)
+    /// A hit only sets a bit, the hand clears bits as it sweeps
+    /// O(1) per hit, amortized O(1) per eviction
+    /// </summary>
+    /// <typeparam name="Capacity"></typeparam>
+    template<size_t Capacity>
+    class clock_cache_eviction;
+
+    /// <summary>
+    /// Fixed capacity cache map, evicting an entry to make room once full
+    /// Entries live in static slots found through an open addressed hash index
+    /// Never allocates
+    /// O(1) expected get, put & erase
+    /// </summary>
+    /// <typeparam name="Key"></typeparam>
+    /// <typeparam name="Value"></typeparam>
+    /// <typeparam name="Capacity"></typeparam>
+    /// <typeparam name="Eviction"></typeparam>
+    /// <typeparam name="Hash"></typeparam>
+    /// <typeparam name="Stats">Hot path counters, see cbb_stats.hpp</typeparam>
+    template<typename Key, typename Value, size_t Capacity, typename Eviction = lru_cache_eviction<Capacity>, typename Hash = std::hash<Key>, typename Stats = no_stats>
+    class cbb_cache_map_impl;
+
+    template<typename Key, typename Value, size_t Capacity, typename Eviction, typename Hash, typename OldStats, typename Stats>
+    class rebind_stats<cbb_cache_map_impl<Key, Value, Capacity, Eviction, Hash, OldStats>, Stats>
+    {
+    public:
+        using type = cbb_cache_map_impl<Key, Value, Capacity, Eviction, Hash, Stats>;
+    };
+
+    template<typename Key, typename Value, size_t Capacity, typename Hash = std::hash<Key>>
+    using cbb_lru_map = cbb_cache_map_impl<Key, Value, Capacity, lru_cache_eviction<Capacity>, Hash>;
+
+    template<typename Key, typename Value, size_t Capacity, typename Hash = std::hash<Key>>
+    using cbb_clock_map = cbb_cache_map_impl<Key, Value, Capacity, clock_cache_eviction<Capacity>, Hash>;
+}
+
+/*
+
+    Implementation details
+
+*/
+
+/// <summary>
+/// LRU Cache Eviction
+/// </summary>
+namespace cppcbb
+{
+    template<size_t Capacity>
+    class lru_cache_eviction
+    {
+    private:
+        static constexpr uint32_t k_none = UINT32_MAX;
+
+        //Most recently used first
+        uint32_t m_prev[Capacity];
+        uint32_t m_next[Capacity];
+        uint32_t m_head = k_none;
+        uint32_t m_tail = k_none;
+
+        void unlink(uint32_t slot)
+        {
+            (m_prev[slot] == k_none ? m_head : m_next[m_prev[slot]]) = m_next[slot];
+            (m_next[slot] == k_none ? m_tail : m_prev[m_next[slot]]) = m_prev[slot];
+        }
+
+        void push_front(uint32_t slot)
+        {
+            m_prev[slot] = k_none;
+            m_next[slot] = m_head;
+            (m_head == k_none ? m_tail : m_prev[m_head]) = slot;
+            m_head = slot;
+        }
+
+    public:
+        void on_insert(uint32_t slot) { push_front(slot); }
+
+        void on_hit(uint32_t slot)
+        {
+            if (slot != m_head)
+            {
+                unlink(slot);
+                push_front(slot);
+            }
+        }
+
+        void on_erase(uint32_t slot) { unlink(slot); }
+
+        //Only called while every slot is in use
+        uint32_t victim() { return m_tail; }
+
+        void clear()
+        {
+            m_head = k_none;
+            m_tail = k_none;
+        }
+    };
+}
+
+/// <summary>
+/// CLOCK Cache Eviction
+/// </summary>
+namespace cppcbb
+{
+    template<size_t Capacity>
+    class clock_cache_eviction
+    {
+    private:
+        uint8_t m_referenced[Capacity] = {};
+        uint32_t m_hand = 0;
+
+    public:
+        void on_insert(uint32_t slot) { m_referenced[slot] = 0; }
+        void on_hit(uint32_t slot) { m_referenced[slot] = 1; }
+        void on_erase(uint32_t slot) { m_referenced[slot] = 0; }
+
+        //Only called while every slot is in use
+        uint32_t victim()
+        {
+            while (m_referenced[m_hand] != 0)
+            {
+                m_referenced[m_hand] = 0;
+                m_hand = m_hand + 1 == Capacity ? 0 : m_hand + 1;
+            }
+
+            uint32_t slot = m_hand;
+            m_hand = m_hand + 1 == Capacity ? 0 : m_hand + 1;
+            return slot;
+        }
+
+        void clear()
+        {
+            for (size_t i = 0; i < Capacity; i++)
+            {
+                m_referenced[i] = 0;
+            }
+            m_hand = 0;
+        }
+    };
+}
+
+/// <summary>
+/// Cache Map
+/// </summary>
+namespace cppcbb
+{
+    template<typename Key, typename Value, size_t Capacity, typename Eviction, typename Hash, typename Stats>
+    class cbb_cache_map_impl
+    {
+    public:
+        static_assert(Capacity > 0 && Capacity < UINT32_MAX, "Cache capacity must fit slot indices");
+
+    private:
+        static constexpr uint32_t k_none = UINT32_MAX;
+
+        //At least twice the capacity, so probe runs stay short
+        static constexpr size_t k_bucket_count = bits::next_power_of_two(Capacity * 2);
+        static constexpr size_t k_bucket_mask = k_bucket_count - 1;
+
+        Key m_keys[Capacity];
+        Value m_values[Capacity];
+
+        //Slot index of each bucket, k_none if empty (linear probing)
+        uint32_t m_buckets[k_bucket_count];
+
+        //Stack of unused slots
+        uint32_t m_free[Capacity];
+        size_t m_free_count = Capacity;
+
+        size_t m_size = 0;
+        Eviction m_eviction;
+        cache_counters m_counters;
+        Hash m_hash;
+
+        size_t home(const Key& key) const
+        {
+            //Fibonacci hashing spreads identity hashes over the buckets
+            uint64_t hash = (uint64_t)m_hash(key) * 0x9E3779B97F4A7C15ull;
+            return (size_t)(hash >> 32) & k_bucket_mask;
+        }
+
+        //Bucket holding key, or the empty bucket ending its probe run
+        size_t find_bucket(const Key& key, size_t& probes) const
+        {
+            size_t bucket = home(key);
+            probes = 1;
+            while (m_buckets[bucket] != k_none && !(m_keys[m_buckets[bucket]] == key))
+            {
+                bucket = (bucket + 1) & k_bucket_mask;
+                probes++;
+            }
+            return bucket;
+        }
+
+        //Empties the bucket, shifting later entries of the probe run back so no tombstones are needed
+        void remove_bucket(size_t bucket);
+
+        void evict()
+        {
+            uint32_t slot = m_eviction.victim();
+            size_t probes;
+            remove_bucket(find_bucket(m_keys[slot], probes));
+            m_eviction.on_erase(slot);
+            m_free[m_free_count++] = slot;
+            m_size--;
+            m_counters.evictions++;
+            Stats::on_erase(0);
+        }
+
+    public:
+        cbb_cache_map_impl()
+        {
+            clear();
+        }
+
+        size_t size() const { return m_size; }
+        bool empty() const { return m_size == 0; }
+        size_t capacity() const { return Capacity; }
+
+        const cache_counters& counters() const { return m_counters; }
+        void reset_counters() { m_counters = cache_counters(); }
+
+        //Value of key, marking it used, nullptr on a miss
+        Value* get(const Key& key)
+        {
+            size_t probes;
+            uint32_t slot = m_buckets[find_bucket(key, probes)];
+            Stats::on_find(probes, slot != k_none);
+            if (slot == k_none)
+            {
+                m_counters.misses++;
+                return nullptr;
+            }
+
+            m_counters.hits++;
+            m_eviction.on_hit(slot);
+            return &m_values[slot];
+        }
+
+        //Value of key without marking it used or counting the lookup, nullptr if absent
+        const Value* peek(const Key& key) const
+        {
+            size_t probes;
+            uint32_t slot = m_buckets[find_bucket(key, probes)];
+            return slot == k_none ? nullptr : &m_values[slot];
+        }
+
+        bool contains(const Key& key) const { return peek(key) != nullptr; }
+
+        //Inserts or overwrites key, evicting an entry if the cache is full
+        Value& put(const Key& key, Value value);
+
+        //Returns true if key was present
+        bool erase(const Key& key);
+
+        void clear();
+
+        //Calls func(key, value) for every entry, in no particular order
+        template<typename Func>
+        void for_each(Func func) const
+        {
+            for (size_t bucket = 0; bucket < k_bucket_count; bucket++)
+            {
+                if (m_buckets[bucket] != k_none)
+                {
+                    func(m_keys[m_buckets[bucket]], m_values[m_buckets[bucket]]);
+                }
+            }
+        }
+    };
+
+    template<typename Key, typename Value, size_t Capacity, typename Eviction, typename Hash, typename Stats>
+    inline void cbb_cache_map_impl<Key, Value, Capacity, Eviction, Hash, Stats>::remove_bucket(size_t bucket)
+    {
+        size_t hole = bucket;
+        size_t next = (hole + 1) & k_bucket_mask;
+        while (m_buckets[next] != k_none)
+        {
+            //An entry may fill the hole if the hole lies on its probe run from home to next
+            size_t entry_home = home(m_keys[m_buckets[next]]);
+            if (((next - entry_home) & k_bucket_mask) >= ((next - hole) & k_bucket_mask))
+            {
+                m_buckets[hole] = m_buckets[next];
+                hole = next;
+            }
+            next = (next + 1) & k_bucket_mask;
+        }
+        m_buckets[hole] = k_none;
+    }
+
+    template<typename Key, typename Value, size_t Capacity, typename Eviction, typename Hash, typename Stats>
+    inline Value& cbb_cache_map_impl<Key, Value, Capacity, Eviction, Hash, Stats>::put(const Key& key, Value value)
+    {
+        size_t probes;
+        size_t bucket = find_bucket(key, probes);
+        uint32_t slot = m_buckets[bucket];
+        if (slot != k_none)
+        {
+            m_values[slot] = std::move(value);
+            m_eviction.on_hit(slot);
+            return m_values[slot];
+        }
+
+        if (m_size == Capacity)
+        {
+            //Eviction may shift entries into the bucket found above
+            evict();
+            bucket = find_bucket(key, probes);
+        }
+
+        slot = m_free[--m_free_count];
+        m_keys[slot] = key;
+        m_values[slot] = std::move(value);
+        m_buckets[bucket] = slot;
+        m_eviction.on_insert(slot);
+        m_size++;
+        return m_values[slot];
+    }
+
+    template<typename Key, typename Value, size_t Capacity, typename Eviction, typename Hash, typename Stats>
+    inline bool cbb_cache_map_impl<Key, Value, Capacity, Eviction, Hash, Stats>::erase(const Key& key)
+    {
+        size_t probes;
+        size_t bucket = find_bucket(key, probes);
+        uint32_t slot = m_buckets[bucket];
+        if (slot == k_none)
+        {
+            return false;
+        }
+
+        remove_bucket(bucket);
+        m_eviction.on_erase(slot);
+        m_free[m_free_count++] = slot;
+        m_size--;
+        Stats::on_erase(0);
+        return true;
+    }
+
+    template<typename Key, typename Value, size_t Capacity, typename Eviction, typename Hash, typename Stats>
+    inline void cbb_cache_map_impl<Key, Value, Capacity, Eviction, Hash, Stats>::clear()
+    {
+        for (size_t bucket = 0; bucket < k_bucket_count; bucket++)
+        {
+            m_buckets[bucket] = k_none;
+        }
+
+        //Hand out low slots first
+        for (size_t i = 0; i < Capacity; i++)
+        {
+            m_free[i] = (uint32_t)(Capacity - 1 - i);
+        }
+        m_free_count = Capacity;
+        m_size = 0;
+        m_eviction.clear();
+    }
+}
+
+#endif //CPPCBB_INCLUDE_CBB_CACHE_MAP_H
@@ -38,6 +38,50 @@ Some error handling configuration
 
 #endif
 
+/*
+
+    Constexpr configuration
+
+*/
+
+//C++20 makes the standard algorithms constexpr, so static containers can be built in constant expressions
+#if __cplusplus >= 202002L || (defined(_MSVC_LANG) && _MSVC_LANG >= 202002L)
+#define CPPCBB_HAS_CONSTEXPR_CONTAINERS 1
+#define CPPCBB_CONSTEXPR20 constexpr
+#else
+#define CPPCBB_HAS_CONSTEXPR_CONTAINERS 0
+#define CPPCBB_CONSTEXPR20
+#endif
+
+/*
+
+    Prefetch configuration
+
+*/
+
+//Hints that addr_ will be read soon, so batched lookups can keep several cache misses in flight
+#if defined(__GNUC__) || defined(__clang__)
+#define CPPCBB_PREFETCH(addr_) __builtin_prefetch((const void*)(addr_))
+#elif defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <xmmintrin.h>
+#define CPPCBB_PREFETCH(addr_) _mm_prefetch((const char*)(addr_), _MM_HINT_T0)
+#else
+#define CPPCBB_PREFETCH(addr_) ((void)(addr_))
+#endif
+
+/*
+
+    Bit manipulation helpers
+
+*/
+
+#include <cstddef>
+#include <cstdint>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
 /*
 
     Useful types in this file
@@ -46,6 +90,42 @@ Some error handling configuration
 
 namespace cppcbb
 {
+    namespace bits
+    {
+        /// <summary>
+        /// Index of the lowest set bit, value must be non-zero
+        /// </summary>
+        inline unsigned count_trailing_zeros(uint64_t value);
+
+        /// <summary>
+        /// Number of set bits
+        /// </summary>
+        inline unsigned popcount(uint64_t value);
+
+        /// <summary>
+        /// Number of bits needed to hold value, 0 for 0
+        /// </summary>
+        inline unsigned bit_width(uint64_t value);
+
+        /// <summary>
+        /// Smallest power of two not less than value, usable in constant expressions
+        /// </summary>
+        constexpr size_t next_power_of_two(size_t value, size_t power = 1)
+        {
+            return power >= value ? power : next_power_of_two(value, power * 2);
+        }
+
+        /// <summary>
+        /// Index of the first set bit in [idx, size) of a word array, or size if there is none
+        /// </summary>
+        inline size_t find_next_set(const uint64_t* words, size_t idx, size_t size);
+
+        /// <summary>
+        /// Index of the first clear bit in [idx, size) of a word array, or size if there is none
+        /// </summary>
+        inline size_t find_next_clear(const uint64_t* words, size_t idx, size_t size);
+    }
+
     /// <summary>
     /// Traits for the specific element type
     /// </summary>
@@ -64,6 +144,74 @@ namespace cppcbb
 
 namespace cppcbb
 {
+    namespace bits
+    {
+#if defined(_MSC_VER)
+        inline unsigned count_trailing_zeros(uint64_t value)
+        {
+            unsigned long index;
+            _BitScanForward64(&index, value);
+            return (unsigned)index;
+        }
+
+        inline unsigned popcount(uint64_t value)
+        {
+            return (unsigned)__popcnt64(value);
+        }
+
+        inline unsigned bit_width(uint64_t value)
+        {
+            unsigned long index;
+            return _BitScanReverse64(&index, value) ? (unsigned)index + 1 : 0;
+        }
+#else
+        inline unsigned count_trailing_zeros(uint64_t value)
+        {
+            return (unsigned)__builtin_ctzll(value);
+        }
+
+        inline unsigned popcount(uint64_t value)
+        {
+            return (unsigned)__builtin_popcountll(value);
+        }
+
+        inline unsigned bit_width(uint64_t value)
+        {
+            return value == 0 ? 0 : 64 - (unsigned)__builtin_clzll(value);
+        }
+#endif
+
+        inline size_t find_next_set(const uint64_t* words, size_t idx, size_t size)
+        {
+            while (idx < size)
+            {
+                uint64_t word = words[idx / 64] >> (idx % 64);
+                if (word != 0)
+                {
+                    idx += count_trailing_zeros(word);
+                    break;
+                }
+                idx = (idx / 64 + 1) * 64;
+            }
+            return idx < size ? idx : size;
+        }
+
+        inline size_t find_next_clear(const uint64_t* words, size_t idx, size_t size)
+        {
+            while (idx < size)
+            {
+                uint64_t word = ~words[idx / 64] >> (idx % 64);
+                if (word != 0)
+                {
+                    idx += count_trailing_zeros(word);
+                    break;
+                }
+                idx = (idx / 64 + 1) * 64;
+            }
+            return idx < size ? idx : size;
+        }
+    }
+
     template<typename Elem>
     class default_traits
     {
@@ -0,0 +1,503 @@
+//Copyright(C) 2020 Henry Bullingham
+//This file is subject to the license terms in the LICENSE file
+//found in the top - level directory of this distribution.
+
+#pragma once
+
+#if !defined (CPPCBB_INCLUDE_CBB_DEQUE_H)
+#define CPPCBB_INCLUDE_CBB_DEQUE_H
+
+#include "cbb_common.hpp"
+
+#include <iterator>
+#include <memory>
+#include <type_traits>
+#include <utility>
+
+namespace cppcbb
+{
+    /// <summary>
+    /// Data for block map deque storage
+    /// </summary>
+    class default_deque_storage_params
+    {
+    public:
+        //Elements per block, blocks never move once allocated
+        static constexpr size_t block_size = 64;
+    };
+
+    /// <summary>
+    /// Represents deque storage as a map of fixed size blocks
+    /// Growing copies block pointers only, never elements
+    /// </summary>
+    /// <typeparam name="Elem"></typeparam>
+    /// <typeparam name="Params"></typeparam>
+    template<typename Elem, typename Params = default_deque_storage_params>
+    class block_deque_storage;
+
+    /// <summary>
+    /// Represents deque storage as a fixed capacity ring buffer
+    /// </summary>
+    /// <typeparam name="Elem"></typeparam>
+    template<typename Elem, size_t Capacity = 16>
+    class ring_deque_storage;
+
+    /// <summary>
+    /// Random access iterator over a deque
+    /// </summary>
+    /// <typeparam name="Deque">Deque, const for a const_iterator</typeparam>
+    /// <typeparam name="Elem">Element, const for a const_iterator</typeparam>
+    template<typename Deque, typename Elem>
+    class deque_iterator;
+
+    /// <summary>
+    /// Double ended queue
+    /// O(1) push & pop at both ends
+    /// O(1) indexed access
+    /// </summary>
+    /// <typeparam name="Elem"></typeparam>
+    /// <typeparam name="Storage"></typeparam>
+    template<typename Elem, typename Storage = block_deque_storage<Elem>>
+    class cbb_deque_impl;
+
+    template<typename Elem, typename Params = default_deque_storage_params>
+    using cbb_deque = cbb_deque_impl<Elem, block_deque_storage<Elem, Params>>;
+
+    template<typename Elem, size_t Capacity = 16>
+    using cbb_static_deque = cbb_deque_impl<Elem, ring_deque_storage<Elem, Capacity>>;
+}
+
+/*
+
+    Implementation details
+
+*/
+
+/// <summary>
+/// Block Deque Storage
+/// </summary>
+namespace cppcbb
+{
+    template<typename Elem, typename Params>
+    class block_deque_storage
+    {
+    private:
+        static constexpr size_t k_block_size = Params::block_size;
+
+        //Blocks in use are a contiguous run of the map, positions count from the start of the map
+        std::unique_ptr<std::unique_ptr<Elem[]>[]> m_map;
+        size_t m_map_size = 0;
+
+        void ensure_block(size_t block)
+        {
+            if (m_map[block] == nullptr)
+            {
+                m_map[block].reset(new Elem[k_block_size]());
+            }
+        }
+
+        //Moves the run of blocks in use to the middle of a map with room on both sides
+        void recenter(size_t& head, size_t size);
+
+    public:
+        block_deque_storage() {}
+
+        block_deque_storage(block_deque_storage&& other) noexcept
+            : m_map(std::move(other.m_map))
+            , m_map_size(other.m_map_size)
+        {
+            other.m_map_size = 0;
+        }
+
+        block_deque_storage& operator=(block_deque_storage&& other) noexcept
+        {
+            std::swap(m_map, other.m_map);
+            std::swap(m_map_size, other.m_map_size);
+            return *this;
+        }
+
+        size_t initial_head() const { return 0; }
+        size_t capacity() const { return m_map_size * k_block_size; }
+
+        Elem& slot(size_t head, size_t idx)
+        {
+            size_t pos = head + idx;
+            return m_map[pos / k_block_size][pos % k_block_size];
+        }
+
+        const Elem& slot(size_t head, size_t idx) const
+        {
+            size_t pos = head + idx;
+            return m_map[pos / k_block_size][pos % k_block_size];
+        }
+
+        //Elements stored contiguously from idx
+        size_t run_length(size_t head, size_t idx) const
+        {
+            return k_block_size - (head + idx) % k_block_size;
+        }
+
+        size_t advance_head(size_t head) const { return head + 1; }
+
+        bool make_front_room(size_t& head, size_t size)
+        {
+            if (head == 0)
+            {
+                recenter(head, size);
+            }
+            head--;
+            ensure_block(head / k_block_size);
+            return true;
+        }
+
+        bool make_back_room(size_t& head, size_t size)
+        {
+            if ((head + size) / k_block_size >= m_map_size)
+            {
+                recenter(head, size);
+            }
+            ensure_block((head + size) / k_block_size);
+            return true;
+        }
+    };
+
+    template<typename Elem, typename Params>
+    inline void block_deque_storage<Elem, Params>::recenter(size_t& head, size_t size)
+    {
+        size_t first_block = head / k_block_size;
+        size_t block_count = size == 0 ? 0 : (head + size - 1) / k_block_size - first_block + 1;
+
+        //Double the map once the blocks in use & one spare either side fill half of it
+        size_t needed = block_count + 2;
+        size_t map_size = m_map_size;
+        if (needed * 2 > map_size)
+        {
+            map_size = map_size * 2 > needed * 2 ? map_size * 2 : needed * 2;
+        }
+
+        std::unique_ptr<std::unique_ptr<Elem[]>[]> map(new std::unique_ptr<Elem[]>[map_size]);
+        size_t new_first_block = (map_size - block_count) / 2;
+        for (size_t i = 0; i < block_count; i++)
+        {
+            map[new_first_block + i] = std::move(m_map[first_block + i]);
+        }
+
+        //Keep spare blocks for reuse, filling the free slots after the blocks in use first
+        size_t free_slot = new_first_block + block_count;
+        for (size_t i = 0; i < m_map_size; i++)
+        {
+            if (m_map[i] == nullptr)
+            {
+                continue;
+            }
+            if (free_slot == map_size)
+            {
+                free_slot = 0;
+            }
+            map[free_slot++] = std::move(m_map[i]);
+        }
+
+        m_map = std::move(map);
+        m_map_size = map_size;
+        head = new_first_block * k_block_size + head % k_block_size;
+    }
+}
+
+/// <summary>
+/// Ring Deque Storage
+/// </summary>
+namespace cppcbb
+{
+    template<typename Elem, size_t Capacity>
+    class ring_deque_storage
+    {
+    private:
+        Elem m_data[Capacity];
+
+        static size_t wrap(size_t pos) { return pos >= Capacity ? pos - Capacity : pos; }
+
+    public:
+        size_t initial_head() const { return 0; }
+        size_t capacity() const { return Capacity; }
+
+        Elem& slot(size_t head, size_t idx) { return m_data[wrap(head + idx)]; }
+        const Elem& slot(size_t head, size_t idx) const { return m_data[wrap(head + idx)]; }
+
+        size_t run_length(size_t head, size_t idx) const
+        {
+            return Capacity - wrap(head + idx);
+        }
+
+        size_t advance_head(size_t head) const { return wrap(head + 1); }
+
+        bool make_front_room(size_t& head, size_t size)
+        {
+            if (size == Capacity)
+            {
+                return false;
+            }
+            head = head == 0 ? Capacity - 1 : head - 1;
+            return true;
+        }
+
+        bool make_back_room(size_t& head, size_t size) const
+        {
+            return size < Capacity;
+        }
+    };
+}
+
+/// <summary>
+/// Deque Iterator
+/// </summary>
+namespace cppcbb
+{
+    template<typename Deque, typename Elem>
+    class deque_iterator
+    {
+    private:
+        template<typename, typename> friend class deque_iterator;
+
+        Deque* m_deque = nullptr;
+        size_t m_idx = 0;
+
+    public:
+        using iterator_category = std::random_access_iterator_tag;
+        using value_type = typename std::remove_const<Elem>::type;
+        using difference_type = std::ptrdiff_t;
+        using pointer = Elem*;
+        using reference = Elem&;
+
+        deque_iterator() {}
+        deque_iterator(Deque* deque, size_t idx)
+            : m_deque(deque)
+            , m_idx(idx)
+        {}
+
+        //Mutable to const conversion
+        template<typename OtherDeque, typename OtherElem>
+        deque_iterator(const deque_iterator<OtherDeque, OtherElem>& other)
+            : m_deque(other.m_deque)
+            , m_idx(other.m_idx)
+        {}
+
+        size_t index() const { return m_idx; }
+
+        Elem& operator*() const { return (*m_deque)[m_idx]; }
+        Elem* operator->() const { return &(*m_deque)[m_idx]; }
+        Elem& operator[](difference_type n) const { return (*m_deque)[m_idx + n]; }
+
+        deque_iterator& operator++() { ++m_idx; return *this; }
+        deque_iterator& operator--() { --m_idx; return *this; }
+        deque_iterator operator++(int) { deque_iterator copy = *this; ++m_idx; return copy; }
+        deque_iterator operator--(int) { deque_iterator copy = *this; --m_idx; return copy; }
+
+        deque_iterator& operator+=(difference_type n) { m_idx += n; return *this; }
+        deque_iterator& operator-=(difference_type n) { m_idx -= n; return *this; }
+        deque_iterator operator+(difference_type n) const { return deque_iterator(m_deque, m_idx + n); }
+        deque_iterator operator-(difference_type n) const { return deque_iterator(m_deque, m_idx - n); }
+        difference_type operator-(const deque_iterator& other) const { return (difference_type)m_idx - (difference_type)other.m_idx; }
+
+        bool operator==(const deque_iterator& other) const { return m_idx == other.m_idx; }
+        bool operator!=(const deque_iterator& other) const { return m_idx != other.m_idx; }
+        bool operator<(const deque_iterator& other) const { return m_idx < other.m_idx; }
+        bool operator>(const deque_iterator& other) const { return m_idx > other.m_idx; }
+        bool operator<=(const deque_iterator& other) const { return m_idx <= other.m_idx; }
+        bool operator>=(const deque_iterator& other) const { return m_idx >= other.m_idx; }
+    };
+}
+
+/// <summary>
+/// Deque
+/// </summary>
+namespace cppcbb
+{
+    template<typename Elem, typename Storage>
+    class cbb_deque_impl
+    {
+    public:
+        using self_type = cbb_deque_impl<Elem, Storage>;
+        using value_type = Elem;
+        using iterator = deque_iterator<self_type, Elem>;
+        using const_iterator = deque_iterator<const self_type, const Elem>;
+
+    private:
+        Storage m_storage;
+        size_t m_head = m_storage.initial_head();
+        size_t m_size = 0;
+
+    public:
+        cbb_deque_impl() {}
+
+        cbb_deque_impl(const self_type& other)
+        {
+            for (const Elem& e : other)
+            {
+                push_back(e);
+            }
+        }
+
+        cbb_deque_impl(self_type&& other) noexcept
+            : m_storage(std::move(other.m_storage))
+            , m_head(other.m_head)
+            , m_size(other.m_size)
+        {
+            other.m_head = other.m_storage.initial_head();
+            other.m_size = 0;
+        }
+
+        self_type& operator=(const self_type& other)
+        {
+            if (this != &other)
+            {
+                clear();
+                for (const Elem& e : other)
+                {
+                    push_back(e);
+                }
+            }
+            return *this;
+        }
+
+        self_type& operator=(self_type&& other) noexcept
+        {
+            std::swap(m_storage, other.m_storage);
+            std::swap(m_head, other.m_head);
+            std::swap(m_size, other.m_size);
+            return *this;
+        }
+
+        iterator begin() { return iterator(this, 0); }
+        iterator end() { return iterator(this, m_size); }
+
+        const_iterator begin() const { return const_iterator(this, 0); }
+        const_iterator end() const { return const_iterator(this, m_size); }
+
+        const_iterator cbegin() const { return begin(); }
+        const_iterator cend() const { return end(); }
+
+        size_t size() const { return m_size; }
+        bool empty() const { return m_size == 0; }
+        size_t capacity() const { return m_storage.capacity(); }
+
+        void push_back(const Elem& elem)
+        {
+            CPPCBB_ASSERT(m_storage.make_back_room(m_head, m_size), "Not enough storage!");
+            m_storage.slot(m_head, m_size) = elem;
+            m_size++;
+        }
+
+        void push_back(Elem&& elem)
+        {
+            CPPCBB_ASSERT(m_storage.make_back_room(m_head, m_size), "Not enough storage!");
+            m_storage.slot(m_head, m_size) = std::move(elem);
+            m_size++;
+        }
+
+        template<typename ... Args>
+        void emplace_back(Args&& ... args)
+        {
+            push_back(Elem(std::forward<Args>(args)...));
+        }
+
+        void push_front(const Elem& elem)
+        {
+            CPPCBB_ASSERT(m_storage.make_front_room(m_head, m_size), "Not enough storage!");
+            m_storage.slot(m_head, 0) = elem;
+            m_size++;
+        }
+
+        void push_front(Elem&& elem)
+        {
+            CPPCBB_ASSERT(m_storage.make_front_room(m_head, m_size), "Not enough storage!");
+            m_storage.slot(m_head, 0) = std::move(elem);
+            m_size++;
+        }
+
+        template<typename ... Args>
+        void emplace_front(Args&& ... args)
+        {
+            push_front(Elem(std::forward<Args>(args)...));
+        }
+
+        void pop_back()
+        {
+            CPPCBB_ASSERT((m_size > 0), "No elements in deque!");
+            m_size--;
+        }
+
+        void pop_front()
+        {
+            CPPCBB_ASSERT((m_size > 0), "No elements in deque!");
+            m_head = m_storage.advance_head(m_head);
+            m_size--;
+        }
+
+        Elem& front()
+        {
+            CPPCBB_ASSERT((m_size > 0), "No elements in deque!");
+            return m_storage.slot(m_head, 0);
+        }
+
+        const Elem& front() const
+        {
+            CPPCBB_ASSERT((m_size > 0), "No elements in deque!");
+            return m_storage.slot(m_head, 0);
+        }
+
+        Elem& back()
+        {
+            CPPCBB_ASSERT((m_size > 0), "No elements in deque!");
+            return m_storage.slot(m_head, m_size - 1);
+        }
+
+        const Elem& back() const
+        {
+            CPPCBB_ASSERT((m_size > 0), "No elements in deque!");
+            return m_storage.slot(m_head, m_size - 1);
+        }
+
+        void clear() { m_size = 0; }
+
+        //Calls func(first, last) for each contiguous run of elements, in order
+        template<typename Func>
+        void for_each_segment(Func func)
+        {
+            for (size_t idx = 0; idx < m_size;)
+            {
+                size_t run = m_storage.run_length(m_head, idx);
+                run = run < m_size - idx ? run : m_size - idx;
+                Elem* first = &m_storage.slot(m_head, idx);
+                func(first, first + run);
+                idx += run;
+            }
+        }
+
+        template<typename Func>
+        void for_each_segment(Func func) const
+        {
+            for (size_t idx = 0; idx < m_size;)
+            {
+                size_t run = m_storage.run_length(m_head, idx);
+                run = run < m_size - idx ? run : m_size - idx;
+                const Elem* first = &m_storage.slot(m_head, idx);
+                func(first, first + run);
+                idx += run;
+            }
+        }
+
+        Elem& operator[](size_t idx)
+        {
+            CPPCBB_ASSERT((idx < m_size), "Out of bounds access!");
+            return m_storage.slot(m_head, idx);
+        }
+
+        const Elem& operator[](size_t idx) const
+        {
+            CPPCBB_ASSERT((idx < m_size), "Out of bounds access!");
+            return m_storage.slot(m_head, idx);
+        }
+    };
+}
+
+#endif //CPPCBB_INCLUDE_CBB_DEQUE_H
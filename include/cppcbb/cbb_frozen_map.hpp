@@ -0,0 +1,412 @@
+//Copyright(C) 2020 Henry Bullingham
+//This file is subject to the license terms in the LICENSE file
+//found in the top - level directory of this distribution.
+
+#pragma once
+
+#if !defined (CPPCBB_INCLUDE_CBB_FROZEN_MAP_H)
+#define CPPCBB_INCLUDE_CBB_FROZEN_MAP_H
+
+#include "cbb_common.hpp"
+#include "cbb_vector.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <iterator>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace cppcbb
+{
+    /// <summary>
+    /// Data for frozen maps
+    /// </summary>
+    class default_frozen_map_params
+    {
+    public:
+        //Entries per compressed block, lookups decode at most one block
+        static constexpr size_t block_size = 64;
+    };
+
+    /// <summary>
+    /// Read only map of unsigned integers, compressed in blocks
+    /// Each block keeps its first key in a skip index, then bit packs the gaps between keys
+    /// and the values less the block minimum, each at the narrowest width the block needs
+    /// O(log(n / block_size) + block_size) find & lower_bound
+    /// O(1) per entry sequential decode
+    /// </summary>
+    /// <typeparam name="Key">Unsigned integer</typeparam>
+    /// <typeparam name="Value">Unsigned integer</typeparam>
+    /// <typeparam name="Params"></typeparam>
+    template<typename Key, typename Value, typename Params = default_frozen_map_params>
+    class cbb_frozen_map;
+}
+
+/*
+
+    Implementation details
+
+*/
+
+/// <summary>
+/// Frozen Map
+/// </summary>
+namespace cppcbb
+{
+    template<typename Key, typename Value, typename Params>
+    class cbb_frozen_map
+    {
+    public:
+        static_assert(std::is_integral<Key>::value && std::is_unsigned<Key>::value, "Frozen map keys must be unsigned integers");
+        static_assert(std::is_integral<Value>::value && std::is_unsigned<Value>::value, "Frozen map values must be unsigned integers");
+
+    private:
+        static constexpr size_t k_block_size = Params::block_size;
+
+        class block
+        {
+        public:
+            //Key gaps (less one) for entries 1.., then values for entries 0..
+            size_t bit_offset;
+            uint64_t min_value;
+            uint8_t key_bits;
+            uint8_t value_bits;
+        };
+
+        cbb_vector<Key> m_first_keys;
+        cbb_vector<block> m_blocks;
+        cbb_vector<uint64_t> m_words;
+        size_t m_size = 0;
+
+        size_t block_count(size_t b) const
+        {
+            size_t start = b * k_block_size;
+            return m_size - start < k_block_size ? m_size - start : k_block_size;
+        }
+
+        static uint64_t read_bits(const uint64_t* words, size_t bit, unsigned width)
+        {
+            if (width == 0)
+            {
+                return 0;
+            }
+
+            size_t w = bit / 64;
+            unsigned shift = (unsigned)(bit % 64);
+            uint64_t value = words[w] >> shift;
+            if (shift + width > 64)
+            {
+                value |= words[w + 1] << (64 - shift);
+            }
+            return width == 64 ? value : value & (((uint64_t)1 << width) - 1);
+        }
+
+        void write_bits(size_t bit, uint64_t value, unsigned width)
+        {
+            if (width == 0)
+            {
+                return;
+            }
+
+            while (m_words.size() * 64 < bit + width)
+            {
+                m_words.push_back(0);
+            }
+
+            size_t w = bit / 64;
+            unsigned shift = (unsigned)(bit % 64);
+            m_words[w] |= value << shift;
+            if (shift + width > 64)
+            {
+                m_words[w + 1] |= value >> (64 - shift);
+            }
+        }
+
+        //Fixed width unpack of count fields, a plain loop the compiler can unroll & vectorize
+        static void unpack(const uint64_t* words, size_t bit, unsigned width, size_t count, uint64_t* out)
+        {
+            for (size_t i = 0; i < count; i++)
+            {
+                out[i] = read_bits(words, bit + i * width, width);
+            }
+        }
+
+        const uint64_t* words() const { return m_words.size() == 0 ? nullptr : &m_words[0]; }
+
+        Key key_gap(size_t b, size_t pos) const
+        {
+            const block& header = m_blocks[b];
+            return (Key)(read_bits(words(), header.bit_offset + (pos - 1) * header.key_bits, header.key_bits) + 1);
+        }
+
+        Value value_at(size_t b, size_t pos) const
+        {
+            const block& header = m_blocks[b];
+            size_t values_offset = header.bit_offset + (block_count(b) - 1) * header.key_bits;
+            return (Value)(header.min_value + read_bits(words(), values_offset + pos * header.value_bits, header.value_bits));
+        }
+
+        void append_block(const Key* keys, const Value* values, size_t count);
+
+    public:
+        using value_type = std::pair<Key, Value>;
+
+        /// <summary>
+        /// Forward iterator decoding one entry at a time
+        /// </summary>
+        class const_iterator
+        {
+        private:
+            const cbb_frozen_map* m_map = nullptr;
+            size_t m_block = 0;
+            size_t m_pos = 0;
+            Key m_key = 0;
+
+        public:
+            using iterator_category = std::forward_iterator_tag;
+            using value_type = std::pair<Key, Value>;
+            using difference_type = std::ptrdiff_t;
+            using reference = value_type;
+            using pointer = void;
+
+            const_iterator() {}
+            const_iterator(const cbb_frozen_map* map, size_t block)
+                : m_map(map)
+                , m_block(block)
+                , m_key(block < map->m_blocks.size() ? map->m_first_keys[block] : 0)
+            {}
+
+            //Entry pos of block, whose key is already decoded
+            const_iterator(const cbb_frozen_map* map, size_t block, size_t pos, Key key)
+                : m_map(map)
+                , m_block(block)
+                , m_pos(pos)
+                , m_key(key)
+            {}
+
+            Key key() const { return m_key; }
+            Value value() const { return m_map->value_at(m_block, m_pos); }
+            reference operator*() const { return reference(key(), value()); }
+
+            const_iterator& operator++()
+            {
+                if (++m_pos == m_map->block_count(m_block))
+                {
+                    *this = const_iterator(m_map, m_block + 1);
+                }
+                else
+                {
+                    m_key += m_map->key_gap(m_block, m_pos);
+                }
+                return *this;
+            }
+
+            const_iterator operator++(int)
+            {
+                const_iterator copy = *this;
+                ++(*this);
+                return copy;
+            }
+
+            bool operator==(const const_iterator& other) const { return m_block == other.m_block && m_pos == other.m_pos; }
+            bool operator!=(const const_iterator& other) const { return !(*this == other); }
+        };
+
+        using iterator = const_iterator;
+
+        cbb_frozen_map() {}
+
+        const_iterator begin() const { return const_iterator(this, 0); }
+        const_iterator end() const { return const_iterator(this, m_blocks.size()); }
+
+        const_iterator cbegin() const { return begin(); }
+        const_iterator cend() const { return end(); }
+
+        size_t size() const { return m_size; }
+        bool empty() const { return m_size == 0; }
+
+        //Bytes held by the compressed blocks & skip index
+        size_t memory_bytes() const
+        {
+            return m_first_keys.size() * sizeof(Key) + m_blocks.size() * sizeof(block) + m_words.size() * sizeof(uint64_t);
+        }
+
+        void clear()
+        {
+            m_first_keys.clear();
+            m_blocks.clear();
+            m_words.clear();
+            m_size = 0;
+        }
+
+        //Replaces the entries with a range of pairs sorted by key, with unique keys
+        template<typename Iterator>
+        void assign_sorted(Iterator first, Iterator last);
+
+        //Replaces the entries with those of any map, sorting them first if its iteration isn't ordered
+        template<typename Map>
+        void assign(const Map& map);
+
+        //First entry with a key not less than key
+        const_iterator lower_bound(Key key) const;
+
+        const_iterator find(Key key) const
+        {
+            const_iterator it = lower_bound(key);
+            return it != end() && it.key() == key ? it : end();
+        }
+
+        bool contains(Key key) const { return find(key) != end(); }
+
+        //Calls func(key, value) for every entry in order, unpacking a block at a time
+        template<typename Func>
+        void for_each(Func func) const;
+    };
+
+    template<typename Key, typename Value, typename Params>
+    inline void cbb_frozen_map<Key, Value, Params>::append_block(const Key* keys, const Value* values, size_t count)
+    {
+        uint64_t max_gap = 0;
+        for (size_t i = 1; i < count; i++)
+        {
+            CPPCBB_ASSERT((keys[i - 1] < keys[i]), "Frozen map keys must be sorted & unique!");
+            max_gap = std::max<uint64_t>(max_gap, (uint64_t)(keys[i] - keys[i - 1]) - 1);
+        }
+
+        uint64_t min_value = *std::min_element(values, values + count);
+        uint64_t max_value = *std::max_element(values, values + count);
+
+        block header;
+        header.bit_offset = m_blocks.size() == 0 ? 0 : m_blocks.back().bit_offset
+            + (k_block_size - 1) * m_blocks.back().key_bits + k_block_size * m_blocks.back().value_bits;
+        header.min_value = min_value;
+        header.key_bits = (uint8_t)bits::bit_width(max_gap);
+        header.value_bits = (uint8_t)bits::bit_width(max_value - min_value);
+
+        size_t bit = header.bit_offset;
+        for (size_t i = 1; i < count; i++, bit += header.key_bits)
+        {
+            write_bits(bit, (uint64_t)(keys[i] - keys[i - 1]) - 1, header.key_bits);
+        }
+        for (size_t i = 0; i < count; i++, bit += header.value_bits)
+        {
+            write_bits(bit, (uint64_t)values[i] - min_value, header.value_bits);
+        }
+
+        m_first_keys.push_back(keys[0]);
+        m_blocks.push_back(header);
+        m_size += count;
+    }
+
+    template<typename Key, typename Value, typename Params>
+    template<typename Iterator>
+    inline void cbb_frozen_map<Key, Value, Params>::assign_sorted(Iterator first, Iterator last)
+    {
+        clear();
+
+        Key keys[k_block_size];
+        Value values[k_block_size];
+        size_t count = 0;
+        for (; first != last; ++first)
+        {
+            if (count > 0)
+            {
+                CPPCBB_ASSERT((keys[count - 1] < first->first), "Frozen map keys must be sorted & unique!");
+            }
+            else if (m_size > 0)
+            {
+                CPPCBB_ASSERT((m_first_keys.back() < first->first), "Frozen map keys must be sorted & unique!");
+            }
+
+            keys[count] = first->first;
+            values[count] = first->second;
+            if (++count == k_block_size)
+            {
+                append_block(keys, values, count);
+                count = 0;
+            }
+        }
+
+        if (count > 0)
+        {
+            append_block(keys, values, count);
+        }
+    }
+
+    template<typename Key, typename Value, typename Params>
+    template<typename Map>
+    inline void cbb_frozen_map<Key, Value, Params>::assign(const Map& map)
+    {
+        std::vector<value_type> entries;
+        entries.reserve(map.size());
+        for (const auto& entry : map)
+        {
+            entries.push_back(value_type(entry.first, entry.second));
+        }
+
+        auto by_key = [](const value_type& a, const value_type& b) { return a.first < b.first; };
+        if (!std::is_sorted(entries.begin(), entries.end(), by_key))
+        {
+            std::sort(entries.begin(), entries.end(), by_key);
+        }
+        assign_sorted(entries.begin(), entries.end());
+    }
+
+    template<typename Key, typename Value, typename Params>
+    inline typename cbb_frozen_map<Key, Value, Params>::const_iterator cbb_frozen_map<Key, Value, Params>::lower_bound(Key key) const
+    {
+        if (m_size == 0 || key <= m_first_keys[0])
+        {
+            return begin();
+        }
+
+        //Last block starting at or before key, the answer is in it or starts the next one
+        const Key* first_keys = &m_first_keys[0];
+        size_t b = (size_t)(std::upper_bound(first_keys, first_keys + m_first_keys.size(), key) - first_keys) - 1;
+
+        const block& header = m_blocks[b];
+        size_t count = block_count(b);
+        const uint64_t* w = words();
+        size_t bit = header.bit_offset;
+        Key current = m_first_keys[b];
+        size_t pos = 0;
+        while (current < key)
+        {
+            if (++pos == count)
+            {
+                return const_iterator(this, b + 1);
+            }
+            current += (Key)(read_bits(w, bit, header.key_bits) + 1);
+            bit += header.key_bits;
+        }
+        return const_iterator(this, b, pos, current);
+    }
+
+    template<typename Key, typename Value, typename Params>
+    template<typename Func>
+    inline void cbb_frozen_map<Key, Value, Params>::for_each(Func func) const
+    {
+        uint64_t gaps[k_block_size];
+        uint64_t values[k_block_size];
+        for (size_t b = 0; b < m_blocks.size(); b++)
+        {
+            const block& header = m_blocks[b];
+            size_t count = block_count(b);
+            unpack(words(), header.bit_offset, header.key_bits, count - 1, gaps);
+            unpack(words(), header.bit_offset + (count - 1) * header.key_bits, header.value_bits, count, values);
+
+            Key key = m_first_keys[b];
+            for (size_t i = 0; i < count; i++)
+            {
+                if (i > 0)
+                {
+                    key += (Key)(gaps[i - 1] + 1);
+                }
+                func(key, (Value)(header.min_value + values[i]));
+            }
+        }
+    }
+}
+
+#endif //CPPCBB_INCLUDE_CBB_FROZEN_MAP_H
@@ -0,0 +1,545 @@
+//Copyright(C) 2020 Henry Bullingham
+//This file is subject to the license terms in the LICENSE file
+//found in the top - level directory of this distribution.
+
+#pragma once
+
+#if !defined (CPPCBB_INCLUDE_CBB_HEAP_H)
+#define CPPCBB_INCLUDE_CBB_HEAP_H
+
+#include "cbb_common.hpp"
+#include "cbb_vector.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <utility>
+
+namespace cppcbb
+{
+    /// <summary>
+    /// Sift operations on an implicit d-ary heap
+    /// Elements are moved into a hole instead of swapped, and moved(idx) is called for every element placed at idx
+    /// </summary>
+    /// <typeparam name="Arity">Children per node, 4 keeps the children of a node within one cache line for small elements</typeparam>
+    template<size_t Arity>
+    class dary_heap;
+
+    /// <summary>
+    /// Represents heap vector management (the elements are kept in d-ary heap order)
+    /// The element at begin is the one that no other element compares greater than
+    /// O(log n) insert
+    /// O(log n) delete
+    /// O(1) top
+    /// </summary>
+    /// <typeparam name="Elem"></typeparam>
+    /// <typeparam name="Traits"></typeparam>
+    /// <typeparam name="Arity"></typeparam>
+    /// <typeparam name="Compare"></typeparam>
+    template<typename Elem, typename Traits = default_traits<Elem>, size_t Arity = 2, typename Compare = std::less<Elem>>
+    class heap_vec_management;
+
+    /// <summary>
+    /// Priority queue over a heap managed vector
+    /// </summary>
+    /// <typeparam name="Elem"></typeparam>
+    /// <typeparam name="Vector"></typeparam>
+    template<typename Elem, typename Vector>
+    class cbb_priority_queue_impl;
+
+    template<typename Elem, typename Vector, typename Stats>
+    class rebind_stats<cbb_priority_queue_impl<Elem, Vector>, Stats>
+    {
+    public:
+        using type = cbb_priority_queue_impl<Elem, typename rebind_stats<Vector, Stats>::type>;
+    };
+
+    template<typename Elem, typename Compare = std::less<Elem>, typename Traits = default_traits<Elem>>
+    using cbb_priority_queue =
+        cbb_priority_queue_impl<Elem
+            , cbb_vector_impl<Elem, Traits, dynamic_vec_storage<Elem, Traits>, heap_vec_management<Elem, Traits, 2, Compare>>
+        >;
+
+    template<typename Elem, size_t Capacity = 16, typename Compare = std::less<Elem>, typename Traits = default_traits<Elem>>
+    using cbb_static_priority_queue =
+        cbb_priority_queue_impl<Elem
+            , cbb_vector_impl<Elem, Traits, static_vec_storage<Elem, Capacity, Traits>, heap_vec_management<Elem, Traits, 2, Compare>>
+        >;
+
+    template<typename Elem, typename Compare = std::less<Elem>, typename Traits = default_traits<Elem>>
+    using cbb_quad_priority_queue =
+        cbb_priority_queue_impl<Elem
+            , cbb_vector_impl<Elem, Traits, dynamic_vec_storage<Elem, Traits>, heap_vec_management<Elem, Traits, 4, Compare>>
+        >;
+
+    template<typename Elem, size_t Capacity = 16, typename Compare = std::less<Elem>, typename Traits = default_traits<Elem>>
+    using cbb_static_quad_priority_queue =
+        cbb_priority_queue_impl<Elem
+            , cbb_vector_impl<Elem, Traits, static_vec_storage<Elem, Capacity, Traits>, heap_vec_management<Elem, Traits, 4, Compare>>
+        >;
+
+    /// <summary>
+    /// Entry of an indexed heap
+    /// </summary>
+    template<typename Priority>
+    class indexed_heap_entry;
+
+    /// <summary>
+    /// Heap of integer ids keyed by priority, tracking where each id is so its priority can change
+    /// With the default compare the smallest priority is on top (as used by Dijkstra style schedulers)
+    /// O(log n) push / pop / update / decrease_key
+    /// O(1) contains / priority
+    /// </summary>
+    /// <typeparam name="Priority"></typeparam>
+    /// <typeparam name="Arity"></typeparam>
+    /// <typeparam name="Compare"></typeparam>
+    /// <typeparam name="EntryVector">Heap ordered entries</typeparam>
+    /// <typeparam name="PositionVector">Maps ids to their place in the heap</typeparam>
+    template<typename Priority
+        , size_t Arity = 4
+        , typename Compare = std::greater<Priority>
+        , typename EntryVector = cbb_vector<indexed_heap_entry<Priority>>
+        , typename PositionVector = cbb_vector<uint32_t>
+    >
+    class cbb_indexed_heap_impl;
+
+    template<typename Priority, typename Compare = std::greater<Priority>>
+    using cbb_indexed_heap = cbb_indexed_heap_impl<Priority, 4, Compare>;
+
+    template<typename Priority, size_t MaxId = 16, typename Compare = std::greater<Priority>>
+    using cbb_static_indexed_heap =
+        cbb_indexed_heap_impl<Priority, 4, Compare
+            , cbb_static_vector<indexed_heap_entry<Priority>, MaxId>
+            , cbb_static_vector<uint32_t, MaxId>
+        >;
+}
+
+/*
+
+    Implementation details
+
+*/
+
+/// <summary>
+/// D-ary heap
+/// </summary>
+namespace cppcbb
+{
+    template<size_t Arity>
+    class dary_heap
+    {
+    public:
+        static size_t parent(size_t idx) { return (idx - 1) / Arity; }
+        static size_t first_child(size_t idx) { return idx * Arity + 1; }
+
+        //Moves value up from hole until its parent compares no less
+        template<typename Iterator, typename Elem, typename Compare, typename Moved>
+        static size_t sift_up(Iterator begin, size_t hole, Elem&& value, Compare& comp, Moved& moved)
+        {
+            while (hole > 0)
+            {
+                size_t up = parent(hole);
+                if (!comp(*(begin + up), value))
+                {
+                    break;
+                }
+                *(begin + hole) = std::move(*(begin + up));
+                moved(hole);
+                hole = up;
+            }
+            *(begin + hole) = std::move(value);
+            moved(hole);
+            return hole;
+        }
+
+        //Moves value down from hole until no child compares greater
+        template<typename Iterator, typename Elem, typename Compare, typename Moved>
+        static size_t sift_down(Iterator begin, size_t size, size_t hole, Elem&& value, Compare& comp, Moved& moved)
+        {
+            for (;;)
+            {
+                size_t first = first_child(hole);
+                if (first >= size)
+                {
+                    break;
+                }
+
+                size_t last = std::min(first + Arity, size);
+                size_t best = first;
+                for (size_t child = first + 1; child < last; child++)
+                {
+                    if (comp(*(begin + best), *(begin + child)))
+                    {
+                        best = child;
+                    }
+                }
+
+                if (!comp(value, *(begin + best)))
+                {
+                    break;
+                }
+                *(begin + hole) = std::move(*(begin + best));
+                moved(hole);
+                hole = best;
+            }
+            *(begin + hole) = std::move(value);
+            moved(hole);
+            return hole;
+        }
+
+        //Restores heap order for the value placed at hole, in whichever direction it needs to go
+        template<typename Iterator, typename Elem, typename Compare, typename Moved>
+        static size_t restore(Iterator begin, size_t size, size_t hole, Elem&& value, Compare& comp, Moved& moved)
+        {
+            if (hole > 0 && comp(*(begin + parent(hole)), value))
+            {
+                return sift_up(begin, hole, std::move(value), comp, moved);
+            }
+            return sift_down(begin, size, hole, std::move(value), comp, moved);
+        }
+
+        //Builds heap order bottom up in O(n)
+        template<typename Iterator, typename Compare, typename Moved>
+        static void make_heap(Iterator begin, size_t size, Compare& comp, Moved& moved)
+        {
+            if (size < 2)
+            {
+                return;
+            }
+
+            for (size_t idx = parent(size - 1) + 1; idx-- > 0; )
+            {
+                auto value = std::move(*(begin + idx));
+                sift_down(begin, size, idx, std::move(value), comp, moved);
+            }
+        }
+    };
+}
+
+/// <summary>
+/// Heap Management
+/// </summary>
+namespace cppcbb
+{
+    template<typename Elem, typename Traits, size_t Arity, typename Compare>
+    class heap_vec_management : public contiguous_vec_management<Elem, Traits>
+    {
+    public:
+        using iterator = typename Traits::iterator;
+        using const_iterator = typename Traits::const_iterator;
+
+    private:
+        using heap = dary_heap<Arity>;
+
+        class no_tracking
+        {
+        public:
+            void operator()(size_t) const {}
+        };
+
+        //Finds the final place for elem, moving parents down into the hole at end
+        static iterator sift_hole_up(iterator begin, iterator end, const Elem& elem)
+        {
+            Compare comp;
+            size_t hole = end - begin;
+            while (hole > 0)
+            {
+                size_t up = heap::parent(hole);
+                if (!comp(*(begin + up), elem))
+                {
+                    break;
+                }
+                *(begin + hole) = std::move(*(begin + up));
+                hole = up;
+            }
+            return begin + hole;
+        }
+
+    public:
+        //Returns the slot elem belongs in
+        static iterator insert(iterator begin, iterator end, const Elem& elem)
+        {
+            return sift_hole_up(begin, end, elem);
+        }
+
+        //Position is meaningless in a heap, so this is a regular insert
+        static iterator insert_at(iterator begin, iterator& end, iterator pos, const Elem& elem, size_t capacity)
+        {
+            iterator slot = sift_hole_up(begin, end, elem);
+            ++end;
+            return slot;
+        }
+
+        //Replaces elem with the final element & restores heap order
+        //Returns the new end
+        static iterator erase(iterator begin, iterator end, iterator elem)
+        {
+            iterator last = end - 1;
+            if (elem != last)
+            {
+                Compare comp;
+                no_tracking moved;
+                Elem value = std::move(*last);
+                heap::restore(begin, last - begin, elem - begin, std::move(value), comp, moved);
+            }
+            return last;
+        }
+
+        //The last element fills the hole, sifting it back into place isn't counted
+        static size_t erase_shifts(iterator begin, iterator end, iterator elem)
+        {
+            return (elem + 1) != end ? 1 : 0;
+        }
+
+        //Removes matching elements in a single pass then rebuilds heap order in O(n)
+        template<typename Pred>
+        static iterator erase_if(iterator begin, iterator end, Pred& pred)
+        {
+            iterator new_end = std::remove_if(begin, end, pred);
+
+            Compare comp;
+            no_tracking moved;
+            heap::make_heap(begin, new_end - begin, comp, moved);
+            return new_end;
+        }
+    };
+}
+
+/// <summary>
+/// Priority Queue
+/// </summary>
+namespace cppcbb
+{
+    template<typename Elem, typename Vector>
+    class cbb_priority_queue_impl
+    {
+    public:
+        using const_iterator = typename Vector::const_iterator;
+
+    private:
+        Vector m_elements;
+
+    public:
+        //Iterates in heap order
+        const_iterator begin() const { return m_elements.cbegin(); }
+        const_iterator end() const { return m_elements.cend(); }
+
+        const_iterator cbegin() const { return m_elements.cbegin(); }
+        const_iterator cend() const { return m_elements.cend(); }
+
+        size_t size() const { return m_elements.size(); }
+        size_t capacity() const { return m_elements.capacity(); }
+        bool empty() const { return m_elements.size() == 0; }
+
+        void push(const Elem& elem) { m_elements.push_back(elem); }
+        void push(Elem&& elem) { m_elements.push_back(std::move(elem)); }
+
+        template<typename ... Args>
+        void emplace(Args&& ... args) { m_elements.emplace_back(std::forward<Args>(args)...); }
+
+        const Elem& top() const
+        {
+            CPPCBB_ASSERT((size() > 0), "No elements in queue!");
+            return *m_elements.cbegin();
+        }
+
+        void pop_top()
+        {
+            CPPCBB_ASSERT((size() > 0), "No elements in queue!");
+            m_elements.erase(m_elements.begin());
+        }
+
+        //Removes all matching elements with a single heap rebuild, returns the number removed
+        template<typename Pred>
+        size_t erase_if(Pred pred) { return m_elements.erase_if(pred); }
+
+        void clear() { m_elements.clear(); }
+    };
+}
+
+/// <summary>
+/// Indexed Heap
+/// </summary>
+namespace cppcbb
+{
+    template<typename Priority>
+    class indexed_heap_entry
+    {
+    public:
+        Priority priority = Priority();
+        uint32_t id = 0;
+
+        indexed_heap_entry() {}
+        indexed_heap_entry(Priority priority_, uint32_t id_) : priority(std::move(priority_)), id(id_) {}
+    };
+
+    template<typename Priority, size_t Arity, typename Compare, typename EntryVector, typename PositionVector>
+    class cbb_indexed_heap_impl
+    {
+    public:
+        using entry = indexed_heap_entry<Priority>;
+        using const_iterator = typename EntryVector::const_iterator;
+
+    private:
+        using heap = dary_heap<Arity>;
+
+        static constexpr uint32_t k_invalid_position = UINT32_MAX;
+
+        class entry_compare
+        {
+        public:
+            Compare comp;
+            bool operator()(const entry& left, const entry& right) const { return comp(left.priority, right.priority); }
+        };
+
+        class position_tracking
+        {
+        public:
+            EntryVector& entries;
+            PositionVector& positions;
+            void operator()(size_t idx) const { positions[entries[idx].id] = (uint32_t)idx; }
+        };
+
+        EntryVector m_entries;
+        PositionVector m_positions;
+
+        //Places value at hole and restores heap order, keeping positions up to date
+        void restore(size_t hole, entry value)
+        {
+            entry_compare comp;
+            position_tracking moved{ m_entries, m_positions };
+            heap::restore(m_entries.begin(), m_entries.size(), hole, std::move(value), comp, moved);
+        }
+
+    public:
+        //Iterates in heap order
+        const_iterator begin() const { return m_entries.cbegin(); }
+        const_iterator end() const { return m_entries.cend(); }
+
+        size_t size() const { return m_entries.size(); }
+        bool empty() const { return m_entries.size() == 0; }
+
+        bool contains(uint32_t id) const
+        {
+            return id < m_positions.size() && m_positions[id] != k_invalid_position;
+        }
+
+        const Priority& priority(uint32_t id) const
+        {
+            CPPCBB_ASSERT(contains(id), "Id not in heap!");
+            return m_entries[m_positions[id]].priority;
+        }
+
+        const entry& top() const
+        {
+            CPPCBB_ASSERT((size() > 0), "No elements in heap!");
+            return m_entries[0];
+        }
+
+        void push(uint32_t id, Priority priority);
+
+        void pop_top()
+        {
+            CPPCBB_ASSERT((size() > 0), "No elements in heap!");
+            erase(m_entries[0].id);
+        }
+
+        //Returns false if id was not in the heap
+        bool erase(uint32_t id);
+
+        //Changes the priority of id, moving it whichever way it needs to go
+        void update(uint32_t id, Priority priority);
+
+        //Raises id towards the top, priority must not rank below the current one
+        void decrease_key(uint32_t id, Priority priority);
+
+        //Pushes id, or updates it if already present
+        void push_or_update(uint32_t id, Priority priority);
+
+        void clear();
+    };
+
+    template<typename Priority, size_t Arity, typename Compare, typename EntryVector, typename PositionVector>
+    constexpr uint32_t cbb_indexed_heap_impl<Priority, Arity, Compare, EntryVector, PositionVector>::k_invalid_position;
+
+    template<typename Priority, size_t Arity, typename Compare, typename EntryVector, typename PositionVector>
+    inline void cbb_indexed_heap_impl<Priority, Arity, Compare, EntryVector, PositionVector>::push(uint32_t id, Priority priority)
+    {
+        CPPCBB_ASSERT(!contains(id), "Id already in heap!");
+
+        while (m_positions.size() <= id)
+        {
+            m_positions.push_back(k_invalid_position);
+        }
+
+        m_entries.emplace_back();
+
+        entry_compare comp;
+        position_tracking moved{ m_entries, m_positions };
+        heap::sift_up(m_entries.begin(), m_entries.size() - 1, entry(std::move(priority), id), comp, moved);
+    }
+
+    template<typename Priority, size_t Arity, typename Compare, typename EntryVector, typename PositionVector>
+    inline bool cbb_indexed_heap_impl<Priority, Arity, Compare, EntryVector, PositionVector>::erase(uint32_t id)
+    {
+        if (!contains(id))
+        {
+            return false;
+        }
+
+        size_t hole = m_positions[id];
+        m_positions[id] = k_invalid_position;
+
+        entry last = std::move(m_entries.back());
+        m_entries.pop_back();
+
+        if (hole < m_entries.size())
+        {
+            restore(hole, std::move(last));
+        }
+        return true;
+    }
+
+    template<typename Priority, size_t Arity, typename Compare, typename EntryVector, typename PositionVector>
+    inline void cbb_indexed_heap_impl<Priority, Arity, Compare, EntryVector, PositionVector>::update(uint32_t id, Priority priority)
+    {
+        CPPCBB_ASSERT(contains(id), "Id not in heap!");
+        restore(m_positions[id], entry(std::move(priority), id));
+    }
+
+    template<typename Priority, size_t Arity, typename Compare, typename EntryVector, typename PositionVector>
+    inline void cbb_indexed_heap_impl<Priority, Arity, Compare, EntryVector, PositionVector>::decrease_key(uint32_t id, Priority priority)
+    {
+        CPPCBB_ASSERT(contains(id), "Id not in heap!");
+        CPPCBB_ASSERT(!Compare()(priority, m_entries[m_positions[id]].priority), "Priority would move away from the top!");
+
+        entry_compare comp;
+        position_tracking moved{ m_entries, m_positions };
+        heap::sift_up(m_entries.begin(), m_positions[id], entry(std::move(priority), id), comp, moved);
+    }
+
+    template<typename Priority, size_t Arity, typename Compare, typename EntryVector, typename PositionVector>
+    inline void cbb_indexed_heap_impl<Priority, Arity, Compare, EntryVector, PositionVector>::push_or_update(uint32_t id, Priority priority)
+    {
+        if (contains(id))
+        {
+            update(id, std::move(priority));
+        }
+        else
+        {
+            push(id, std::move(priority));
+        }
+    }
+
+    template<typename Priority, size_t Arity, typename Compare, typename EntryVector, typename PositionVector>
+    inline void cbb_indexed_heap_impl<Priority, Arity, Compare, EntryVector, PositionVector>::clear()
+    {
+        for (const entry& e : m_entries)
+        {
+            m_positions[e.id] = k_invalid_position;
+        }
+        m_entries.clear();
+    }
+}
+
+#endif //CPPCBB_INCLUDE_CBB_HEAP_H
@@ -9,7 +9,10 @@
 
 #include "cbb_common.hpp"
 #include "cbb_vector.hpp"
+#include "cbb_stats.hpp"
 
+#include <algorithm>
+#include <iterator>
 #include <utility>
 
 namespace cppcbb
@@ -64,6 +67,11 @@ namespace cppcbb
     template<typename Key, typename Value, typename Traits = default_pair_storage_traits<Key, Value>>
     class sorted_pair_management;
 
+    /// <summary>
+    /// Keys find_many looks up together, so the cache misses of a whole group overlap
+    /// </summary>
+    static constexpr size_t k_find_many_group = 16;
+
     /// <summary>
     /// Stores elements as a vector of pairs
     /// </summary>
@@ -85,9 +93,25 @@ namespace cppcbb
     /// <typeparam name="Key"></typeparam>
     /// <typeparam name="Value"></typeparam>
     /// <typeparam name="Storage"></typeparam>
-    template<typename Key, typename Value, typename Storage = pair_storage<Key,Value>>
+    /// <typeparam name="Stats">Hot path counters, see cbb_stats.hpp</typeparam>
+    template<typename Key, typename Value, typename Storage = pair_storage<Key,Value>, typename Stats = no_stats>
     class cbb_map_impl;
 
+    template<typename Key, typename Value, typename Traits, typename Vector, typename Management, typename Stats>
+    class rebind_stats<pair_storage<Key, Value, Traits, Vector, Management>, Stats>
+    {
+    public:
+        using type = pair_storage<Key, Value, Traits, typename rebind_stats<Vector, Stats>::type, Management>;
+    };
+
+    //The storage is rebound too, so allocations of the underlying vector are counted with the map
+    template<typename Key, typename Value, typename Storage, typename OldStats, typename Stats>
+    class rebind_stats<cbb_map_impl<Key, Value, Storage, OldStats>, Stats>
+    {
+    public:
+        using type = cbb_map_impl<Key, Value, typename rebind_stats<Storage, Stats>::type, Stats>;
+    };
+
     /// <summary>
     /// Map with dynamic vector storage
     /// </summary>
@@ -137,7 +161,7 @@ namespace cppcbb
             Key, Value, 
             pair_storage<Key, Value, Traits
                 , cbb_vector<typename Traits::Elem>
-                , unordered_map_pair_management<Key, Value, Traits>
+                , sorted_pair_management<Key, Value, Traits>
             >
         >;
 
@@ -150,7 +174,7 @@ namespace cppcbb
             Key, Value, 
             pair_storage<Key, Value, Traits
                 , cbb_static_vector<typename Traits::Elem, Capacity>
-                , unordered_map_pair_management<Key, Value, Traits>
+                , sorted_pair_management<Key, Value, Traits>
             >
         >;
 }
@@ -169,22 +193,35 @@ namespace cppcbb
         using const_iterator = typename Traits::const_iterator;
 
         //elm passed in is at end of range
-        static iterator insert(iterator begin, iterator end, iterator elem)
+        static CPPCBB_CONSTEXPR20 iterator insert(iterator begin, iterator end, iterator elem)
         {
             CPPCBB_ASSERT((elem + 1) == end, "Elem not passed at end of range!");
             return elem;
         }
 
         //Need to move elem to end of range
-        static void erase(iterator begin, iterator end, iterator elem)
+        //Returns the number of entries shifted
+        static CPPCBB_CONSTEXPR20 size_t erase(iterator begin, iterator end, iterator elem)
         {
             //Rotate elem to the end
             std::rotate(elem, elem + 1, end);
+            return end - elem - 1;
+        }
+
+        //Probes counts the keys compared
+        static CPPCBB_CONSTEXPR20 const_iterator find(const_iterator begin, const_iterator end, const Key& key, size_t& probes)
+        {
+            return std::find_if(begin, end, [&](const Elem& entry) { probes++; return entry.first == key; });
         }
 
-        static const_iterator find(const_iterator begin, const_iterator end, const Key& key)
+        //Linear searches stream through the entries, so the group is just searched in turn
+        template<typename KeyIt, typename ResultIt>
+        static void find_group(const_iterator begin, const_iterator end, KeyIt keys, size_t count, ResultIt results, size_t* probes)
         {
-            return std::find_if(begin, end, [&](const Elem& entry) { return entry.first == key; });
+            for (size_t i = 0; i < count; i++)
+            {
+                results[i] = find(begin, end, keys[i], probes[i]);
+            }
         }
     };
 }
@@ -203,21 +240,34 @@ namespace cppcbb
         using const_iterator = typename Traits::const_iterator;
 
         //elm passed in is at end of range
-        static iterator insert(iterator begin, iterator end, iterator elem)
+        static CPPCBB_CONSTEXPR20 iterator insert(iterator begin, iterator end, iterator elem)
         {
             CPPCBB_ASSERT((elem + 1) == end, "Elem not passed at end of range!");
             return elem;
         }
 
         //Need to move elem to end of range
-        static void erase(iterator begin, iterator end, iterator elem)
+        //Returns the number of entries shifted
+        static CPPCBB_CONSTEXPR20 size_t erase(iterator begin, iterator end, iterator elem)
         {
             std::swap(*elem, *(end - 1));
+            return (elem + 1) != end ? 1 : 0;
         }
 
-        static const_iterator find(const_iterator begin, const_iterator end, const Key& key)
+        //Probes counts the keys compared
+        static CPPCBB_CONSTEXPR20 const_iterator find(const_iterator begin, const_iterator end, const Key& key, size_t& probes)
         {
-            return std::find_if(begin, end, [&](const Elem& entry) { return entry.first == key; });
+            return std::find_if(begin, end, [&](const Elem& entry) { probes++; return entry.first == key; });
+        }
+
+        //Linear searches stream through the entries, so the group is just searched in turn
+        template<typename KeyIt, typename ResultIt>
+        static void find_group(const_iterator begin, const_iterator end, KeyIt keys, size_t count, ResultIt results, size_t* probes)
+        {
+            for (size_t i = 0; i < count; i++)
+            {
+                results[i] = find(begin, end, keys[i], probes[i]);
+            }
         }
     };
 }
@@ -236,29 +286,92 @@ namespace cppcbb
         using const_iterator = typename Traits::const_iterator;
 
         //elem passed in is at end of range
-        static iterator insert(iterator begin, iterator end, iterator elem)
+        static CPPCBB_CONSTEXPR20 iterator insert(iterator begin, iterator end, iterator elem)
         {
             CPPCBB_ASSERT((elem + 1) == end, "Elem not passed at end of range!");
-            auto loc = std::lower_bound(begin, end, elem, [](const Elem& left, const Elem& right) { return left.first < right.first); };
+            auto loc = std::lower_bound(begin, elem, *elem, [](const Elem& left, const Elem& right) { return left.first < right.first; });
             std::rotate(loc, elem, end);
             return loc;
         }
 
         //Need to move elem to end of range
-        static void erase(iterator begin, iterator end, iterator elem)
+        //Returns the number of entries shifted
+        static CPPCBB_CONSTEXPR20 size_t erase(iterator begin, iterator end, iterator elem)
         {
             std::rotate(elem, elem + 1, end);
+            return end - elem - 1;
         }
 
-        static const_iterator find(const_iterator begin, const_iterator end, const Key& key)
+        //Probes counts the keys compared by the binary search
+        static CPPCBB_CONSTEXPR20 const_iterator find(const_iterator begin, const_iterator end, const Key& key, size_t& probes)
         {
-            auto loc = std::lower_bound(begin, end, key, [](const Elem& left, const Key& right) { return left.first < key); };
-            if (loc->first == key)
+            auto loc = std::lower_bound(begin, end, key, [&](const Elem& left, const Key& right) { probes++; return left.first < right; });
+            if (loc != end && loc->first == key)
             {
                 return loc;
             }
             return end;
         }
+
+        //Binary searches every key of the group a step at a time, prefetching each key's next probe
+        //so the misses of the whole group are in flight together
+        template<typename KeyIt, typename ResultIt>
+        static void find_group(const_iterator begin, const_iterator end, KeyIt keys, size_t count, ResultIt results, size_t* probes)
+        {
+            const size_t size = end - begin;
+            if (size == 0)
+            {
+                for (size_t i = 0; i < count; i++)
+                {
+                    results[i] = end;
+                }
+                return;
+            }
+
+            size_t bases[k_find_many_group] = {};
+            for (size_t length = size; length > 1; )
+            {
+                const size_t half = length / 2;
+                length -= half;
+                for (size_t i = 0; i < count; i++)
+                {
+                    bases[i] = begin[bases[i] + half].first < keys[i] ? bases[i] + half : bases[i];
+                    probes[i]++;
+                    CPPCBB_PREFETCH(&begin[bases[i] + length / 2]);
+                }
+            }
+
+            for (size_t i = 0; i < count; i++)
+            {
+                probes[i]++;
+                const_iterator loc = begin + bases[i];
+                if (loc->first < keys[i])
+                {
+                    ++loc;
+                }
+                results[i] = (loc != end && loc->first == keys[i]) ? loc : end;
+            }
+        }
+
+        //First entry with a key not less than key
+        static CPPCBB_CONSTEXPR20 const_iterator lower_bound(const_iterator begin, const_iterator end, const Key& key, size_t& probes)
+        {
+            return std::lower_bound(begin, end, key, [&](const Elem& left, const Key& right) { probes++; return left.first < right; });
+        }
+
+        //First entry with a key greater than key
+        static CPPCBB_CONSTEXPR20 const_iterator upper_bound(const_iterator begin, const_iterator end, const Key& key, size_t& probes)
+        {
+            return std::upper_bound(begin, end, key, [&](const Key& left, const Elem& right) { probes++; return left < right.first; });
+        }
+
+        //Need to move [first, last) to end of range, keeping the order of the rest
+        //Returns the number of entries shifted
+        static CPPCBB_CONSTEXPR20 size_t erase_range(iterator begin, iterator end, iterator first, iterator last)
+        {
+            std::move(last, end, first);
+            return end - last;
+        }
     };
 }
 
@@ -283,20 +396,45 @@ namespace cppcbb
         Vector m_elements;
 
     public:
-        iterator begin() { return m_elements.begin(); }
-        iterator end() { return m_elements.end(); }
+        CPPCBB_CONSTEXPR20 iterator begin() { return m_elements.begin(); }
+        CPPCBB_CONSTEXPR20 iterator end() { return m_elements.end(); }
 
-        const_iterator cbegin() const { return m_elements.cbegin(); }
-        const_iterator cend() const { return m_elements.cend(); }
+        CPPCBB_CONSTEXPR20 const_iterator cbegin() const { return m_elements.cbegin(); }
+        CPPCBB_CONSTEXPR20 const_iterator cend() const { return m_elements.cend(); }
 
         //Finds the iterator for the key
-        const_iterator find(const Key& key) const
+        CPPCBB_CONSTEXPR20 const_iterator find(const Key& key) const
         { 
-            return Management::find(cbegin(), cend(), key);
+            size_t probes = 0;
+            return find(key, probes);
+        }
+
+        //Finds the iterator for the key, adding the number of keys compared to probes
+        CPPCBB_CONSTEXPR20 const_iterator find(const Key& key, size_t& probes) const
+        {
+            return Management::find(cbegin(), cend(), key, probes);
         }
        
+        //Finds up to k_find_many_group keys together, adding the keys compared for each to probes
+        template<typename KeyIt, typename ResultIt>
+        void find_group(KeyIt keys, size_t count, ResultIt results, size_t* probes) const
+        {
+            Management::find_group(cbegin(), cend(), keys, count, results, probes);
+        }
+
+        //Ordered range lookups, only for managements that keep the keys sorted
+        CPPCBB_CONSTEXPR20 const_iterator lower_bound(const Key& key, size_t& probes) const
+        {
+            return Management::lower_bound(cbegin(), cend(), key, probes);
+        }
+
+        CPPCBB_CONSTEXPR20 const_iterator upper_bound(const Key& key, size_t& probes) const
+        {
+            return Management::upper_bound(cbegin(), cend(), key, probes);
+        }
+
         //Inserts a new iterator for the key
-        iterator insert(Key key, Value value)
+        CPPCBB_CONSTEXPR20 iterator insert(Key key, Value value)
         {
             auto it = find(key);
             if (it != end())
@@ -307,19 +445,45 @@ namespace cppcbb
             return Management::insert(begin(), end(), end() - 1);
         }
 
-        //Erases the item from the list
-        void erase(const_iterator elem)
+        //Erases the item from the list, returns the number of entries shifted
+        CPPCBB_CONSTEXPR20 size_t erase(const_iterator elem)
         {
-            Management::erase(begin(), end(), (iterator)elem);
+            size_t shifts = Management::erase(begin(), end(), (iterator)elem);
             m_elements.pop_back();
+            return shifts;
         }
 
-        void clear()
+        //Erases the items in [first, last), returns the number of entries shifted
+        CPPCBB_CONSTEXPR20 size_t erase(const_iterator first, const_iterator last)
+        {
+            size_t count = last - first;
+            size_t shifts = Management::erase_range(begin(), end(), (iterator)first, (iterator)last);
+            for (size_t i = 0; i < count; i++)
+            {
+                m_elements.pop_back();
+            }
+            return shifts;
+        }
+
+        //Bulk builds: returns the element vector resized to size entries, to be filled with
+        //unique keys in an order the management keeps (sorted by key suits every management)
+        CPPCBB_CONSTEXPR20 Vector& bulk_elements(size_t size)
+        {
+            m_elements.clear();
+            m_elements.resize(size);
+            CPPCBB_ASSERT((size <= m_elements.capacity()), "Not enough storage!");
+            return m_elements;
+        }
+
+        //Called once the bulk elements are written
+        CPPCBB_CONSTEXPR20 void bulk_commit() {}
+
+        CPPCBB_CONSTEXPR20 void clear()
         {
             m_elements.clear();
         }
 
-        size_t size() const
+        CPPCBB_CONSTEXPR20 size_t size() const
         {
             return m_elements.size();
         }
@@ -328,7 +492,7 @@ namespace cppcbb
 
 namespace cppcbb
 {
-    template<typename Key, typename Value, typename Storage>
+    template<typename Key, typename Value, typename Storage, typename Stats>
     class cbb_map_impl
     {
     public:
@@ -341,18 +505,44 @@ namespace cppcbb
 
     public:
 
-        iterator begin() { return m_storage.begin(); }
-        iterator end() { return m_storage.end(); }
+        CPPCBB_CONSTEXPR20 iterator begin() { return m_storage.begin(); }
+        CPPCBB_CONSTEXPR20 iterator end() { return m_storage.end(); }
 
-        const_iterator begin() const { return m_storage.cbegin(); }
-        const_iterator end() const { return m_storage.cend(); }
+        CPPCBB_CONSTEXPR20 const_iterator begin() const { return m_storage.cbegin(); }
+        CPPCBB_CONSTEXPR20 const_iterator end() const { return m_storage.cend(); }
 
-        const_iterator cbegin() const { return m_storage.cbegin(); }
-        const_iterator cend() const { return m_storage.cend(); }
+        CPPCBB_CONSTEXPR20 const_iterator cbegin() const { return m_storage.cbegin(); }
+        CPPCBB_CONSTEXPR20 const_iterator cend() const { return m_storage.cend(); }
+
+        CPPCBB_CONSTEXPR20 const_iterator find(const Key& key) const
+        {
+            size_t probes = 0;
+            const_iterator it = m_storage.find(key, probes);
+            Stats::on_find(probes, it != cend());
+            return it;
+        }
+
+        //Resizes results to keys.size() & sets results[i] = find(keys[i])
+        //Keys are looked up in groups, so the cache misses of a group overlap instead of queueing
+        template<typename Keys, typename Results>
+        void find_many(const Keys& keys, Results& results) const
+        {
+            results.resize(keys.size());
 
-        const_iterator find(const Key& key) const { return m_storage.find(key); }
+            size_t probes[k_find_many_group];
+            for (size_t first = 0; first < keys.size(); first += k_find_many_group)
+            {
+                size_t count = std::min(keys.size() - first, k_find_many_group);
+                std::fill(probes, probes + count, 0);
+                m_storage.find_group(std::begin(keys) + first, count, std::begin(results) + first, probes);
+                for (size_t i = 0; i < count; i++)
+                {
+                    Stats::on_find(probes[i], results[first + i] != cend());
+                }
+            }
+        }
 
-        Value& operator[] (Key key) 
+        CPPCBB_CONSTEXPR20 Value& operator[] (Key key) 
         { 
             auto constIt = find(key); 
             if (constIt != end())
@@ -363,17 +553,58 @@ namespace cppcbb
             return m_storage.insert(std::move(key), Value())->second;
         }
 
-        void erase(const_iterator elem)
+        CPPCBB_CONSTEXPR20 void erase(const_iterator elem)
+        {
+            Stats::on_erase(m_storage.erase(elem));
+        }
+
+        //Ordered range APIs, for sorted vector & B+ tree maps
+        CPPCBB_CONSTEXPR20 const_iterator lower_bound(const Key& key) const
+        {
+            size_t probes = 0;
+            return m_storage.lower_bound(key, probes);
+        }
+
+        CPPCBB_CONSTEXPR20 const_iterator upper_bound(const Key& key) const
+        {
+            size_t probes = 0;
+            return m_storage.upper_bound(key, probes);
+        }
+
+        CPPCBB_CONSTEXPR20 std::pair<const_iterator, const_iterator> equal_range(const Key& key) const
+        {
+            const_iterator first = lower_bound(key);
+            const_iterator last = first;
+            if (last != cend() && !(key < last->first))
+            {
+                ++last;
+            }
+            return std::make_pair(first, last);
+        }
+
+        //Erases the entries in [first, last)
+        CPPCBB_CONSTEXPR20 void erase(const_iterator first, const_iterator last)
+        {
+            Stats::on_erase(m_storage.erase(first, last));
+        }
+
+        //Bulk builds write the entries straight into the storage, see parallel::build_from
+        CPPCBB_CONSTEXPR20 auto bulk_elements(size_t size) -> decltype(m_storage.bulk_elements(size))
+        {
+            return m_storage.bulk_elements(size);
+        }
+
+        CPPCBB_CONSTEXPR20 void bulk_commit()
         {
-            m_storage.erase(elem);
+            m_storage.bulk_commit();
         }
 
-        void clear()
+        CPPCBB_CONSTEXPR20 void clear()
         {
             m_storage.clear();
         }
 
-        size_t size() const { return m_storage.size(); }
+        CPPCBB_CONSTEXPR20 size_t size() const { return m_storage.size(); }
     };
 }
 
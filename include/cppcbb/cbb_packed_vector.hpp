@@ -0,0 +1,484 @@
+//Copyright(C) 2020 Henry Bullingham
+//This file is subject to the license terms in the LICENSE file
+//found in the top - level directory of this distribution.
+
+#pragma once
+
+#if !defined (CPPCBB_INCLUDE_CBB_PACKED_VECTOR_H)
+#define CPPCBB_INCLUDE_CBB_PACKED_VECTOR_H
+
+#include "cbb_common.hpp"
+#include "cbb_vector.hpp"
+
+#include <cstdint>
+#include <iterator>
+
+namespace cppcbb
+{
+    /// <summary>
+    /// Proxy reference to an element of a packed vector
+    /// </summary>
+    /// <typeparam name="Vector"></typeparam>
+    template<typename Vector>
+    class packed_reference;
+
+    /// <summary>
+    /// Random access iterator over a packed vector, dereferencing to a value or a proxy reference
+    /// </summary>
+    /// <typeparam name="Vector">Packed vector, const for a const_iterator</typeparam>
+    /// <typeparam name="Reference"></typeparam>
+    template<typename Vector, typename Reference>
+    class packed_iterator;
+
+    /// <summary>
+    /// Vector of small values (bool, small enums & integers) packed Bits to an element into 64 bit words
+    /// Elements never straddle words, so Bits must divide 64
+    /// O(n / 64) count, find and bitwise operations, a word at a time
+    /// </summary>
+    /// <typeparam name="Elem">Type convertible to and from an unsigned integer of Bits bits</typeparam>
+    /// <typeparam name="Bits"></typeparam>
+    /// <typeparam name="Words">Contiguous vector of uint64_t holding the packed elements</typeparam>
+    template<typename Elem, unsigned Bits, typename Words = cbb_vector<uint64_t>>
+    class cbb_packed_vector;
+
+    template<typename Elem, unsigned Bits, size_t Capacity>
+    using cbb_static_packed_vector = cbb_packed_vector<Elem, Bits, cbb_static_vector<uint64_t, (Capacity * Bits + 63) / 64>>;
+
+    using cbb_bit_vector = cbb_packed_vector<bool, 1>;
+
+    template<size_t Capacity>
+    using cbb_static_bit_vector = cbb_static_packed_vector<bool, 1, Capacity>;
+}
+
+/*
+
+    Implementation details
+
+*/
+
+/// <summary>
+/// Packed Reference
+/// </summary>
+namespace cppcbb
+{
+    template<typename Vector>
+    class packed_reference
+    {
+    private:
+        using value_type = typename Vector::value_type;
+
+        Vector* m_vector;
+        size_t m_idx;
+
+    public:
+        packed_reference(Vector* vector, size_t idx)
+            : m_vector(vector)
+            , m_idx(idx)
+        {}
+
+        operator value_type() const { return m_vector->get(m_idx); }
+
+        packed_reference& operator=(const value_type& value)
+        {
+            m_vector->set(m_idx, value);
+            return *this;
+        }
+
+        packed_reference& operator=(const packed_reference& other)
+        {
+            m_vector->set(m_idx, other.m_vector->get(other.m_idx));
+            return *this;
+        }
+    };
+}
+
+/// <summary>
+/// Packed Iterator
+/// </summary>
+namespace cppcbb
+{
+    template<typename Vector, typename Reference>
+    class packed_iterator
+    {
+    private:
+        template<typename, typename> friend class packed_iterator;
+
+        Vector* m_vector = nullptr;
+        size_t m_idx = 0;
+
+    public:
+        using iterator_category = std::random_access_iterator_tag;
+        using value_type = typename Vector::value_type;
+        using difference_type = std::ptrdiff_t;
+        using pointer = void;
+        using reference = Reference;
+
+        packed_iterator() {}
+        packed_iterator(Vector* vector, size_t idx)
+            : m_vector(vector)
+            , m_idx(idx)
+        {}
+
+        //Mutable to const conversion
+        template<typename OtherVector, typename OtherReference>
+        packed_iterator(const packed_iterator<OtherVector, OtherReference>& other)
+            : m_vector(other.m_vector)
+            , m_idx(other.m_idx)
+        {}
+
+        size_t index() const { return m_idx; }
+
+        Reference operator*() const { return Reference(m_vector->at_proxy(m_idx)); }
+        Reference operator[](difference_type n) const { return Reference(m_vector->at_proxy(m_idx + n)); }
+
+        packed_iterator& operator++() { ++m_idx; return *this; }
+        packed_iterator& operator--() { --m_idx; return *this; }
+        packed_iterator operator++(int) { packed_iterator copy = *this; ++m_idx; return copy; }
+        packed_iterator operator--(int) { packed_iterator copy = *this; --m_idx; return copy; }
+
+        packed_iterator& operator+=(difference_type n) { m_idx += n; return *this; }
+        packed_iterator& operator-=(difference_type n) { m_idx -= n; return *this; }
+        packed_iterator operator+(difference_type n) const { return packed_iterator(m_vector, m_idx + n); }
+        packed_iterator operator-(difference_type n) const { return packed_iterator(m_vector, m_idx - n); }
+        difference_type operator-(const packed_iterator& other) const { return (difference_type)m_idx - (difference_type)other.m_idx; }
+
+        bool operator==(const packed_iterator& other) const { return m_idx == other.m_idx; }
+        bool operator!=(const packed_iterator& other) const { return m_idx != other.m_idx; }
+        bool operator<(const packed_iterator& other) const { return m_idx < other.m_idx; }
+        bool operator>(const packed_iterator& other) const { return m_idx > other.m_idx; }
+        bool operator<=(const packed_iterator& other) const { return m_idx <= other.m_idx; }
+        bool operator>=(const packed_iterator& other) const { return m_idx >= other.m_idx; }
+    };
+}
+
+/// <summary>
+/// Packed Vector
+/// </summary>
+namespace cppcbb
+{
+    template<typename Elem, unsigned Bits, typename Words>
+    class cbb_packed_vector
+    {
+    public:
+        static_assert(Bits > 0 && Bits <= 32 && (64 % Bits) == 0, "Packed elements must divide a 64 bit word");
+
+        using self_type = cbb_packed_vector<Elem, Bits, Words>;
+        using value_type = Elem;
+        using reference = packed_reference<self_type>;
+        using iterator = packed_iterator<self_type, reference>;
+        using const_iterator = packed_iterator<const self_type, Elem>;
+
+    private:
+        template<typename, typename> friend class packed_iterator;
+
+        static constexpr size_t k_per_word = 64 / Bits;
+        static constexpr uint64_t k_elem_mask = ((uint64_t)1 << Bits) - 1;
+
+        //Lowest bit of every element in a word
+        static constexpr uint64_t k_low_bits = ~(uint64_t)0 / k_elem_mask;
+
+        //Bits past m_size in the last word are kept clear, so whole words can be counted and compared
+        Words m_words;
+        size_t m_size = 0;
+
+        static uint64_t encode(const Elem& value)
+        {
+            uint64_t code = static_cast<uint64_t>(value);
+            CPPCBB_ASSERT(((code & ~k_elem_mask) == 0), "Value doesn't fit in the packed bits!");
+            return code;
+        }
+
+        static Elem decode(uint64_t code)
+        {
+            return static_cast<Elem>(code);
+        }
+
+        uint64_t* words() { return m_words.size() == 0 ? nullptr : &m_words[0]; }
+        const uint64_t* words() const { return m_words.size() == 0 ? nullptr : &m_words[0]; }
+
+        static size_t words_for(size_t size) { return (size + k_per_word - 1) / k_per_word; }
+
+        //Mask of the bits in use in word w
+        uint64_t used_mask(size_t w) const
+        {
+            size_t used = m_size - w * k_per_word;
+            return used >= k_per_word ? ~(uint64_t)0 : ((uint64_t)1 << (used * Bits)) - 1;
+        }
+
+        //Low bit of each element in the word equal to value
+        static uint64_t matches(uint64_t word, uint64_t pattern)
+        {
+            uint64_t diff = word ^ pattern;
+            for (unsigned shift = 1; shift < Bits; shift *= 2)
+            {
+                diff |= diff >> shift;
+            }
+            return ~diff & k_low_bits;
+        }
+
+        reference at_proxy(size_t idx) { return reference(this, idx); }
+        Elem at_proxy(size_t idx) const { return get(idx); }
+
+        //Clears the bits past m_size, after shrinking or a whole word operation
+        void clear_tail()
+        {
+            size_t count = words_for(m_size);
+            while (m_words.size() > count)
+            {
+                m_words.pop_back();
+            }
+            if (count > 0)
+            {
+                m_words[count - 1] &= used_mask(count - 1);
+            }
+        }
+
+        template<typename Op>
+        self_type& combine(const self_type& other, Op op);
+
+    public:
+        cbb_packed_vector() {}
+
+        iterator begin() { return iterator(this, 0); }
+        iterator end() { return iterator(this, m_size); }
+
+        const_iterator begin() const { return const_iterator(this, 0); }
+        const_iterator end() const { return const_iterator(this, m_size); }
+
+        const_iterator cbegin() const { return begin(); }
+        const_iterator cend() const { return end(); }
+
+        size_t size() const { return m_size; }
+        bool empty() const { return m_size == 0; }
+        size_t capacity() const { return m_words.capacity() * k_per_word; }
+
+        //Packed words, k_per_word elements to a word from the low bits up
+        size_t word_count() const { return m_words.size(); }
+        const uint64_t* data() const { return words(); }
+
+        Elem get(size_t idx) const
+        {
+            CPPCBB_ASSERT((idx < m_size), "Out of bounds access!");
+            return decode((m_words[idx / k_per_word] >> ((idx % k_per_word) * Bits)) & k_elem_mask);
+        }
+
+        void set(size_t idx, const Elem& value)
+        {
+            CPPCBB_ASSERT((idx < m_size), "Out of bounds access!");
+            unsigned shift = (unsigned)(idx % k_per_word) * Bits;
+            uint64_t& word = m_words[idx / k_per_word];
+            word = (word & ~(k_elem_mask << shift)) | (encode(value) << shift);
+        }
+
+        reference operator[](size_t idx) { return reference(this, idx); }
+        Elem operator[](size_t idx) const { return get(idx); }
+
+        reference back()
+        {
+            CPPCBB_ASSERT((m_size > 0), "No elements in vector!");
+            return reference(this, m_size - 1);
+        }
+
+        Elem back() const
+        {
+            CPPCBB_ASSERT((m_size > 0), "No elements in vector!");
+            return get(m_size - 1);
+        }
+
+        void push_back(const Elem& value)
+        {
+            if (m_size % k_per_word == 0)
+            {
+                m_words.push_back(0);
+            }
+            m_size++;
+            set(m_size - 1, value);
+        }
+
+        void pop_back()
+        {
+            CPPCBB_ASSERT((m_size > 0), "No elements in vector!");
+            m_size--;
+            clear_tail();
+        }
+
+        void clear()
+        {
+            m_words.clear();
+            m_size = 0;
+        }
+
+        void resize(size_t size, const Elem& value = Elem());
+
+        //Sets every element to value
+        void fill(const Elem& value);
+
+        //Number of elements equal to value
+        size_t count(const Elem& value) const;
+
+        //Index of the first element equal to value at or after idx, or size() if there is none
+        size_t find_next(const Elem& value, size_t idx) const;
+
+        size_t find_first(const Elem& value) const { return find_next(value, 0); }
+
+        //Bitwise operations on the packed codes, both vectors must be the same size
+        self_type& operator&=(const self_type& other) { return combine(other, [](uint64_t a, uint64_t b) { return a & b; }); }
+        self_type& operator|=(const self_type& other) { return combine(other, [](uint64_t a, uint64_t b) { return a | b; }); }
+        self_type& operator^=(const self_type& other) { return combine(other, [](uint64_t a, uint64_t b) { return a ^ b; }); }
+
+        //Inverts every bit of every element
+        void flip();
+
+        bool operator==(const self_type& other) const;
+        bool operator!=(const self_type& other) const { return !(*this == other); }
+    };
+
+    template<typename Elem, unsigned Bits, typename Words>
+    inline void cbb_packed_vector<Elem, Bits, Words>::resize(size_t size, const Elem& value)
+    {
+        if (size <= m_size)
+        {
+            m_size = size;
+            clear_tail();
+            return;
+        }
+
+        //Top up the last partial word, then append whole words of the repeated value
+        while (m_size < size && m_size % k_per_word != 0)
+        {
+            m_size++;
+            set(m_size - 1, value);
+        }
+
+        uint64_t pattern = encode(value) * k_low_bits;
+        while (m_size < size)
+        {
+            m_words.push_back(pattern);
+            m_size += k_per_word;
+        }
+        if (m_size > size)
+        {
+            m_size = size;
+            clear_tail();
+        }
+    }
+
+    template<typename Elem, unsigned Bits, typename Words>
+    inline void cbb_packed_vector<Elem, Bits, Words>::fill(const Elem& value)
+    {
+        uint64_t pattern = encode(value) * k_low_bits;
+        uint64_t* w = words();
+        size_t count = m_words.size();
+        for (size_t i = 0; i < count; i++)
+        {
+            w[i] = pattern;
+        }
+        clear_tail();
+    }
+
+    template<typename Elem, unsigned Bits, typename Words>
+    inline size_t cbb_packed_vector<Elem, Bits, Words>::count(const Elem& value) const
+    {
+        const uint64_t* w = words();
+        size_t word_count = m_words.size();
+        size_t count = 0;
+
+        uint64_t code = encode(value);
+        if (Bits == 1)
+        {
+            for (size_t i = 0; i < word_count; i++)
+            {
+                count += bits::popcount(w[i]);
+            }
+            return code != 0 ? count : m_size - count;
+        }
+
+        uint64_t pattern = code * k_low_bits;
+        for (size_t i = 0; i < word_count; i++)
+        {
+            count += bits::popcount(matches(w[i], pattern) & used_mask(i));
+        }
+        return count;
+    }
+
+    template<typename Elem, unsigned Bits, typename Words>
+    inline size_t cbb_packed_vector<Elem, Bits, Words>::find_next(const Elem& value, size_t idx) const
+    {
+        if (idx >= m_size)
+        {
+            return m_size;
+        }
+
+        uint64_t code = encode(value);
+        if (Bits == 1)
+        {
+            return code != 0 ? bits::find_next_set(words(), idx, m_size) : bits::find_next_clear(words(), idx, m_size);
+        }
+
+        uint64_t pattern = code * k_low_bits;
+        size_t w = idx / k_per_word;
+        uint64_t found = matches(m_words[w], pattern) & used_mask(w) & (~(uint64_t)0 << ((idx % k_per_word) * Bits));
+        size_t word_count = m_words.size();
+        while (found == 0)
+        {
+            if (++w == word_count)
+            {
+                return m_size;
+            }
+            found = matches(m_words[w], pattern) & used_mask(w);
+        }
+        return w * k_per_word + bits::count_trailing_zeros(found) / Bits;
+    }
+
+    template<typename Elem, unsigned Bits, typename Words>
+    template<typename Op>
+    inline typename cbb_packed_vector<Elem, Bits, Words>::self_type& cbb_packed_vector<Elem, Bits, Words>::combine(const self_type& other, Op op)
+    {
+        CPPCBB_ASSERT((m_size == other.m_size), "Packed vectors must be the same size!");
+
+        //Plain loops over raw words, so the compiler can vectorize them
+        uint64_t* w = words();
+        const uint64_t* o = other.words();
+        size_t count = m_words.size();
+        for (size_t i = 0; i < count; i++)
+        {
+            w[i] = op(w[i], o[i]);
+        }
+        return *this;
+    }
+
+    template<typename Elem, unsigned Bits, typename Words>
+    inline void cbb_packed_vector<Elem, Bits, Words>::flip()
+    {
+        uint64_t* w = words();
+        size_t count = m_words.size();
+        for (size_t i = 0; i < count; i++)
+        {
+            w[i] = ~w[i];
+        }
+        clear_tail();
+    }
+
+    template<typename Elem, unsigned Bits, typename Words>
+    inline bool cbb_packed_vector<Elem, Bits, Words>::operator==(const self_type& other) const
+    {
+        if (m_size != other.m_size)
+        {
+            return false;
+        }
+
+        const uint64_t* w = words();
+        const uint64_t* o = other.words();
+        size_t count = m_words.size();
+        for (size_t i = 0; i < count; i++)
+        {
+            if (w[i] != o[i])
+            {
+                return false;
+            }
+        }
+        return true;
+    }
+}
+
+#endif //CPPCBB_INCLUDE_CBB_PACKED_VECTOR_H
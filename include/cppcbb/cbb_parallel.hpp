@@ -0,0 +1,1087 @@
+//Copyright(C) 2020 Henry Bullingham
+//This file is subject to the license terms in the LICENSE file
+//found in the top - level directory of this distribution.
+
+#pragma once
+
+#if !defined (CPPCBB_INCLUDE_CBB_PARALLEL_H)
+#define CPPCBB_INCLUDE_CBB_PARALLEL_H
+
+#include "cbb_common.hpp"
+#include "cbb_vector.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace cppcbb
+{
+    /// <summary>
+    /// Work stealing thread pool
+    /// Each worker pops its own queue newest first & steals from the others oldest first
+    /// Threads waiting on parallel_for run queued tasks instead of blocking, so calls may nest
+    /// </summary>
+    class thread_pool;
+
+    namespace parallel
+    {
+        /// <summary>
+        /// How the parallel algorithms split their work
+        /// </summary>
+        class default_parallel_params
+        {
+        public:
+            //Ranges smaller than this run on the calling thread
+            static constexpr size_t min_grain_size = 4096;
+
+            //Chunks per pool thread, more chunks balance uneven work at the cost of more tasks
+            static constexpr size_t chunks_per_thread = 4;
+        };
+
+        /// <summary>
+        /// Logical elements of a vector as contiguous runs, taken from for_each_segment
+        /// Contiguous storage is a single run, gap & tombstone storage are split around the holes
+        /// </summary>
+        /// <typeparam name="Iterator">Segment iterator of the vector</typeparam>
+        template<typename Iterator>
+        class segment_list;
+
+        /// <summary>
+        /// Calls func(elem) for every element
+        /// </summary>
+        template<typename Params = default_parallel_params, typename Vector, typename Func>
+        void for_each(Vector& v, Func func, thread_pool& pool);
+        template<typename Params = default_parallel_params, typename Vector, typename Func>
+        void for_each(Vector& v, Func func);
+
+        /// <summary>
+        /// Resizes out to in.size() & sets out[i] = op(in[i])
+        /// </summary>
+        template<typename Params = default_parallel_params, typename InVector, typename OutVector, typename Op>
+        void transform(const InVector& in, OutVector& out, Op op, thread_pool& pool);
+        template<typename Params = default_parallel_params, typename InVector, typename OutVector, typename Op>
+        void transform(const InVector& in, OutVector& out, Op op);
+
+        /// <summary>
+        /// Folds the elements in order with op, which must be associative
+        /// </summary>
+        template<typename Params = default_parallel_params, typename Vector, typename T, typename Op>
+        T reduce(const Vector& v, T init, Op op, thread_pool& pool);
+        template<typename Params = default_parallel_params, typename Vector, typename T, typename Op>
+        T reduce(const Vector& v, T init, Op op);
+
+        /// <summary>
+        /// Sorts the elements (not stable), chunks are sorted in parallel then merged in parallel
+        /// </summary>
+        template<typename Params = default_parallel_params, typename Vector, typename Compare>
+        void sort(Vector& v, Compare comp, thread_pool& pool);
+        template<typename Params = default_parallel_params, typename Vector, typename Compare>
+        void sort(Vector& v, Compare comp);
+        template<typename Params = default_parallel_params, typename Vector>
+        void sort(Vector& v);
+
+        /// <summary>
+        /// Sorts the elements, keeping equal elements in their original order
+        /// </summary>
+        template<typename Params = default_parallel_params, typename Vector, typename Compare>
+        void stable_sort(Vector& v, Compare comp, thread_pool& pool);
+        template<typename Params = default_parallel_params, typename Vector, typename Compare>
+        void stable_sort(Vector& v, Compare comp);
+
+        /// <summary>
+        /// Moves the elements matching pred before the others, keeping the order within each group
+        /// Returns the number of matching elements
+        /// </summary>
+        template<typename Params = default_parallel_params, typename Vector, typename Pred>
+        size_t stable_partition(Vector& v, Pred pred, thread_pool& pool);
+        template<typename Params = default_parallel_params, typename Vector, typename Pred>
+        size_t stable_partition(Vector& v, Pred pred);
+
+        /// <summary>
+        /// Removes all elements matching pred, keeping the order of the rest
+        /// Returns the number removed
+        /// </summary>
+        template<typename Params = default_parallel_params, typename Vector, typename Pred>
+        size_t erase_if(Vector& v, Pred pred, thread_pool& pool);
+        template<typename Params = default_parallel_params, typename Vector, typename Pred>
+        size_t erase_if(Vector& v, Pred pred);
+
+        /// <summary>
+        /// Duplicate key policies for build_from
+        /// </summary>
+        class last_wins
+        {
+        public:
+            static constexpr bool keep_last = true;
+        };
+
+        class first_wins
+        {
+        public:
+            static constexpr bool keep_last = false;
+        };
+
+        /// <summary>
+        /// Builds a map from a range of key value pairs, e.g. build_from&lt;cbb_sorted_vector_map&lt;int, int&gt;&gt;(pairs, 8)
+        /// The entries are stable sorted by key & deduplicated in parallel, then written straight into the map's storage
+        /// Works with every map whose storage has bulk_elements (vector, sorted vector & sparse maps)
+        /// Single pass (input iterator) ranges are buffered before building, a static map too small for the unique keys is left empty
+        /// </summary>
+        template<typename Map, typename Duplicates = last_wins, typename Params = default_parallel_params, typename Range>
+        Map build_from(const Range& range, thread_pool& pool);
+        template<typename Map, typename Duplicates = last_wins, typename Params = default_parallel_params, typename Range>
+        Map build_from(const Range& range, size_t threads);
+        template<typename Map, typename Duplicates = last_wins, typename Params = default_parallel_params, typename Range>
+        Map build_from(const Range& range);
+    }
+}
+
+/*
+
+    Implementation details
+
+*/
+
+/// <summary>
+/// Thread Pool
+/// </summary>
+namespace cppcbb
+{
+    class thread_pool
+    {
+    private:
+        using task = std::function<void()>;
+
+        class worker_queue
+        {
+        public:
+            std::mutex mutex;
+            std::deque<task> tasks;
+        };
+
+        //Pool & queue index of the calling thread, if it is a worker
+        class worker_identity
+        {
+        public:
+            const thread_pool* pool = nullptr;
+            size_t index = 0;
+        };
+
+        size_t m_thread_count;
+        size_t m_queue_count;
+        std::unique_ptr<worker_queue[]> m_queues;
+        std::vector<std::thread> m_workers;
+
+        std::atomic<size_t> m_pending;
+        std::atomic<size_t> m_next_queue;
+
+        std::mutex m_sleep_mutex;
+        std::condition_variable m_wake;
+        bool m_stopping = false;
+
+        static worker_identity& identity()
+        {
+            static thread_local worker_identity current;
+            return current;
+        }
+
+        size_t queue_count() const { return m_queue_count; }
+
+        //Workers push to their own queue, other threads spread tasks round robin
+        size_t submit_queue()
+        {
+            const worker_identity& current = identity();
+            if (current.pool == this)
+            {
+                return current.index;
+            }
+            return m_next_queue.fetch_add(1, std::memory_order_relaxed) % queue_count();
+        }
+
+        bool pop_back(size_t idx, task& out)
+        {
+            std::lock_guard<std::mutex> lock(m_queues[idx].mutex);
+            if (m_queues[idx].tasks.empty())
+            {
+                return false;
+            }
+            out = std::move(m_queues[idx].tasks.back());
+            m_queues[idx].tasks.pop_back();
+            m_pending.fetch_sub(1, std::memory_order_relaxed);
+            return true;
+        }
+
+        bool steal(size_t idx, task& out)
+        {
+            std::lock_guard<std::mutex> lock(m_queues[idx].mutex);
+            if (m_queues[idx].tasks.empty())
+            {
+                return false;
+            }
+            out = std::move(m_queues[idx].tasks.front());
+            m_queues[idx].tasks.pop_front();
+            m_pending.fetch_sub(1, std::memory_order_relaxed);
+            return true;
+        }
+
+        //Own queue first, then steal from the others starting at the next one
+        bool try_pop(size_t home, task& out)
+        {
+            if (pop_back(home, out))
+            {
+                return true;
+            }
+            for (size_t i = 1; i < queue_count(); i++)
+            {
+                if (steal((home + i) % queue_count(), out))
+                {
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        void worker_loop(size_t idx)
+        {
+            identity().pool = this;
+            identity().index = idx;
+
+            while (true)
+            {
+                task current;
+                if (try_pop(idx, current))
+                {
+                    current();
+                    continue;
+                }
+
+                std::unique_lock<std::mutex> lock(m_sleep_mutex);
+                m_wake.wait(lock, [this] { return m_stopping || m_pending.load(std::memory_order_relaxed) > 0; });
+                if (m_stopping && m_pending.load(std::memory_order_relaxed) == 0)
+                {
+                    return;
+                }
+            }
+        }
+
+    public:
+        //The calling thread works too while it waits, so threads - 1 workers are started
+        explicit thread_pool(size_t threads = default_thread_count())
+            : m_thread_count(threads > 0 ? threads : 1)
+            , m_queue_count(m_thread_count > 1 ? m_thread_count - 1 : 1)
+            , m_queues(new worker_queue[m_queue_count])
+            , m_pending(0)
+            , m_next_queue(0)
+        {
+            for (size_t i = 0; i + 1 < m_thread_count; i++)
+            {
+                m_workers.emplace_back(&thread_pool::worker_loop, this, i);
+            }
+        }
+
+        //Runs the queued tasks, then joins the workers
+        ~thread_pool()
+        {
+            {
+                std::lock_guard<std::mutex> lock(m_sleep_mutex);
+                m_stopping = true;
+            }
+            m_wake.notify_all();
+            for (std::thread& worker : m_workers)
+            {
+                worker.join();
+            }
+        }
+
+        thread_pool(const thread_pool&) = delete;
+        thread_pool& operator=(const thread_pool&) = delete;
+
+        static size_t default_thread_count()
+        {
+            unsigned count = std::thread::hardware_concurrency();
+            return count > 0 ? count : 1;
+        }
+
+        //Shared pool with a thread per core
+        static thread_pool& default_pool()
+        {
+            static thread_pool pool;
+            return pool;
+        }
+
+        //Including the thread that waits
+        size_t thread_count() const { return m_thread_count; }
+
+        //Queues func to run on a worker, or runs it now when there are none
+        template<typename Func>
+        void submit(Func func)
+        {
+            if (m_workers.empty())
+            {
+                func();
+                return;
+            }
+
+            size_t idx = submit_queue();
+            {
+                std::lock_guard<std::mutex> lock(m_queues[idx].mutex);
+                m_queues[idx].tasks.emplace_back(std::move(func));
+                m_pending.fetch_add(1, std::memory_order_relaxed);
+            }
+
+            //Taking the lock orders the notify after a worker's check of m_pending
+            {
+                std::lock_guard<std::mutex> lock(m_sleep_mutex);
+            }
+            m_wake.notify_one();
+        }
+
+        //Runs one queued task on the calling thread, returns false if there was none
+        bool run_pending_task()
+        {
+            if (m_workers.empty())
+            {
+                return false;
+            }
+
+            const worker_identity& current = identity();
+            size_t home = current.pool == this ? current.index : 0;
+
+            task found;
+            if (!try_pop(home, found))
+            {
+                return false;
+            }
+            found();
+            return true;
+        }
+
+        //Calls func(i) for i in [0, count) across the pool & returns once all are done
+        //The first exception thrown is rethrown here
+        template<typename Func>
+        void parallel_for(size_t count, Func func);
+    };
+
+    template<typename Func>
+    inline void thread_pool::parallel_for(size_t count, Func func)
+    {
+        if (count == 0)
+        {
+            return;
+        }
+        if (count == 1 || m_workers.empty())
+        {
+            for (size_t i = 0; i < count; i++)
+            {
+                func(i);
+            }
+            return;
+        }
+
+        std::atomic<size_t> remaining(count);
+        std::exception_ptr error;
+        std::mutex error_mutex;
+
+        auto run = [&](size_t i)
+        {
+            try
+            {
+                func(i);
+            }
+            catch (...)
+            {
+                std::lock_guard<std::mutex> lock(error_mutex);
+                if (!error)
+                {
+                    error = std::current_exception();
+                }
+            }
+            remaining.fetch_sub(1, std::memory_order_acq_rel);
+        };
+
+        //The calling thread takes the first index itself
+        for (size_t i = 1; i < count; i++)
+        {
+            submit([&run, i] { run(i); });
+        }
+        run(0);
+
+        while (remaining.load(std::memory_order_acquire) > 0)
+        {
+            if (!run_pending_task())
+            {
+                std::this_thread::yield();
+            }
+        }
+
+        if (error)
+        {
+            std::rethrow_exception(error);
+        }
+    }
+}
+
+/// <summary>
+/// Segment List
+/// </summary>
+namespace cppcbb
+{
+    namespace parallel
+    {
+        template<typename Iterator>
+        class segment_list
+        {
+        private:
+            class segment
+            {
+            public:
+                Iterator first = Iterator();
+                Iterator last = Iterator();
+
+                //Logical index of first
+                size_t offset = 0;
+            };
+
+            cbb_vector<segment> m_segments;
+            size_t m_size = 0;
+
+        public:
+            template<typename Vector>
+            explicit segment_list(Vector& v)
+            {
+                v.for_each_segment([this](Iterator first, Iterator last)
+                {
+                    if (first == last)
+                    {
+                        return;
+                    }
+                    segment run;
+                    run.first = first;
+                    run.last = last;
+                    run.offset = m_size;
+                    m_segments.push_back(run);
+                    m_size += last - first;
+                });
+            }
+
+            size_t size() const { return m_size; }
+            size_t segment_count() const { return m_segments.size(); }
+
+            //Calls func(first, last, index of first) for each run of the logical elements [begin, end)
+            template<typename Func>
+            void for_each_run(size_t begin, size_t end, Func func) const
+            {
+                if (begin >= end)
+                {
+                    return;
+                }
+
+                //Last segment starting at or before begin
+                const segment* first = &m_segments[0];
+                const segment* last = first + m_segments.size();
+                const segment* current = std::upper_bound(first, last, begin
+                    , [](size_t idx, const segment& run) { return idx < run.offset; }) - 1;
+
+                for (; current != last && current->offset < end; ++current)
+                {
+                    size_t run_begin = std::max(begin, current->offset);
+                    size_t run_end = std::min(end, current->offset + (size_t)(current->last - current->first));
+                    func(current->first + (run_begin - current->offset), current->first + (run_end - current->offset), run_begin);
+                }
+            }
+        };
+
+        template<typename Vector>
+        using segment_iterator_of = typename std::conditional<std::is_const<Vector>::value
+            , typename std::remove_const<Vector>::type::const_segment_iterator
+            , typename Vector::segment_iterator>::type;
+
+        template<typename Params>
+        inline size_t chunk_count(size_t size, const thread_pool& pool)
+        {
+            size_t by_grain = (size + Params::min_grain_size - 1) / Params::min_grain_size;
+            size_t by_threads = pool.thread_count() * Params::chunks_per_thread;
+            size_t count = by_grain < by_threads ? by_grain : by_threads;
+            return count > 0 ? count : 1;
+        }
+
+        inline size_t chunk_begin(size_t size, size_t count, size_t chunk)
+        {
+            return (size_t)((uint64_t)size * chunk / count);
+        }
+
+        //Calls func(chunk, begin, end) for each chunk of [0, size) across the pool
+        template<typename Params, typename Func>
+        inline void for_each_chunk(size_t size, thread_pool& pool, Func func)
+        {
+            size_t count = chunk_count<Params>(size, pool);
+            pool.parallel_for(count, [&](size_t chunk)
+            {
+                func(chunk, chunk_begin(size, count, chunk), chunk_begin(size, count, chunk + 1));
+            });
+        }
+    }
+}
+
+/// <summary>
+/// For Each, Transform & Reduce
+/// </summary>
+namespace cppcbb
+{
+    namespace parallel
+    {
+        template<typename Params, typename Vector, typename Func>
+        inline void for_each(Vector& v, Func func, thread_pool& pool)
+        {
+            using iterator = segment_iterator_of<Vector>;
+            segment_list<iterator> segments(v);
+
+            for_each_chunk<Params>(segments.size(), pool, [&](size_t chunk, size_t begin, size_t end)
+            {
+                segments.for_each_run(begin, end, [&](iterator first, iterator last, size_t)
+                {
+                    std::for_each(first, last, func);
+                });
+            });
+        }
+
+        template<typename Params, typename Vector, typename Func>
+        inline void for_each(Vector& v, Func func)
+        {
+            parallel::for_each<Params>(v, func, thread_pool::default_pool());
+        }
+
+        template<typename Params, typename InVector, typename OutVector, typename Op>
+        inline void transform(const InVector& in, OutVector& out, Op op, thread_pool& pool)
+        {
+            using in_iterator = typename InVector::const_segment_iterator;
+            using out_iterator = typename OutVector::segment_iterator;
+
+            out.resize(in.size());
+            segment_list<in_iterator> in_segments(in);
+            segment_list<out_iterator> out_segments(out);
+
+            //Runs of the input are split again wherever the output's runs break
+            for_each_chunk<Params>(in_segments.size(), pool, [&](size_t chunk, size_t begin, size_t end)
+            {
+                in_segments.for_each_run(begin, end, [&](in_iterator first, in_iterator last, size_t in_idx)
+                {
+                    out_segments.for_each_run(in_idx, in_idx + (last - first), [&](out_iterator out_first, out_iterator out_last, size_t out_idx)
+                    {
+                        in_iterator from = first + (out_idx - in_idx);
+                        std::transform(from, from + (out_last - out_first), out_first, op);
+                    });
+                });
+            });
+        }
+
+        template<typename Params, typename InVector, typename OutVector, typename Op>
+        inline void transform(const InVector& in, OutVector& out, Op op)
+        {
+            parallel::transform<Params>(in, out, op, thread_pool::default_pool());
+        }
+
+        template<typename Params, typename Vector, typename T, typename Op>
+        inline T reduce(const Vector& v, T init, Op op, thread_pool& pool)
+        {
+            using iterator = typename Vector::const_segment_iterator;
+            segment_list<iterator> segments(v);
+            if (segments.size() == 0)
+            {
+                return init;
+            }
+
+            //Each chunk folds from its own first element, so init is only used once
+            size_t count = chunk_count<Params>(segments.size(), pool);
+            std::vector<T> partials(count, init);
+
+            pool.parallel_for(count, [&](size_t chunk)
+            {
+                size_t begin = chunk_begin(segments.size(), count, chunk);
+                size_t end = chunk_begin(segments.size(), count, chunk + 1);
+                bool first_run = true;
+                segments.for_each_run(begin, end, [&](iterator first, iterator last, size_t)
+                {
+                    if (first_run)
+                    {
+                        partials[chunk] = *first++;
+                        first_run = false;
+                    }
+                    for (; first != last; ++first)
+                    {
+                        partials[chunk] = op(partials[chunk], *first);
+                    }
+                });
+            });
+
+            T result = init;
+            for (const T& partial : partials)
+            {
+                result = op(result, partial);
+            }
+            return result;
+        }
+
+        template<typename Params, typename Vector, typename T, typename Op>
+        inline T reduce(const Vector& v, T init, Op op)
+        {
+            return parallel::reduce<Params>(v, init, op, thread_pool::default_pool());
+        }
+    }
+}
+
+/// <summary>
+/// Sort
+/// </summary>
+namespace cppcbb
+{
+    namespace parallel
+    {
+        //Merges each pair of neighbouring sorted runs of src into dst, bounds holds run_count + 1 offsets
+        //Every pair is cut into pieces at splitters of its first run, so the final merges still use the whole pool
+        template<typename Source, typename Dest, typename Compare>
+        inline void merge_runs(Source src, Dest dst, std::vector<size_t>& bounds, Compare& comp, thread_pool& pool)
+        {
+            size_t run_count = bounds.size() - 1;
+            size_t pair_count = run_count / 2;
+            size_t pieces = (pool.thread_count() * 2 + pair_count - 1) / pair_count;
+            size_t task_count = pair_count * pieces + (run_count % 2);
+
+            pool.parallel_for(task_count, [&](size_t task)
+            {
+                //Odd run out is only moved
+                if (task == pair_count * pieces)
+                {
+                    size_t begin = bounds[run_count - 1];
+                    std::move(src + begin, src + bounds[run_count], dst + begin);
+                    return;
+                }
+
+                size_t pair = task / pieces;
+                size_t piece = task % pieces;
+                Source a = src + bounds[2 * pair];
+                Source b = src + bounds[2 * pair + 1];
+                Source b_end = src + bounds[2 * pair + 2];
+                size_t a_size = b - a;
+
+                //Elements of b go after equal elements of a, as std::merge does
+                size_t a_lo = a_size * piece / pieces;
+                size_t a_hi = a_size * (piece + 1) / pieces;
+                Source b_lo = piece == 0 ? b : std::lower_bound(b, b_end, a[a_lo], comp);
+                Source b_hi = piece + 1 == pieces ? b_end : std::lower_bound(b, b_end, a[a_hi], comp);
+
+                Dest out = dst + (bounds[2 * pair] + a_lo + (b_lo - b));
+                std::merge(std::make_move_iterator(a + a_lo), std::make_move_iterator(a + a_hi)
+                    , std::make_move_iterator(b_lo), std::make_move_iterator(b_hi), out, comp);
+            });
+
+            std::vector<size_t> merged;
+            for (size_t i = 0; i < run_count; i += 2)
+            {
+                merged.push_back(bounds[i]);
+            }
+            merged.push_back(bounds[run_count]);
+            bounds.swap(merged);
+        }
+
+        //Sorts [data, data + size) using scratch, which holds size elements
+        //The merges are stable, so the sort is stable when the chunks are
+        template<typename Params, bool Stable, typename Iterator, typename Elem, typename Compare>
+        inline void sort_contiguous(Iterator data, Elem* scratch, size_t size, Compare& comp, thread_pool& pool)
+        {
+            size_t count = chunk_count<Params>(size, pool);
+            std::vector<size_t> bounds;
+            for (size_t chunk = 0; chunk <= count; chunk++)
+            {
+                bounds.push_back(chunk_begin(size, count, chunk));
+            }
+
+            pool.parallel_for(count, [&](size_t chunk)
+            {
+                if (Stable)
+                {
+                    std::stable_sort(data + bounds[chunk], data + bounds[chunk + 1], comp);
+                }
+                else
+                {
+                    std::sort(data + bounds[chunk], data + bounds[chunk + 1], comp);
+                }
+            });
+
+            //Ping pong between data & scratch
+            bool in_scratch = false;
+            while (bounds.size() > 2)
+            {
+                if (in_scratch)
+                {
+                    merge_runs(scratch, data, bounds, comp, pool);
+                }
+                else
+                {
+                    merge_runs(data, scratch, bounds, comp, pool);
+                }
+                in_scratch = !in_scratch;
+            }
+
+            if (in_scratch)
+            {
+                for_each_chunk<Params>(size, pool, [&](size_t chunk, size_t begin, size_t end)
+                {
+                    std::move(scratch + begin, scratch + end, data + begin);
+                });
+            }
+        }
+
+        template<typename Params, bool Stable, typename Vector, typename Compare>
+        inline void sort_vector(Vector& v, Compare& comp, thread_pool& pool)
+        {
+            using iterator = typename Vector::segment_iterator;
+            using Elem = typename Vector::value_type;
+
+            segment_list<iterator> segments(v);
+            size_t size = segments.size();
+            if (size < 2)
+            {
+                return;
+            }
+
+            std::unique_ptr<Elem[]> scratch(new Elem[size]());
+            if (segments.segment_count() == 1)
+            {
+                iterator data = iterator();
+                segments.for_each_run(0, size, [&](iterator first, iterator, size_t) { data = first; });
+                sort_contiguous<Params, Stable>(data, scratch.get(), size, comp, pool);
+                return;
+            }
+
+            //Split storage is gathered, sorted & scattered back
+            std::unique_ptr<Elem[]> gathered(new Elem[size]());
+            for_each_chunk<Params>(size, pool, [&](size_t chunk, size_t begin, size_t end)
+            {
+                segments.for_each_run(begin, end, [&](iterator first, iterator last, size_t idx)
+                {
+                    std::move(first, last, gathered.get() + idx);
+                });
+            });
+
+            sort_contiguous<Params, Stable>(gathered.get(), scratch.get(), size, comp, pool);
+
+            for_each_chunk<Params>(size, pool, [&](size_t chunk, size_t begin, size_t end)
+            {
+                segments.for_each_run(begin, end, [&](iterator first, iterator last, size_t idx)
+                {
+                    std::move(gathered.get() + idx, gathered.get() + idx + (last - first), first);
+                });
+            });
+        }
+
+        template<typename Params, typename Vector, typename Compare>
+        inline void sort(Vector& v, Compare comp, thread_pool& pool)
+        {
+            sort_vector<Params, false>(v, comp, pool);
+        }
+
+        template<typename Params, typename Vector, typename Compare>
+        inline void sort(Vector& v, Compare comp)
+        {
+            parallel::sort<Params>(v, comp, thread_pool::default_pool());
+        }
+
+        template<typename Params, typename Vector>
+        inline void sort(Vector& v)
+        {
+            parallel::sort<Params>(v, std::less<typename Vector::value_type>(), thread_pool::default_pool());
+        }
+
+        template<typename Params, typename Vector, typename Compare>
+        inline void stable_sort(Vector& v, Compare comp, thread_pool& pool)
+        {
+            sort_vector<Params, true>(v, comp, pool);
+        }
+
+        template<typename Params, typename Vector, typename Compare>
+        inline void stable_sort(Vector& v, Compare comp)
+        {
+            parallel::stable_sort<Params>(v, comp, thread_pool::default_pool());
+        }
+    }
+}
+
+/// <summary>
+/// Stable Partition & Erase If
+/// </summary>
+namespace cppcbb
+{
+    namespace parallel
+    {
+        //Moves the matching elements to the front of the vector, keeping their order, in three parallel passes:
+        //flag & count per chunk, move into scratch at the prefix offsets, then move back
+        //The rest follow the matching elements if keep_rest, otherwise they are left moved from at the end
+        //Returns the number of matching elements
+        template<typename Params, typename Vector, typename Pred>
+        inline size_t partition_into_front(Vector& v, Pred& pred, bool keep_rest, thread_pool& pool)
+        {
+            using iterator = typename Vector::segment_iterator;
+            using Elem = typename Vector::value_type;
+
+            segment_list<iterator> segments(v);
+            size_t size = segments.size();
+            if (size == 0)
+            {
+                return 0;
+            }
+
+            size_t count = chunk_count<Params>(size, pool);
+            std::unique_ptr<uint8_t[]> matches(new uint8_t[size]);
+            std::vector<size_t> match_offsets(count + 1, 0);
+
+            pool.parallel_for(count, [&](size_t chunk)
+            {
+                size_t matched = 0;
+                segments.for_each_run(chunk_begin(size, count, chunk), chunk_begin(size, count, chunk + 1), [&](iterator first, iterator last, size_t idx)
+                {
+                    for (; first != last; ++first, ++idx)
+                    {
+                        matches[idx] = pred(*first) ? 1 : 0;
+                        matched += matches[idx];
+                    }
+                });
+                match_offsets[chunk + 1] = matched;
+            });
+
+            for (size_t chunk = 0; chunk < count; chunk++)
+            {
+                match_offsets[chunk + 1] += match_offsets[chunk];
+            }
+            size_t total_matched = match_offsets[count];
+
+            if (total_matched == size || total_matched == 0)
+            {
+                return total_matched;
+            }
+
+            size_t moved_size = keep_rest ? size : total_matched;
+            std::unique_ptr<Elem[]> scratch(new Elem[moved_size]());
+
+            pool.parallel_for(count, [&](size_t chunk)
+            {
+                size_t begin = chunk_begin(size, count, chunk);
+                size_t match_out = match_offsets[chunk];
+                size_t rest_out = total_matched + (begin - match_offsets[chunk]);
+                segments.for_each_run(begin, chunk_begin(size, count, chunk + 1), [&](iterator first, iterator last, size_t idx)
+                {
+                    for (; first != last; ++first, ++idx)
+                    {
+                        if (matches[idx])
+                        {
+                            scratch[match_out++] = std::move(*first);
+                        }
+                        else if (keep_rest)
+                        {
+                            scratch[rest_out++] = std::move(*first);
+                        }
+                    }
+                });
+            });
+
+            for_each_chunk<Params>(moved_size, pool, [&](size_t chunk, size_t begin, size_t end)
+            {
+                segments.for_each_run(begin, end, [&](iterator first, iterator last, size_t idx)
+                {
+                    std::move(scratch.get() + idx, scratch.get() + idx + (last - first), first);
+                });
+            });
+
+            return total_matched;
+        }
+
+        template<typename Params, typename Vector, typename Pred>
+        inline size_t stable_partition(Vector& v, Pred pred, thread_pool& pool)
+        {
+            return partition_into_front<Params>(v, pred, true, pool);
+        }
+
+        template<typename Params, typename Vector, typename Pred>
+        inline size_t stable_partition(Vector& v, Pred pred)
+        {
+            return parallel::stable_partition<Params>(v, pred, thread_pool::default_pool());
+        }
+
+        template<typename Params, typename Vector, typename Pred>
+        inline size_t erase_if(Vector& v, Pred pred, thread_pool& pool)
+        {
+            auto keep = [&pred](const typename Vector::value_type& elem) { return !pred(elem); };
+            size_t size = v.size();
+            size_t kept = partition_into_front<Params>(v, keep, false, pool);
+            v.resize(kept);
+            return size - kept;
+        }
+
+        template<typename Params, typename Vector, typename Pred>
+        inline size_t erase_if(Vector& v, Pred pred)
+        {
+            return parallel::erase_if<Params>(v, pred, thread_pool::default_pool());
+        }
+    }
+}
+
+/// <summary>
+/// Build From
+/// </summary>
+namespace cppcbb
+{
+    namespace parallel
+    {
+        template<typename Params, typename Iterator, typename Elem>
+        inline void copy_range(Iterator first, size_t size, Elem* out, thread_pool& pool, std::random_access_iterator_tag)
+        {
+            for_each_chunk<Params>(size, pool, [&](size_t chunk, size_t begin, size_t end)
+            {
+                for (size_t i = begin; i < end; i++)
+                {
+                    out[i] = Elem(first[i]);
+                }
+            });
+        }
+
+        //Ranges without random access are copied by the calling thread
+        template<typename Params, typename Iterator, typename Elem>
+        inline void copy_range(Iterator first, size_t size, Elem* out, thread_pool& pool, std::forward_iterator_tag)
+        {
+            for (size_t i = 0; i < size; i++, ++first)
+            {
+                out[i] = Elem(*first);
+            }
+        }
+
+        //Single pass ranges can't be measured & then read, so they are buffered first
+        template<typename Map, typename Duplicates, typename Params, typename Range>
+        inline Map build_from(const Range& range, thread_pool& pool, std::input_iterator_tag)
+        {
+            std::vector<typename Map::Elem> buffer;
+            for (auto it = std::begin(range), end = std::end(range); it != end; ++it)
+            {
+                buffer.push_back(typename Map::Elem(*it));
+            }
+            return parallel::build_from<Map, Duplicates, Params>(buffer, pool);
+        }
+
+        template<typename Map, typename Duplicates, typename Params, typename Range>
+        inline Map build_from(const Range& range, thread_pool& pool, std::forward_iterator_tag)
+        {
+            using Elem = typename Map::Elem;
+            using range_iterator = decltype(std::begin(range));
+            using vector_type = typename std::remove_reference<decltype(std::declval<Map&>().bulk_elements(0))>::type;
+            using iterator = typename vector_type::segment_iterator;
+
+            Map map;
+            size_t size = (size_t)std::distance(std::begin(range), std::end(range));
+            if (size == 0)
+            {
+                return map;
+            }
+
+            std::unique_ptr<Elem[]> entries(new Elem[size]());
+            copy_range<Params>(std::begin(range), size, entries.get(), pool
+                , typename std::iterator_traits<range_iterator>::iterator_category());
+
+            //Stable, so equal keys stay in range order for the duplicate policy
+            {
+                auto by_key = [](const Elem& left, const Elem& right) { return left.first < right.first; };
+                std::unique_ptr<Elem[]> scratch(new Elem[size]());
+                sort_contiguous<Params, true>(entries.get(), scratch.get(), size, by_key, pool);
+            }
+
+            //Keeps the last (or first) of each run of equal keys, counting the kept entries per chunk
+            size_t count = chunk_count<Params>(size, pool);
+            std::vector<size_t> offsets(count + 1, 0);
+            auto is_kept = [&](size_t i)
+            {
+                if (Duplicates::keep_last)
+                {
+                    return i + 1 == size || entries[i].first < entries[i + 1].first;
+                }
+                return i == 0 || entries[i - 1].first < entries[i].first;
+            };
+
+            pool.parallel_for(count, [&](size_t chunk)
+            {
+                size_t kept = 0;
+                for (size_t i = chunk_begin(size, count, chunk); i < chunk_begin(size, count, chunk + 1); i++)
+                {
+                    kept += is_kept(i) ? 1 : 0;
+                }
+                offsets[chunk + 1] = kept;
+            });
+
+            for (size_t chunk = 0; chunk < count; chunk++)
+            {
+                offsets[chunk + 1] += offsets[chunk];
+            }
+
+            //Each chunk's kept entries fill a contiguous range of the final storage
+            vector_type& elements = map.bulk_elements(offsets[count]);
+            if (elements.size() != offsets[count])
+            {
+                //Static storage too small for the unique keys, left empty
+                map.bulk_elements(0);
+                map.bulk_commit();
+                return map;
+            }
+            segment_list<iterator> segments(elements);
+
+            pool.parallel_for(count, [&](size_t chunk)
+            {
+                size_t i = chunk_begin(size, count, chunk);
+                segments.for_each_run(offsets[chunk], offsets[chunk + 1], [&](iterator first, iterator last, size_t)
+                {
+                    for (; first != last; ++first, ++i)
+                    {
+                        while (!is_kept(i))
+                        {
+                            ++i;
+                        }
+                        *first = std::move(entries[i]);
+                    }
+                });
+            });
+
+            map.bulk_commit();
+            return map;
+        }
+
+        template<typename Map, typename Duplicates, typename Params, typename Range>
+        inline Map build_from(const Range& range, thread_pool& pool)
+        {
+            using range_iterator = decltype(std::begin(range));
+            return parallel::build_from<Map, Duplicates, Params>(range, pool
+                , typename std::iterator_traits<range_iterator>::iterator_category());
+        }
+
+        template<typename Map, typename Duplicates, typename Params, typename Range>
+        inline Map build_from(const Range& range, size_t threads)
+        {
+            thread_pool pool(threads);
+            return parallel::build_from<Map, Duplicates, Params>(range, pool);
+        }
+
+        template<typename Map, typename Duplicates, typename Params, typename Range>
+        inline Map build_from(const Range& range)
+        {
+            return parallel::build_from<Map, Duplicates, Params>(range, thread_pool::default_pool());
+        }
+    }
+}
+
+#endif //CPPCBB_INCLUDE_CBB_PARALLEL_H
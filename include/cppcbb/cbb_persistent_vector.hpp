@@ -0,0 +1,523 @@
+//Copyright(C) 2020 Henry Bullingham
+//This file is subject to the license terms in the LICENSE file
+//found in the top - level directory of this distribution.
+
+#pragma once
+
+#if !defined (CPPCBB_INCLUDE_CBB_PERSISTENT_VECTOR_H)
+#define CPPCBB_INCLUDE_CBB_PERSISTENT_VECTOR_H
+
+#include "cbb_common.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <iterator>
+#include <utility>
+
+namespace cppcbb
+{
+    /// <summary>
+    /// Data for persistent vectors
+    /// </summary>
+    class default_persistent_vector_params
+    {
+    public:
+        //Each trie node holds 2^branch_bits children or elements
+        static constexpr unsigned branch_bits = 5;
+    };
+
+    /// <summary>
+    /// Vector stored as a radix trie of refcounted chunks, with structural sharing between copies
+    /// Copies share every chunk, a write copies only the chunks on the path to the element it touches
+    /// O(1) copy
+    /// O(log n) indexed access, push_back & pop_back (log base 2^branch_bits, so at most a few levels)
+    /// Copies may be read & written from other threads while this one is written
+    /// </summary>
+    /// <typeparam name="Elem"></typeparam>
+    /// <typeparam name="Params"></typeparam>
+    template<typename Elem, typename Params = default_persistent_vector_params>
+    class cbb_persistent_vector;
+}
+
+/*
+
+    Implementation details
+
+*/
+
+/// <summary>
+/// Persistent Vector
+/// </summary>
+namespace cppcbb
+{
+    template<typename Elem, typename Params>
+    class cbb_persistent_vector
+    {
+    private:
+        static constexpr unsigned k_bits = Params::branch_bits;
+        static constexpr size_t k_width = (size_t)1 << k_bits;
+        static constexpr size_t k_mask = k_width - 1;
+
+        class node
+        {
+        public:
+            std::atomic<uint32_t> refs;
+
+            node() : refs(1) {}
+        };
+
+        class leaf : public node
+        {
+        public:
+            Elem values[k_width];
+        };
+
+        class branch : public node
+        {
+        public:
+            node* children[k_width];
+
+            branch()
+            {
+                for (size_t i = 0; i < k_width; i++)
+                {
+                    children[i] = nullptr;
+                }
+            }
+        };
+
+        //Levels below the root are implied by m_shift, the level of a node is the shift of its children
+        node* m_root = nullptr;
+        unsigned m_shift = 0;
+        size_t m_size = 0;
+
+        static node* acquire(node* n)
+        {
+            if (n != nullptr)
+            {
+                n->refs.fetch_add(1, std::memory_order_relaxed);
+            }
+            return n;
+        }
+
+        static void release(node* n, unsigned shift);
+
+        //Copies the node if it is shared, so it can be written
+        static void make_unique(node*& slot, unsigned shift);
+
+        //Capacity of a trie whose root children are at shift
+        size_t capacity() const
+        {
+            return m_root == nullptr ? 0 : k_width << m_shift;
+        }
+
+        const Elem& get(size_t idx) const
+        {
+            const node* current = m_root;
+            for (unsigned shift = m_shift; shift > 0; shift -= k_bits)
+            {
+                current = static_cast<const branch*>(current)->children[(idx >> shift) & k_mask];
+            }
+            return static_cast<const leaf*>(current)->values[idx & k_mask];
+        }
+
+        //Copies the shared chunks on the path to idx, creating missing ones
+        Elem& get_unique(size_t idx);
+
+        //Drops the chunks holding nothing but idx, returns true if slot was dropped
+        static bool pop(node*& slot, unsigned shift, size_t idx);
+
+        //Calls func(first, last) for each leaf under n holding elements of [begin, end)
+        template<typename Func>
+        static void for_each_leaf(const node* n, unsigned shift, size_t base, size_t end, Func& func);
+
+    public:
+        using value_type = Elem;
+
+        /// <summary>
+        /// Forward iterator, finding the next chunk once per chunk
+        /// </summary>
+        class const_iterator
+        {
+        private:
+            const cbb_persistent_vector* m_vector = nullptr;
+            const Elem* m_chunk = nullptr;
+            size_t m_idx = 0;
+
+            void find_chunk()
+            {
+                m_chunk = m_idx < m_vector->size() ? &m_vector->get(m_idx & ~k_mask) : nullptr;
+            }
+
+        public:
+            using iterator_category = std::forward_iterator_tag;
+            using value_type = Elem;
+            using difference_type = std::ptrdiff_t;
+            using pointer = const Elem*;
+            using reference = const Elem&;
+
+            const_iterator() {}
+            const_iterator(const cbb_persistent_vector* vector, size_t idx)
+                : m_vector(vector)
+                , m_idx(idx)
+            {
+                find_chunk();
+            }
+
+            const Elem& operator*() const { return m_chunk[m_idx & k_mask]; }
+            const Elem* operator->() const { return &m_chunk[m_idx & k_mask]; }
+
+            const_iterator& operator++()
+            {
+                ++m_idx;
+                if ((m_idx & k_mask) == 0)
+                {
+                    find_chunk();
+                }
+                return *this;
+            }
+
+            const_iterator operator++(int)
+            {
+                const_iterator copy = *this;
+                ++(*this);
+                return copy;
+            }
+
+            bool operator==(const const_iterator& other) const { return m_idx == other.m_idx; }
+            bool operator!=(const const_iterator& other) const { return m_idx != other.m_idx; }
+        };
+
+        using iterator = const_iterator;
+
+        cbb_persistent_vector() {}
+        ~cbb_persistent_vector() { clear(); }
+
+        //Shares every chunk
+        cbb_persistent_vector(const cbb_persistent_vector& other)
+            : m_root(acquire(other.m_root))
+            , m_shift(other.m_shift)
+            , m_size(other.m_size)
+        {}
+
+        cbb_persistent_vector(cbb_persistent_vector&& other) noexcept
+            : m_root(other.m_root)
+            , m_shift(other.m_shift)
+            , m_size(other.m_size)
+        {
+            other.m_root = nullptr;
+            other.m_shift = 0;
+            other.m_size = 0;
+        }
+
+        cbb_persistent_vector& operator=(const cbb_persistent_vector& other)
+        {
+            node* root = acquire(other.m_root);
+            clear();
+            m_root = root;
+            m_shift = other.m_shift;
+            m_size = other.m_size;
+            return *this;
+        }
+
+        cbb_persistent_vector& operator=(cbb_persistent_vector&& other) noexcept
+        {
+            if (this != &other)
+            {
+                clear();
+                std::swap(m_root, other.m_root);
+                std::swap(m_shift, other.m_shift);
+                std::swap(m_size, other.m_size);
+            }
+            return *this;
+        }
+
+        const_iterator begin() const { return const_iterator(this, 0); }
+        const_iterator end() const { return const_iterator(this, m_size); }
+
+        const_iterator cbegin() const { return begin(); }
+        const_iterator cend() const { return end(); }
+
+        size_t size() const { return m_size; }
+        bool empty() const { return m_size == 0; }
+
+        void push_back(const Elem& elem)
+        {
+            Elem copy = elem;
+            push_back(std::move(copy));
+        }
+
+        void push_back(Elem&& elem);
+
+        template<typename ... Args>
+        void emplace_back(Args&& ... args)
+        {
+            push_back(Elem(std::forward<Args>(args)...));
+        }
+
+        Elem& back()
+        {
+            CPPCBB_ASSERT((m_size > 0), "No elements in vector!");
+            return get_unique(m_size - 1);
+        }
+
+        const Elem& back() const
+        {
+            CPPCBB_ASSERT((m_size > 0), "No elements in vector!");
+            return get(m_size - 1);
+        }
+
+        void pop_back();
+
+        //Removes all elements matching the predicate, rebuilding the trie, returns the number removed
+        template<typename Pred>
+        size_t erase_if(Pred pred);
+
+        void clear()
+        {
+            release(m_root, m_shift);
+            m_root = nullptr;
+            m_shift = 0;
+            m_size = 0;
+        }
+
+        void resize(size_t size);
+
+        //Calls func(first, last) for each chunk of elements, in order
+        template<typename Func>
+        void for_each_segment(Func func) const
+        {
+            if (m_root != nullptr)
+            {
+                for_each_leaf(m_root, m_shift, 0, m_size, func);
+            }
+        }
+
+        //Writing copies the shared chunks on the path to the element
+        Elem& operator[](size_t idx)
+        {
+            CPPCBB_ASSERT((idx < m_size), "Out of bounds access!");
+            return get_unique(idx);
+        }
+
+        const Elem& operator[](size_t idx) const
+        {
+            CPPCBB_ASSERT((idx < m_size), "Out of bounds access!");
+            return get(idx);
+        }
+
+        //True if the chunk holding idx is shared with a copy
+        bool is_shared(size_t idx) const
+        {
+            CPPCBB_ASSERT((idx < m_size), "Out of bounds access!");
+            const node* current = m_root;
+            for (unsigned shift = m_shift; ; shift -= k_bits)
+            {
+                if (current->refs.load(std::memory_order_acquire) > 1)
+                {
+                    return true;
+                }
+                if (shift == 0)
+                {
+                    return false;
+                }
+                current = static_cast<const branch*>(current)->children[(idx >> shift) & k_mask];
+            }
+        }
+    };
+
+    template<typename Elem, typename Params>
+    inline void cbb_persistent_vector<Elem, Params>::release(node* n, unsigned shift)
+    {
+        if (n == nullptr || n->refs.fetch_sub(1, std::memory_order_acq_rel) != 1)
+        {
+            return;
+        }
+
+        if (shift == 0)
+        {
+            delete static_cast<leaf*>(n);
+            return;
+        }
+
+        branch* b = static_cast<branch*>(n);
+        for (size_t i = 0; i < k_width; i++)
+        {
+            release(b->children[i], shift - k_bits);
+        }
+        delete b;
+    }
+
+    template<typename Elem, typename Params>
+    inline void cbb_persistent_vector<Elem, Params>::make_unique(node*& slot, unsigned shift)
+    {
+        //Only this vector can reach a node with a single reference, so nobody can share it meanwhile
+        if (slot->refs.load(std::memory_order_acquire) == 1)
+        {
+            return;
+        }
+
+        node* copy;
+        if (shift == 0)
+        {
+            leaf* l = new leaf();
+            const leaf* from = static_cast<const leaf*>(slot);
+            for (size_t i = 0; i < k_width; i++)
+            {
+                l->values[i] = from->values[i];
+            }
+            copy = l;
+        }
+        else
+        {
+            branch* b = new branch();
+            const branch* from = static_cast<const branch*>(slot);
+            for (size_t i = 0; i < k_width; i++)
+            {
+                b->children[i] = acquire(from->children[i]);
+            }
+            copy = b;
+        }
+
+        release(slot, shift);
+        slot = copy;
+    }
+
+    template<typename Elem, typename Params>
+    inline Elem& cbb_persistent_vector<Elem, Params>::get_unique(size_t idx)
+    {
+        node** slot = &m_root;
+        for (unsigned shift = m_shift; ; shift -= k_bits)
+        {
+            if (*slot == nullptr)
+            {
+                *slot = shift == 0 ? static_cast<node*>(new leaf()) : static_cast<node*>(new branch());
+            }
+            else
+            {
+                make_unique(*slot, shift);
+            }
+
+            if (shift == 0)
+            {
+                return static_cast<leaf*>(*slot)->values[idx & k_mask];
+            }
+            slot = &static_cast<branch*>(*slot)->children[(idx >> shift) & k_mask];
+        }
+    }
+
+    template<typename Elem, typename Params>
+    inline void cbb_persistent_vector<Elem, Params>::push_back(Elem&& elem)
+    {
+        //A full trie grows a level, with the old root as its first child
+        if (m_size == capacity() && m_root != nullptr)
+        {
+            branch* root = new branch();
+            root->children[0] = m_root;
+            m_root = root;
+            m_shift += k_bits;
+        }
+
+        get_unique(m_size) = std::move(elem);
+        m_size++;
+    }
+
+    template<typename Elem, typename Params>
+    inline bool cbb_persistent_vector<Elem, Params>::pop(node*& slot, unsigned shift, size_t idx)
+    {
+        //idx is the first element under slot, so the whole chunk goes
+        if ((idx & ((k_width << shift) - 1)) == 0)
+        {
+            release(slot, shift);
+            slot = nullptr;
+            return true;
+        }
+
+        make_unique(slot, shift);
+        if (shift == 0)
+        {
+            static_cast<leaf*>(slot)->values[idx & k_mask] = Elem();
+            return false;
+        }
+
+        pop(static_cast<branch*>(slot)->children[(idx >> shift) & k_mask], shift - k_bits, idx);
+        return false;
+    }
+
+    template<typename Elem, typename Params>
+    inline void cbb_persistent_vector<Elem, Params>::pop_back()
+    {
+        CPPCBB_ASSERT((m_size > 0), "No elements in vector!");
+        m_size--;
+        pop(m_root, m_shift, m_size);
+        if (m_root == nullptr)
+        {
+            m_shift = 0;
+        }
+
+        //Drop root levels holding a single child
+        while (m_shift > 0 && static_cast<branch*>(m_root)->children[1] == nullptr)
+        {
+            node* child = acquire(static_cast<branch*>(m_root)->children[0]);
+            release(m_root, m_shift);
+            m_root = child;
+            m_shift -= k_bits;
+        }
+    }
+
+    template<typename Elem, typename Params>
+    template<typename Pred>
+    inline size_t cbb_persistent_vector<Elem, Params>::erase_if(Pred pred)
+    {
+        cbb_persistent_vector kept;
+        for (const Elem& elem : *this)
+        {
+            if (!pred(elem))
+            {
+                kept.push_back(elem);
+            }
+        }
+
+        size_t removed = m_size - kept.m_size;
+        if (removed > 0)
+        {
+            *this = std::move(kept);
+        }
+        return removed;
+    }
+
+    template<typename Elem, typename Params>
+    inline void cbb_persistent_vector<Elem, Params>::resize(size_t new_size)
+    {
+        while (m_size > new_size)
+        {
+            pop_back();
+        }
+        while (m_size < new_size)
+        {
+            push_back(Elem());
+        }
+    }
+
+    template<typename Elem, typename Params>
+    template<typename Func>
+    inline void cbb_persistent_vector<Elem, Params>::for_each_leaf(const node* n, unsigned shift, size_t base, size_t end, Func& func)
+    {
+        if (shift == 0)
+        {
+            const leaf* l = static_cast<const leaf*>(n);
+            size_t count = end - base < k_width ? end - base : k_width;
+            func((const Elem*)l->values, (const Elem*)l->values + count);
+            return;
+        }
+
+        const branch* b = static_cast<const branch*>(n);
+        size_t child_size = (size_t)1 << shift;
+        for (size_t i = 0; i < k_width && base + i * child_size < end; i++)
+        {
+            for_each_leaf(b->children[i], shift - k_bits, base + i * child_size, end, func);
+        }
+    }
+}
+
+#endif //CPPCBB_INCLUDE_CBB_PERSISTENT_VECTOR_H
@@ -0,0 +1,528 @@
+//Copyright(C) 2020 Henry Bullingham
+//This file is subject to the license terms in the LICENSE file
+//found in the top - level directory of this distribution.
+
+#pragma once
+
+#if !defined (CPPCBB_INCLUDE_CBB_POOL_H)
+#define CPPCBB_INCLUDE_CBB_POOL_H
+
+#include "cbb_common.hpp"
+#include "cbb_vector.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace cppcbb
+{
+    /// <summary>
+    /// Pool slot, holding either an object or the index of the next free slot
+    /// </summary>
+    /// <typeparam name="Elem"></typeparam>
+    template<typename Elem>
+    union pool_slot
+    {
+        typename std::aligned_storage<sizeof(Elem), alignof(Elem)>::type storage;
+        uint32_t next_free;
+    };
+
+    /// <summary>
+    /// Data for chunked pool storage
+    /// </summary>
+    class default_pool_storage_params
+    {
+    public:
+        //Slots per chunk, chunks never move once allocated
+        static constexpr size_t chunk_size = 256;
+    };
+
+    /// <summary>
+    /// Represents pool storage as a list of fixed size chunks, adding a chunk when the pool runs dry
+    /// </summary>
+    /// <typeparam name="Elem"></typeparam>
+    /// <typeparam name="Params"></typeparam>
+    template<typename Elem, typename Params = default_pool_storage_params>
+    class dynamic_pool_storage;
+
+    /// <summary>
+    /// Represents pool storage as a fixed array of slots
+    /// Never allocates
+    /// </summary>
+    /// <typeparam name="Elem"></typeparam>
+    template<typename Elem, size_t Capacity = 16>
+    class static_pool_storage;
+
+    /// <summary>
+    /// Snapshot of pool usage
+    /// </summary>
+    class pool_occupancy
+    {
+    public:
+        //Slots handed out
+        size_t live = 0;
+        size_t capacity = 0;
+        //Most slots handed out at once
+        size_t peak = 0;
+    };
+
+    /// <summary>
+    /// Object pool, handing out slots from a free list threaded through the unused slots
+    /// Objects never move, so pointers & indices stay valid until destroyed
+    /// O(1) create & destroy
+    /// </summary>
+    /// <typeparam name="Elem"></typeparam>
+    /// <typeparam name="Storage"></typeparam>
+    /// <typeparam name="Bitmap">Vector of uint64_t holding the live bits</typeparam>
+    template<typename Elem, typename Storage = dynamic_pool_storage<Elem>, typename Bitmap = cbb_vector<uint64_t>>
+    class cbb_pool;
+
+    template<typename Elem, size_t Capacity = 16>
+    using cbb_static_pool = cbb_pool<Elem, static_pool_storage<Elem, Capacity>, cbb_static_vector<uint64_t, (Capacity + 63) / 64>>;
+
+    /// <summary>
+    /// Pool guarded by a mutex, to be shared between threads
+    /// Hands out slots in batches to pool caches
+    /// </summary>
+    /// <typeparam name="Pool"></typeparam>
+    template<typename Pool>
+    class cbb_shared_pool;
+
+    /// <summary>
+    /// Data for pool caches
+    /// </summary>
+    class default_pool_cache_params
+    {
+    public:
+        //Slots taken from or returned to the shared pool at once
+        static constexpr size_t batch_size = 32;
+    };
+
+    /// <summary>
+    /// Per thread front end to a shared pool, keeping free slots locally so most creates & destroys take no lock
+    /// Must be destroyed before the shared pool
+    /// </summary>
+    /// <typeparam name="SharedPool"></typeparam>
+    /// <typeparam name="Params"></typeparam>
+    template<typename SharedPool, typename Params = default_pool_cache_params>
+    class pool_cache;
+}
+
+/*
+
+    Implementation details
+
+*/
+
+/// <summary>
+/// Dynamic Pool Storage
+/// </summary>
+namespace cppcbb
+{
+    template<typename Elem, typename Params>
+    class dynamic_pool_storage
+    {
+    public:
+        using slot_type = pool_slot<Elem>;
+
+    private:
+        static constexpr size_t k_chunk_size = Params::chunk_size;
+        static_assert(k_chunk_size > 0, "Chunks must hold at least one slot");
+
+        class chunk_range
+        {
+        public:
+            const slot_type* begin = nullptr;
+            size_t first = 0;
+        };
+
+        //In index order
+        cbb_vector<std::unique_ptr<slot_type[]>> m_chunks;
+
+        //Sorted by address, to map pointers back to indices
+        cbb_vector<chunk_range> m_ranges;
+
+    public:
+        size_t capacity() const { return m_chunks.size() * k_chunk_size; }
+
+        slot_type& slot(size_t idx) { return m_chunks[idx / k_chunk_size][idx % k_chunk_size]; }
+        const slot_type& slot(size_t idx) const { return m_chunks[idx / k_chunk_size][idx % k_chunk_size]; }
+
+        //O(log chunks), branch free since freed pointers arrive in no predictable order
+        size_t index_of(const slot_type* ptr) const
+        {
+            const chunk_range* range = m_ranges.begin();
+            for (size_t count = m_ranges.size(); count > 1; count -= count / 2)
+            {
+                range = range[count / 2].begin <= ptr ? range + count / 2 : range;
+            }
+            return range->first + (size_t)(ptr - range->begin);
+        }
+
+        //New slots are [old capacity, capacity())
+        bool grow()
+        {
+            chunk_range range;
+            range.first = capacity();
+            m_chunks.push_back(std::unique_ptr<slot_type[]>(new slot_type[k_chunk_size]));
+            range.begin = m_chunks.back().get();
+
+            chunk_range* pos = std::upper_bound(m_ranges.begin(), m_ranges.end(), range.begin,
+                [](const slot_type* p, const chunk_range& r) { return p < r.begin; });
+            m_ranges.insert(pos, range);
+            return true;
+        }
+    };
+}
+
+/// <summary>
+/// Static Pool Storage
+/// </summary>
+namespace cppcbb
+{
+    template<typename Elem, size_t Capacity>
+    class static_pool_storage
+    {
+    public:
+        using slot_type = pool_slot<Elem>;
+
+    private:
+        slot_type m_slots[Capacity];
+
+    public:
+        size_t capacity() const { return Capacity; }
+
+        slot_type& slot(size_t idx) { return m_slots[idx]; }
+        const slot_type& slot(size_t idx) const { return m_slots[idx]; }
+
+        size_t index_of(const slot_type* ptr) const { return (size_t)(ptr - m_slots); }
+
+        bool grow() { return false; }
+    };
+}
+
+/// <summary>
+/// Pool
+/// </summary>
+namespace cppcbb
+{
+    template<typename Elem, typename Storage, typename Bitmap>
+    class cbb_pool
+    {
+    public:
+        using value_type = Elem;
+
+    private:
+        using slot_type = typename Storage::slot_type;
+
+        static constexpr uint32_t k_none = UINT32_MAX;
+
+        Storage m_storage;
+        Bitmap m_live;
+        uint32_t m_free_head = k_none;
+        size_t m_size = 0;
+        size_t m_peak = 0;
+
+        //Links the slots from first to the end of storage into the free list, lowest index handed out first
+        void link_free(size_t first)
+        {
+            CPPCBB_ASSERT(m_storage.capacity() <= k_none, "Pool capacity must fit slot indices");
+            for (size_t idx = m_storage.capacity(); idx > first; idx--)
+            {
+                m_storage.slot(idx - 1).next_free = m_free_head;
+                m_free_head = (uint32_t)(idx - 1);
+            }
+
+            while (m_live.size() * 64 < m_storage.capacity())
+            {
+                m_live.push_back(0);
+            }
+        }
+
+        static Elem* object(slot_type& slot) { return reinterpret_cast<Elem*>(&slot.storage); }
+        static const Elem* object(const slot_type& slot) { return reinterpret_cast<const Elem*>(&slot.storage); }
+
+    public:
+        cbb_pool()
+        {
+            link_free(0);
+        }
+
+        //Handed out pointers must stay valid
+        cbb_pool(const cbb_pool&) = delete;
+        cbb_pool& operator=(const cbb_pool&) = delete;
+
+        ~cbb_pool()
+        {
+            clear();
+        }
+
+        size_t size() const { return m_size; }
+        bool empty() const { return m_size == 0; }
+        size_t capacity() const { return m_storage.capacity(); }
+        size_t peak_size() const { return m_peak; }
+
+        pool_occupancy occupancy() const
+        {
+            pool_occupancy result;
+            result.live = m_size;
+            result.capacity = capacity();
+            result.peak = m_peak;
+            return result;
+        }
+
+        //Uninitialized slot, nullptr once static storage is exhausted
+        void* allocate();
+
+        //Returns a slot from allocate, whose object has already been destroyed
+        void deallocate(void* ptr);
+
+        //Constructs an object in a free slot, nullptr once static storage is exhausted
+        template<typename ... Args>
+        Elem* create(Args&& ... args)
+        {
+            void* ptr = allocate();
+            return ptr == nullptr ? nullptr : new (ptr) Elem(std::forward<Args>(args)...);
+        }
+
+        void destroy(Elem* ptr)
+        {
+            ptr->~Elem();
+            deallocate(ptr);
+        }
+
+        //Stable index of a live object
+        size_t index_of(const Elem* ptr) const
+        {
+            return m_storage.index_of(reinterpret_cast<const slot_type*>(ptr));
+        }
+
+        bool is_live(size_t idx) const
+        {
+            return idx < capacity() && (m_live[idx / 64] >> (idx % 64) & 1) != 0;
+        }
+
+        Elem& operator[](size_t idx) { return *object(m_storage.slot(idx)); }
+        const Elem& operator[](size_t idx) const { return *object(m_storage.slot(idx)); }
+
+        //Calls func(elem) for every live object, in index order
+        template<typename Func>
+        void for_each(Func func)
+        {
+            for (size_t idx = bits::find_next_set(m_live.begin(), 0, capacity()); idx < capacity(); idx = bits::find_next_set(m_live.begin(), idx + 1, capacity()))
+            {
+                func(*object(m_storage.slot(idx)));
+            }
+        }
+
+        template<typename Func>
+        void for_each(Func func) const
+        {
+            for (size_t idx = bits::find_next_set(m_live.begin(), 0, capacity()); idx < capacity(); idx = bits::find_next_set(m_live.begin(), idx + 1, capacity()))
+            {
+                func(*object(m_storage.slot(idx)));
+            }
+        }
+
+        //Destroys every live object, keeping the storage
+        void clear();
+    };
+
+    template<typename Elem, typename Storage, typename Bitmap>
+    inline void* cbb_pool<Elem, Storage, Bitmap>::allocate()
+    {
+        if (m_free_head == k_none)
+        {
+            size_t first = m_storage.capacity();
+            if (!m_storage.grow())
+            {
+                return nullptr;
+            }
+            link_free(first);
+        }
+
+        uint32_t idx = m_free_head;
+        slot_type& slot = m_storage.slot(idx);
+        m_free_head = slot.next_free;
+        m_live[idx / 64] |= (uint64_t)1 << (idx % 64);
+
+        m_size++;
+        m_peak = m_size > m_peak ? m_size : m_peak;
+        return &slot.storage;
+    }
+
+    template<typename Elem, typename Storage, typename Bitmap>
+    inline void cbb_pool<Elem, Storage, Bitmap>::deallocate(void* ptr)
+    {
+        slot_type* slot = reinterpret_cast<slot_type*>(ptr);
+        size_t idx = m_storage.index_of(slot);
+        CPPCBB_ASSERT(is_live(idx), "Slot is not live!");
+
+        m_live[idx / 64] &= ~((uint64_t)1 << (idx % 64));
+        slot->next_free = m_free_head;
+        m_free_head = (uint32_t)idx;
+        m_size--;
+    }
+
+    template<typename Elem, typename Storage, typename Bitmap>
+    inline void cbb_pool<Elem, Storage, Bitmap>::clear()
+    {
+        for (size_t word = 0; word < m_live.size(); word++)
+        {
+            for (uint64_t live = m_live[word]; live != 0; live &= live - 1)
+            {
+                object(m_storage.slot(word * 64 + bits::count_trailing_zeros(live)))->~Elem();
+            }
+            m_live[word] = 0;
+        }
+
+        m_free_head = k_none;
+        m_size = 0;
+        link_free(0);
+    }
+}
+
+/// <summary>
+/// Shared Pool
+/// </summary>
+namespace cppcbb
+{
+    template<typename Pool>
+    class cbb_shared_pool
+    {
+    public:
+        using value_type = typename Pool::value_type;
+
+    private:
+        Pool m_pool;
+        mutable std::mutex m_mutex;
+
+    public:
+        //Constructs outside the lock
+        template<typename ... Args>
+        value_type* create(Args&& ... args)
+        {
+            void* ptr;
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                ptr = m_pool.allocate();
+            }
+            return ptr == nullptr ? nullptr : new (ptr) value_type(std::forward<Args>(args)...);
+        }
+
+        void destroy(value_type* ptr)
+        {
+            ptr->~value_type();
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_pool.deallocate(ptr);
+        }
+
+        //Fills out with up to count uninitialized slots under one lock, returns the number handed out
+        size_t allocate_batch(void** out, size_t count)
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            size_t filled = 0;
+            while (filled < count && (out[filled] = m_pool.allocate()) != nullptr)
+            {
+                filled++;
+            }
+            return filled;
+        }
+
+        void deallocate_batch(void* const* ptrs, size_t count)
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            for (size_t i = 0; i < count; i++)
+            {
+                m_pool.deallocate(ptrs[i]);
+            }
+        }
+
+        //Slots held by pool caches count as live
+        pool_occupancy occupancy() const
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            return m_pool.occupancy();
+        }
+    };
+}
+
+/// <summary>
+/// Pool Cache
+/// </summary>
+namespace cppcbb
+{
+    template<typename SharedPool, typename Params>
+    class pool_cache
+    {
+    public:
+        using value_type = typename SharedPool::value_type;
+
+    private:
+        static constexpr size_t k_batch_size = Params::batch_size;
+        static_assert(k_batch_size > 0, "Batches must hold at least one slot");
+
+        SharedPool& m_pool;
+
+        //Refilled with a batch when empty, returns a batch when full
+        void* m_free[k_batch_size * 2];
+        size_t m_count = 0;
+
+    public:
+        explicit pool_cache(SharedPool& pool)
+            : m_pool(pool)
+        {
+        }
+
+        pool_cache(const pool_cache&) = delete;
+        pool_cache& operator=(const pool_cache&) = delete;
+
+        ~pool_cache()
+        {
+            flush();
+        }
+
+        //Free slots held locally
+        size_t cached() const { return m_count; }
+
+        //nullptr once static storage is exhausted
+        template<typename ... Args>
+        value_type* create(Args&& ... args)
+        {
+            if (m_count == 0)
+            {
+                m_count = m_pool.allocate_batch(m_free, k_batch_size);
+                if (m_count == 0)
+                {
+                    return nullptr;
+                }
+            }
+            return new (m_free[--m_count]) value_type(std::forward<Args>(args)...);
+        }
+
+        //Objects may be destroyed by any thread's cache
+        void destroy(value_type* ptr)
+        {
+            ptr->~value_type();
+            if (m_count == k_batch_size * 2)
+            {
+                m_pool.deallocate_batch(m_free + k_batch_size, k_batch_size);
+                m_count = k_batch_size;
+            }
+            m_free[m_count++] = ptr;
+        }
+
+        //Returns every cached slot to the shared pool
+        void flush()
+        {
+            m_pool.deallocate_batch(m_free, m_count);
+            m_count = 0;
+        }
+    };
+}
+
+#endif //CPPCBB_INCLUDE_CBB_POOL_H
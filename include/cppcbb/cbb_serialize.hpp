@@ -0,0 +1,870 @@
+//Copyright(C) 2020 Henry Bullingham
+//This file is subject to the license terms in the LICENSE file
+//found in the top - level directory of this distribution.
+
+#pragma once
+
+#if !defined (CPPCBB_INCLUDE_CBB_SERIALIZE_H)
+#define CPPCBB_INCLUDE_CBB_SERIALIZE_H
+
+#include "cbb_common.hpp"
+#include "cbb_vector.hpp"
+#include "cbb_map.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <iterator>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#if defined(_WIN32)
+//Only the file mapping API is needed, the macros are dropped again if they weren't already set
+#if !defined(WIN32_LEAN_AND_MEAN)
+#define WIN32_LEAN_AND_MEAN
+#define CPPCBB_SERIALIZE_LEAN_AND_MEAN
+#endif
+#if !defined(NOMINMAX)
+#define NOMINMAX
+#define CPPCBB_SERIALIZE_NOMINMAX
+#endif
+#include <windows.h>
+#if defined(CPPCBB_SERIALIZE_LEAN_AND_MEAN)
+#undef WIN32_LEAN_AND_MEAN
+#undef CPPCBB_SERIALIZE_LEAN_AND_MEAN
+#endif
+#if defined(CPPCBB_SERIALIZE_NOMINMAX)
+#undef NOMINMAX
+#undef CPPCBB_SERIALIZE_NOMINMAX
+#endif
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+/*
+
+    Binary container files, for vectors & maps of trivially copyable types
+
+    File layout (native byte order, a file from a machine with the other order is rejected):
+        header, 64 bytes:
+            "CBBS", uint16 version, uint16 kind (1 vector, 2 map), uint32 flags, uint32 header size,
+            uint64 count, uint32 key size, uint32 key alignment, uint32 value size, uint32 value alignment,
+            uint64 keys offset, uint64 values offset, uint64 checksum of every byte after the header
+        keys: count elements (vectors) or keys (maps, sorted & unique), at a 64 byte aligned offset
+        values: count values (maps only), at a 64 byte aligned offset
+
+    Arrays are aligned in the file, so a mapped view serves them in place without copying
+
+*/
+
+namespace cppcbb
+{
+    namespace serial
+    {
+        /// <summary>
+        /// Writes the elements of a vector, returns false if the file can't be written
+        /// </summary>
+        template<typename Elem, typename Traits, typename Storage, typename Management, typename Stats>
+        bool save(const char* path, const cbb_vector_impl<Elem, Traits, Storage, Management, Stats>& v);
+
+        /// <summary>
+        /// Replaces the elements of a vector, returns false (leaving v empty) if the file is missing, corrupt or of another type
+        /// </summary>
+        template<typename Elem, typename Traits, typename Storage, typename Management, typename Stats>
+        bool load(const char* path, cbb_vector_impl<Elem, Traits, Storage, Management, Stats>& v);
+
+        /// <summary>
+        /// Writes the entries of a map sorted by key, whatever the map's own order
+        /// </summary>
+        template<typename Key, typename Value, typename Storage, typename Stats>
+        bool save(const char* path, const cbb_map_impl<Key, Value, Storage, Stats>& map);
+
+        /// <summary>
+        /// Replaces the entries of a map, returns false (leaving map empty) if the file is missing, corrupt or of another type
+        /// </summary>
+        template<typename Key, typename Value, typename Storage, typename Stats>
+        bool load(const char* path, cbb_map_impl<Key, Value, Storage, Stats>& map);
+
+        /// <summary>
+        /// Read only memory mapping of a whole file
+        /// </summary>
+        class mapped_file;
+
+        /// <summary>
+        /// Read only vector served straight out of a mapped file, opening costs no copies
+        /// </summary>
+        /// <typeparam name="Elem"></typeparam>
+        template<typename Elem>
+        class mapped_vector_view;
+
+        /// <summary>
+        /// Read only map served straight out of a mapped file
+        /// O(log n) search over the sorted key array
+        /// </summary>
+        /// <typeparam name="Key"></typeparam>
+        /// <typeparam name="Value"></typeparam>
+        template<typename Key, typename Value>
+        class mapped_map_view;
+    }
+}
+
+/*
+
+    Implementation details
+
+*/
+
+/// <summary>
+/// File Format
+/// </summary>
+namespace cppcbb
+{
+    namespace serial
+    {
+        static constexpr char k_magic[4] = { 'C', 'B', 'B', 'S' };
+        static constexpr uint16_t k_version = 1;
+        static constexpr uint32_t k_header_size = 64;
+        static constexpr size_t k_alignment = 64;
+
+        static constexpr uint16_t k_kind_vector = 1;
+        static constexpr uint16_t k_kind_map = 2;
+
+        //Map keys are stored sorted & unique
+        static constexpr uint32_t k_flag_sorted = 1;
+
+        class file_header
+        {
+        public:
+            uint16_t kind = 0;
+            uint32_t flags = 0;
+            uint64_t count = 0;
+            uint32_t key_size = 0;
+            uint32_t key_align = 0;
+            uint32_t value_size = 0;
+            uint32_t value_align = 0;
+            uint64_t keys_offset = 0;
+            uint64_t values_offset = 0;
+            uint64_t checksum = 0;
+
+            void write(uint8_t* out) const
+            {
+                memset(out, 0, k_header_size);
+                memcpy(out, k_magic, sizeof(k_magic));
+                memcpy(out + 4, &k_version, 2);
+                memcpy(out + 6, &kind, 2);
+                memcpy(out + 8, &flags, 4);
+                memcpy(out + 12, &k_header_size, 4);
+                memcpy(out + 16, &count, 8);
+                memcpy(out + 24, &key_size, 4);
+                memcpy(out + 28, &key_align, 4);
+                memcpy(out + 32, &value_size, 4);
+                memcpy(out + 36, &value_align, 4);
+                memcpy(out + 40, &keys_offset, 8);
+                memcpy(out + 48, &values_offset, 8);
+                memcpy(out + 56, &checksum, 8);
+            }
+
+            //Returns false if the magic, version or header size don't match
+            bool read(const uint8_t* in, size_t size)
+            {
+                uint16_t version = 0;
+                uint32_t header_size = 0;
+                if (size < k_header_size || memcmp(in, k_magic, sizeof(k_magic)) != 0)
+                {
+                    return false;
+                }
+                memcpy(&version, in + 4, 2);
+                memcpy(&kind, in + 6, 2);
+                memcpy(&flags, in + 8, 4);
+                memcpy(&header_size, in + 12, 4);
+                memcpy(&count, in + 16, 8);
+                memcpy(&key_size, in + 24, 4);
+                memcpy(&key_align, in + 28, 4);
+                memcpy(&value_size, in + 32, 4);
+                memcpy(&value_align, in + 36, 4);
+                memcpy(&keys_offset, in + 40, 8);
+                memcpy(&values_offset, in + 48, 8);
+                memcpy(&checksum, in + 56, 8);
+                return version == k_version && header_size == k_header_size;
+            }
+        };
+
+        inline uint64_t align_up(uint64_t offset)
+        {
+            return (offset + k_alignment - 1) / k_alignment * k_alignment;
+        }
+
+        /// <summary>
+        /// Checksum of a byte stream, 8 bytes at a time
+        /// Fed in pieces, every piece but the last must be a multiple of 8 bytes
+        /// </summary>
+        class checksum
+        {
+        private:
+            static constexpr uint64_t k_prime = 0x100000001b3ULL;
+
+            uint64_t m_hash = 0xcbf29ce484222325ULL;
+            uint64_t m_length = 0;
+
+        public:
+            void add(const uint8_t* data, size_t size)
+            {
+                size_t i = 0;
+                for (; i + 8 <= size; i += 8)
+                {
+                    uint64_t word;
+                    memcpy(&word, data + i, 8);
+                    m_hash = (m_hash ^ word) * k_prime;
+                    m_hash ^= m_hash >> 29;
+                }
+
+                if (i < size)
+                {
+                    uint64_t word = 0;
+                    memcpy(&word, data + i, size - i);
+                    m_hash = (m_hash ^ word) * k_prime;
+                    m_hash ^= m_hash >> 29;
+                }
+                m_length += size;
+            }
+
+            uint64_t value() const
+            {
+                return (m_hash ^ m_length) * k_prime;
+            }
+        };
+
+        /// <summary>
+        /// Buffered file writer, checksumming everything after the header
+        /// </summary>
+        class file_writer
+        {
+        private:
+            static constexpr size_t k_buffer_size = 1 << 16;
+
+            FILE* m_file = nullptr;
+            uint64_t m_offset = 0;
+            size_t m_buffered = 0;
+            bool m_failed = false;
+            checksum m_checksum;
+            std::vector<uint8_t> m_buffer;
+
+            void flush()
+            {
+                m_checksum.add(m_buffer.data(), m_buffered);
+                if (m_buffered > 0 && fwrite(m_buffer.data(), 1, m_buffered, m_file) != m_buffered)
+                {
+                    m_failed = true;
+                }
+                m_buffered = 0;
+            }
+
+        public:
+            file_writer() : m_buffer(k_buffer_size) {}
+            ~file_writer() { close(); }
+
+            file_writer(const file_writer&) = delete;
+            file_writer& operator=(const file_writer&) = delete;
+
+            //Leaves room for the header, which is written by finish
+            bool open(const char* path)
+            {
+                m_file = fopen(path, "wb");
+                if (m_file == nullptr)
+                {
+                    return false;
+                }
+                uint8_t empty[k_header_size] = {};
+                m_failed = fwrite(empty, 1, k_header_size, m_file) != k_header_size;
+                m_offset = k_header_size;
+                return !m_failed;
+            }
+
+            uint64_t offset() const { return m_offset; }
+
+            void write(const void* data, size_t size)
+            {
+                const uint8_t* bytes = (const uint8_t*)data;
+                while (size > 0)
+                {
+                    size_t count = std::min(size, k_buffer_size - m_buffered);
+                    memcpy(m_buffer.data() + m_buffered, bytes, count);
+                    m_buffered += count;
+                    m_offset += count;
+                    bytes += count;
+                    size -= count;
+                    if (m_buffered == k_buffer_size)
+                    {
+                        flush();
+                    }
+                }
+            }
+
+            //Zero pads to the next aligned offset
+            void align()
+            {
+                static const uint8_t zeros[k_alignment] = {};
+                write(zeros, (size_t)(align_up(m_offset) - m_offset));
+            }
+
+            //Writes the header with the checksum, returns false if anything failed to write
+            bool finish(file_header& header)
+            {
+                flush();
+                header.checksum = m_checksum.value();
+
+                uint8_t bytes[k_header_size];
+                header.write(bytes);
+                bool ok = !m_failed
+                    && fseek(m_file, 0, SEEK_SET) == 0
+                    && fwrite(bytes, 1, k_header_size, m_file) == k_header_size;
+                ok = (fclose(m_file) == 0) && ok;
+                m_file = nullptr;
+                return ok;
+            }
+
+            void close()
+            {
+                if (m_file != nullptr)
+                {
+                    fclose(m_file);
+                    m_file = nullptr;
+                }
+            }
+        };
+    }
+}
+
+/// <summary>
+/// Mapped File
+/// </summary>
+namespace cppcbb
+{
+    namespace serial
+    {
+        class mapped_file
+        {
+        private:
+            const uint8_t* m_data = nullptr;
+            size_t m_size = 0;
+
+#if defined(_WIN32)
+            HANDLE m_file = INVALID_HANDLE_VALUE;
+            HANDLE m_mapping = nullptr;
+#endif
+
+        public:
+            mapped_file() {}
+            ~mapped_file() { close(); }
+
+            mapped_file(const mapped_file&) = delete;
+            mapped_file& operator=(const mapped_file&) = delete;
+
+            //Returns false if the file is missing or can't be mapped
+            bool open(const char* path);
+            void close();
+
+            bool is_open() const { return m_data != nullptr; }
+            const uint8_t* data() const { return m_data; }
+            size_t size() const { return m_size; }
+        };
+
+#if defined(_WIN32)
+        inline bool mapped_file::open(const char* path)
+        {
+            close();
+            m_file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+            if (m_file == INVALID_HANDLE_VALUE)
+            {
+                return false;
+            }
+
+            LARGE_INTEGER size;
+            if (!GetFileSizeEx(m_file, &size) || size.QuadPart == 0)
+            {
+                close();
+                return false;
+            }
+
+            m_mapping = CreateFileMappingA(m_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+            if (m_mapping == nullptr)
+            {
+                close();
+                return false;
+            }
+
+            m_data = (const uint8_t*)MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0);
+            m_size = (size_t)size.QuadPart;
+            if (m_data == nullptr)
+            {
+                close();
+                return false;
+            }
+            return true;
+        }
+
+        inline void mapped_file::close()
+        {
+            if (m_data != nullptr)
+            {
+                UnmapViewOfFile(m_data);
+            }
+            if (m_mapping != nullptr)
+            {
+                CloseHandle(m_mapping);
+            }
+            if (m_file != INVALID_HANDLE_VALUE)
+            {
+                CloseHandle(m_file);
+            }
+            m_data = nullptr;
+            m_size = 0;
+            m_mapping = nullptr;
+            m_file = INVALID_HANDLE_VALUE;
+        }
+#else
+        inline bool mapped_file::open(const char* path)
+        {
+            close();
+            int fd = ::open(path, O_RDONLY);
+            if (fd < 0)
+            {
+                return false;
+            }
+
+            struct stat info;
+            if (fstat(fd, &info) != 0 || info.st_size <= 0)
+            {
+                ::close(fd);
+                return false;
+            }
+
+            //The mapping keeps the file alive once the descriptor is closed
+            void* data = mmap(nullptr, (size_t)info.st_size, PROT_READ, MAP_SHARED, fd, 0);
+            ::close(fd);
+            if (data == MAP_FAILED)
+            {
+                return false;
+            }
+
+            m_data = (const uint8_t*)data;
+            m_size = (size_t)info.st_size;
+            return true;
+        }
+
+        inline void mapped_file::close()
+        {
+            if (m_data != nullptr)
+            {
+                munmap((void*)m_data, m_size);
+            }
+            m_data = nullptr;
+            m_size = 0;
+        }
+#endif
+
+        //Static storage that can't hold a file is left empty, rather than asserting
+        template<typename Vector>
+        inline bool fits(const Vector&, uint64_t)
+        {
+            return true;
+        }
+
+        template<typename Elem, typename Traits, size_t Capacity, typename StorageTraits, typename Management, typename Stats>
+        inline bool fits(const cbb_vector_impl<Elem, Traits, static_vec_storage<Elem, Capacity, StorageTraits>, Management, Stats>&, uint64_t count)
+        {
+            return count <= Capacity;
+        }
+
+        //Reads & checks the header of a mapped file against the expected layout
+        //Returns false if the file is of another kind or type, truncated, or (if verify) corrupt
+        inline bool check_file(const mapped_file& file, uint16_t kind
+            , size_t key_size, size_t key_align, size_t value_size, size_t value_align
+            , bool verify, file_header& header)
+        {
+            if (!file.is_open() || !header.read(file.data(), file.size()))
+            {
+                return false;
+            }
+
+            if (header.kind != kind
+                || header.key_size != key_size || header.key_align != key_align
+                || header.value_size != value_size || header.value_align != value_align
+                || header.keys_offset % k_alignment != 0 || header.values_offset % k_alignment != 0)
+            {
+                return false;
+            }
+
+            //Sizes are checked by division, so a huge count can't overflow
+            uint64_t keys_room = file.size() >= header.keys_offset ? file.size() - header.keys_offset : 0;
+            if (key_size > 0 && header.count > keys_room / key_size)
+            {
+                return false;
+            }
+            if (value_size > 0)
+            {
+                uint64_t values_room = file.size() >= header.values_offset ? file.size() - header.values_offset : 0;
+                if (header.values_offset < header.keys_offset + header.count * key_size || header.count > values_room / value_size)
+                {
+                    return false;
+                }
+            }
+
+            if (verify)
+            {
+                checksum sum;
+                sum.add(file.data() + k_header_size, file.size() - k_header_size);
+                if (sum.value() != header.checksum)
+                {
+                    return false;
+                }
+            }
+            return true;
+        }
+    }
+}
+
+/// <summary>
+/// Save & Load
+/// </summary>
+namespace cppcbb
+{
+    namespace serial
+    {
+        template<typename Elem, typename Traits, typename Storage, typename Management, typename Stats>
+        inline bool save(const char* path, const cbb_vector_impl<Elem, Traits, Storage, Management, Stats>& v)
+        {
+            static_assert(std::is_trivially_copyable<Elem>::value, "Only trivially copyable elements can be saved");
+            static_assert(alignof(Elem) <= k_alignment, "Elements are over aligned");
+
+            file_writer writer;
+            if (!writer.open(path))
+            {
+                return false;
+            }
+
+            file_header header;
+            header.kind = k_kind_vector;
+            header.count = v.size();
+            header.key_size = sizeof(Elem);
+            header.key_align = alignof(Elem);
+
+            writer.align();
+            header.keys_offset = writer.offset();
+            v.for_each_segment([&](const Elem* first, const Elem* last)
+            {
+                writer.write(first, (last - first) * sizeof(Elem));
+            });
+
+            return writer.finish(header);
+        }
+
+        template<typename Elem, typename Traits, typename Storage, typename Management, typename Stats>
+        inline bool load(const char* path, cbb_vector_impl<Elem, Traits, Storage, Management, Stats>& v)
+        {
+            static_assert(std::is_trivially_copyable<Elem>::value, "Only trivially copyable elements can be loaded");
+
+            v.clear();
+
+            mapped_file file;
+            file_header header;
+            if (!file.open(path) || !check_file(file, k_kind_vector, sizeof(Elem), alignof(Elem), 0, 0, true, header))
+            {
+                return false;
+            }
+
+            if (!fits(v, header.count))
+            {
+                return false;
+            }
+
+            v.resize((size_t)header.count);
+            const uint8_t* in = file.data() + header.keys_offset;
+            v.for_each_segment([&](Elem* first, Elem* last)
+            {
+                memcpy((void*)first, in, (last - first) * sizeof(Elem));
+                in += (last - first) * sizeof(Elem);
+            });
+            return true;
+        }
+
+        template<typename Key, typename Value, typename Storage, typename Stats>
+        inline bool save(const char* path, const cbb_map_impl<Key, Value, Storage, Stats>& map)
+        {
+            static_assert(std::is_trivially_copyable<Key>::value && std::is_trivially_copyable<Value>::value
+                , "Only trivially copyable keys & values can be saved");
+            static_assert(alignof(Key) <= k_alignment && alignof(Value) <= k_alignment, "Keys or values are over aligned");
+
+            using Elem = typename cbb_map_impl<Key, Value, Storage, Stats>::Elem;
+
+            //Sorted through pointers, so the map itself is untouched
+            std::vector<const Elem*> entries;
+            entries.reserve(map.size());
+            for (const Elem& entry : map)
+            {
+                entries.push_back(&entry);
+            }
+
+            auto by_key = [](const Elem* left, const Elem* right) { return left->first < right->first; };
+            if (!std::is_sorted(entries.begin(), entries.end(), by_key))
+            {
+                std::sort(entries.begin(), entries.end(), by_key);
+            }
+
+            file_writer writer;
+            if (!writer.open(path))
+            {
+                return false;
+            }
+
+            file_header header;
+            header.kind = k_kind_map;
+            header.flags = k_flag_sorted;
+            header.count = entries.size();
+            header.key_size = sizeof(Key);
+            header.key_align = alignof(Key);
+            header.value_size = sizeof(Value);
+            header.value_align = alignof(Value);
+
+            writer.align();
+            header.keys_offset = writer.offset();
+            for (const Elem* entry : entries)
+            {
+                writer.write(&entry->first, sizeof(Key));
+            }
+
+            writer.align();
+            header.values_offset = writer.offset();
+            for (const Elem* entry : entries)
+            {
+                writer.write(&entry->second, sizeof(Value));
+            }
+
+            return writer.finish(header);
+        }
+
+        template<typename Key, typename Value, typename Storage, typename Stats>
+        inline bool load(const char* path, cbb_map_impl<Key, Value, Storage, Stats>& map)
+        {
+            static_assert(std::is_trivially_copyable<Key>::value && std::is_trivially_copyable<Value>::value
+                , "Only trivially copyable keys & values can be loaded");
+
+            using Elem = typename cbb_map_impl<Key, Value, Storage, Stats>::Elem;
+
+            map.clear();
+
+            mapped_file file;
+            file_header header;
+            if (!file.open(path) || !check_file(file, k_kind_map, sizeof(Key), alignof(Key), sizeof(Value), alignof(Value), true, header)
+                || (header.flags & k_flag_sorted) == 0)
+            {
+                return false;
+            }
+
+            if (!fits(map.bulk_elements(0), header.count))
+            {
+                return false;
+            }
+
+            //Sorted unique keys suit every map's storage, so they are written straight in
+            auto& elements = map.bulk_elements((size_t)header.count);
+
+            const uint8_t* keys = file.data() + header.keys_offset;
+            const uint8_t* values = file.data() + header.values_offset;
+            size_t idx = 0;
+            elements.for_each_segment([&](Elem* first, Elem* last)
+            {
+                for (; first != last; ++first, ++idx)
+                {
+                    memcpy((void*)&first->first, keys + idx * sizeof(Key), sizeof(Key));
+                    memcpy((void*)&first->second, values + idx * sizeof(Value), sizeof(Value));
+                }
+            });
+
+            map.bulk_commit();
+            return true;
+        }
+    }
+}
+
+/// <summary>
+/// Mapped Vector View
+/// </summary>
+namespace cppcbb
+{
+    namespace serial
+    {
+        template<typename Elem>
+        class mapped_vector_view
+        {
+        private:
+            static_assert(std::is_trivially_copyable<Elem>::value, "Only trivially copyable elements can be mapped");
+
+            mapped_file m_file;
+            const Elem* m_data = nullptr;
+            size_t m_size = 0;
+
+        public:
+            using const_iterator = const Elem*;
+
+            //Checking the checksum reads the whole file, which mapping otherwise avoids
+            bool open(const char* path, bool verify = false)
+            {
+                close();
+                file_header header;
+                if (!m_file.open(path) || !check_file(m_file, k_kind_vector, sizeof(Elem), alignof(Elem), 0, 0, verify, header))
+                {
+                    close();
+                    return false;
+                }
+                m_data = (const Elem*)(m_file.data() + header.keys_offset);
+                m_size = (size_t)header.count;
+                return true;
+            }
+
+            void close()
+            {
+                m_file.close();
+                m_data = nullptr;
+                m_size = 0;
+            }
+
+            bool is_open() const { return m_file.is_open(); }
+
+            const_iterator begin() const { return m_data; }
+            const_iterator end() const { return m_data + m_size; }
+
+            size_t size() const { return m_size; }
+            const Elem* data() const { return m_data; }
+
+            const Elem& operator[](size_t idx) const
+            {
+                CPPCBB_ASSERT((idx < m_size), "Out of bounds access!");
+                return m_data[idx];
+            }
+        };
+    }
+}
+
+/// <summary>
+/// Mapped Map View
+/// </summary>
+namespace cppcbb
+{
+    namespace serial
+    {
+        template<typename Key, typename Value>
+        class mapped_map_view
+        {
+        private:
+            static_assert(std::is_trivially_copyable<Key>::value && std::is_trivially_copyable<Value>::value
+                , "Only trivially copyable keys & values can be mapped");
+
+            mapped_file m_file;
+            const Key* m_keys = nullptr;
+            const Value* m_values = nullptr;
+            size_t m_size = 0;
+
+        public:
+            //Walks the key & value arrays together, dereferencing to a pair of references
+            class const_iterator
+            {
+            private:
+                const mapped_map_view* m_view = nullptr;
+                size_t m_idx = 0;
+
+            public:
+                using iterator_category = std::random_access_iterator_tag;
+                using value_type = std::pair<Key, Value>;
+                using difference_type = std::ptrdiff_t;
+                using reference = std::pair<const Key&, const Value&>;
+                using pointer = void;
+
+                const_iterator() {}
+                const_iterator(const mapped_map_view* view, size_t idx) : m_view(view), m_idx(idx) {}
+
+                const Key& key() const { return m_view->m_keys[m_idx]; }
+                const Value& value() const { return m_view->m_values[m_idx]; }
+                reference operator*() const { return reference(key(), value()); }
+
+                const_iterator& operator++() { ++m_idx; return *this; }
+                const_iterator operator++(int) { const_iterator copy = *this; ++m_idx; return copy; }
+                const_iterator& operator--() { --m_idx; return *this; }
+                const_iterator operator--(int) { const_iterator copy = *this; --m_idx; return copy; }
+                const_iterator& operator+=(difference_type count) { m_idx += count; return *this; }
+                const_iterator& operator-=(difference_type count) { m_idx -= count; return *this; }
+                const_iterator operator+(difference_type count) const { return const_iterator(m_view, m_idx + count); }
+                const_iterator operator-(difference_type count) const { return const_iterator(m_view, m_idx - count); }
+                difference_type operator-(const const_iterator& other) const { return (difference_type)m_idx - (difference_type)other.m_idx; }
+                reference operator[](difference_type count) const { return *(*this + count); }
+
+                bool operator==(const const_iterator& other) const { return m_idx == other.m_idx; }
+                bool operator!=(const const_iterator& other) const { return m_idx != other.m_idx; }
+                bool operator<(const const_iterator& other) const { return m_idx < other.m_idx; }
+                bool operator>(const const_iterator& other) const { return m_idx > other.m_idx; }
+                bool operator<=(const const_iterator& other) const { return m_idx <= other.m_idx; }
+                bool operator>=(const const_iterator& other) const { return m_idx >= other.m_idx; }
+
+                friend const_iterator operator+(difference_type count, const const_iterator& it) { return it + count; }
+            };
+
+            //Checking the checksum reads the whole file, which mapping otherwise avoids
+            bool open(const char* path, bool verify = false)
+            {
+                close();
+                file_header header;
+                if (!m_file.open(path) || !check_file(m_file, k_kind_map, sizeof(Key), alignof(Key), sizeof(Value), alignof(Value), verify, header)
+                    || (header.flags & k_flag_sorted) == 0)
+                {
+                    close();
+                    return false;
+                }
+                m_keys = (const Key*)(m_file.data() + header.keys_offset);
+                m_values = (const Value*)(m_file.data() + header.values_offset);
+                m_size = (size_t)header.count;
+                return true;
+            }
+
+            void close()
+            {
+                m_file.close();
+                m_keys = nullptr;
+                m_values = nullptr;
+                m_size = 0;
+            }
+
+            bool is_open() const { return m_file.is_open(); }
+
+            const_iterator begin() const { return const_iterator(this, 0); }
+            const_iterator end() const { return const_iterator(this, m_size); }
+
+            size_t size() const { return m_size; }
+
+            //The sorted key & value arrays, in place in the file
+            const Key* keys() const { return m_keys; }
+            const Value* values() const { return m_values; }
+
+            const_iterator find(const Key& key) const
+            {
+                const Key* loc = std::lower_bound(m_keys, m_keys + m_size, key);
+                if (loc != m_keys + m_size && *loc == key)
+                {
+                    return const_iterator(this, loc - m_keys);
+                }
+                return end();
+            }
+
+            bool contains(const Key& key) const
+            {
+                return find(key) != end();
+            }
+        };
+    }
+}
+
+#endif //CPPCBB_INCLUDE_CBB_SERIALIZE_H
@@ -0,0 +1,536 @@
+//Copyright(C) 2020 Henry Bullingham
+//This file is subject to the license terms in the LICENSE file
+//found in the top - level directory of this distribution.
+
+#pragma once
+
+#if !defined (CPPCBB_INCLUDE_CBB_SIMD_H)
+#define CPPCBB_INCLUDE_CBB_SIMD_H
+
+#include "cbb_common.hpp"
+#include "cbb_vector.hpp"
+
+#include <cstdint>
+#include <memory>
+#include <new>
+
+#if defined(__GNUC__) || defined(__clang__)
+#define CPPCBB_ASSUME_ALIGNED(ptr_, align_) ((decltype(ptr_))__builtin_assume_aligned((ptr_), (align_)))
+#else
+#define CPPCBB_ASSUME_ALIGNED(ptr_, align_) (ptr_)
+#endif
+
+namespace cppcbb
+{
+    /// <summary>
+    /// Data for aligned storage option
+    /// </summary>
+    class default_aligned_storage_params
+    {
+    public:
+        //Bytes, a power of two, 64 covers a cache line & an AVX-512 register
+        static constexpr size_t alignment = 64;
+        static constexpr size_t initial_capacity = 16;
+        static constexpr float growth_rate = 1.5f;
+    };
+
+    /// <summary>
+    /// Represents heap allocated vector storage starting on an alignment boundary
+    /// Capacity is a whole number of aligned blocks, so reading a block past the last element stays in the allocation
+    /// </summary>
+    /// <typeparam name="Elem"></typeparam>
+    /// <typeparam name="Traits"></typeparam>
+    /// <typeparam name="Params"></typeparam>
+    template<typename Elem, typename Traits = default_traits<Elem>, typename Params = default_aligned_storage_params>
+    class aligned_vec_storage;
+
+    /// <summary>
+    /// Represents fixed size vector storage starting on an alignment boundary, padded to a whole number of aligned blocks
+    /// Before C++17 heap allocating the owning vector with new does not honor the alignment
+    /// </summary>
+    /// <typeparam name="Elem"></typeparam>
+    /// <typeparam name="Traits"></typeparam>
+    template<typename Elem, size_t Capacity = 16, size_t Alignment = 64, typename Traits = default_traits<Elem>>
+    class static_aligned_vec_storage;
+
+    template<typename Elem, typename Params = default_aligned_storage_params>
+    using cbb_aligned_vector = cbb_vector_impl<Elem, default_traits<Elem>, aligned_vec_storage<Elem, default_traits<Elem>, Params>, ordered_vec_management<Elem>>;
+
+    template<typename Elem, size_t Capacity = 16, size_t Alignment = 64>
+    using cbb_static_aligned_vector = cbb_vector_impl<Elem, default_traits<Elem>, static_aligned_vec_storage<Elem, Capacity, Alignment>, ordered_vec_management<Elem>>;
+
+    /// <summary>
+    /// Kernels over every element of a vector
+    /// When the storage advertises padded_alignment they work on whole aligned blocks,
+    /// masking the lanes outside the elements instead of finishing with a scalar loop
+    /// Other storage gets plain loops
+    /// </summary>
+    namespace simd
+    {
+        /// <summary>
+        /// Elements per aligned block of Storage, 1 if the storage makes no padding guarantee
+        /// </summary>
+        template<typename Storage, typename Elem, typename = void>
+        class storage_lanes;
+
+        /// <summary>
+        /// Sum of the elements, added lane by lane so floating point results may differ from a sequential sum in the last bits
+        /// </summary>
+        template<typename Vector>
+        typename Vector::value_type sum(const Vector& v);
+
+        /// <summary>
+        /// Smallest element, the vector must not be empty
+        /// </summary>
+        template<typename Vector>
+        typename Vector::value_type min_value(const Vector& v);
+
+        /// <summary>
+        /// Largest element, the vector must not be empty
+        /// </summary>
+        template<typename Vector>
+        typename Vector::value_type max_value(const Vector& v);
+
+        /// <summary>
+        /// Index of the first element equal to value, or size() if there is none
+        /// </summary>
+        template<typename Vector>
+        size_t find(const Vector& v, const typename Vector::value_type& value);
+
+        /// <summary>
+        /// Number of elements equal to value
+        /// </summary>
+        template<typename Vector>
+        size_t count(const Vector& v, const typename Vector::value_type& value);
+
+        /// <summary>
+        /// Sets every element to value
+        /// </summary>
+        template<typename Vector>
+        void fill(Vector& v, const typename Vector::value_type& value);
+    }
+}
+
+/*
+
+    Implementation details
+
+*/
+
+/// <summary>
+/// Aligned Storage
+/// </summary>
+namespace cppcbb
+{
+    template<typename Elem, typename Traits, typename Params>
+    class aligned_vec_storage
+    {
+    public:
+        using iterator = typename Traits::iterator;
+        using const_iterator = typename Traits::const_iterator;
+
+        static constexpr size_t padded_alignment = Params::alignment;
+
+    private:
+        static_assert((padded_alignment & (padded_alignment - 1)) == 0 && padded_alignment >= alignof(Elem), "Alignment must be a power of two, at least that of the element");
+
+        //Capacity is rounded up to whole blocks
+        static constexpr size_t k_block_size = padded_alignment % sizeof(Elem) == 0 ? padded_alignment / sizeof(Elem) : 1;
+        static constexpr size_t k_initial_capacity = (Params::initial_capacity + k_block_size - 1) / k_block_size * k_block_size;
+        static constexpr float k_growth_rate = Params::growth_rate;
+
+        std::unique_ptr<unsigned char[]> m_buffer;
+        Elem* m_data;
+        size_t m_capacity;
+
+        //Constructs capacity elements on an alignment boundary within buffer
+        static Elem* allocate(std::unique_ptr<unsigned char[]>& buffer, size_t capacity)
+        {
+            buffer.reset(new unsigned char[capacity * sizeof(Elem) + padded_alignment - 1]);
+            uintptr_t address = ((uintptr_t)buffer.get() + padded_alignment - 1) & ~(uintptr_t)(padded_alignment - 1);
+            Elem* data = reinterpret_cast<Elem*>(address);
+            for (size_t i = 0; i < capacity; i++)
+            {
+                new (data + i) Elem();
+            }
+            return data;
+        }
+
+        static void release(Elem* data, size_t capacity)
+        {
+            for (size_t i = 0; i < capacity; i++)
+            {
+                data[i].~Elem();
+            }
+        }
+
+    public:
+        aligned_vec_storage()
+            : m_data(allocate(m_buffer, k_initial_capacity))
+            , m_capacity(k_initial_capacity)
+        {}
+
+        aligned_vec_storage(const aligned_vec_storage&) = delete;
+        aligned_vec_storage& operator=(const aligned_vec_storage&) = delete;
+
+        ~aligned_vec_storage()
+        {
+            release(m_data, m_capacity);
+        }
+
+        iterator begin() { return (iterator)m_data; }
+        const_iterator begin() const { return (const_iterator)m_data; }
+        const_iterator cbegin() const { return (const_iterator)m_data; }
+
+        size_t capacity() const { return m_capacity; }
+
+        bool ensure_capacity(size_t capacity, size_t size);
+    };
+
+    template<typename Elem, typename Traits, typename Params>
+    inline bool aligned_vec_storage<Elem, Traits, Params>::ensure_capacity(size_t capacity, size_t size)
+    {
+        if (capacity <= m_capacity)
+        {
+            return true;
+        }
+
+        //Calculate new capacity by growth rate, in whole blocks
+        size_t new_capacity = (size_t)(m_capacity * k_growth_rate);
+        if (new_capacity < capacity)
+        {
+            new_capacity = capacity;
+        }
+        new_capacity = (new_capacity + k_block_size - 1) / k_block_size * k_block_size;
+
+        std::unique_ptr<unsigned char[]> new_buffer;
+        Elem* new_data = allocate(new_buffer, new_capacity);
+        for (size_t i = 0; i < size; i++)
+        {
+            new_data[i] = std::move(m_data[i]);
+        }
+
+        release(m_data, m_capacity);
+        m_buffer = std::move(new_buffer);
+        m_data = new_data;
+        m_capacity = new_capacity;
+        return true;
+    }
+}
+
+/// <summary>
+/// Static Aligned Storage
+/// </summary>
+namespace cppcbb
+{
+    template<typename Elem, size_t Capacity, size_t Alignment, typename Traits>
+    class static_aligned_vec_storage
+    {
+    public:
+        using iterator = typename Traits::iterator;
+        using const_iterator = typename Traits::const_iterator;
+
+        static constexpr size_t padded_alignment = Alignment;
+
+    private:
+        static_assert((Alignment & (Alignment - 1)) == 0 && Alignment >= alignof(Elem), "Alignment must be a power of two, at least that of the element");
+
+        static constexpr size_t k_block_size = Alignment % sizeof(Elem) == 0 ? Alignment / sizeof(Elem) : 1;
+
+        //Padding past Capacity is never handed out as elements, but masked kernel lanes read it
+        //so it is value initialized like the dynamic storage's
+        alignas(Alignment) Elem m_data[(Capacity + k_block_size - 1) / k_block_size * k_block_size] = {};
+
+    public:
+        iterator begin() { return (iterator)&m_data[0]; }
+        const_iterator begin() const { return (const_iterator)&m_data[0]; }
+        const_iterator cbegin() const { return (const_iterator)&m_data[0]; }
+
+        size_t capacity() const { return Capacity; }
+
+        bool ensure_capacity(size_t capacity, size_t /*size*/) const { return capacity <= Capacity; }
+    };
+}
+
+/// <summary>
+/// SIMD Kernels
+/// </summary>
+namespace cppcbb
+{
+    namespace simd
+    {
+        template<typename T>
+        class make_void
+        {
+        public:
+            using type = void;
+        };
+
+        template<typename Storage, typename Elem, typename>
+        class storage_lanes
+        {
+        public:
+            static constexpr size_t value = 1;
+        };
+
+        template<typename Storage, typename Elem>
+        class storage_lanes<Storage, Elem, typename make_void<decltype(Storage::padded_alignment)>::type>
+        {
+        public:
+            static constexpr size_t value = Storage::padded_alignment % sizeof(Elem) == 0 ? Storage::padded_alignment / sizeof(Elem) : 1;
+        };
+
+        //Calls op.block<Masked>(block, lo, hi) for the aligned blocks of Lanes elements covering [first, last), lanes [lo, hi) being elements
+        //Lanes outside [lo, hi) are read from the storage padding or neighbouring elements, never outside the allocation
+        //Only the first & last blocks are masked, so the others compile to plain vector loops
+        //Stops early once op.block returns true
+        template<size_t Lanes, typename Ptr, typename Op>
+        inline void for_each_block(Ptr first, Ptr last, Op& op)
+        {
+            if (first == last)
+            {
+                return;
+            }
+
+            size_t head = (size_t)((uintptr_t)first % (Lanes * sizeof(*first))) / sizeof(*first);
+            Ptr block = first - head;
+            size_t remaining = last - block;
+            if (remaining <= Lanes)
+            {
+                op.template block<true>(block, head, remaining);
+                return;
+            }
+
+            if (op.template block<true>(block, head, Lanes))
+            {
+                return;
+            }
+
+            for (block += Lanes, remaining -= Lanes; remaining >= Lanes; block += Lanes, remaining -= Lanes)
+            {
+                if (op.template block<false>(CPPCBB_ASSUME_ALIGNED(block, Lanes * sizeof(*first)), 0, Lanes))
+                {
+                    return;
+                }
+            }
+
+            if (remaining > 0)
+            {
+                op.template block<true>(block, 0, remaining);
+            }
+        }
+
+        template<typename Elem, size_t Lanes>
+        class sum_op
+        {
+        public:
+            Elem lanes[Lanes] = {};
+
+            template<bool Masked>
+            bool block(const Elem* block, size_t lo, size_t hi)
+            {
+                for (size_t l = 0; l < Lanes; l++)
+                {
+                    lanes[l] += (!Masked || (l >= lo && l < hi)) ? block[l] : Elem();
+                }
+                return false;
+            }
+        };
+
+        template<typename Elem, size_t Lanes, bool Max>
+        class extreme_op
+        {
+        public:
+            Elem lanes[Lanes];
+
+            explicit extreme_op(const Elem& first)
+            {
+                for (size_t l = 0; l < Lanes; l++)
+                {
+                    lanes[l] = first;
+                }
+            }
+
+            template<bool Masked>
+            bool block(const Elem* block, size_t lo, size_t hi)
+            {
+                //Masked lanes are blended with the lane's current extreme, so they never compare better
+                for (size_t l = 0; l < Lanes; l++)
+                {
+                    Elem value = (!Masked || (l >= lo && l < hi)) ? block[l] : lanes[l];
+                    lanes[l] = (Max ? lanes[l] < value : value < lanes[l]) ? value : lanes[l];
+                }
+                return false;
+            }
+        };
+
+        template<typename Elem, size_t Lanes>
+        class count_op
+        {
+        public:
+            const Elem& value;
+            size_t lanes[Lanes] = {};
+
+            explicit count_op(const Elem& v) : value(v) {}
+
+            template<bool Masked>
+            bool block(const Elem* block, size_t lo, size_t hi)
+            {
+                for (size_t l = 0; l < Lanes; l++)
+                {
+                    lanes[l] += ((!Masked || (l >= lo && l < hi)) && block[l] == value) ? 1 : 0;
+                }
+                return false;
+            }
+        };
+
+        template<typename Elem, size_t Lanes>
+        class find_op
+        {
+        public:
+            const Elem& value;
+            const Elem* found = nullptr;
+
+            explicit find_op(const Elem& v) : value(v) {}
+
+            template<bool Masked>
+            bool block(const Elem* block, size_t lo, size_t hi)
+            {
+                //Compares every lane before branching once per block
+                unsigned any = 0;
+                for (size_t l = 0; l < Lanes; l++)
+                {
+                    any |= ((!Masked || (l >= lo && l < hi)) && block[l] == value) ? 1 : 0;
+                }
+                if (any == 0)
+                {
+                    return false;
+                }
+
+                for (size_t l = lo; found == nullptr; l++)
+                {
+                    found = block[l] == value ? block + l : nullptr;
+                }
+                return true;
+            }
+        };
+
+        template<typename Elem, size_t Lanes>
+        class fill_op
+        {
+        public:
+            const Elem& value;
+
+            explicit fill_op(const Elem& v) : value(v) {}
+
+            template<bool Masked>
+            bool block(Elem* block, size_t lo, size_t hi)
+            {
+                for (size_t l = 0; l < Lanes; l++)
+                {
+                    block[l] = (!Masked || (l >= lo && l < hi)) ? value : block[l];
+                }
+                return false;
+            }
+        };
+
+        template<typename Vector>
+        using vector_lanes = storage_lanes<typename Vector::storage_type, typename Vector::value_type>;
+
+        template<typename Vector>
+        inline typename Vector::value_type sum(const Vector& v)
+        {
+            using Elem = typename Vector::value_type;
+            constexpr size_t lanes = vector_lanes<Vector>::value;
+
+            sum_op<Elem, lanes> op;
+            v.for_each_segment([&](const Elem* first, const Elem* last) { for_each_block<lanes>(first, last, op); });
+
+            Elem result = Elem();
+            for (size_t l = 0; l < lanes; l++)
+            {
+                result += op.lanes[l];
+            }
+            return result;
+        }
+
+        template<typename Vector, bool Max>
+        inline typename Vector::value_type extreme_value(const Vector& v)
+        {
+            using Elem = typename Vector::value_type;
+            constexpr size_t lanes = vector_lanes<Vector>::value;
+            CPPCBB_ASSERT(v.size() > 0, "No elements in vector!");
+
+            extreme_op<Elem, lanes, Max> op(*v.begin());
+            v.for_each_segment([&](const Elem* first, const Elem* last) { for_each_block<lanes>(first, last, op); });
+
+            Elem result = op.lanes[0];
+            for (size_t l = 1; l < lanes; l++)
+            {
+                result = (Max ? result < op.lanes[l] : op.lanes[l] < result) ? op.lanes[l] : result;
+            }
+            return result;
+        }
+
+        template<typename Vector>
+        inline typename Vector::value_type min_value(const Vector& v)
+        {
+            return extreme_value<Vector, false>(v);
+        }
+
+        template<typename Vector>
+        inline typename Vector::value_type max_value(const Vector& v)
+        {
+            return extreme_value<Vector, true>(v);
+        }
+
+        template<typename Vector>
+        inline size_t find(const Vector& v, const typename Vector::value_type& value)
+        {
+            using Elem = typename Vector::value_type;
+            constexpr size_t lanes = vector_lanes<Vector>::value;
+
+            find_op<Elem, lanes> op(value);
+            size_t index = 0;
+            v.for_each_segment([&](const Elem* first, const Elem* last)
+            {
+                if (op.found != nullptr)
+                {
+                    return;
+                }
+                for_each_block<lanes>(first, last, op);
+                index += op.found != nullptr ? op.found - first : last - first;
+            });
+            return index;
+        }
+
+        template<typename Vector>
+        inline size_t count(const Vector& v, const typename Vector::value_type& value)
+        {
+            using Elem = typename Vector::value_type;
+            constexpr size_t lanes = vector_lanes<Vector>::value;
+
+            count_op<Elem, lanes> op(value);
+            v.for_each_segment([&](const Elem* first, const Elem* last) { for_each_block<lanes>(first, last, op); });
+
+            size_t result = 0;
+            for (size_t l = 0; l < lanes; l++)
+            {
+                result += op.lanes[l];
+            }
+            return result;
+        }
+
+        template<typename Vector>
+        inline void fill(Vector& v, const typename Vector::value_type& value)
+        {
+            using Elem = typename Vector::value_type;
+            constexpr size_t lanes = vector_lanes<Vector>::value;
+
+            fill_op<Elem, lanes> op(value);
+            v.for_each_segment([&](Elem* first, Elem* last) { for_each_block<lanes>(first, last, op); });
+        }
+    }
+}
+
+#endif //CPPCBB_INCLUDE_CBB_SIMD_H
@@ -0,0 +1,308 @@
+//Copyright(C) 2020 Henry Bullingham
+//This file is subject to the license terms in the LICENSE file
+//found in the top - level directory of this distribution.
+
+#pragma once
+
+#if !defined (CPPCBB_INCLUDE_CBB_SLOT_MAP_H)
+#define CPPCBB_INCLUDE_CBB_SLOT_MAP_H
+
+#include "cbb_common.hpp"
+#include "cbb_vector.hpp"
+
+#include <cstdint>
+#include <utility>
+
+namespace cppcbb
+{
+    /// <summary>
+    /// Handle to an element in a slot map.
+    /// Stays valid until the element is erased, regardless of other insertions / erasures
+    /// </summary>
+    class slot_map_handle;
+
+    /// <summary>
+    /// Entry in the sparse index of a slot map
+    /// While in use, index points into the dense values
+    /// While free, index points to the next free slot
+    /// </summary>
+    class slot_map_slot;
+
+    /// <summary>
+    /// Container handing out generation tagged handles to its elements
+    /// Values are kept densely packed (swap with last on erase), handles are resolved through a sparse slot index
+    /// O(1) insert
+    /// O(1) delete
+    /// O(1) lookup
+    /// </summary>
+    /// <typeparam name="Elem"></typeparam>
+    /// <typeparam name="ValueVector">Dense value storage, should use unordered management</typeparam>
+    /// <typeparam name="SlotVector">Sparse slot index</typeparam>
+    /// <typeparam name="IndexVector">Maps dense positions back to their slots</typeparam>
+    template<typename Elem
+        , typename ValueVector = cbb_unordered_vector<Elem>
+        , typename SlotVector = cbb_vector<slot_map_slot>
+        , typename IndexVector = cbb_unordered_vector<uint32_t>
+    >
+    class cbb_slot_map_impl;
+
+    /// <summary>
+    /// Slot map with dynamic vector storage
+    /// </summary>
+    template<typename Elem>
+    using cbb_slot_map = cbb_slot_map_impl<Elem>;
+
+    /// <summary>
+    /// Slot map with static vector storage
+    /// </summary>
+    template<typename Elem, size_t Capacity = 16>
+    using cbb_static_slot_map =
+        cbb_slot_map_impl<
+            Elem
+            , cbb_static_unordered_vector<Elem, Capacity>
+            , cbb_static_vector<slot_map_slot, Capacity>
+            , cbb_static_unordered_vector<uint32_t, Capacity>
+        >;
+}
+
+/*
+
+    Implementation details
+
+*/
+
+/// <summary>
+/// Handles & Slots
+/// </summary>
+namespace cppcbb
+{
+    class slot_map_handle
+    {
+    public:
+        static constexpr uint32_t k_invalid_index = UINT32_MAX;
+
+        uint32_t index = k_invalid_index;
+        uint32_t generation = 0;
+
+        slot_map_handle() {}
+        slot_map_handle(uint32_t index_, uint32_t generation_) : index(index_), generation(generation_) {}
+
+        bool operator==(const slot_map_handle& other) const { return index == other.index && generation == other.generation; }
+        bool operator!=(const slot_map_handle& other) const { return !(*this == other); }
+    };
+
+    class slot_map_slot
+    {
+    public:
+        uint32_t index = slot_map_handle::k_invalid_index;
+        uint32_t generation = 0;
+    };
+}
+
+/// <summary>
+/// Slot Map
+/// </summary>
+namespace cppcbb
+{
+    template<typename Elem, typename ValueVector, typename SlotVector, typename IndexVector>
+    class cbb_slot_map_impl
+    {
+    public:
+        using handle = slot_map_handle;
+        using iterator = typename ValueVector::iterator;
+        using const_iterator = typename ValueVector::const_iterator;
+
+    private:
+        static constexpr uint32_t k_invalid_index = slot_map_handle::k_invalid_index;
+
+        ValueVector m_values;
+        SlotVector m_slots;
+        IndexVector m_value_slots;
+        uint32_t m_free_head = k_invalid_index;
+
+        //Claims a free slot (or a new one) for the value at dense index
+        handle acquire_slot(uint32_t dense_index);
+
+    public:
+        iterator begin() { return m_values.begin(); }
+        iterator end() { return m_values.end(); }
+
+        const_iterator begin() const { return m_values.begin(); }
+        const_iterator end() const { return m_values.end(); }
+
+        const_iterator cbegin() const { return m_values.cbegin(); }
+        const_iterator cend() const { return m_values.cend(); }
+
+        size_t size() const { return m_values.size(); }
+        size_t capacity() const { return m_values.capacity(); }
+
+        handle insert(const Elem& elem);
+        handle insert(Elem&& elem);
+        template<typename ... Args>
+        handle emplace(Args&& ... args);
+
+        bool contains(handle h) const;
+
+        //Returns nullptr if the handle is stale
+        Elem* find(handle h);
+        const Elem* find(handle h) const;
+
+        //Gets the handle of an element while iterating
+        handle handle_of(const_iterator elem) const;
+
+        //Returns false if the handle is stale
+        bool erase(handle h);
+
+        void clear();
+
+        Elem& operator[](handle h);
+        const Elem& operator[](handle h) const;
+    };
+
+    template<typename Elem, typename ValueVector, typename SlotVector, typename IndexVector>
+    inline typename cbb_slot_map_impl<Elem, ValueVector, SlotVector, IndexVector>::handle cbb_slot_map_impl<Elem, ValueVector, SlotVector, IndexVector>::acquire_slot(uint32_t dense_index)
+    {
+        uint32_t slot_index = m_free_head;
+        if (slot_index == k_invalid_index)
+        {
+            slot_index = (uint32_t)m_slots.size();
+            m_slots.push_back(slot_map_slot());
+        }
+        else
+        {
+            m_free_head = m_slots[slot_index].index;
+        }
+
+        slot_map_slot& slot = m_slots[slot_index];
+        slot.index = dense_index;
+        m_value_slots.push_back(slot_index);
+
+        return handle(slot_index, slot.generation);
+    }
+
+    template<typename Elem, typename ValueVector, typename SlotVector, typename IndexVector>
+    inline typename cbb_slot_map_impl<Elem, ValueVector, SlotVector, IndexVector>::handle cbb_slot_map_impl<Elem, ValueVector, SlotVector, IndexVector>::insert(const Elem& elem)
+    {
+        uint32_t dense_index = (uint32_t)m_values.size();
+        m_values.push_back(elem);
+        return acquire_slot(dense_index);
+    }
+
+    template<typename Elem, typename ValueVector, typename SlotVector, typename IndexVector>
+    inline typename cbb_slot_map_impl<Elem, ValueVector, SlotVector, IndexVector>::handle cbb_slot_map_impl<Elem, ValueVector, SlotVector, IndexVector>::insert(Elem&& elem)
+    {
+        uint32_t dense_index = (uint32_t)m_values.size();
+        m_values.push_back(std::move(elem));
+        return acquire_slot(dense_index);
+    }
+
+    template<typename Elem, typename ValueVector, typename SlotVector, typename IndexVector>
+    template<typename ...Args>
+    inline typename cbb_slot_map_impl<Elem, ValueVector, SlotVector, IndexVector>::handle cbb_slot_map_impl<Elem, ValueVector, SlotVector, IndexVector>::emplace(Args && ...args)
+    {
+        uint32_t dense_index = (uint32_t)m_values.size();
+        m_values.emplace_back(std::forward<Args>(args)...);
+        return acquire_slot(dense_index);
+    }
+
+    template<typename Elem, typename ValueVector, typename SlotVector, typename IndexVector>
+    inline bool cbb_slot_map_impl<Elem, ValueVector, SlotVector, IndexVector>::contains(handle h) const
+    {
+        if (h.index >= m_slots.size())
+        {
+            return false;
+        }
+
+        const slot_map_slot& slot = m_slots[h.index];
+        return slot.generation == h.generation
+            && slot.index < m_values.size()
+            && m_value_slots[slot.index] == h.index;
+    }
+
+    template<typename Elem, typename ValueVector, typename SlotVector, typename IndexVector>
+    inline Elem* cbb_slot_map_impl<Elem, ValueVector, SlotVector, IndexVector>::find(handle h)
+    {
+        if (!contains(h))
+        {
+            return nullptr;
+        }
+        return &*(m_values.begin() + m_slots[h.index].index);
+    }
+
+    template<typename Elem, typename ValueVector, typename SlotVector, typename IndexVector>
+    inline const Elem* cbb_slot_map_impl<Elem, ValueVector, SlotVector, IndexVector>::find(handle h) const
+    {
+        if (!contains(h))
+        {
+            return nullptr;
+        }
+        return &*(m_values.begin() + m_slots[h.index].index);
+    }
+
+    template<typename Elem, typename ValueVector, typename SlotVector, typename IndexVector>
+    inline typename cbb_slot_map_impl<Elem, ValueVector, SlotVector, IndexVector>::handle cbb_slot_map_impl<Elem, ValueVector, SlotVector, IndexVector>::handle_of(const_iterator elem) const
+    {
+        size_t dense_index = elem - m_values.cbegin();
+        CPPCBB_ASSERT((dense_index < size()), "Element not in slot map!");
+
+        uint32_t slot_index = m_value_slots[dense_index];
+        return handle(slot_index, m_slots[slot_index].generation);
+    }
+
+    template<typename Elem, typename ValueVector, typename SlotVector, typename IndexVector>
+    inline bool cbb_slot_map_impl<Elem, ValueVector, SlotVector, IndexVector>::erase(handle h)
+    {
+        if (!contains(h))
+        {
+            return false;
+        }
+
+        slot_map_slot& slot = m_slots[h.index];
+        uint32_t dense_index = slot.index;
+        uint32_t last_index = (uint32_t)m_values.size() - 1;
+
+        //Value & index vectors swap the last entry into the hole, so repoint its slot
+        m_slots[m_value_slots[last_index]].index = dense_index;
+        m_values.erase(m_values.begin() + dense_index);
+        m_value_slots.erase(m_value_slots.begin() + dense_index);
+
+        //Invalidate outstanding handles & push slot onto free list
+        slot.generation++;
+        slot.index = m_free_head;
+        m_free_head = h.index;
+
+        return true;
+    }
+
+    template<typename Elem, typename ValueVector, typename SlotVector, typename IndexVector>
+    inline void cbb_slot_map_impl<Elem, ValueVector, SlotVector, IndexVector>::clear()
+    {
+        //Every live slot is released so that existing handles go stale
+        for (uint32_t slot_index : m_value_slots)
+        {
+            slot_map_slot& slot = m_slots[slot_index];
+            slot.generation++;
+            slot.index = m_free_head;
+            m_free_head = slot_index;
+        }
+
+        m_values.clear();
+        m_value_slots.clear();
+    }
+
+    template<typename Elem, typename ValueVector, typename SlotVector, typename IndexVector>
+    inline Elem& cbb_slot_map_impl<Elem, ValueVector, SlotVector, IndexVector>::operator[](handle h)
+    {
+        CPPCBB_ASSERT(contains(h), "Stale slot map handle!");
+        return *(m_values.begin() + m_slots[h.index].index);
+    }
+
+    template<typename Elem, typename ValueVector, typename SlotVector, typename IndexVector>
+    inline const Elem& cbb_slot_map_impl<Elem, ValueVector, SlotVector, IndexVector>::operator[](handle h) const
+    {
+        CPPCBB_ASSERT(contains(h), "Stale slot map handle!");
+        return *(m_values.begin() + m_slots[h.index].index);
+    }
+}
+
+#endif //CPPCBB_INCLUDE_CBB_SLOT_MAP_H
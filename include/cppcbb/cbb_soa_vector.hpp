@@ -0,0 +1,519 @@
+//Copyright(C) 2020 Henry Bullingham
+//This file is subject to the license terms in the LICENSE file
+//found in the top - level directory of this distribution.
+
+#pragma once
+
+#if !defined (CPPCBB_INCLUDE_CBB_SOA_VECTOR_H)
+#define CPPCBB_INCLUDE_CBB_SOA_VECTOR_H
+
+#include "cbb_common.hpp"
+#include "cbb_vector.hpp"
+
+#include <iterator>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+namespace cppcbb
+{
+    namespace soa
+    {
+        /// <summary>
+        /// Compile time list of column indices
+        /// </summary>
+        template<size_t ... I>
+        class indices;
+
+        /// <summary>
+        /// indices<0, 1, ... Count - 1> as ::type
+        /// </summary>
+        template<size_t Count, size_t ... I>
+        class make_indices;
+
+        /// <summary>
+        /// Contiguous run of one column, for kernels touching a single field
+        /// </summary>
+        /// <typeparam name="Elem"></typeparam>
+        template<typename Elem>
+        class span;
+
+        /// <summary>
+        /// Proxy reference to one row, giving AoS style access to its fields
+        /// </summary>
+        /// <typeparam name="Vector">SoA vector, const for a const reference</typeparam>
+        template<typename Vector>
+        class row_reference;
+
+        /// <summary>
+        /// Random access iterator over rows, dereferencing to a row_reference
+        /// </summary>
+        /// <typeparam name="Vector">SoA vector, const for a const_iterator</typeparam>
+        template<typename Vector>
+        class row_iterator;
+    }
+
+    /// <summary>
+    /// Columns with dynamic storage, Management applies to every column in lockstep
+    /// </summary>
+    template<template<typename, typename> class Management = ordered_vec_management>
+    class dynamic_soa_columns;
+
+    /// <summary>
+    /// Columns with static storage, Management applies to every column in lockstep
+    /// </summary>
+    template<size_t Capacity, template<typename, typename> class Management = ordered_vec_management>
+    class static_soa_columns;
+
+    /// <summary>
+    /// Vector of records stored as one column vector per field (structure of arrays)
+    /// Kernels touching one field walk a contiguous span of just that field
+    /// Columns must be contiguous (ordered or unordered management)
+    /// </summary>
+    /// <typeparam name="Columns">Picks the vector type of each column</typeparam>
+    /// <typeparam name="Fields"></typeparam>
+    template<typename Columns, typename ... Fields>
+    class cbb_soa_vector_impl;
+
+    template<typename ... Fields>
+    using cbb_soa_vector = cbb_soa_vector_impl<dynamic_soa_columns<>, Fields...>;
+
+    template<size_t Capacity, typename ... Fields>
+    using cbb_static_soa_vector = cbb_soa_vector_impl<static_soa_columns<Capacity>, Fields...>;
+
+    template<typename ... Fields>
+    using cbb_unordered_soa_vector = cbb_soa_vector_impl<dynamic_soa_columns<unordered_vec_management>, Fields...>;
+
+    template<size_t Capacity, typename ... Fields>
+    using cbb_static_unordered_soa_vector = cbb_soa_vector_impl<static_soa_columns<Capacity, unordered_vec_management>, Fields...>;
+}
+
+/*
+
+    Implementation details
+
+*/
+
+/// <summary>
+/// Indices
+/// </summary>
+namespace cppcbb
+{
+    namespace soa
+    {
+        template<size_t ... I>
+        class indices
+        {
+        };
+
+        template<size_t Count, size_t ... I>
+        class make_indices : public make_indices<Count - 1, Count - 1, I...>
+        {
+        };
+
+        template<size_t ... I>
+        class make_indices<0, I...>
+        {
+        public:
+            using type = indices<I...>;
+        };
+    }
+}
+
+/// <summary>
+/// Span
+/// </summary>
+namespace cppcbb
+{
+    namespace soa
+    {
+        template<typename Elem>
+        class span
+        {
+        private:
+            Elem* m_data;
+            size_t m_size;
+
+        public:
+            span(Elem* data, size_t size)
+                : m_data(data)
+                , m_size(size)
+            {}
+
+            Elem* data() const { return m_data; }
+            size_t size() const { return m_size; }
+            bool empty() const { return m_size == 0; }
+
+            Elem* begin() const { return m_data; }
+            Elem* end() const { return m_data + m_size; }
+
+            Elem& operator[](size_t idx) const { return m_data[idx]; }
+        };
+    }
+}
+
+/// <summary>
+/// Row Reference
+/// </summary>
+namespace cppcbb
+{
+    namespace soa
+    {
+        template<typename Vector>
+        class row_reference
+        {
+        private:
+            template<typename> friend class row_reference;
+
+            Vector* m_vector;
+            size_t m_idx;
+
+        public:
+            using value_type = typename Vector::value_type;
+
+            row_reference(Vector* vector, size_t idx)
+                : m_vector(vector)
+                , m_idx(idx)
+            {}
+
+            //Mutable to const conversion
+            template<typename OtherVector>
+            row_reference(const row_reference<OtherVector>& other)
+                : m_vector(other.m_vector)
+                , m_idx(other.m_idx)
+            {}
+
+            size_t index() const { return m_idx; }
+
+            template<size_t I>
+            auto get() const -> decltype(std::declval<Vector&>().template at<I>(0))
+            {
+                return m_vector->template at<I>(m_idx);
+            }
+
+            operator value_type() const { return m_vector->row(m_idx); }
+
+            const row_reference& operator=(const value_type& value) const
+            {
+                m_vector->set_row(m_idx, value);
+                return *this;
+            }
+
+            const row_reference& operator=(const row_reference& other) const
+            {
+                m_vector->set_row(m_idx, other.m_vector->row(other.m_idx));
+                return *this;
+            }
+        };
+    }
+}
+
+/// <summary>
+/// Row Iterator
+/// </summary>
+namespace cppcbb
+{
+    namespace soa
+    {
+        template<typename Vector>
+        class row_iterator
+        {
+        private:
+            template<typename> friend class row_iterator;
+
+            Vector* m_vector = nullptr;
+            size_t m_idx = 0;
+
+        public:
+            using iterator_category = std::random_access_iterator_tag;
+            using value_type = typename Vector::value_type;
+            using difference_type = std::ptrdiff_t;
+            using pointer = void;
+            using reference = row_reference<Vector>;
+
+            row_iterator() {}
+            row_iterator(Vector* vector, size_t idx)
+                : m_vector(vector)
+                , m_idx(idx)
+            {}
+
+            //Mutable to const conversion
+            template<typename OtherVector>
+            row_iterator(const row_iterator<OtherVector>& other)
+                : m_vector(other.m_vector)
+                , m_idx(other.m_idx)
+            {}
+
+            size_t index() const { return m_idx; }
+
+            reference operator*() const { return reference(m_vector, m_idx); }
+            reference operator[](difference_type n) const { return reference(m_vector, m_idx + n); }
+
+            row_iterator& operator++() { ++m_idx; return *this; }
+            row_iterator& operator--() { --m_idx; return *this; }
+            row_iterator operator++(int) { row_iterator copy = *this; ++m_idx; return copy; }
+            row_iterator operator--(int) { row_iterator copy = *this; --m_idx; return copy; }
+
+            row_iterator& operator+=(difference_type n) { m_idx += n; return *this; }
+            row_iterator& operator-=(difference_type n) { m_idx -= n; return *this; }
+            row_iterator operator+(difference_type n) const { return row_iterator(m_vector, m_idx + n); }
+            row_iterator operator-(difference_type n) const { return row_iterator(m_vector, m_idx - n); }
+            difference_type operator-(const row_iterator& other) const { return (difference_type)m_idx - (difference_type)other.m_idx; }
+
+            bool operator==(const row_iterator& other) const { return m_idx == other.m_idx; }
+            bool operator!=(const row_iterator& other) const { return m_idx != other.m_idx; }
+            bool operator<(const row_iterator& other) const { return m_idx < other.m_idx; }
+            bool operator>(const row_iterator& other) const { return m_idx > other.m_idx; }
+            bool operator<=(const row_iterator& other) const { return m_idx <= other.m_idx; }
+            bool operator>=(const row_iterator& other) const { return m_idx >= other.m_idx; }
+        };
+    }
+}
+
+/// <summary>
+/// SoA Columns
+/// </summary>
+namespace cppcbb
+{
+    template<template<typename, typename> class Management>
+    class dynamic_soa_columns
+    {
+    public:
+        template<typename Field>
+        using column = cbb_vector_impl<Field, default_traits<Field>, dynamic_vec_storage<Field, default_traits<Field>>, Management<Field, default_traits<Field>>>;
+    };
+
+    template<size_t Capacity, template<typename, typename> class Management>
+    class static_soa_columns
+    {
+    public:
+        template<typename Field>
+        using column = cbb_vector_impl<Field, default_traits<Field>, static_vec_storage<Field, Capacity, default_traits<Field>>, Management<Field, default_traits<Field>>>;
+    };
+}
+
+/// <summary>
+/// SoA Vector
+/// </summary>
+namespace cppcbb
+{
+    template<typename Columns, typename ... Fields>
+    class cbb_soa_vector_impl
+    {
+    public:
+        static_assert(sizeof...(Fields) > 0, "SoA vector needs at least one field");
+
+        using self_type = cbb_soa_vector_impl<Columns, Fields...>;
+        using value_type = std::tuple<Fields...>;
+        using reference = soa::row_reference<self_type>;
+        using const_reference = soa::row_reference<const self_type>;
+        using iterator = soa::row_iterator<self_type>;
+        using const_iterator = soa::row_iterator<const self_type>;
+
+        template<size_t I>
+        using field_type = typename std::tuple_element<I, value_type>::type;
+
+        template<size_t I>
+        using column_type = typename Columns::template column<field_type<I>>;
+
+    private:
+        using all_columns = typename soa::make_indices<sizeof...(Fields)>::type;
+
+        //Calls each expression in a pack in order
+        using expand = int[];
+
+        std::tuple<typename Columns::template column<Fields>...> m_columns;
+
+        template<typename ... Args, size_t ... I>
+        void push_back(soa::indices<I...>, Args&& ... args)
+        {
+            (void)expand{ 0, ((void)std::get<I>(m_columns).push_back(std::forward<Args>(args)), 0)... };
+        }
+
+        template<size_t ... I>
+        void pop_back(soa::indices<I...>)
+        {
+            (void)expand{ 0, ((void)std::get<I>(m_columns).pop_back(), 0)... };
+        }
+
+        template<size_t ... I>
+        void erase(soa::indices<I...>, size_t idx)
+        {
+            (void)expand{ 0, ((void)std::get<I>(m_columns).erase(std::get<I>(m_columns).begin() + idx), 0)... };
+        }
+
+        template<size_t ... I>
+        void move_row(soa::indices<I...>, size_t to, size_t from)
+        {
+            (void)expand{ 0, ((void)(std::get<I>(m_columns)[to] = std::move(std::get<I>(m_columns)[from])), 0)... };
+        }
+
+        template<size_t ... I>
+        void resize(soa::indices<I...>, size_t size)
+        {
+            (void)expand{ 0, ((void)std::get<I>(m_columns).resize(size), 0)... };
+        }
+
+        template<size_t ... I>
+        void clear(soa::indices<I...>)
+        {
+            (void)expand{ 0, ((void)std::get<I>(m_columns).clear(), 0)... };
+        }
+
+        template<size_t ... I>
+        value_type row(soa::indices<I...>, size_t idx) const
+        {
+            return value_type(std::get<I>(m_columns)[idx]...);
+        }
+
+        template<size_t ... I>
+        void set_row(soa::indices<I...>, size_t idx, const value_type& value)
+        {
+            (void)expand{ 0, ((void)(std::get<I>(m_columns)[idx] = std::get<I>(value)), 0)... };
+        }
+
+        template<size_t ... I>
+        void push_back_row(soa::indices<I...>, const value_type& value)
+        {
+            push_back(all_columns(), std::get<I>(value)...);
+        }
+
+    public:
+        cbb_soa_vector_impl() {}
+
+        iterator begin() { return iterator(this, 0); }
+        iterator end() { return iterator(this, size()); }
+
+        const_iterator begin() const { return const_iterator(this, 0); }
+        const_iterator end() const { return const_iterator(this, size()); }
+
+        const_iterator cbegin() const { return begin(); }
+        const_iterator cend() const { return end(); }
+
+        size_t size() const { return std::get<0>(m_columns).size(); }
+        bool empty() const { return size() == 0; }
+        size_t capacity() const { return std::get<0>(m_columns).capacity(); }
+
+        //One value per field, in field order
+        template<typename ... Args>
+        void emplace_back(Args&& ... args)
+        {
+            static_assert(sizeof...(Args) == sizeof...(Fields), "Pass one value per field");
+            push_back(all_columns(), std::forward<Args>(args)...);
+        }
+
+        void push_back(const value_type& value) { push_back_row(all_columns(), value); }
+
+        reference back()
+        {
+            CPPCBB_ASSERT((size() > 0), "No elements in vector!");
+            return reference(this, size() - 1);
+        }
+
+        const_reference back() const
+        {
+            CPPCBB_ASSERT((size() > 0), "No elements in vector!");
+            return const_reference(this, size() - 1);
+        }
+
+        void pop_back()
+        {
+            CPPCBB_ASSERT((size() > 0), "No elements in vector!");
+            pop_back(all_columns());
+        }
+
+        //Erases the row from every column, so swap-erase moves the same row in each
+        void erase(size_t idx)
+        {
+            CPPCBB_ASSERT((idx < size()), "Out of bounds access!");
+            erase(all_columns(), idx);
+        }
+
+        void erase(const_iterator pos) { erase(pos.index()); }
+
+        //Removes all rows matching pred(const_reference) in one pass, keeping the order of the rest
+        template<typename Pred>
+        size_t erase_if(Pred pred);
+
+        void clear() { clear(all_columns()); }
+        void resize(size_t size) { resize(all_columns(), size); }
+
+        //Column vector of field I
+        template<size_t I>
+        column_type<I>& column() { return std::get<I>(m_columns); }
+
+        template<size_t I>
+        const column_type<I>& column() const { return std::get<I>(m_columns); }
+
+        //Contiguous values of field I, one per row
+        template<size_t I>
+        soa::span<field_type<I>> span()
+        {
+            static_assert(std::is_same<typename column_type<I>::iterator, field_type<I>*>::value, "Spans need contiguous columns");
+            return soa::span<field_type<I>>(std::get<I>(m_columns).begin(), size());
+        }
+
+        template<size_t I>
+        soa::span<const field_type<I>> span() const
+        {
+            static_assert(std::is_same<typename column_type<I>::const_iterator, const field_type<I>*>::value, "Spans need contiguous columns");
+            return soa::span<const field_type<I>>(std::get<I>(m_columns).begin(), size());
+        }
+
+        //Field I of a row
+        template<size_t I>
+        field_type<I>& at(size_t idx)
+        {
+            CPPCBB_ASSERT((idx < size()), "Out of bounds access!");
+            return std::get<I>(m_columns)[idx];
+        }
+
+        template<size_t I>
+        const field_type<I>& at(size_t idx) const
+        {
+            CPPCBB_ASSERT((idx < size()), "Out of bounds access!");
+            return std::get<I>(m_columns)[idx];
+        }
+
+        //Copies of every field of a row
+        value_type row(size_t idx) const
+        {
+            CPPCBB_ASSERT((idx < size()), "Out of bounds access!");
+            return row(all_columns(), idx);
+        }
+
+        void set_row(size_t idx, const value_type& value)
+        {
+            CPPCBB_ASSERT((idx < size()), "Out of bounds access!");
+            set_row(all_columns(), idx, value);
+        }
+
+        reference operator[](size_t idx) { return reference(this, idx); }
+        const_reference operator[](size_t idx) const { return const_reference(this, idx); }
+    };
+
+    template<typename Columns, typename ... Fields>
+    template<typename Pred>
+    inline size_t cbb_soa_vector_impl<Columns, Fields...>::erase_if(Pred pred)
+    {
+        size_t old_size = size();
+        size_t kept = 0;
+        for (size_t idx = 0; idx < old_size; idx++)
+        {
+            if (pred(const_reference(this, idx)))
+            {
+                continue;
+            }
+            if (kept != idx)
+            {
+                move_row(all_columns(), kept, idx);
+            }
+            kept++;
+        }
+
+        resize(kept);
+        return old_size - kept;
+    }
+}
+
+#endif //CPPCBB_INCLUDE_CBB_SOA_VECTOR_H
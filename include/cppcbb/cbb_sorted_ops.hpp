@@ -0,0 +1,263 @@
+//Copyright(C) 2020 Henry Bullingham
+//This file is subject to the license terms in the LICENSE file
+//found in the top - level directory of this distribution.
+
+#pragma once
+
+#if !defined (CPPCBB_INCLUDE_CBB_SORTED_OPS_H)
+#define CPPCBB_INCLUDE_CBB_SORTED_OPS_H
+
+#include "cbb_common.hpp"
+#include "cbb_map.hpp"
+
+#include <iterator>
+#include <utility>
+
+namespace cppcbb
+{
+    /// <summary>
+    /// Linear time operations over maps that keep their keys sorted (sorted vector & B+ tree maps)
+    /// Both sides are walked together, skipping ahead with galloping search, so a small map
+    /// against a large one costs O(m log(n / m)) instead of probing every key from the top
+    /// </summary>
+    namespace sorted
+    {
+        /// <summary>
+        /// First position in [first, last) with a key not less than key
+        /// Probes 1, 2, 4... entries ahead, then binary searches the last step
+        /// Forward iterators walk a few entries, then fall back to map.lower_bound(key)
+        /// </summary>
+        template<typename Map>
+        typename Map::const_iterator seek(const Map& map, typename Map::const_iterator first, const typename Map::Elem::first_type& key);
+
+        /// <summary>
+        /// Resizes results to keys.size() & sets results[i] = map.find(keys[i]), keys must be ascending
+        /// </summary>
+        template<typename Map, typename Keys, typename Results>
+        void find_sorted(const Map& map, const Keys& keys, Results& results);
+
+        /// <summary>
+        /// Calls visit(key, left value, right value) for every key in both maps, in key order
+        /// </summary>
+        template<typename Left, typename Right, typename Visit>
+        void intersect_join(const Left& left, const Right& right, Visit visit);
+
+        /// <summary>
+        /// Map with the keys of both, a key in both takes combine(left value, right value)
+        /// A static map too small for the union is left empty
+        /// </summary>
+        template<typename Left, typename Right, typename Combine>
+        Left merge(const Left& left, const Right& right, Combine combine);
+
+        //A key in both keeps the left value
+        template<typename Left, typename Right>
+        Left merge(const Left& left, const Right& right);
+
+        /// <summary>
+        /// Map with the entries of left whose keys are not in right
+        /// </summary>
+        template<typename Left, typename Right>
+        Left difference(const Left& left, const Right& right);
+    }
+}
+
+/*
+
+    Implementation details
+
+*/
+
+/// <summary>
+/// Galloping Search
+/// </summary>
+namespace cppcbb
+{
+    namespace sorted
+    {
+        namespace detail
+        {
+            //Entries a forward iterator steps over before searching from the root
+            static constexpr size_t k_forward_steps = 8;
+
+            template<typename Map, typename Key>
+            typename Map::const_iterator seek(const Map& map, typename Map::const_iterator first, const Key& key, std::random_access_iterator_tag)
+            {
+                using const_iterator = typename Map::const_iterator;
+                using Elem = typename Map::Elem;
+
+                const_iterator last = map.cend();
+                if (first == last || !(first->first < key))
+                {
+                    return first;
+                }
+
+                //first is below key, double the step until an entry is not
+                size_t remaining = last - first;
+                size_t low = 0;
+                size_t step = 1;
+                while (step < remaining && first[step].first < key)
+                {
+                    low = step;
+                    step *= 2;
+                }
+
+                size_t high = step < remaining ? step + 1 : remaining;
+                return std::lower_bound(first + low + 1, first + high, key,
+                    [](const Elem& left, const Key& right) { return left.first < right; });
+            }
+
+            template<typename Map, typename Key>
+            typename Map::const_iterator seek(const Map& map, typename Map::const_iterator first, const Key& key, std::forward_iterator_tag)
+            {
+                typename Map::const_iterator last = map.cend();
+                for (size_t i = 0; i < k_forward_steps; i++, ++first)
+                {
+                    if (first == last || !(first->first < key))
+                    {
+                        return first;
+                    }
+                }
+                return map.lower_bound(key);
+            }
+
+            //Number of keys in both maps
+            template<typename Left, typename Right>
+            size_t count_common(const Left& left, const Right& right)
+            {
+                size_t common = 0;
+                intersect_join(left, right, [&](const typename Left::Elem::first_type&,
+                    const typename Left::Elem::second_type&, const typename Right::Elem::second_type&) { common++; });
+                return common;
+            }
+        }
+
+        template<typename Map>
+        inline typename Map::const_iterator seek(const Map& map, typename Map::const_iterator first, const typename Map::Elem::first_type& key)
+        {
+            return detail::seek(map, first, key, typename std::iterator_traits<typename Map::const_iterator>::iterator_category());
+        }
+    }
+}
+
+/// <summary>
+/// Find Sorted & Joins
+/// </summary>
+namespace cppcbb
+{
+    namespace sorted
+    {
+        template<typename Map, typename Keys, typename Results>
+        inline void find_sorted(const Map& map, const Keys& keys, Results& results)
+        {
+            results.resize(keys.size());
+
+            typename Map::const_iterator it = map.cbegin();
+            typename Map::const_iterator end = map.cend();
+            for (size_t i = 0; i < keys.size(); i++)
+            {
+                CPPCBB_ASSERT(i == 0 || !(keys[i] < keys[i - 1]), "Keys not ascending!");
+                it = seek(map, it, keys[i]);
+                results[i] = (it != end && it->first == keys[i]) ? it : end;
+            }
+        }
+
+        template<typename Left, typename Right, typename Visit>
+        inline void intersect_join(const Left& left, const Right& right, Visit visit)
+        {
+            typename Left::const_iterator l = left.cbegin();
+            typename Left::const_iterator l_end = left.cend();
+            typename Right::const_iterator r = right.cbegin();
+            typename Right::const_iterator r_end = right.cend();
+
+            while (l != l_end && r != r_end)
+            {
+                if (l->first < r->first)
+                {
+                    l = seek(left, l, r->first);
+                }
+                else if (r->first < l->first)
+                {
+                    r = seek(right, r, l->first);
+                }
+                else
+                {
+                    visit(l->first, l->second, r->second);
+                    ++l;
+                    ++r;
+                }
+            }
+        }
+
+        template<typename Left, typename Right, typename Combine>
+        inline Left merge(const Left& left, const Right& right, Combine combine)
+        {
+            using Elem = typename Left::Elem;
+
+            //Sized up front so the result is bulk built in one pass
+            Left result;
+            auto& elements = result.bulk_elements(left.size() + right.size() - detail::count_common(left, right));
+
+            typename Left::const_iterator l = left.cbegin();
+            typename Left::const_iterator l_end = left.cend();
+            typename Right::const_iterator r = right.cbegin();
+            typename Right::const_iterator r_end = right.cend();
+
+            //A static result too small for the union is left empty
+            size_t count = 0;
+            while ((l != l_end || r != r_end) && count < elements.size())
+            {
+                if (r == r_end || (l != l_end && l->first < r->first))
+                {
+                    elements[count++] = *l;
+                    ++l;
+                }
+                else if (l == l_end || r->first < l->first)
+                {
+                    elements[count++] = Elem(r->first, r->second);
+                    ++r;
+                }
+                else
+                {
+                    elements[count++] = Elem(l->first, combine(l->second, r->second));
+                    ++l;
+                    ++r;
+                }
+            }
+
+            result.bulk_commit();
+            return result;
+        }
+
+        template<typename Left, typename Right>
+        inline Left merge(const Left& left, const Right& right)
+        {
+            using Value = typename Left::Elem::second_type;
+            return merge(left, right, [](const Value& value, const typename Right::Elem::second_type&) { return value; });
+        }
+
+        template<typename Left, typename Right>
+        inline Left difference(const Left& left, const Right& right)
+        {
+            Left result;
+            auto& elements = result.bulk_elements(left.size() - detail::count_common(left, right));
+
+            typename Right::const_iterator r = right.cbegin();
+            typename Right::const_iterator r_end = right.cend();
+
+            size_t count = 0;
+            for (typename Left::const_iterator l = left.cbegin(); l != left.cend(); ++l)
+            {
+                r = seek(right, r, l->first);
+                if (r == r_end || l->first < r->first)
+                {
+                    elements[count++] = *l;
+                }
+            }
+
+            result.bulk_commit();
+            return result;
+        }
+    }
+}
+
+#endif //CPPCBB_INCLUDE_CBB_SORTED_OPS_H
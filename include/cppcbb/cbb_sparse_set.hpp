@@ -0,0 +1,520 @@
+//Copyright(C) 2020 Henry Bullingham
+//This file is subject to the license terms in the LICENSE file
+//found in the top - level directory of this distribution.
+
+#pragma once
+
+#if !defined (CPPCBB_INCLUDE_CBB_SPARSE_SET_H)
+#define CPPCBB_INCLUDE_CBB_SPARSE_SET_H
+
+#include "cbb_common.hpp"
+#include "cbb_vector.hpp"
+#include "cbb_map.hpp"
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <utility>
+
+namespace cppcbb
+{
+    /// <summary>
+    /// Data for paged sparse storage option
+    /// </summary>
+    class default_sparse_page_params
+    {
+    public:
+        static constexpr size_t page_size = 4096;
+    };
+
+    /// <summary>
+    /// Sparse index (key -> dense index) split into lazily allocated pages
+    /// Memory scales with the key range actually used
+    /// </summary>
+    /// <typeparam name="Params"></typeparam>
+    template<typename Params = default_sparse_page_params>
+    class paged_sparse_storage;
+
+    /// <summary>
+    /// Sparse index (key -> dense index) stored as a fixed size array, keys must be less than MaxKey
+    /// </summary>
+    template<size_t MaxKey>
+    class static_sparse_storage;
+
+    /// <summary>
+    /// Set of non-negative integer keys
+    /// Keys are kept densely packed (swap with last on erase), and found through a sparse index
+    /// O(1) insert
+    /// O(1) delete
+    /// O(1) search
+    /// </summary>
+    /// <typeparam name="Key"></typeparam>
+    /// <typeparam name="Sparse"></typeparam>
+    /// <typeparam name="Dense"></typeparam>
+    template<typename Key, typename Sparse = paged_sparse_storage<>, typename Dense = cbb_unordered_vector<Key>>
+    class cbb_sparse_set_impl;
+
+    /// <summary>
+    /// Pair storage for maps with non-negative integer keys
+    /// O(1) insert
+    /// O(1) delete
+    /// O(1) search
+    /// </summary>
+    /// <typeparam name="Key"></typeparam>
+    /// <typeparam name="Value"></typeparam>
+    /// <typeparam name="Traits"></typeparam>
+    /// <typeparam name="Sparse"></typeparam>
+    /// <typeparam name="Vector"></typeparam>
+    template<typename Key, typename Value
+        , typename Traits = default_pair_storage_traits<Key, Value>
+        , typename Sparse = paged_sparse_storage<>
+        , typename Vector = cbb_unordered_vector<typename Traits::Elem>
+    >
+    class sparse_pair_storage;
+
+    template<typename Key, typename Value, typename Traits, typename Sparse, typename Vector, typename Stats>
+    class rebind_stats<sparse_pair_storage<Key, Value, Traits, Sparse, Vector>, Stats>
+    {
+    public:
+        using type = sparse_pair_storage<Key, Value, Traits, Sparse, typename rebind_stats<Vector, Stats>::type>;
+    };
+
+    /// <summary>
+    /// Sparse set with paged sparse index & dynamic dense storage
+    /// </summary>
+    template<typename Key, typename Params = default_sparse_page_params>
+    using cbb_sparse_set = cbb_sparse_set_impl<Key, paged_sparse_storage<Params>, cbb_unordered_vector<Key>>;
+
+    /// <summary>
+    /// Sparse set with static storage
+    /// </summary>
+    template<typename Key, size_t MaxKey, size_t Capacity = MaxKey>
+    using cbb_static_sparse_set = cbb_sparse_set_impl<Key, static_sparse_storage<MaxKey>, cbb_static_unordered_vector<Key, Capacity>>;
+
+    /// <summary>
+    /// Map with paged sparse index & dynamic dense storage
+    /// </summary>
+    template<typename Key, typename Value, typename Traits = default_pair_storage_traits<Key, Value>>
+    using cbb_sparse_map =
+        cbb_map_impl <
+            Key, Value,
+            sparse_pair_storage<Key, Value, Traits
+                , paged_sparse_storage<>
+                , cbb_unordered_vector<typename Traits::Elem>
+            >
+        >;
+
+    /// <summary>
+    /// Map with static sparse index & static dense storage
+    /// </summary>
+    template<typename Key, typename Value, size_t MaxKey, size_t Capacity = MaxKey, typename Traits = default_pair_storage_traits<Key, Value>>
+    using cbb_static_sparse_map =
+        cbb_map_impl <
+            Key, Value,
+            sparse_pair_storage<Key, Value, Traits
+                , static_sparse_storage<MaxKey>
+                , cbb_static_unordered_vector<typename Traits::Elem, Capacity>
+            >
+        >;
+}
+
+/*
+
+    Implementation details
+
+*/
+
+/// <summary>
+/// Paged Sparse Storage
+/// </summary>
+namespace cppcbb
+{
+    template<typename Params>
+    class paged_sparse_storage
+    {
+    public:
+        static constexpr uint32_t k_invalid_index = UINT32_MAX;
+
+    private:
+        static constexpr size_t k_page_size = Params::page_size;
+
+        cbb_vector<std::unique_ptr<uint32_t[]>> m_pages;
+
+        uint32_t* page_for(size_t key);
+
+    public:
+        paged_sparse_storage() {}
+
+        paged_sparse_storage(const paged_sparse_storage&);
+        paged_sparse_storage(paged_sparse_storage&&) = default;
+
+        paged_sparse_storage& operator=(const paged_sparse_storage&);
+        paged_sparse_storage& operator=(paged_sparse_storage&&) = default;
+
+        //Dense index of the key, or k_invalid_index if not present
+        uint32_t get(size_t key) const
+        {
+            size_t page = key / k_page_size;
+            if (page >= m_pages.size() || m_pages[page] == nullptr)
+            {
+                return k_invalid_index;
+            }
+            return m_pages[page][key % k_page_size];
+        }
+
+        //Pages grow to fit any key, so this always succeeds
+        bool set(size_t key, uint32_t index)
+        {
+            page_for(key)[key % k_page_size] = index;
+            return true;
+        }
+
+        void reset(size_t key)
+        {
+            size_t page = key / k_page_size;
+            if (page < m_pages.size() && m_pages[page] != nullptr)
+            {
+                m_pages[page][key % k_page_size] = k_invalid_index;
+            }
+        }
+
+        //Releases all pages
+        void clear();
+
+        size_t allocated_pages() const
+        {
+            return std::count_if(m_pages.begin(), m_pages.end(), [](const std::unique_ptr<uint32_t[]>& page) { return page != nullptr; });
+        }
+    };
+
+    template<typename Params>
+    constexpr uint32_t paged_sparse_storage<Params>::k_invalid_index;
+
+    template<typename Params>
+    inline uint32_t* paged_sparse_storage<Params>::page_for(size_t key)
+    {
+        size_t page = key / k_page_size;
+        while (m_pages.size() <= page)
+        {
+            m_pages.emplace_back();
+        }
+
+        if (m_pages[page] == nullptr)
+        {
+            m_pages[page].reset(new uint32_t[k_page_size]);
+            std::fill(m_pages[page].get(), m_pages[page].get() + k_page_size, k_invalid_index);
+        }
+        return m_pages[page].get();
+    }
+
+    template<typename Params>
+    inline paged_sparse_storage<Params>::paged_sparse_storage(const paged_sparse_storage& other)
+    {
+        *this = other;
+    }
+
+    template<typename Params>
+    inline paged_sparse_storage<Params>& paged_sparse_storage<Params>::operator=(const paged_sparse_storage& other)
+    {
+        if (this == &other)
+        {
+            return *this;
+        }
+
+        clear();
+        for (const std::unique_ptr<uint32_t[]>& page : other.m_pages)
+        {
+            std::unique_ptr<uint32_t[]> copy;
+            if (page != nullptr)
+            {
+                copy.reset(new uint32_t[k_page_size]);
+                std::copy(page.get(), page.get() + k_page_size, copy.get());
+            }
+            m_pages.push_back(std::move(copy));
+        }
+        return *this;
+    }
+
+    template<typename Params>
+    inline void paged_sparse_storage<Params>::clear()
+    {
+        //Vector clear leaves elements alive, so release pages explicitly
+        for (std::unique_ptr<uint32_t[]>& page : m_pages)
+        {
+            page.reset();
+        }
+        m_pages.clear();
+    }
+}
+
+/// <summary>
+/// Static Sparse Storage
+/// </summary>
+namespace cppcbb
+{
+    template<size_t MaxKey>
+    class static_sparse_storage
+    {
+    public:
+        static constexpr uint32_t k_invalid_index = UINT32_MAX;
+
+    private:
+        uint32_t m_indices[MaxKey];
+
+    public:
+        static_sparse_storage() { clear(); }
+
+        uint32_t get(size_t key) const
+        {
+            return key < MaxKey ? m_indices[key] : k_invalid_index;
+        }
+
+        //Returns false for keys past MaxKey, leaving the indices untouched
+        bool set(size_t key, uint32_t index)
+        {
+            CPPCBB_ASSERT((key < MaxKey), "Key out of range!");
+            if (key >= MaxKey)
+            {
+                return false;
+            }
+            m_indices[key] = index;
+            return true;
+        }
+
+        void reset(size_t key)
+        {
+            if (key < MaxKey)
+            {
+                m_indices[key] = k_invalid_index;
+            }
+        }
+
+        void clear()
+        {
+            std::fill(m_indices, m_indices + MaxKey, k_invalid_index);
+        }
+    };
+
+    template<size_t MaxKey>
+    constexpr uint32_t static_sparse_storage<MaxKey>::k_invalid_index;
+}
+
+/// <summary>
+/// Sparse Set
+/// </summary>
+namespace cppcbb
+{
+    template<typename Key, typename Sparse, typename Dense>
+    class cbb_sparse_set_impl
+    {
+    public:
+        using iterator = typename Dense::const_iterator;
+        using const_iterator = typename Dense::const_iterator;
+
+    private:
+        Sparse m_sparse;
+        Dense m_dense;
+
+    public:
+        //Keys can't be modified through iteration, or the sparse index would go stale
+        const_iterator begin() const { return m_dense.cbegin(); }
+        const_iterator end() const { return m_dense.cend(); }
+
+        const_iterator cbegin() const { return m_dense.cbegin(); }
+        const_iterator cend() const { return m_dense.cend(); }
+
+        size_t size() const { return m_dense.size(); }
+
+        bool contains(Key key) const
+        {
+            return m_sparse.get((size_t)key) != Sparse::k_invalid_index;
+        }
+
+        const_iterator find(Key key) const
+        {
+            uint32_t index = m_sparse.get((size_t)key);
+            if (index == Sparse::k_invalid_index)
+            {
+                return cend();
+            }
+            return cbegin() + index;
+        }
+
+        //Returns false if key was already present, or is past a static set's MaxKey
+        bool insert(Key key)
+        {
+            if (contains(key))
+            {
+                return false;
+            }
+            if (!m_sparse.set((size_t)key, (uint32_t)m_dense.size()))
+            {
+                return false;
+            }
+            m_dense.push_back(key);
+            return true;
+        }
+
+        //Returns false if key was not present
+        bool erase(Key key)
+        {
+            uint32_t index = m_sparse.get((size_t)key);
+            if (index == Sparse::k_invalid_index)
+            {
+                return false;
+            }
+
+            //Last key gets swapped into the hole
+            m_sparse.set((size_t)m_dense.back(), index);
+            m_sparse.reset((size_t)key);
+            m_dense.erase(m_dense.begin() + index);
+            return true;
+        }
+
+        void clear()
+        {
+            m_sparse.clear();
+            m_dense.clear();
+        }
+    };
+}
+
+/// <summary>
+/// Sparse Pair Storage
+/// </summary>
+namespace cppcbb
+{
+    template<typename Key, typename Value
+        , typename Traits
+        , typename Sparse
+        , typename Vector
+    >
+    class sparse_pair_storage
+    {
+    public:
+        using Elem = typename Traits::Elem;
+        using iterator = typename Vector::iterator;
+        using const_iterator = typename Vector::const_iterator;
+
+    private:
+        Sparse m_sparse;
+        Vector m_elements;
+
+    public:
+        iterator begin() { return m_elements.begin(); }
+        iterator end() { return m_elements.end(); }
+
+        const_iterator cbegin() const { return m_elements.cbegin(); }
+        const_iterator cend() const { return m_elements.cend(); }
+
+        //Finds the iterator for the key
+        const_iterator find(const Key& key) const
+        {
+            size_t probes = 0;
+            return find(key, probes);
+        }
+
+        //A lookup is always a single probe of the sparse index
+        const_iterator find(const Key& key, size_t& probes) const
+        {
+            probes++;
+            uint32_t index = m_sparse.get((size_t)key);
+            if (index == Sparse::k_invalid_index)
+            {
+                return cend();
+            }
+            return cbegin() + index;
+        }
+
+        //Each lookup is a single load that no other depends on, so the core overlaps the misses of
+        //a plain loop already, explicit prefetches only added work when measured
+        template<typename KeyIt, typename ResultIt>
+        void find_group(KeyIt keys, size_t count, ResultIt results, size_t* probes) const
+        {
+            for (size_t i = 0; i < count; i++)
+            {
+                results[i] = find(keys[i], probes[i]);
+            }
+        }
+
+        //Inserts a new iterator for the key, or returns end() for a key past a static map's MaxKey
+        iterator insert(Key key, Value value)
+        {
+            auto it = find(key);
+            if (it != end())
+            {
+                return (iterator)it;
+            }
+            if (!m_sparse.set((size_t)key, (uint32_t)m_elements.size()))
+            {
+                return end();
+            }
+            m_elements.push_back(Elem(std::move(key), std::move(value)));
+            return end() - 1;
+        }
+
+        //Erases the item from the list, returns the number of entries shifted
+        size_t erase(const_iterator elem)
+        {
+            uint32_t index = (uint32_t)(elem - cbegin());
+            size_t key = (size_t)elem->first;
+
+            //Last entry gets swapped into the hole
+            m_sparse.set((size_t)m_elements.back().first, index);
+            m_sparse.reset(key);
+
+            //Moved by hand & popped, so a counting vector doesn't record the erase twice
+            size_t shifts = 0;
+            if ((size_t)index + 1 != m_elements.size())
+            {
+                *(begin() + index) = std::move(m_elements.back());
+                shifts = 1;
+            }
+            m_elements.pop_back();
+            return shifts;
+        }
+
+        //Bulk builds: returns the element vector resized to size entries, to be filled with unique keys
+        Vector& bulk_elements(size_t size)
+        {
+            clear();
+            m_elements.resize(size);
+            CPPCBB_ASSERT((size <= m_elements.capacity()), "Not enough storage!");
+            return m_elements;
+        }
+
+        //Indexes the bulk elements once they are written, dropping keys past MaxKey like insert does
+        void bulk_commit()
+        {
+            size_t kept = 0;
+            for (size_t i = 0; i < m_elements.size(); i++)
+            {
+                bool indexed = m_sparse.set((size_t)m_elements[i].first, (uint32_t)kept);
+                CPPCBB_ASSERT(indexed, "Key out of range!");
+                if (!indexed)
+                {
+                    continue;
+                }
+                if (kept != i)
+                {
+                    m_elements[kept] = std::move(m_elements[i]);
+                }
+                kept++;
+            }
+            m_elements.resize(kept);
+        }
+
+        void clear()
+        {
+            m_sparse.clear();
+            m_elements.clear();
+        }
+
+        size_t size() const
+        {
+            return m_elements.size();
+        }
+    };
+}
+
+#endif //CPPCBB_INCLUDE_CBB_SPARSE_SET_H
@@ -0,0 +1,263 @@
+//Copyright(C) 2020 Henry Bullingham
+//This file is subject to the license terms in the LICENSE file
+//found in the top - level directory of this distribution.
+
+#pragma once
+
+#if !defined (CPPCBB_INCLUDE_CBB_STATS_H)
+#define CPPCBB_INCLUDE_CBB_STATS_H
+
+#include "cbb_common.hpp"
+
+#include <atomic>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <vector>
+
+namespace cppcbb
+{
+    /// <summary>
+    /// Stats policy that records nothing, all hooks compile away
+    /// This is the default for every container
+    /// </summary>
+    class no_stats;
+
+    /// <summary>
+    /// Names the counters of a counting_stats policy in the report
+    /// </summary>
+    class default_stats_tag
+    {
+    public:
+        static const char* name() { return "default"; }
+    };
+
+    /// <summary>
+    /// Counters shared by every container using the same counting_stats policy
+    /// </summary>
+    class container_stats;
+
+    /// <summary>
+    /// Holds the counters of every counting_stats policy used so far, for reporting
+    /// </summary>
+    class stats_registry;
+
+    /// <summary>
+    /// Stats policy counting hot path events into a global container_stats entry
+    /// Containers sharing a Tag share counters, Tag must provide static const char* name()
+    /// </summary>
+    /// <typeparam name="Tag"></typeparam>
+    template<typename Tag = default_stats_tag>
+    class counting_stats;
+
+    /// <summary>
+    /// Rebinds the Stats policy of a container type (and of the containers it is built from)
+    /// Types without a Stats policy are left unchanged
+    /// </summary>
+    /// <typeparam name="Container"></typeparam>
+    /// <typeparam name="Stats"></typeparam>
+    template<typename Container, typename Stats>
+    class rebind_stats
+    {
+    public:
+        using type = Container;
+    };
+
+    /// <summary>
+    /// Container with its Stats policy replaced, e.g. cbb_with_stats&lt;cbb_sorted_vector_map&lt;int, int&gt;, counting_stats&lt;my_tag&gt;&gt;
+    /// </summary>
+    template<typename Container, typename Stats>
+    using cbb_with_stats = typename rebind_stats<Container, Stats>::type;
+}
+
+/*
+
+    Implementation details
+
+*/
+
+/// <summary>
+/// No Stats
+/// </summary>
+namespace cppcbb
+{
+    class no_stats
+    {
+    public:
+        //Storage was (re)allocated
+        static CPPCBB_CONSTEXPR20 void on_allocation(size_t /*bytes*/) {}
+
+        //Elements were moved to new locations without being erased
+        static CPPCBB_CONSTEXPR20 void on_moves(size_t /*count*/) {}
+
+        //A lookup compared against probes entries
+        static CPPCBB_CONSTEXPR20 void on_find(size_t /*probes*/, bool /*hit*/) {}
+
+        //An element was erased, moving shifts other elements
+        static CPPCBB_CONSTEXPR20 void on_erase(size_t /*shifts*/) {}
+    };
+}
+
+/// <summary>
+/// Container Stats
+/// </summary>
+namespace cppcbb
+{
+    class container_stats
+    {
+    public:
+        //Relaxed atomics, counters may be bumped from many threads
+        std::atomic<uint64_t> allocations;
+        std::atomic<uint64_t> bytes_allocated;
+        std::atomic<uint64_t> moves;
+        std::atomic<uint64_t> finds;
+        std::atomic<uint64_t> probes;
+        std::atomic<uint64_t> hits;
+        std::atomic<uint64_t> misses;
+        std::atomic<uint64_t> erases;
+        std::atomic<uint64_t> erase_shifts;
+
+    private:
+        const char* m_name;
+
+    public:
+        //Registers itself with the stats_registry
+        explicit container_stats(const char* name);
+
+        container_stats(const container_stats&) = delete;
+        container_stats& operator=(const container_stats&) = delete;
+
+        const char* name() const { return m_name; }
+
+        void reset()
+        {
+            allocations = 0;
+            bytes_allocated = 0;
+            moves = 0;
+            finds = 0;
+            probes = 0;
+            hits = 0;
+            misses = 0;
+            erases = 0;
+            erase_shifts = 0;
+        }
+    };
+}
+
+/// <summary>
+/// Stats Registry
+/// </summary>
+namespace cppcbb
+{
+    class stats_registry
+    {
+    private:
+        mutable std::mutex m_mutex;
+        std::vector<container_stats*> m_entries;
+
+        stats_registry() {}
+
+    public:
+        static stats_registry& instance()
+        {
+            static stats_registry registry;
+            return registry;
+        }
+
+        void add(container_stats* entry)
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_entries.push_back(entry);
+        }
+
+        std::vector<container_stats*> entries() const
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            return m_entries;
+        }
+
+        void reset()
+        {
+            for (container_stats* entry : entries())
+            {
+                entry->reset();
+            }
+        }
+
+        //Writes one line per container type
+        void report(FILE* out) const;
+    };
+
+    inline container_stats::container_stats(const char* name)
+        : m_name(name)
+    {
+        reset();
+        stats_registry::instance().add(this);
+    }
+
+    inline void stats_registry::report(FILE* out) const
+    {
+        fprintf(out, "%-24s %12s %14s %12s %12s %12s %10s %12s %12s %14s\n"
+            , "container", "allocations", "bytes", "moves", "finds", "probes/find", "hit rate", "misses", "erases", "shifts/erase");
+
+        for (const container_stats* entry : entries())
+        {
+            uint64_t finds = entry->finds;
+            uint64_t erases = entry->erases;
+            fprintf(out, "%-24s %12llu %14llu %12llu %12llu %12.2f %10.3f %12llu %12llu %14.2f\n"
+                , entry->name()
+                , (unsigned long long)entry->allocations
+                , (unsigned long long)entry->bytes_allocated
+                , (unsigned long long)entry->moves
+                , (unsigned long long)finds
+                , finds > 0 ? (double)entry->probes / finds : 0.0
+                , finds > 0 ? (double)entry->hits / finds : 0.0
+                , (unsigned long long)entry->misses
+                , (unsigned long long)erases
+                , erases > 0 ? (double)entry->erase_shifts / erases : 0.0);
+        }
+    }
+}
+
+/// <summary>
+/// Counting Stats
+/// </summary>
+namespace cppcbb
+{
+    template<typename Tag>
+    class counting_stats
+    {
+    public:
+        static container_stats& stats()
+        {
+            static container_stats counters(Tag::name());
+            return counters;
+        }
+
+        static void on_allocation(size_t bytes)
+        {
+            stats().allocations.fetch_add(1, std::memory_order_relaxed);
+            stats().bytes_allocated.fetch_add(bytes, std::memory_order_relaxed);
+        }
+
+        static void on_moves(size_t count)
+        {
+            stats().moves.fetch_add(count, std::memory_order_relaxed);
+        }
+
+        static void on_find(size_t probes, bool hit)
+        {
+            stats().finds.fetch_add(1, std::memory_order_relaxed);
+            stats().probes.fetch_add(probes, std::memory_order_relaxed);
+            (hit ? stats().hits : stats().misses).fetch_add(1, std::memory_order_relaxed);
+        }
+
+        static void on_erase(size_t shifts)
+        {
+            stats().erases.fetch_add(1, std::memory_order_relaxed);
+            stats().erase_shifts.fetch_add(shifts, std::memory_order_relaxed);
+        }
+    };
+}
+
+#endif //CPPCBB_INCLUDE_CBB_STATS_H
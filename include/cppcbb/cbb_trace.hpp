@@ -0,0 +1,355 @@
+//Copyright(C) 2020 Henry Bullingham
+//This file is subject to the license terms in the LICENSE file
+//found in the top - level directory of this distribution.
+
+#pragma once
+
+#if !defined (CPPCBB_INCLUDE_CBB_TRACE_H)
+#define CPPCBB_INCLUDE_CBB_TRACE_H
+
+#include "cbb_common.hpp"
+#include "cbb_vector.hpp"
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+
+/*
+
+    Map operation traces, recorded from an instrumented run and replayed offline against every map policy
+
+    File layout (little endian):
+        header: "CBBT", uint16 version, uint16 flags, uint64 operation count
+        records: one byte op type, then the key as a zigzag varint delta from the previous key
+
+*/
+
+namespace cppcbb
+{
+    namespace trace
+    {
+        enum class op_type : uint8_t
+        {
+            insert = 0,
+            find = 1,
+            erase = 2
+        };
+
+        /// <summary>
+        /// One recorded map operation
+        /// </summary>
+        class operation
+        {
+        public:
+            op_type type = op_type::find;
+            uint64_t key = 0;
+        };
+
+        /// <summary>
+        /// Header flags of a trace file
+        /// </summary>
+        enum trace_flags : uint16_t
+        {
+            //Generated rather than recorded from a real run
+            synthetic_trace = 1
+        };
+
+        /// <summary>
+        /// Appends operations to a trace file
+        /// </summary>
+        class trace_writer;
+
+        /// <summary>
+        /// Reads a whole trace file, returns false if it is missing or malformed
+        /// </summary>
+        inline bool read_trace(const char* path, cbb_vector<operation>& ops, uint16_t* flags = nullptr);
+
+        /// <summary>
+        /// Wraps a map, recording every operation made through it
+        /// </summary>
+        /// <typeparam name="Map"></typeparam>
+        template<typename Map>
+        class recording_map;
+    }
+}
+
+/*
+
+    Implementation details
+
+*/
+
+/// <summary>
+/// Trace Encoding
+/// </summary>
+namespace cppcbb
+{
+    namespace trace
+    {
+        static constexpr char k_magic[4] = { 'C', 'B', 'B', 'T' };
+        static constexpr uint16_t k_version = 1;
+        static constexpr size_t k_header_size = 16;
+        static constexpr size_t k_max_record_size = 1 + 10;
+
+        inline void write_le(uint8_t* out, uint64_t value, size_t bytes)
+        {
+            for (size_t i = 0; i < bytes; i++)
+            {
+                out[i] = (uint8_t)(value >> (8 * i));
+            }
+        }
+
+        inline uint64_t read_le(const uint8_t* in, size_t bytes)
+        {
+            uint64_t value = 0;
+            for (size_t i = 0; i < bytes; i++)
+            {
+                value |= (uint64_t)in[i] << (8 * i);
+            }
+            return value;
+        }
+
+        //Small deltas either way encode in few bytes
+        inline uint64_t zigzag(uint64_t delta)
+        {
+            return (delta << 1) ^ (uint64_t)((int64_t)delta >> 63);
+        }
+
+        inline uint64_t unzigzag(uint64_t value)
+        {
+            return (value >> 1) ^ (uint64_t)(-(int64_t)(value & 1));
+        }
+
+        //Returns the number of bytes written
+        inline size_t write_varint(uint8_t* out, uint64_t value)
+        {
+            size_t count = 0;
+            while (value >= 0x80)
+            {
+                out[count++] = (uint8_t)(value | 0x80);
+                value >>= 7;
+            }
+            out[count++] = (uint8_t)value;
+            return count;
+        }
+
+        //Returns false if the varint runs past end
+        inline bool read_varint(const uint8_t*& in, const uint8_t* end, uint64_t& value)
+        {
+            value = 0;
+            for (unsigned shift = 0; shift < 64 && in != end; shift += 7)
+            {
+                uint8_t byte = *in++;
+                value |= (uint64_t)(byte & 0x7f) << shift;
+                if ((byte & 0x80) == 0)
+                {
+                    return true;
+                }
+            }
+            return false;
+        }
+    }
+}
+
+/// <summary>
+/// Trace Writer
+/// </summary>
+namespace cppcbb
+{
+    namespace trace
+    {
+        class trace_writer
+        {
+        private:
+            static constexpr size_t k_buffer_size = 1 << 16;
+
+            FILE* m_file = nullptr;
+            uint16_t m_flags = 0;
+            uint64_t m_count = 0;
+            uint64_t m_previous_key = 0;
+            size_t m_buffered = 0;
+            uint8_t m_buffer[k_buffer_size];
+
+            void flush()
+            {
+                fwrite(m_buffer, 1, m_buffered, m_file);
+                m_buffered = 0;
+            }
+
+            void write_header()
+            {
+                uint8_t header[k_header_size] = {};
+                memcpy(header, k_magic, sizeof(k_magic));
+                write_le(header + 4, k_version, 2);
+                write_le(header + 6, m_flags, 2);
+                write_le(header + 8, m_count, 8);
+                fwrite(header, 1, k_header_size, m_file);
+            }
+
+        public:
+            trace_writer() {}
+            ~trace_writer() { close(); }
+
+            trace_writer(const trace_writer&) = delete;
+            trace_writer& operator=(const trace_writer&) = delete;
+
+            //Returns false if the file can't be created, flags are trace_flags stored in the header
+            bool open(const char* path, uint16_t flags = 0)
+            {
+                close();
+                m_file = fopen(path, "wb");
+                if (m_file == nullptr)
+                {
+                    return false;
+                }
+                m_flags = flags;
+                m_count = 0;
+                m_previous_key = 0;
+                write_header();
+                return true;
+            }
+
+            bool is_open() const { return m_file != nullptr; }
+            uint64_t count() const { return m_count; }
+
+            void record(op_type type, uint64_t key)
+            {
+                CPPCBB_ASSERT(is_open(), "Trace not open!");
+                if (m_buffered + k_max_record_size > k_buffer_size)
+                {
+                    flush();
+                }
+                m_buffer[m_buffered++] = (uint8_t)type;
+                m_buffered += write_varint(m_buffer + m_buffered, zigzag(key - m_previous_key));
+                m_previous_key = key;
+                m_count++;
+            }
+
+            //Flushes & rewrites the header with the final count
+            void close()
+            {
+                if (m_file == nullptr)
+                {
+                    return;
+                }
+                flush();
+                fseek(m_file, 0, SEEK_SET);
+                write_header();
+                fclose(m_file);
+                m_file = nullptr;
+            }
+        };
+
+        inline bool read_trace(const char* path, cbb_vector<operation>& ops, uint16_t* flags)
+        {
+            FILE* file = fopen(path, "rb");
+            if (file == nullptr)
+            {
+                return false;
+            }
+
+            fseek(file, 0, SEEK_END);
+            long file_size = ftell(file);
+            fseek(file, 0, SEEK_SET);
+
+            cbb_vector<uint8_t> bytes;
+            bytes.resize(file_size > 0 ? (size_t)file_size : 0);
+            size_t read = bytes.size() > 0 ? fread(&bytes[0], 1, bytes.size(), file) : 0;
+            fclose(file);
+
+            if (read != bytes.size() || bytes.size() < k_header_size
+                || memcmp(&bytes[0], k_magic, sizeof(k_magic)) != 0
+                || read_le(&bytes[0] + 4, 2) != k_version)
+            {
+                return false;
+            }
+
+            if (flags != nullptr)
+            {
+                *flags = (uint16_t)read_le(&bytes[0] + 6, 2);
+            }
+
+            uint64_t count = read_le(&bytes[0] + 8, 8);
+            const uint8_t* in = &bytes[0] + k_header_size;
+            const uint8_t* end = &bytes[0] + bytes.size();
+            uint64_t key = 0;
+
+            ops.clear();
+            for (uint64_t i = 0; i < count; i++)
+            {
+                uint64_t delta = 0;
+                if (in == end || *in > (uint8_t)op_type::erase)
+                {
+                    return false;
+                }
+                operation op;
+                op.type = (op_type)*in++;
+                if (!read_varint(in, end, delta))
+                {
+                    return false;
+                }
+                key += unzigzag(delta);
+                op.key = key;
+                ops.push_back(op);
+            }
+            return in == end;
+        }
+    }
+}
+
+/// <summary>
+/// Recording Map
+/// </summary>
+namespace cppcbb
+{
+    namespace trace
+    {
+        template<typename Map>
+        class recording_map
+        {
+        private:
+            Map& m_map;
+            trace_writer& m_writer;
+
+        public:
+            recording_map(Map& map, trace_writer& writer)
+                : m_map(map)
+                , m_writer(writer)
+            {}
+
+            //Recorded as an insert, even if the key was already present
+            template<typename Key>
+            auto operator[](const Key& key) -> decltype(m_map[key])
+            {
+                m_writer.record(op_type::insert, (uint64_t)key);
+                return m_map[key];
+            }
+
+            template<typename Key>
+            auto find(const Key& key) const -> decltype(m_map.find(key))
+            {
+                m_writer.record(op_type::find, (uint64_t)key);
+                return m_map.find(key);
+            }
+
+            //Erases by key, returns false if it was not present
+            template<typename Key>
+            bool erase(const Key& key)
+            {
+                m_writer.record(op_type::erase, (uint64_t)key);
+                auto it = m_map.find(key);
+                if (it == m_map.end())
+                {
+                    return false;
+                }
+                m_map.erase(it);
+                return true;
+            }
+
+            Map& map() { return m_map; }
+            const Map& map() const { return m_map; }
+        };
+    }
+}
+
+#endif //CPPCBB_INCLUDE_CBB_TRACE_H
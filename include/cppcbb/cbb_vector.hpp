@@ -8,9 +8,13 @@
 #define CPPCBB_INCLUDE_CBB_VECTOR_H
 
 #include "cbb_common.hpp"
+#include "cbb_stats.hpp"
 
 #include <algorithm>
+#include <cstdint>
+#include <iterator>
 #include <memory>
+#include <utility>
 
 namespace cppcbb
 {
@@ -38,6 +42,14 @@ namespace cppcbb
     template<typename Elem, size_t Capacity = 16, typename Traits = default_traits<Elem>>
     class static_vec_storage;
 
+    /// <summary>
+    /// Common management behaviour for elements stored contiguously in [begin, end)
+    /// Managements customize insert / erase and inherit the rest
+    /// </summary>
+    /// <typeparam name="Elem"></typeparam>
+    template<typename Elem, typename Traits = default_traits<Elem>>
+    class contiguous_vec_management;
+
     /// <summary>
     /// Represents ordered vector management (the elements stay in the order they were inserted)
     /// </summary>
@@ -61,9 +73,17 @@ namespace cppcbb
     /// <typeparam name="Traits"></typeparam>
     /// <typeparam name="Storage"></typeparam>
     /// <typeparam name="Management"></typeparam>
-    template<typename Elem, typename Traits = default_traits<Elem>, typename Storage = dynamic_vec_storage<Elem, Traits>, typename Management = ordered_vec_management<Elem,Traits>>
+    /// <typeparam name="Stats">Hot path counters, see cbb_stats.hpp</typeparam>
+    template<typename Elem, typename Traits = default_traits<Elem>, typename Storage = dynamic_vec_storage<Elem, Traits>, typename Management = ordered_vec_management<Elem,Traits>, typename Stats = no_stats>
     class cbb_vector_impl;
 
+    template<typename Elem, typename Traits, typename Storage, typename Management, typename OldStats, typename Stats>
+    class rebind_stats<cbb_vector_impl<Elem, Traits, Storage, Management, OldStats>, Stats>
+    {
+    public:
+        using type = cbb_vector_impl<Elem, Traits, Storage, Management, Stats>;
+    };
+
     template<typename Elem, typename Traits = default_traits<Elem>>
     using cbb_vector = cbb_vector_impl<Elem, Traits, dynamic_vec_storage<Elem, Traits>, ordered_vec_management<Elem, Traits>>;
 
@@ -75,6 +95,86 @@ namespace cppcbb
 
     template<typename Elem, size_t Capacity = 16, typename Traits = default_traits<Elem>>
     using cbb_static_unordered_vector = cbb_vector_impl<Elem, Traits, static_vec_storage<Elem, Capacity, Traits>, unordered_vec_management<Elem, Traits>>;
+
+    /// <summary>
+    /// Data for tombstone management
+    /// </summary>
+    class default_tombstone_params
+    {
+    public:
+        //Compact once this fraction of the stored elements are tombstones
+        static constexpr float max_dead_ratio = 0.5f;
+    };
+
+    /// <summary>
+    /// Iterator skipping over erased (tombstoned) elements
+    /// </summary>
+    /// <typeparam name="Elem"></typeparam>
+    /// <typeparam name="Iterator">Underlying storage iterator</typeparam>
+    template<typename Elem, typename Iterator>
+    class tombstone_iterator;
+
+    /// <summary>
+    /// Represents tombstone vector management (the elements stay in the order they were inserted)
+    /// Erase marks the element dead in a bitmap, dead elements are skipped when iterating
+    /// and removed in a single pass once enough have accumulated
+    /// O(1) amortized erase
+    /// O(n / 64) indexed access while tombstones are present
+    /// </summary>
+    /// <typeparam name="Elem"></typeparam>
+    /// <typeparam name="Traits"></typeparam>
+    /// <typeparam name="Bitmap">Vector of uint64_t holding the dead bits</typeparam>
+    /// <typeparam name="Params"></typeparam>
+    template<typename Elem, typename Traits = default_traits<Elem>, typename Bitmap = cbb_vector<uint64_t>, typename Params = default_tombstone_params>
+    class tombstone_vec_management;
+
+    template<typename Elem, typename Traits = default_traits<Elem>>
+    using cbb_tombstone_vector = cbb_vector_impl<Elem, Traits, dynamic_vec_storage<Elem, Traits>, tombstone_vec_management<Elem, Traits>>;
+
+    template<typename Elem, size_t Capacity = 16, typename Traits = default_traits<Elem>>
+    using cbb_static_tombstone_vector =
+        cbb_vector_impl<Elem, Traits
+            , static_vec_storage<Elem, Capacity, Traits>
+            , tombstone_vec_management<Elem, Traits, cbb_static_vector<uint64_t, (Capacity + 63) / 64>>
+        >;
+
+    /// <summary>
+    /// Data for gap buffer management
+    /// </summary>
+    class default_gap_buffer_params
+    {
+    public:
+        //A new gap covers at least this many elements
+        static constexpr size_t min_gap = 16;
+        //A new gap covers at least this fraction of the elements
+        static constexpr float gap_ratio = 0.125f;
+    };
+
+    /// <summary>
+    /// Random access iterator skipping over the gap of a gap buffer
+    /// </summary>
+    /// <typeparam name="Elem"></typeparam>
+    /// <typeparam name="Iterator">Underlying storage iterator</typeparam>
+    template<typename Elem, typename Iterator>
+    class gap_iterator;
+
+    /// <summary>
+    /// Represents gap buffer vector management (the elements stay in the order they were inserted)
+    /// Free slots are kept as a gap at the last edit position, so the elements form two contiguous segments
+    /// O(1) amortized insert / erase near the last edit
+    /// O(distance to last edit) insert / erase elsewhere
+    /// </summary>
+    /// <typeparam name="Elem"></typeparam>
+    /// <typeparam name="Traits"></typeparam>
+    /// <typeparam name="Params"></typeparam>
+    template<typename Elem, typename Traits = default_traits<Elem>, typename Params = default_gap_buffer_params>
+    class gap_vec_management;
+
+    template<typename Elem, typename Traits = default_traits<Elem>>
+    using cbb_gap_vector = cbb_vector_impl<Elem, Traits, dynamic_vec_storage<Elem, Traits>, gap_vec_management<Elem, Traits>>;
+
+    template<typename Elem, size_t Capacity = 16, typename Traits = default_traits<Elem>>
+    using cbb_static_gap_vector = cbb_vector_impl<Elem, Traits, static_vec_storage<Elem, Capacity, Traits>, gap_vec_management<Elem, Traits>>;
 }
 
 /*
@@ -93,7 +193,7 @@ namespace cppcbb
     {
     public:
         using iterator = typename Traits::iterator;
-        using const_iterator = typename Traits::iterator;
+        using const_iterator = typename Traits::const_iterator;
 
     private:
         std::unique_ptr<Elem[]> m_data;
@@ -104,7 +204,7 @@ namespace cppcbb
         
     public:
         dynamic_vec_storage() 
-            : m_data(std::make_unique<Elem[]>(k_initial_capacity))
+            : m_data(new Elem[k_initial_capacity]())
             , m_capacity(k_initial_capacity)
         {}
 
@@ -132,7 +232,7 @@ namespace cppcbb
             new_capacity = capacity;
         }
 
-        auto new_data = std::make_unique<Elem[]>(new_capacity);
+        std::unique_ptr<Elem[]> new_data(new Elem[new_capacity]());
         if (new_data == nullptr)
         {
             return false;
@@ -161,46 +261,130 @@ namespace cppcbb
     {
     public:
         using iterator = typename Traits::iterator;
-        using const_iterator = typename Traits::iterator;
+        using const_iterator = typename Traits::const_iterator;
 
     private:
+#if CPPCBB_HAS_CONSTEXPR_CONTAINERS
+        //Constant evaluation needs every element initialized
+        Elem m_data[Capacity] = {};
+#else
         Elem m_data[Capacity];
+#endif
 
     public:
 
-        iterator begin() { return (iterator)&m_data[0]; }
-        const_iterator begin() const { return (const_iterator)& m_data[0]; }
-        const_iterator cbegin() const { return (const_iterator)& m_data[0]; }
+        CPPCBB_CONSTEXPR20 iterator begin() { return (iterator)&m_data[0]; }
+        CPPCBB_CONSTEXPR20 const_iterator begin() const { return (const_iterator)& m_data[0]; }
+        CPPCBB_CONSTEXPR20 const_iterator cbegin() const { return (const_iterator)& m_data[0]; }
 
-        size_t capacity() const { return m_capacity; }
+        CPPCBB_CONSTEXPR20 size_t capacity() const { return Capacity; }
 
-        bool ensure_capacity (size_t capacity, size_t size) const { return capacity <= Capacity; }
+        CPPCBB_CONSTEXPR20 bool ensure_capacity(size_t capacity, size_t size) const { return capacity <= Capacity; }
     };
 }
 
 /// <summary>
-/// Ordered Management
+/// Contiguous Management
 /// </summary>
 namespace cppcbb
 {
     template<typename Elem, typename Traits>
-    class ordered_vec_management
+    class contiguous_vec_management
     {
     public:
         using iterator = typename Traits::iterator;
-        using const_iterator = typename Traits::iterator;
+        using const_iterator = typename Traits::const_iterator;
+
+        //Iterator handed out by the vector for a storage location
+        template<typename Iterator>
+        static CPPCBB_CONSTEXPR20 Iterator make_iterator(Iterator begin, Iterator end, Iterator pos) { return pos; }
+
+        //Storage location of an iterator handed out by the vector
+        static CPPCBB_CONSTEXPR20 iterator position(iterator elem) { return elem; }
+
+        template<typename Iterator>
+        static CPPCBB_CONSTEXPR20 size_t size(Iterator begin, Iterator end) { return end - begin; }
+
+        template<typename Iterator>
+        static CPPCBB_CONSTEXPR20 Iterator at(Iterator begin, Iterator end, size_t idx) { return begin + idx; }
+
+        template<typename Iterator>
+        static CPPCBB_CONSTEXPR20 Iterator back(Iterator begin, Iterator end) { return end - 1; }
 
         //Inserts at end
-        static iterator insert (iterator begin, iterator end, const Elem& elem)
-        { 
-            return end; 
+        static CPPCBB_CONSTEXPR20 iterator insert(iterator begin, iterator end, const Elem& elem)
+        {
+            return end;
+        }
+
+        //Storage slots past end needed by insert_at
+        static CPPCBB_CONSTEXPR20 size_t insert_headroom(iterator begin, iterator end)
+        {
+            return 1;
+        }
+
+        //Shifts elements over to make room at pos, returns the slot for the new element
+        static CPPCBB_CONSTEXPR20 iterator insert_at(iterator begin, iterator& end, iterator pos, const Elem& elem, size_t capacity)
+        {
+            std::move_backward(pos, end, end + 1);
+            ++end;
+            return pos;
+        }
+
+        //Removes the final element, returns the new end
+        static CPPCBB_CONSTEXPR20 iterator pop_back(iterator begin, iterator end)
+        {
+            return end - 1;
+        }
+
+        //Number of elements erase(begin, end, elem) moves, every following element shifts down
+        static CPPCBB_CONSTEXPR20 size_t erase_shifts(iterator begin, iterator end, iterator elem)
+        {
+            return end - elem - 1;
         }
 
+        //Removes all matching elements in a single pass, returns the new end
+        template<typename Pred>
+        static CPPCBB_CONSTEXPR20 iterator erase_if(iterator begin, iterator end, Pred& pred)
+        {
+            return std::remove_if(begin, end, pred);
+        }
+
+        //Called before the storage has to grow, returns the new end
+        static CPPCBB_CONSTEXPR20 iterator compact(iterator begin, iterator end)
+        {
+            return end;
+        }
+
+        //Calls func(first, last) for each contiguous run of elements
+        template<typename Iterator, typename Func>
+        static CPPCBB_CONSTEXPR20 void for_each_segment(Iterator begin, Iterator end, Func& func)
+        {
+            func(begin, end);
+        }
+
+        static CPPCBB_CONSTEXPR20 void clear() {}
+    };
+}
+
+/// <summary>
+/// Ordered Management
+/// </summary>
+namespace cppcbb
+{
+    template<typename Elem, typename Traits>
+    class ordered_vec_management : public contiguous_vec_management<Elem, Traits>
+    {
+    public:
+        using iterator = typename Traits::iterator;
+        using const_iterator = typename Traits::const_iterator;
+
         // Shifts things over to remove
-        // Afterwards, final element should be removable
-        static void erase (iterator begin, iterator end, iterator elem)
+        // Returns the new end
+        static CPPCBB_CONSTEXPR20 iterator erase (iterator begin, iterator end, iterator elem)
         {
             std::rotate(elem, elem + 1, end);
+            return end - 1;
         }
     };
 }
@@ -211,28 +395,662 @@ namespace cppcbb
 namespace cppcbb
 {
     template<typename Elem, typename Traits>
-    class unordered_vec_management
+    class unordered_vec_management : public contiguous_vec_management<Elem, Traits>
     {
     public:
         using iterator = typename Traits::iterator;
-        using const_iterator = typename Traits::iterator;
+        using const_iterator = typename Traits::const_iterator;
+
+        // Swap element with end
+        // Returns the new end
+        static CPPCBB_CONSTEXPR20 iterator erase (iterator begin, iterator end, iterator elem)
+        {
+            if ((elem + 1) != end)
+            {
+                std::swap(*elem, *(end - 1));
+            }
+            return end - 1;
+        }
+
+        // Only the end element moves
+        static CPPCBB_CONSTEXPR20 size_t erase_shifts(iterator begin, iterator end, iterator elem)
+        {
+            return (elem + 1) != end ? 1 : 0;
+        }
+
+        // Moves the element at pos to the end
+        static CPPCBB_CONSTEXPR20 iterator insert_at(iterator begin, iterator& end, iterator pos, const Elem& elem, size_t capacity)
+        {
+            if (pos != end)
+            {
+                *end = std::move(*pos);
+            }
+            ++end;
+            return pos;
+        }
+
+        // Fills holes from the back, so fewer elements move than with remove_if
+        template<typename Pred>
+        static CPPCBB_CONSTEXPR20 iterator erase_if(iterator begin, iterator end, Pred& pred)
+        {
+            iterator current = begin;
+            while (current != end)
+            {
+                if (pred(*current))
+                {
+                    --end;
+                    if (current != end)
+                    {
+                        *current = std::move(*end);
+                    }
+                }
+                else
+                {
+                    ++current;
+                }
+            }
+            return end;
+        }
+    };
+}
+
+/// <summary>
+/// Tombstone Management
+/// </summary>
+namespace cppcbb
+{
+    template<typename Elem, typename Iterator>
+    class tombstone_iterator
+    {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = Elem;
+        using difference_type = std::ptrdiff_t;
+        using pointer = Iterator;
+        using reference = decltype(*std::declval<Iterator>());
+
+    private:
+        template<typename, typename> friend class tombstone_iterator;
+
+        Iterator m_begin;
+        Iterator m_pos;
+        Iterator m_end;
+        const uint64_t* m_dead;
+
+        //Moves forward to the next live element, a word of the bitmap at a time
+        void skip_dead()
+        {
+            m_pos = m_begin + bits::find_next_clear(m_dead, m_pos - m_begin, m_end - m_begin);
+        }
+
+    public:
+        tombstone_iterator() : m_begin(), m_pos(), m_end(), m_dead(nullptr) {}
+
+        tombstone_iterator(Iterator begin, Iterator pos, Iterator end, const uint64_t* dead)
+            : m_begin(begin), m_pos(pos), m_end(end), m_dead(dead)
+        {
+            skip_dead();
+        }
+
+        //Allows iterator -> const_iterator conversion
+        template<typename OtherIterator>
+        tombstone_iterator(const tombstone_iterator<Elem, OtherIterator>& other)
+            : m_begin(other.m_begin), m_pos(other.m_pos), m_end(other.m_end), m_dead(other.m_dead)
+        {}
+
+        Iterator base() const { return m_pos; }
+
+        reference operator*() const { return *m_pos; }
+        pointer operator->() const { return m_pos; }
+
+        tombstone_iterator& operator++()
+        {
+            ++m_pos;
+            skip_dead();
+            return *this;
+        }
+
+        tombstone_iterator operator++(int)
+        {
+            tombstone_iterator copy = *this;
+            ++(*this);
+            return copy;
+        }
+
+        template<typename OtherIterator>
+        bool operator==(const tombstone_iterator<Elem, OtherIterator>& other) const { return m_pos == other.m_pos; }
+
+        template<typename OtherIterator>
+        bool operator!=(const tombstone_iterator<Elem, OtherIterator>& other) const { return m_pos != other.m_pos; }
+    };
+
+    template<typename Elem, typename Traits, typename Bitmap, typename Params>
+    class tombstone_vec_management
+    {
+    public:
+        using iterator = tombstone_iterator<Elem, typename Traits::iterator>;
+        using const_iterator = tombstone_iterator<Elem, typename Traits::const_iterator>;
+
+    private:
+        using storage_iterator = typename Traits::iterator;
+
+        static constexpr float k_max_dead_ratio = Params::max_dead_ratio;
+
+        Bitmap m_dead;
+        size_t m_dead_count = 0;
+
+        bool is_dead(size_t idx) const
+        {
+            return ((m_dead[idx / 64] >> (idx % 64)) & 1) != 0;
+        }
+
+        void set_dead(size_t idx)
+        {
+            m_dead[idx / 64] |= (uint64_t)1 << (idx % 64);
+        }
+
+        void set_live(size_t idx)
+        {
+            m_dead[idx / 64] &= ~((uint64_t)1 << (idx % 64));
+        }
+
+        void ensure_bit(size_t idx)
+        {
+            if (idx / 64 >= m_dead.size())
+            {
+                m_dead.push_back(0);
+            }
+        }
+
+    public:
+        template<typename Iterator>
+        tombstone_iterator<Elem, Iterator> make_iterator(Iterator begin, Iterator end, Iterator pos) const
+        {
+            return tombstone_iterator<Elem, Iterator>(begin, pos, end, m_dead.begin());
+        }
+
+        static storage_iterator position(iterator elem) { return elem.base(); }
+
+        template<typename Iterator>
+        size_t size(Iterator begin, Iterator end) const
+        {
+            return (end - begin) - m_dead_count;
+        }
+
+        //Finds the idx-th live element by counting live bits a word at a time
+        template<typename Iterator>
+        Iterator at(Iterator begin, Iterator end, size_t idx) const
+        {
+            if (m_dead_count == 0)
+            {
+                return begin + idx;
+            }
+
+            for (size_t word = 0; ; word++)
+            {
+                uint64_t live = ~m_dead[word];
+                size_t count = bits::popcount(live);
+                if (idx < count)
+                {
+                    for (; idx > 0; idx--)
+                    {
+                        live &= live - 1;
+                    }
+                    return begin + (word * 64 + bits::count_trailing_zeros(live));
+                }
+                idx -= count;
+            }
+        }
+
+        //The final stored element is always live
+        template<typename Iterator>
+        static Iterator back(Iterator begin, Iterator end) { return end - 1; }
 
         //Inserts at end
-        static iterator insert (iterator begin, iterator end, const Elem& elem)
+        storage_iterator insert(storage_iterator begin, storage_iterator end, const Elem& elem)
         {
+            ensure_bit(end - begin);
             return end;
         }
 
-        // Swap element with end
-        // Afterwards, final element should be removable
-        static void erase (iterator begin, iterator end, iterator elem)
+        static size_t insert_headroom(storage_iterator begin, storage_iterator end)
+        {
+            return 1;
+        }
+
+        //Shifts elements & their dead bits over to make room at pos
+        storage_iterator insert_at(storage_iterator begin, storage_iterator& end, storage_iterator pos, const Elem& elem, size_t capacity)
         {
+            ensure_bit(end - begin);
+
+            size_t idx = pos - begin;
+            size_t first_word = idx / 64;
+            for (size_t word = m_dead.size() - 1; word > first_word; word--)
+            {
+                m_dead[word] = (m_dead[word] << 1) | (m_dead[word - 1] >> 63);
+            }
+
+            uint64_t low_mask = ((uint64_t)1 << (idx % 64)) - 1;
+            uint64_t value = m_dead[first_word];
+            m_dead[first_word] = (value & low_mask) | ((value & ~low_mask) << 1);
+
+            std::move_backward(pos, end, end + 1);
+            ++end;
+            return pos;
+        }
+
+        //Marks the element dead, compacting once the threshold is reached
+        //Returns the new end
+        storage_iterator erase(storage_iterator begin, storage_iterator end, storage_iterator elem)
+        {
+            size_t idx = elem - begin;
+            CPPCBB_ASSERT(!is_dead(idx), "Element already erased!");
+
             if ((elem + 1) == end)
             {
+                return pop_back(begin, end);
+            }
+
+            set_dead(idx);
+            m_dead_count++;
+
+            if (m_dead_count >= k_max_dead_ratio * (end - begin))
+            {
+                return compact(begin, end);
+            }
+            return end;
+        }
+
+        //Erasing only marks a tombstone, compaction is amortized over many erases
+        static size_t erase_shifts(storage_iterator begin, storage_iterator end, storage_iterator elem)
+        {
+            return 0;
+        }
+
+        //Removes the final element, and any tombstones exposed behind it
+        storage_iterator pop_back(storage_iterator begin, storage_iterator end)
+        {
+            --end;
+            while (end != begin && is_dead((end - begin) - 1))
+            {
+                set_live((end - begin) - 1);
+                m_dead_count--;
+                --end;
+            }
+            return end;
+        }
+
+        //Removes tombstones & matching elements in a single pass, returns the new end
+        template<typename Pred>
+        storage_iterator erase_if(storage_iterator begin, storage_iterator end, Pred& pred)
+        {
+            storage_iterator write = begin;
+            for (storage_iterator read = begin; read != end; ++read)
+            {
+                if (is_dead(read - begin) || pred(*read))
+                {
+                    continue;
+                }
+
+                if (write != read)
+                {
+                    *write = std::move(*read);
+                }
+                ++write;
+            }
+
+            std::fill(m_dead.begin(), m_dead.end(), 0);
+            m_dead_count = 0;
+            return write;
+        }
+
+        //Removes tombstones in a single pass, returns the new end
+        storage_iterator compact(storage_iterator begin, storage_iterator end)
+        {
+            if (m_dead_count == 0)
+            {
+                return end;
+            }
+
+            auto keep_all = [](const Elem&) { return false; };
+            return erase_if(begin, end, keep_all);
+        }
+
+        size_t dead_count() const { return m_dead_count; }
+
+        //Calls func(first, last) for each run of live elements
+        template<typename Iterator, typename Func>
+        void for_each_segment(Iterator begin, Iterator end, Func& func) const
+        {
+            size_t size = end - begin;
+            size_t idx = bits::find_next_clear(m_dead.begin(), 0, size);
+            while (idx < size)
+            {
+                size_t run_end = bits::find_next_set(m_dead.begin(), idx, size);
+                func(begin + idx, begin + run_end);
+                idx = bits::find_next_clear(m_dead.begin(), run_end, size);
+            }
+        }
+
+        void clear()
+        {
+            m_dead.clear();
+            m_dead_count = 0;
+        }
+    };
+}
+
+/// <summary>
+/// Gap Buffer Management
+/// </summary>
+namespace cppcbb
+{
+    template<typename Elem, typename Iterator>
+    class gap_iterator
+    {
+    public:
+        using iterator_category = std::random_access_iterator_tag;
+        using value_type = Elem;
+        using difference_type = std::ptrdiff_t;
+        using pointer = Iterator;
+        using reference = decltype(*std::declval<Iterator>());
+
+    private:
+        template<typename, typename> friend class gap_iterator;
+
+        Iterator m_begin;
+        Iterator m_pos;
+        size_t m_gap_begin;
+        size_t m_gap_size;
+
+        size_t index() const
+        {
+            size_t offset = m_pos - m_begin;
+            return offset < m_gap_begin ? offset : offset - m_gap_size;
+        }
+
+        void seek(size_t idx)
+        {
+            m_pos = m_begin + (idx < m_gap_begin ? idx : idx + m_gap_size);
+        }
+
+    public:
+        gap_iterator() : m_begin(), m_pos(), m_gap_begin(0), m_gap_size(0) {}
+
+        gap_iterator(Iterator begin, Iterator pos, size_t gap_begin, size_t gap_size)
+            : m_begin(begin), m_pos(pos), m_gap_begin(gap_begin), m_gap_size(gap_size)
+        {
+            //The start of the gap is the same element as the end of the gap
+            if ((size_t)(m_pos - m_begin) == m_gap_begin)
+            {
+                m_pos += m_gap_size;
+            }
+        }
+
+        //Allows iterator -> const_iterator conversion
+        template<typename OtherIterator>
+        gap_iterator(const gap_iterator<Elem, OtherIterator>& other)
+            : m_begin(other.m_begin), m_pos(other.m_pos), m_gap_begin(other.m_gap_begin), m_gap_size(other.m_gap_size)
+        {}
+
+        Iterator base() const { return m_pos; }
+
+        reference operator*() const { return *m_pos; }
+        pointer operator->() const { return m_pos; }
+        reference operator[](difference_type n) const { return *(*this + n); }
+
+        gap_iterator& operator++()
+        {
+            ++m_pos;
+            if ((size_t)(m_pos - m_begin) == m_gap_begin)
+            {
+                m_pos += m_gap_size;
+            }
+            return *this;
+        }
+
+        gap_iterator& operator--()
+        {
+            if ((size_t)(m_pos - m_begin) == m_gap_begin + m_gap_size)
+            {
+                m_pos -= m_gap_size;
+            }
+            --m_pos;
+            return *this;
+        }
+
+        gap_iterator operator++(int) { gap_iterator copy = *this; ++(*this); return copy; }
+        gap_iterator operator--(int) { gap_iterator copy = *this; --(*this); return copy; }
+
+        gap_iterator& operator+=(difference_type n) { seek(index() + n); return *this; }
+        gap_iterator& operator-=(difference_type n) { seek(index() - n); return *this; }
+
+        gap_iterator operator+(difference_type n) const { gap_iterator copy = *this; return copy += n; }
+        gap_iterator operator-(difference_type n) const { gap_iterator copy = *this; return copy -= n; }
+        friend gap_iterator operator+(difference_type n, const gap_iterator& it) { return it + n; }
+
+        template<typename OtherIterator>
+        difference_type operator-(const gap_iterator<Elem, OtherIterator>& other) const { return (difference_type)index() - (difference_type)other.index(); }
+
+        //Storage order matches element order
+        template<typename OtherIterator>
+        bool operator==(const gap_iterator<Elem, OtherIterator>& other) const { return m_pos == other.m_pos; }
+        template<typename OtherIterator>
+        bool operator!=(const gap_iterator<Elem, OtherIterator>& other) const { return m_pos != other.m_pos; }
+        template<typename OtherIterator>
+        bool operator<(const gap_iterator<Elem, OtherIterator>& other) const { return m_pos < other.m_pos; }
+        template<typename OtherIterator>
+        bool operator>(const gap_iterator<Elem, OtherIterator>& other) const { return m_pos > other.m_pos; }
+        template<typename OtherIterator>
+        bool operator<=(const gap_iterator<Elem, OtherIterator>& other) const { return m_pos <= other.m_pos; }
+        template<typename OtherIterator>
+        bool operator>=(const gap_iterator<Elem, OtherIterator>& other) const { return m_pos >= other.m_pos; }
+    };
+
+    template<typename Elem, typename Traits, typename Params>
+    class gap_vec_management
+    {
+    public:
+        using iterator = gap_iterator<Elem, typename Traits::iterator>;
+        using const_iterator = gap_iterator<Elem, typename Traits::const_iterator>;
+
+    private:
+        using storage_iterator = typename Traits::iterator;
+
+        static constexpr size_t k_min_gap = Params::min_gap;
+        static constexpr float k_gap_ratio = Params::gap_ratio;
+
+        //The gap never touches the end of the storage range, so the final stored element is always live
+        size_t m_gap_begin = 0;
+        size_t m_gap_size = 0;
+
+        template<typename Iterator>
+        size_t index_of(Iterator begin, Iterator pos) const
+        {
+            size_t offset = pos - begin;
+            return offset <= m_gap_begin ? offset : offset - m_gap_size;
+        }
+
+        //Moves the gap so that it starts before element idx, shifting only the elements in between
+        void move_gap(storage_iterator begin, size_t idx)
+        {
+            if (m_gap_size == 0)
+            {
+                m_gap_begin = idx;
                 return;
             }
 
-            std::swap(*elem, *(end - 1));
+            if (idx < m_gap_begin)
+            {
+                std::move_backward(begin + idx, begin + m_gap_begin, begin + m_gap_begin + m_gap_size);
+            }
+            else if (idx > m_gap_begin)
+            {
+                std::move(begin + m_gap_begin + m_gap_size, begin + idx + m_gap_size, begin + m_gap_begin);
+            }
+            m_gap_begin = idx;
+        }
+
+        //Drops a gap that reached the end of the storage range, returns the new end
+        storage_iterator trim(storage_iterator begin, storage_iterator end)
+        {
+            if (m_gap_size > 0 && m_gap_begin + m_gap_size == (size_t)(end - begin))
+            {
+                end = begin + m_gap_begin;
+                m_gap_size = 0;
+            }
+            return end;
+        }
+
+    public:
+        template<typename Iterator>
+        gap_iterator<Elem, Iterator> make_iterator(Iterator begin, Iterator end, Iterator pos) const
+        {
+            return gap_iterator<Elem, Iterator>(begin, pos, m_gap_begin, m_gap_size);
+        }
+
+        static storage_iterator position(iterator elem) { return elem.base(); }
+
+        template<typename Iterator>
+        size_t size(Iterator begin, Iterator end) const
+        {
+            return (end - begin) - m_gap_size;
+        }
+
+        template<typename Iterator>
+        Iterator at(Iterator begin, Iterator end, size_t idx) const
+        {
+            return begin + (idx < m_gap_begin ? idx : idx + m_gap_size);
+        }
+
+        template<typename Iterator>
+        static Iterator back(Iterator begin, Iterator end) { return end - 1; }
+
+        //Inserts at end
+        static storage_iterator insert(storage_iterator begin, storage_iterator end, const Elem& elem)
+        {
+            return end;
+        }
+
+        //Only an empty gap needs more storage
+        size_t insert_headroom(storage_iterator begin, storage_iterator end) const
+        {
+            return m_gap_size == 0 ? 1 : 0;
+        }
+
+        //Moves the gap to pos and fills its first slot
+        //An empty gap is reopened as large as the free capacity & params allow
+        storage_iterator insert_at(storage_iterator begin, storage_iterator& end, storage_iterator pos, const Elem& elem, size_t capacity)
+        {
+            size_t idx = index_of(begin, pos);
+
+            if (m_gap_size == 0)
+            {
+                size_t count = (end - begin);
+                size_t gap = (size_t)(count * k_gap_ratio);
+                if (gap < k_min_gap)
+                {
+                    gap = k_min_gap;
+                }
+                if (gap > capacity - count)
+                {
+                    gap = capacity - count;
+                }
+
+                std::move_backward(begin + idx, end, end + gap);
+                end += gap;
+                m_gap_begin = idx;
+                m_gap_size = gap;
+            }
+            else
+            {
+                move_gap(begin, idx);
+            }
+
+            storage_iterator slot = begin + m_gap_begin;
+            m_gap_begin++;
+            m_gap_size--;
+
+            end = trim(begin, end);
+            return slot;
+        }
+
+        //Moves the gap to elem and grows it over elem
+        //Returns the new end
+        storage_iterator erase(storage_iterator begin, storage_iterator end, storage_iterator elem)
+        {
+            move_gap(begin, index_of(begin, elem));
+            m_gap_size++;
+            return trim(begin, end);
+        }
+
+        //Elements between the gap and elem move across the gap
+        size_t erase_shifts(storage_iterator begin, storage_iterator end, storage_iterator elem) const
+        {
+            if (m_gap_size == 0)
+            {
+                return 0;
+            }
+            size_t idx = index_of(begin, elem);
+            return idx < m_gap_begin ? m_gap_begin - idx : idx - m_gap_begin;
+        }
+
+        storage_iterator pop_back(storage_iterator begin, storage_iterator end)
+        {
+            return trim(begin, end - 1);
+        }
+
+        //Closes the gap & removes all matching elements in a single pass, returns the new end
+        template<typename Pred>
+        storage_iterator erase_if(storage_iterator begin, storage_iterator end, Pred& pred)
+        {
+            storage_iterator write = std::remove_if(begin, begin + m_gap_begin, pred);
+            for (storage_iterator read = begin + m_gap_begin + m_gap_size; read != end; ++read)
+            {
+                if (!pred(*read))
+                {
+                    *write = std::move(*read);
+                    ++write;
+                }
+            }
+
+            m_gap_begin = 0;
+            m_gap_size = 0;
+            return write;
+        }
+
+        //Closes the gap, returns the new end
+        storage_iterator compact(storage_iterator begin, storage_iterator end)
+        {
+            if (m_gap_size == 0)
+            {
+                return end;
+            }
+
+            storage_iterator new_end = std::move(begin + m_gap_begin + m_gap_size, end, begin + m_gap_begin);
+            m_gap_begin = 0;
+            m_gap_size = 0;
+            return new_end;
+        }
+
+        //Calls func(first, last) for the segments before & after the gap
+        template<typename Iterator, typename Func>
+        void for_each_segment(Iterator begin, Iterator end, Func& func) const
+        {
+            if (m_gap_size == 0)
+            {
+                func(begin, end);
+                return;
+            }
+
+            func(begin, begin + m_gap_begin);
+            func(begin + m_gap_begin + m_gap_size, end);
+        }
+
+        void clear()
+        {
+            m_gap_begin = 0;
+            m_gap_size = 0;
         }
     };
 }
@@ -240,74 +1058,113 @@ namespace cppcbb
 
 ///
 /// Vector implementation
-/// 
+///
 namespace cppcbb
 {
-    template<typename Elem, typename Traits, typename Storage, typename Management>
-    class cbb_vector_impl
+    template<typename Elem, typename Traits, typename Storage, typename Management, typename Stats>
+    class cbb_vector_impl : private Management
     {
     public:
-        using iterator = typename Traits::iterator;
-        using const_iterator = typename Traits::const_iterator;
-        using self_type = cbb_vector_impl<Elem, Traits, Storage, Management>;
+        using iterator = typename Management::iterator;
+        using const_iterator = typename Management::const_iterator;
+        using value_type = Elem;
+        using self_type = cbb_vector_impl<Elem, Traits, Storage, Management, Stats>;
+        using storage_type = Storage;
+
+        //Iterators passed to for_each_segment
+        using segment_iterator = typename Traits::iterator;
+        using const_segment_iterator = typename Traits::const_iterator;
 
     private:
+        using storage_iterator = typename Traits::iterator;
+        using storage_const_iterator = typename Traits::const_iterator;
+
         Storage m_storage;
-        iterator m_end = m_storage.begin();
+        //Storage slots in use, an offset rather than an end pointer so the vector never points into itself
+        size_t m_storage_size = 0;
 
-        bool ensure_capacity(size_t capacity);
+        //Management is a private base, so stateless managements take no space
+        CPPCBB_CONSTEXPR20 Management& management() { return *this; }
+        CPPCBB_CONSTEXPR20 const Management& management() const { return *this; }
+
+        CPPCBB_CONSTEXPR20 bool ensure_capacity(size_t capacity);
+
+        CPPCBB_CONSTEXPR20 storage_iterator storage_end() { return m_storage.begin() + m_storage_size; }
+        CPPCBB_CONSTEXPR20 storage_const_iterator storage_cend() const { return m_storage.begin() + m_storage_size; }
+        CPPCBB_CONSTEXPR20 void set_storage_end(storage_iterator end) { m_storage_size = end - m_storage.begin(); }
+        CPPCBB_CONSTEXPR20 size_t storage_size() const { return m_storage_size; }
 
     public:
-        cbb_vector_impl(){}
+        CPPCBB_CONSTEXPR20 cbb_vector_impl(){}
 
-        cbb_vector_impl(const self_type&);
-        cbb_vector_impl(self_type&&) noexcept;
+        CPPCBB_CONSTEXPR20 cbb_vector_impl(const self_type&);
+        CPPCBB_CONSTEXPR20 cbb_vector_impl(self_type&&) noexcept;
 
-        self_type& operator=(const self_type&);
-        self_type& operator=(self_type&&);
+        CPPCBB_CONSTEXPR20 self_type& operator=(const self_type&);
+        CPPCBB_CONSTEXPR20 self_type& operator=(self_type&&);
 
-        iterator begin() { return m_storage.begin(); }
-        iterator end() { return m_end; }
+        CPPCBB_CONSTEXPR20 iterator begin() { return management().make_iterator(m_storage.begin(), storage_end(), m_storage.begin()); }
+        CPPCBB_CONSTEXPR20 iterator end() { return management().make_iterator(m_storage.begin(), storage_end(), storage_end()); }
 
-        const_iterator begin() const { return m_storage.begin(); }
-        const_iterator end() const { return m_end; }
+        CPPCBB_CONSTEXPR20 const_iterator begin() const { return management().make_iterator(m_storage.begin(), storage_cend(), m_storage.begin()); }
+        CPPCBB_CONSTEXPR20 const_iterator end() const { return management().make_iterator(m_storage.begin(), storage_cend(), storage_cend()); }
 
-        const_iterator cbegin() const { return m_storage.begin(); }
-        const_iterator cend() const { return m_end; }
+        CPPCBB_CONSTEXPR20 const_iterator cbegin() const { return begin(); }
+        CPPCBB_CONSTEXPR20 const_iterator cend() const { return end(); }
 
-        size_t size() const { return m_end - begin(); }
-        size_t capacity() const { return m_storage.capacity(); }
+        CPPCBB_CONSTEXPR20 size_t size() const { return management().size(m_storage.begin(), storage_cend()); }
+        CPPCBB_CONSTEXPR20 size_t capacity() const { return m_storage.capacity(); }
 
-        void push_back(const Elem& elem);
-        void push_back(Elem&& elem);
+        CPPCBB_CONSTEXPR20 void push_back(const Elem& elem);
+        CPPCBB_CONSTEXPR20 void push_back(Elem&& elem);
         template<typename ... Args>
-        void emplace_back(Args&& ... args);
+        CPPCBB_CONSTEXPR20 void emplace_back(Args&& ... args);
+
+        //Inserts before pos, returns an iterator to the new element
+        CPPCBB_CONSTEXPR20 iterator insert(iterator pos, const Elem& elem);
+        CPPCBB_CONSTEXPR20 iterator insert(iterator pos, Elem&& elem);
 
-        Elem& back();
-        const Elem& back() const;
+        CPPCBB_CONSTEXPR20 Elem& back();
+        CPPCBB_CONSTEXPR20 const Elem& back() const;
 
-        void pop_back();
+        CPPCBB_CONSTEXPR20 void pop_back();
 
-        void erase(iterator elem);
+        CPPCBB_CONSTEXPR20 void erase(iterator elem);
 
-        void clear();
-        void resize(size_t size);
+        //Removes all elements matching the predicate in a single pass, returns the number removed
+        template<typename Pred>
+        CPPCBB_CONSTEXPR20 size_t erase_if(Pred pred);
 
-        Elem& operator[](size_t);
-        const Elem& operator[](size_t) const;
+        CPPCBB_CONSTEXPR20 void clear();
+        CPPCBB_CONSTEXPR20 void resize(size_t size);
+
+        //Calls func(first, last) for each contiguous run of elements, in order
+        template<typename Func>
+        CPPCBB_CONSTEXPR20 void for_each_segment(Func func);
+        template<typename Func>
+        CPPCBB_CONSTEXPR20 void for_each_segment(Func func) const;
+
+        CPPCBB_CONSTEXPR20 Elem& operator[](size_t);
+        CPPCBB_CONSTEXPR20 const Elem& operator[](size_t) const;
     };
 
-    template<typename Elem, typename Traits, typename Storage, typename Management>
-    inline bool cbb_vector_impl<Elem, Traits, Storage, Management>::ensure_capacity(size_t capacity)
+    template<typename Elem, typename Traits, typename Storage, typename Management, typename Stats>
+    CPPCBB_CONSTEXPR20 inline bool cbb_vector_impl<Elem, Traits, Storage, Management, Stats>::ensure_capacity(size_t capacity)
     {
-        size_t cur_size = size();
+        size_t cur_size = storage_size();
+        size_t old_capacity = m_storage.capacity();
         bool enough_storage = m_storage.ensure_capacity(capacity, cur_size);
-        m_end = begin() + cur_size;
+
+        if (m_storage.capacity() != old_capacity)
+        {
+            Stats::on_allocation(m_storage.capacity() * sizeof(Elem));
+            Stats::on_moves(cur_size);
+        }
         return enough_storage;
     }
 
-    template<typename Elem, typename Traits, typename Storage, typename Management>
-    inline cbb_vector_impl<Elem, Traits, Storage, Management>::cbb_vector_impl(const self_type& other)
+    template<typename Elem, typename Traits, typename Storage, typename Management, typename Stats>
+    CPPCBB_CONSTEXPR20 inline cbb_vector_impl<Elem, Traits, Storage, Management, Stats>::cbb_vector_impl(const self_type& other)
     {
         for (const Elem& e : other)
         {
@@ -315,17 +1172,19 @@ namespace cppcbb
         }
     }
 
-    template<typename Elem, typename Traits, typename Storage, typename Management>
-    inline cbb_vector_impl<Elem, Traits, Storage, Management>::cbb_vector_impl(self_type&& other) noexcept
+    template<typename Elem, typename Traits, typename Storage, typename Management, typename Stats>
+    CPPCBB_CONSTEXPR20 inline cbb_vector_impl<Elem, Traits, Storage, Management, Stats>::cbb_vector_impl(self_type&& other) noexcept
     {
+        //Storage is never stolen, so every element moves
+        Stats::on_moves(other.size());
         for (Elem& e : other)
         {
             push_back(std::move(e));
         }
     }
 
-    template<typename Elem, typename Traits, typename Storage, typename Management>
-    inline typename cbb_vector_impl<Elem, Traits, Storage, Management>::self_type& cbb_vector_impl<Elem, Traits, Storage, Management>::operator=(const self_type& other)
+    template<typename Elem, typename Traits, typename Storage, typename Management, typename Stats>
+    CPPCBB_CONSTEXPR20 inline typename cbb_vector_impl<Elem, Traits, Storage, Management, Stats>::self_type& cbb_vector_impl<Elem, Traits, Storage, Management, Stats>::operator=(const self_type& other)
     {
         clear();
         for (const Elem& e : other)
@@ -335,10 +1194,11 @@ namespace cppcbb
         return *this;
     }
 
-    template<typename Elem, typename Traits, typename Storage, typename Management>
-    inline typename cbb_vector_impl<Elem, Traits, Storage, Management>::self_type& cbb_vector_impl<Elem, Traits, Storage, Management>::operator=(self_type&& other)
+    template<typename Elem, typename Traits, typename Storage, typename Management, typename Stats>
+    CPPCBB_CONSTEXPR20 inline typename cbb_vector_impl<Elem, Traits, Storage, Management, Stats>::self_type& cbb_vector_impl<Elem, Traits, Storage, Management, Stats>::operator=(self_type&& other)
     {
         clear();
+        Stats::on_moves(other.size());
         for (Elem& e : other)
         {
             push_back(std::move(e));
@@ -346,102 +1206,175 @@ namespace cppcbb
         return *this;
     }
 
-    template<typename Elem, typename Traits, typename Storage, typename Management>
-    inline void cbb_vector_impl<Elem, Traits, Storage, Management>::push_back(const Elem& elem)
+    template<typename Elem, typename Traits, typename Storage, typename Management, typename Stats>
+    CPPCBB_CONSTEXPR20 inline void cbb_vector_impl<Elem, Traits, Storage, Management, Stats>::push_back(const Elem& elem)
     {
-        CPPCBB_ASSERT(ensure_capacity(size() + 1), "Not enough storage!");
-        iterator loc = Management::insert(begin(), end(), elem);
+        if (storage_size() == capacity())
+        {
+            set_storage_end(management().compact(m_storage.begin(), storage_end()));
+        }
+        CPPCBB_ASSERT(ensure_capacity(storage_size() + 1), "Not enough storage!");
+        storage_iterator loc = management().insert(m_storage.begin(), storage_end(), elem);
         *loc = elem;
-        m_end++;
+        m_storage_size++;
     }
 
-    template<typename Elem, typename Traits, typename Storage, typename Management>
-    inline void cbb_vector_impl<Elem, Traits, Storage, Management>::push_back(Elem&& elem)
+    template<typename Elem, typename Traits, typename Storage, typename Management, typename Stats>
+    CPPCBB_CONSTEXPR20 inline void cbb_vector_impl<Elem, Traits, Storage, Management, Stats>::push_back(Elem&& elem)
     {
-        CPPCBB_ASSERT(ensure_capacity(size() + 1), "Not enough storage!");
+        if (storage_size() == capacity())
+        {
+            set_storage_end(management().compact(m_storage.begin(), storage_end()));
+        }
+        CPPCBB_ASSERT(ensure_capacity(storage_size() + 1), "Not enough storage!");
 
-        iterator loc = Management::insert(begin(), end(), elem);
+        storage_iterator loc = management().insert(m_storage.begin(), storage_end(), elem);
         *loc = std::move(elem);
-        m_end++;
+        m_storage_size++;
     }
 
-    template<typename Elem, typename Traits, typename Storage, typename Management>
+    template<typename Elem, typename Traits, typename Storage, typename Management, typename Stats>
     template<typename ...Args>
-    inline void cbb_vector_impl<Elem, Traits, Storage, Management>::emplace_back(Args && ...args)
+    CPPCBB_CONSTEXPR20 inline void cbb_vector_impl<Elem, Traits, Storage, Management, Stats>::emplace_back(Args && ...args)
     {
         Elem elem(std::forward<Args>(args)...);
         push_back(std::move(elem));
     }
 
-    template<typename Elem, typename Traits, typename Storage, typename Management>
-    inline Elem& cbb_vector_impl<Elem, Traits, Storage, Management>::back()
+    template<typename Elem, typename Traits, typename Storage, typename Management, typename Stats>
+    CPPCBB_CONSTEXPR20 inline typename cbb_vector_impl<Elem, Traits, Storage, Management, Stats>::iterator cbb_vector_impl<Elem, Traits, Storage, Management, Stats>::insert(iterator pos, const Elem& elem)
+    {
+        Elem copy = elem;
+        return insert(pos, std::move(copy));
+    }
+
+    template<typename Elem, typename Traits, typename Storage, typename Management, typename Stats>
+    CPPCBB_CONSTEXPR20 inline typename cbb_vector_impl<Elem, Traits, Storage, Management, Stats>::iterator cbb_vector_impl<Elem, Traits, Storage, Management, Stats>::insert(iterator pos, Elem&& elem)
+    {
+        //Growing the storage invalidates pos
+        size_t offset = management().position(pos) - m_storage.begin();
+        if (storage_size() == capacity())
+        {
+            //Full storage may still hold tombstones or a gap, compacting frees them before growing
+            //Compacted storage is in logical order, so pos is found again by its index
+            offset = std::distance(begin(), pos);
+            set_storage_end(management().compact(m_storage.begin(), storage_end()));
+        }
+
+        size_t headroom = management().insert_headroom(m_storage.begin(), storage_end());
+        if (headroom > 0)
+        {
+            CPPCBB_ASSERT(ensure_capacity(storage_size() + headroom), "Not enough storage!");
+        }
+
+        storage_iterator end = storage_end();
+        storage_iterator loc = management().insert_at(m_storage.begin(), end, m_storage.begin() + offset, elem, capacity());
+        set_storage_end(end);
+        *loc = std::move(elem);
+        return management().make_iterator(m_storage.begin(), end, loc);
+    }
+
+    template<typename Elem, typename Traits, typename Storage, typename Management, typename Stats>
+    CPPCBB_CONSTEXPR20 inline Elem& cbb_vector_impl<Elem, Traits, Storage, Management, Stats>::back()
     {
         CPPCBB_ASSERT((size() > 0), "No elements in vector!");
 
-        return *(m_end - 1);
+        return *management().back(m_storage.begin(), storage_end());
     }
 
-    template<typename Elem, typename Traits, typename Storage, typename Management>
-    inline const Elem& cbb_vector_impl<Elem, Traits, Storage, Management>::back() const
+    template<typename Elem, typename Traits, typename Storage, typename Management, typename Stats>
+    CPPCBB_CONSTEXPR20 inline const Elem& cbb_vector_impl<Elem, Traits, Storage, Management, Stats>::back() const
     {
         CPPCBB_ASSERT((size() > 0), "No elements in vector!");
 
-        return *(m_end - 1);
+        return *management().back(m_storage.begin(), storage_cend());
     }
 
-    template<typename Elem, typename Traits, typename Storage, typename Management>
-    inline void cbb_vector_impl<Elem, Traits, Storage, Management>::pop_back()
+    template<typename Elem, typename Traits, typename Storage, typename Management, typename Stats>
+    CPPCBB_CONSTEXPR20 inline void cbb_vector_impl<Elem, Traits, Storage, Management, Stats>::pop_back()
     {
         CPPCBB_ASSERT((size() > 0), "No elements in vector!");
-        m_end--;
+        set_storage_end(management().pop_back(m_storage.begin(), storage_end()));
     }
 
-    template<typename Elem, typename Traits, typename Storage, typename Management>
-    inline void cbb_vector_impl<Elem, Traits, Storage, Management>::erase(iterator elem)
+    template<typename Elem, typename Traits, typename Storage, typename Management, typename Stats>
+    CPPCBB_CONSTEXPR20 inline void cbb_vector_impl<Elem, Traits, Storage, Management, Stats>::erase(iterator elem)
     {
-        Management::erase(begin(), end(), elem);
-        pop_back();
+        CPPCBB_ASSERT((size() > 0), "No elements in vector!");
+        storage_iterator pos = management().position(elem);
+        Stats::on_erase(management().erase_shifts(m_storage.begin(), storage_end(), pos));
+        set_storage_end(management().erase(m_storage.begin(), storage_end(), pos));
+    }
+
+    template<typename Elem, typename Traits, typename Storage, typename Management, typename Stats>
+    template<typename Pred>
+    CPPCBB_CONSTEXPR20 inline size_t cbb_vector_impl<Elem, Traits, Storage, Management, Stats>::erase_if(Pred pred)
+    {
+        size_t old_size = size();
+        set_storage_end(management().erase_if(m_storage.begin(), storage_end(), pred));
+        return old_size - size();
     }
 
-    template<typename Elem, typename Traits, typename Storage, typename Management>
-    inline void cbb_vector_impl<Elem, Traits, Storage, Management>::clear()
+    template<typename Elem, typename Traits, typename Storage, typename Management, typename Stats>
+    CPPCBB_CONSTEXPR20 inline void cbb_vector_impl<Elem, Traits, Storage, Management, Stats>::clear()
     {
-        m_end = begin();
+        management().clear();
+        m_storage_size = 0;
     }
 
-    template<typename Elem, typename Traits, typename Storage, typename Management>
-    inline void cbb_vector_impl<Elem, Traits, Storage, Management>::resize(size_t size)
+    template<typename Elem, typename Traits, typename Storage, typename Management, typename Stats>
+    CPPCBB_CONSTEXPR20 inline void cbb_vector_impl<Elem, Traits, Storage, Management, Stats>::resize(size_t new_size)
     {
-        CPPCBB_ASSERT(ensure_capacity(size), "Not enough storage!");
+        //Static storage stops short rather than writing past its capacity
+        bool fits = ensure_capacity(new_size);
+        CPPCBB_ASSERT(fits, "Not enough storage!");
+        if (!fits)
+        {
+            return;
+        }
 
-        if (size() >= size)
+        if (size() >= new_size)
         {
-            for (size_t current = size(); current > size; current--)
+            for (size_t current = size(); current > new_size; current--)
             {
                 pop_back();
             }
         }
         else
         {
-            for (size_t current = size(); current < size; current++)
+            for (size_t current = size(); current < new_size; current++)
             {
                 emplace_back();
             }
         }
     }
 
-    template<typename Elem, typename Traits, typename Storage, typename Management>
-    inline Elem& cbb_vector_impl<Elem, Traits, Storage, Management>::operator[](size_t idx)
+    template<typename Elem, typename Traits, typename Storage, typename Management, typename Stats>
+    template<typename Func>
+    CPPCBB_CONSTEXPR20 inline void cbb_vector_impl<Elem, Traits, Storage, Management, Stats>::for_each_segment(Func func)
+    {
+        management().for_each_segment(m_storage.begin(), storage_end(), func);
+    }
+
+    template<typename Elem, typename Traits, typename Storage, typename Management, typename Stats>
+    template<typename Func>
+    CPPCBB_CONSTEXPR20 inline void cbb_vector_impl<Elem, Traits, Storage, Management, Stats>::for_each_segment(Func func) const
+    {
+        management().for_each_segment(m_storage.begin(), storage_cend(), func);
+    }
+
+    template<typename Elem, typename Traits, typename Storage, typename Management, typename Stats>
+    CPPCBB_CONSTEXPR20 inline Elem& cbb_vector_impl<Elem, Traits, Storage, Management, Stats>::operator[](size_t idx)
     {
         CPPCBB_ASSERT((idx < size()), "Out of bounds access!");
-        return *(begin() + idx);
+        return *management().at(m_storage.begin(), storage_end(), idx);
     }
 
-    template<typename Elem, typename Traits, typename Storage, typename Management>
-    inline const Elem& cbb_vector_impl<Elem, Traits, Storage, Management>::operator[](size_t idx) const
+    template<typename Elem, typename Traits, typename Storage, typename Management, typename Stats>
+    CPPCBB_CONSTEXPR20 inline const Elem& cbb_vector_impl<Elem, Traits, Storage, Management, Stats>::operator[](size_t idx) const
     {
         CPPCBB_ASSERT((idx < size()), "Out of bounds access!");
-        return *(begin() + idx);
+        return *management().at(m_storage.begin(), storage_cend(), idx);
     }
 
 };
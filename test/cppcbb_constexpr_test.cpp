@@ -0,0 +1,144 @@
+// Copyright(C) 2020 Henry Bullingham
+// This file is subject to the license terms in the LICENSE file
+// found in the top - level directory of this distribution.
+
+#include "catch_amalgamated.hpp"
+
+#include "cppcbb/cbb_vector.hpp"
+#include "cppcbb/cbb_map.hpp"
+
+#include <algorithm>
+#include <utility>
+
+static_assert(CPPCBB_HAS_CONSTEXPR_CONTAINERS, "Constexpr tests need C++20");
+
+/*
+
+    Static vectors built in constant expressions
+
+*/
+
+constexpr cppcbb::cbb_static_vector<int, 16> MakeSquares()
+{
+    cppcbb::cbb_static_vector<int, 16> v;
+    for (int i = 0; i < 10; i++)
+    {
+        v.push_back(i * i);
+    }
+    v.erase(v.begin() + 2);
+    v.insert(v.begin(), -1);
+    v.erase_if([](int value) { return value == 9; });
+    return v;
+}
+
+constexpr cppcbb::cbb_static_unordered_vector<int, 8> MakeUnordered()
+{
+    cppcbb::cbb_static_unordered_vector<int, 8> v;
+    for (int i = 0; i < 5; i++)
+    {
+        v.emplace_back(i);
+    }
+    //The last element fills the hole
+    v.erase(v.begin() + 1);
+    v.resize(6);
+    return v;
+}
+
+constexpr cppcbb::cbb_static_vector<int, 16> k_squares = MakeSquares();
+constexpr cppcbb::cbb_static_unordered_vector<int, 8> k_unordered = MakeUnordered();
+
+static_assert(k_squares.size() == 9, "");
+static_assert(k_squares[0] == -1 && k_squares[1] == 0 && k_squares[2] == 1 && k_squares[3] == 16, "");
+static_assert(k_squares.back() == 81, "");
+static_assert(std::is_sorted(k_squares.begin(), k_squares.end()), "");
+
+static_assert(k_unordered.size() == 6, "");
+static_assert(k_unordered[0] == 0 && k_unordered[1] == 4 && k_unordered[3] == 3 && k_unordered[5] == 0, "");
+
+/*
+
+    Static maps built in constant expressions
+
+*/
+
+constexpr cppcbb::cbb_static_sorted_vector_map<int, char, 16> MakeSortedMap()
+{
+    cppcbb::cbb_static_sorted_vector_map<int, char, 16> map;
+    const int keys[] = { 42, 7, 19, 3, 88, 7 };
+    for (int key : keys)
+    {
+        map[key] = (char)('a' + key % 26);
+    }
+    map.erase(map.find(19));
+    return map;
+}
+
+//Bulk build, sorted by std::sort at compile time
+constexpr cppcbb::cbb_static_sorted_vector_map<int, int, 64> MakeBulkMap()
+{
+    cppcbb::cbb_static_sorted_vector_map<int, int, 64> map;
+    auto& elements = map.bulk_elements(50);
+    for (int i = 0; i < 50; i++)
+    {
+        elements[i] = std::make_pair((i * 37) % 50, i);
+    }
+    std::sort(elements.begin(), elements.end());
+    map.bulk_commit();
+    return map;
+}
+
+template<typename Map>
+constexpr Map MakeLinearMap()
+{
+    Map map;
+    for (int i = 0; i < 8; i++)
+    {
+        map[10 - i] = i;
+    }
+    map[5] = 100;
+    map.erase(map.find(10));
+    return map;
+}
+
+constexpr cppcbb::cbb_static_sorted_vector_map<int, char, 16> k_sorted_map = MakeSortedMap();
+constexpr cppcbb::cbb_static_sorted_vector_map<int, int, 64> k_bulk_map = MakeBulkMap();
+constexpr cppcbb::cbb_static_vector_map<int, int, 8> k_ordered_map = MakeLinearMap<cppcbb::cbb_static_vector_map<int, int, 8>>();
+constexpr cppcbb::cbb_static_unordered_vector_map<int, int, 8> k_unordered_map = MakeLinearMap<cppcbb::cbb_static_unordered_vector_map<int, int, 8>>();
+
+static_assert(k_sorted_map.size() == 4, "");
+static_assert(k_sorted_map.begin()->first == 3 && (k_sorted_map.end() - 1)->first == 88, "");
+static_assert(k_sorted_map.find(42)->second == 'a' + 42 % 26, "");
+static_assert(k_sorted_map.find(19) == k_sorted_map.end(), "");
+
+static_assert(k_bulk_map.size() == 50, "");
+static_assert(k_bulk_map.find(37)->second == 1, "");
+static_assert(k_bulk_map.find(50) == k_bulk_map.end(), "");
+
+static_assert(k_ordered_map.size() == 7, "");
+static_assert(k_ordered_map.begin()->first == 9 && k_ordered_map.find(5)->second == 100, "");
+static_assert(k_unordered_map.size() == 7, "");
+static_assert(k_unordered_map.find(10) == k_unordered_map.end() && k_unordered_map.find(3)->second == 7, "");
+
+TEST_CASE("CPPCBB Constexpr", "[CPPCBB]")
+{
+    SECTION("Compile time tables match runtime builds")
+    {
+        cppcbb::cbb_static_vector<int, 16> squares = MakeSquares();
+        REQUIRE(std::equal(squares.begin(), squares.end(), k_squares.begin(), k_squares.end()));
+
+        cppcbb::cbb_static_unordered_vector<int, 8> unordered = MakeUnordered();
+        REQUIRE(std::equal(unordered.begin(), unordered.end(), k_unordered.begin(), k_unordered.end()));
+
+        cppcbb::cbb_static_sorted_vector_map<int, int, 64> bulk = MakeBulkMap();
+        REQUIRE(std::equal(bulk.begin(), bulk.end(), k_bulk_map.begin(), k_bulk_map.end()));
+    }
+
+    SECTION("Compile time tables can be copied & changed at runtime")
+    {
+        cppcbb::cbb_static_sorted_vector_map<int, char, 16> map = k_sorted_map;
+        map[1] = 'z';
+        REQUIRE(map.size() == k_sorted_map.size() + 1);
+        REQUIRE(map.begin()->second == 'z');
+        REQUIRE(k_sorted_map.find(1) == k_sorted_map.end());
+    }
+}
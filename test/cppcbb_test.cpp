@@ -3,15 +3,49 @@
 // found in the top - level directory of this distribution.
 
 #include "catch_amalgamated.hpp"
+#include "cppcbb_test_support.hpp"
 
 #include "cppcbb/cbb_vector.hpp"
 #include "cppcbb/cbb_map.hpp"
+#include "cppcbb/cbb_slot_map.hpp"
+#include "cppcbb/cbb_sparse_set.hpp"
+#include "cppcbb/cbb_heap.hpp"
+#include "cppcbb/cbb_stats.hpp"
+#include "cppcbb/cbb_trace.hpp"
+#include "cppcbb/cbb_auto.hpp"
+#include "cppcbb/cbb_parallel.hpp"
+#include "cppcbb/cbb_serialize.hpp"
+#include "cppcbb/cbb_persistent_vector.hpp"
+#include "cppcbb/cbb_packed_vector.hpp"
+#include "cppcbb/cbb_soa_vector.hpp"
+#include "cppcbb/cbb_frozen_map.hpp"
+#include "cppcbb/cbb_deque.hpp"
+#include "cppcbb/cbb_cache_map.hpp"
+#include "cppcbb/cbb_pool.hpp"
+#include "cppcbb/cbb_simd.hpp"
+#include "cppcbb/cbb_btree_map.hpp"
+#include "cppcbb/cbb_sorted_ops.hpp"
 
 #include <algorithm>
+#include <atomic>
+#include <climits>
+#include <cstddef>
+#include <cstdio>
+#include <deque>
 
+#include <iterator>
 #include <limits>
+#include <list>
+#include <map>
+#include <memory>
+#include <numeric>
 
 #include <random>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <type_traits>
+#include <vector>
 
 /*
 
@@ -247,6 +281,238 @@ void TestVector(Vector& v)
     }
 }
 
+template<typename Vector>
+void TestInsert(Vector& v, bool keeps_order)
+{
+    for (int i = 0; i < 10; i++)
+    {
+        v.push_back(i);
+    }
+
+    auto it = v.begin();
+    std::advance(it, 5);
+    REQUIRE(*v.insert(it, 100) == 100);
+    REQUIRE(*v.insert(v.begin(), 101) == 101);
+    REQUIRE(*v.insert(v.end(), 102) == 102);
+
+    REQUIRE(v.size() == 13);
+
+    std::vector<int> expected = { 101, 0, 1, 2, 3, 4, 100, 5, 6, 7, 8, 9, 102 };
+    if (keeps_order)
+    {
+        REQUIRE(std::equal(v.begin(), v.end(), expected.begin()));
+    }
+    else
+    {
+        REQUIRE(std::is_permutation(v.begin(), v.end(), expected.begin()));
+    }
+}
+
+template<typename Vector>
+void TestSegments(Vector& v)
+{
+    std::vector<int> seen;
+    v.for_each_segment([&](const int* first, const int* last) { seen.insert(seen.end(), first, last); });
+
+    REQUIRE(seen.size() == v.size());
+    REQUIRE(std::equal(v.begin(), v.end(), seen.begin()));
+}
+
+template<typename Vector>
+void TestGapVector(Vector& v)
+{
+    SECTION("Insert & erase near cursor")
+    {
+        std::vector<int> expected;
+        std::uniform_int_distribution<int> step_dist(-3, 3);
+        std::uniform_int_distribution<int> op_dist(0, 3);
+
+        int cursor = 0;
+        for (int i = 0; i < k_test_max_size * 2; i++)
+        {
+            cursor = std::max(0, std::min((int)expected.size(), cursor + step_dist(GetRandom())));
+
+            if (op_dist(GetRandom()) == 0 && cursor < (int)expected.size())
+            {
+                v.erase(v.begin() + cursor);
+                expected.erase(expected.begin() + cursor);
+            }
+            else if (expected.size() + 1 < (size_t)k_test_max_size)
+            {
+                //One slot is left for the push_back below, static vectors can't grow past k_test_max_size
+                REQUIRE(*v.insert(v.begin() + cursor, i) == i);
+                expected.insert(expected.begin() + cursor, i);
+            }
+
+            REQUIRE(v.size() == expected.size());
+        }
+
+        REQUIRE(std::equal(v.begin(), v.end(), expected.begin()));
+        for (size_t i = 0; i < expected.size(); i++)
+        {
+            REQUIRE(v[i] == expected[i]);
+        }
+
+        TestSegments(v);
+
+        v.push_back(-1);
+        REQUIRE(v.back() == -1);
+        REQUIRE(v[v.size() - 1] == -1);
+    }
+
+    SECTION("Iterator arithmetic crosses the gap")
+    {
+        for (int i = 0; i < 50; i++)
+        {
+            v.push_back(i);
+        }
+        v.insert(v.begin() + 20, -1);
+
+        REQUIRE(*(v.begin() + 30) == 29);
+        REQUIRE((v.end() - v.begin()) == 51);
+        REQUIRE(*(v.end() - 1) == 49);
+
+        auto it = v.begin() + 21;
+        --it;
+        REQUIRE(*it == -1);
+        --it;
+        REQUIRE(*it == 19);
+    }
+}
+
+template<typename Vector>
+void TestEraseIf(Vector& v)
+{
+    for (int i = 0; i < k_test_max_size; i++)
+    {
+        v.push_back(i);
+    }
+
+    REQUIRE(v.erase_if([](int x) { return x % 3 == 0; }) == (size_t)(k_test_max_size + 2) / 3);
+    REQUIRE(v.size() == (size_t)(k_test_max_size - (k_test_max_size + 2) / 3));
+
+    for (int i = 0; i < k_test_max_size; i++)
+    {
+        bool found = std::find(v.begin(), v.end(), i) != v.end();
+        REQUIRE(found == (i % 3 != 0));
+    }
+
+    REQUIRE(v.erase_if([](int) { return false; }) == 0);
+    REQUIRE(v.erase_if([](int) { return true; }) == (size_t)(k_test_max_size - (k_test_max_size + 2) / 3));
+    REQUIRE(v.size() == 0);
+}
+
+template<typename Vector>
+void TestOrderedEraseIf(Vector& v)
+{
+    for (int i = 0; i < k_test_max_size; i++)
+    {
+        v.push_back(i);
+    }
+
+    v.erase_if([](int x) { return x % 2 == 1; });
+    REQUIRE(std::is_sorted(v.begin(), v.end()));
+}
+
+template<typename Vector>
+void TestTombstoneVector(Vector& v)
+{
+    SECTION("Erase keeps order")
+    {
+        for (int i = 0; i < 10; i++)
+        {
+            v.push_back(i);
+        }
+
+        v.erase(std::find(v.begin(), v.end(), 3));
+        v.erase(std::find(v.begin(), v.end(), 7));
+
+        std::vector<int> expected = { 0, 1, 2, 4, 5, 6, 8, 9 };
+        REQUIRE(v.size() == expected.size());
+        REQUIRE(std::equal(v.begin(), v.end(), expected.begin()));
+
+        for (size_t i = 0; i < expected.size(); i++)
+        {
+            REQUIRE(v[i] == expected[i]);
+        }
+    }
+
+    SECTION("Pop back skips tombstones")
+    {
+        for (int i = 0; i < 10; i++)
+        {
+            v.push_back(i);
+        }
+
+        v.erase(std::find(v.begin(), v.end(), 8));
+        REQUIRE(v.back() == 9);
+
+        v.pop_back();
+        REQUIRE(v.back() == 7);
+        REQUIRE(v.size() == 8);
+
+        v.push_back(10);
+        REQUIRE(v.back() == 10);
+        REQUIRE(v.size() == 9);
+    }
+
+    SECTION("Random insertions and deletions")
+    {
+        std::uniform_int_distribution<int> dist{ INT_MIN, INT_MAX };
+        std::vector<int> expected;
+
+        for (int j = 0; j < 10; j++)
+        {
+            while (expected.size() < (size_t)k_test_max_size)
+            {
+                int x = dist(GetRandom());
+                v.push_back(x);
+                expected.push_back(x);
+            }
+
+            while (expected.size() > (size_t)k_test_max_size / 4)
+            {
+                std::uniform_int_distribution<int> index_dist(0, (int)expected.size() - 1);
+                size_t index = index_dist(GetRandom());
+
+                auto it = v.begin();
+                std::advance(it, index);
+                v.erase(it);
+                expected.erase(expected.begin() + index);
+
+                REQUIRE(v.size() == expected.size());
+            }
+
+            REQUIRE(std::equal(v.begin(), v.end(), expected.begin()));
+            REQUIRE(v[expected.size() / 2] == expected[expected.size() / 2]);
+        }
+    }
+
+    SECTION("Erase If")
+    {
+        TestEraseIf(v);
+    }
+
+    SECTION("Erase If keeps order")
+    {
+        TestOrderedEraseIf(v);
+    }
+
+    SECTION("Insert")
+    {
+        TestInsert(v, true);
+        v.erase(std::find(v.begin(), v.end(), 3));
+        v.erase(std::find(v.begin(), v.end(), 7));
+
+        auto it = std::find(v.begin(), v.end(), 8);
+        v.insert(it, 200);
+
+        std::vector<int> expected = { 101, 0, 1, 2, 4, 100, 5, 6, 200, 8, 9, 102 };
+        REQUIRE(std::equal(v.begin(), v.end(), expected.begin()));
+        TestSegments(v);
+    }
+}
+
 TEST_CASE("CPPCBB Vector", "[CPPCBB]")
 {
     SECTION("Dynamic, Ordered")
@@ -272,6 +538,160 @@ TEST_CASE("CPPCBB Vector", "[CPPCBB]")
         cppcbb::cbb_static_unordered_vector<int, k_test_max_size> vec;
         TestVector(vec);
     }
+
+    SECTION("Stateless management takes no space")
+    {
+        using Vector = cppcbb::cbb_vector<int>;
+        using StaticVector = cppcbb::cbb_static_unordered_vector<int, 4>;
+        REQUIRE(sizeof(Vector) == sizeof(Vector::storage_type) + sizeof(size_t));
+        REQUIRE(sizeof(StaticVector) == sizeof(StaticVector::storage_type) + sizeof(size_t));
+    }
+}
+
+TEST_CASE("CPPCBB Vector Erase If", "[CPPCBB]")
+{
+    SECTION("Dynamic, Ordered")
+    {
+        cppcbb::cbb_vector<int> vec;
+        TestEraseIf(vec);
+        TestOrderedEraseIf(vec);
+    }
+
+    SECTION("Dynamic, Unordered")
+    {
+        cppcbb::cbb_unordered_vector<int> vec;
+        TestEraseIf(vec);
+    }
+
+    SECTION("Static, Ordered")
+    {
+        cppcbb::cbb_static_vector<int, k_test_max_size> vec;
+        TestEraseIf(vec);
+        TestOrderedEraseIf(vec);
+    }
+
+    SECTION("Static, Unordered")
+    {
+        cppcbb::cbb_static_unordered_vector<int, k_test_max_size> vec;
+        TestEraseIf(vec);
+    }
+}
+
+TEST_CASE("CPPCBB Vector Insert", "[CPPCBB]")
+{
+    SECTION("Dynamic, Ordered")
+    {
+        cppcbb::cbb_vector<int> vec;
+        TestInsert(vec, true);
+    }
+
+    SECTION("Dynamic, Unordered")
+    {
+        cppcbb::cbb_unordered_vector<int> vec;
+        TestInsert(vec, false);
+    }
+
+    SECTION("Static, Ordered")
+    {
+        cppcbb::cbb_static_vector<int, k_test_max_size> vec;
+        TestInsert(vec, true);
+    }
+
+    SECTION("Static, Unordered")
+    {
+        cppcbb::cbb_static_unordered_vector<int, k_test_max_size> vec;
+        TestInsert(vec, false);
+    }
+}
+
+TEST_CASE("CPPCBB Gap Vector", "[CPPCBB]")
+{
+    SECTION("Dynamic")
+    {
+        cppcbb::cbb_gap_vector<int> vec;
+        TestVector(vec);
+    }
+
+    SECTION("Static")
+    {
+        cppcbb::cbb_static_gap_vector<int, k_test_max_size> vec;
+        TestVector(vec);
+    }
+
+    SECTION("Dynamic, Gap Buffer")
+    {
+        cppcbb::cbb_gap_vector<int> vec;
+        TestGapVector(vec);
+    }
+
+    SECTION("Static, Gap Buffer")
+    {
+        cppcbb::cbb_static_gap_vector<int, k_test_max_size> vec;
+        TestGapVector(vec);
+    }
+
+    SECTION("Dynamic, Insert")
+    {
+        cppcbb::cbb_gap_vector<int> vec;
+        TestInsert(vec, true);
+        TestSegments(vec);
+    }
+
+    SECTION("Static, Erase If")
+    {
+        cppcbb::cbb_static_gap_vector<int, k_test_max_size> vec;
+        TestEraseIf(vec);
+    }
+}
+
+TEST_CASE("CPPCBB Tombstone Vector", "[CPPCBB]")
+{
+    SECTION("Dynamic")
+    {
+        cppcbb::cbb_tombstone_vector<int> vec;
+        TestTombstoneVector(vec);
+    }
+
+    SECTION("Static")
+    {
+        cppcbb::cbb_static_tombstone_vector<int, k_test_max_size> vec;
+        TestTombstoneVector(vec);
+    }
+
+    SECTION("Insert into full storage reuses tombstones")
+    {
+        cppcbb::cbb_static_tombstone_vector<int, 8> vec;
+        for (int i = 0; i < 8; i++)
+        {
+            vec.push_back(i);
+        }
+
+        //Below the compaction ratio, so the storage stays full of tombstones
+        vec.erase(std::find(vec.begin(), vec.end(), 1));
+        vec.erase(std::find(vec.begin(), vec.end(), 3));
+        REQUIRE(vec.size() == 6);
+
+        REQUIRE(*vec.insert(std::next(vec.begin(), 1), 42) == 42);
+        std::vector<int> expected = { 0, 42, 2, 4, 5, 6, 7 };
+        REQUIRE(vec.size() == expected.size());
+        REQUIRE(std::equal(vec.begin(), vec.end(), expected.begin()));
+    }
+
+    SECTION("Insert into full storage doesn't grow")
+    {
+        cppcbb::cbb_tombstone_vector<int> vec;
+        while (vec.size() == 0 || vec.size() < vec.capacity())
+        {
+            vec.push_back((int)vec.size());
+        }
+        size_t capacity = vec.capacity();
+
+        vec.erase(std::find(vec.begin(), vec.end(), 0));
+        REQUIRE(*vec.insert(vec.end(), -1) == -1);
+        REQUIRE(vec.capacity() == capacity);
+        REQUIRE(vec.back() == -1);
+        REQUIRE(*vec.begin() == 1);
+    }
 }
 
 template<typename Map>
@@ -411,4 +831,3521 @@ TEST_CASE("CPPCBB Map", "[CPPCBB]")
         cppcbb::cbb_static_sorted_vector_map<int, int, k_test_max_size> map;
         TestMap(map);
     }
-}
\ No newline at end of file
+}
+
+template<typename SlotMap>
+void TestSlotMap(SlotMap& map)
+{
+    using handle = typename SlotMap::handle;
+
+    SECTION("Insert")
+    {
+        handle a = map.insert(5);
+        handle b = map.insert(-1);
+        handle c = map.emplace(3);
+
+        REQUIRE(map.size() == 3);
+
+        REQUIRE(map.contains(a));
+        REQUIRE(map.contains(b));
+        REQUIRE(map.contains(c));
+
+        REQUIRE(map[a] == 5);
+        REQUIRE(map[b] == -1);
+        REQUIRE(map[c] == 3);
+
+        REQUIRE(!map.contains(handle()));
+    }
+
+    SECTION("Erase")
+    {
+        handle a = map.insert(5);
+        handle b = map.insert(-1);
+        handle c = map.insert(3);
+
+        REQUIRE(map.erase(a));
+        REQUIRE(!map.erase(a));
+
+        REQUIRE(map.size() == 2);
+        REQUIRE(!map.contains(a));
+        REQUIRE(map.find(a) == nullptr);
+
+        REQUIRE(map[b] == -1);
+        REQUIRE(map[c] == 3);
+
+        //Reused slot must not revive the stale handle
+        handle d = map.insert(7);
+        REQUIRE(d.index == a.index);
+        REQUIRE(!map.contains(a));
+        REQUIRE(map[d] == 7);
+    }
+
+    SECTION("Iteration")
+    {
+        for (int i = 0; i < k_test_max_size; i++)
+        {
+            map.insert(i);
+        }
+
+        for (auto it = map.cbegin(); it != map.cend(); ++it)
+        {
+            REQUIRE(map[map.handle_of(it)] == *it);
+        }
+    }
+
+    SECTION("Clear")
+    {
+        handle a = map.insert(5);
+        map.clear();
+
+        REQUIRE(map.size() == 0);
+        REQUIRE(!map.contains(a));
+
+        handle b = map.insert(6);
+        REQUIRE(!map.contains(a));
+        REQUIRE(map[b] == 6);
+    }
+
+    SECTION("Random insertions and deletions")
+    {
+        std::uniform_int_distribution<int> dist{ INT_MIN, INT_MAX };
+
+        const int num_runs = 10;
+        const int num_values = k_test_max_size;
+
+        for (int j = 0; j < num_runs; j++)
+        {
+            cppcbb::cbb_vector<std::pair<handle, int>> handles;
+
+            for (int i = 0; i < num_values; i++)
+            {
+                int x = dist(GetRandom());
+                handles.push_back(std::make_pair(map.insert(x), x));
+            }
+
+            std::random_shuffle(handles.begin(), handles.end());
+
+            while (handles.size() > 0)
+            {
+                std::pair<handle, int> entry = handles.back();
+                handles.pop_back();
+
+                REQUIRE(map[entry.first] == entry.second);
+                REQUIRE(map.erase(entry.first));
+                REQUIRE(!map.contains(entry.first));
+
+                for (const std::pair<handle, int>& other : handles)
+                {
+                    REQUIRE(map[other.first] == other.second);
+                }
+            }
+        }
+    }
+}
+
+TEST_CASE("CPPCBB Slot Map", "[CPPCBB]")
+{
+    SECTION("Dynamic")
+    {
+        cppcbb::cbb_slot_map<int> map;
+        TestSlotMap(map);
+    }
+
+    SECTION("Static")
+    {
+        cppcbb::cbb_static_slot_map<int, k_test_max_size> map;
+        TestSlotMap(map);
+    }
+}
+
+template<typename Set>
+void TestSparseSet(Set& set)
+{
+    SECTION("Insert")
+    {
+        REQUIRE(set.insert(5));
+        REQUIRE(set.insert(0));
+        REQUIRE(set.insert(3));
+        REQUIRE(!set.insert(3));
+
+        REQUIRE(set.size() == 3);
+
+        REQUIRE(set.contains(5));
+        REQUIRE(set.contains(0));
+        REQUIRE(set.contains(3));
+
+        REQUIRE(!set.contains(1));
+        REQUIRE(!set.contains(k_test_max_size - 1));
+        REQUIRE(set.find(1) == set.end());
+        REQUIRE(*set.find(5) == 5);
+    }
+
+    SECTION("Erase")
+    {
+        set.insert(5);
+        set.insert(0);
+        set.insert(3);
+
+        REQUIRE(set.erase(0));
+        REQUIRE(!set.erase(0));
+        REQUIRE(set.erase(3));
+
+        REQUIRE(set.size() == 1);
+        REQUIRE(!set.contains(0));
+        REQUIRE(!set.contains(3));
+        REQUIRE(set.contains(5));
+    }
+
+    SECTION("Copying")
+    {
+        set.insert(5);
+        set.insert(0);
+
+        Set set2 = set;
+        set.erase(5);
+
+        REQUIRE(set2.contains(5));
+        REQUIRE(set2.contains(0));
+        REQUIRE(!set.contains(5));
+    }
+
+    SECTION("Random insertions and deletions")
+    {
+        const int num_runs = 10;
+
+        for (int j = 0; j < num_runs; j++)
+        {
+            cppcbb::cbb_vector<int> keys;
+            for (int i = 0; i < k_test_max_size; i++)
+            {
+                keys.push_back(i);
+            }
+            std::random_shuffle(keys.begin(), keys.end());
+
+            for (int key : keys)
+            {
+                REQUIRE(set.insert(key));
+            }
+            REQUIRE(set.size() == (size_t)k_test_max_size);
+
+            std::random_shuffle(keys.begin(), keys.end());
+
+            while (keys.size() > 0)
+            {
+                int key = keys.back();
+                keys.pop_back();
+
+                REQUIRE(set.erase(key));
+                REQUIRE(!set.contains(key));
+                REQUIRE(set.size() == keys.size());
+            }
+        }
+    }
+}
+
+template<typename Map>
+void TestSparseMap(Map& map)
+{
+    SECTION("Insert & Erase")
+    {
+        map[1] = 5;
+        map[2] = 7;
+        map[0] = 3;
+        map[6] = -32;
+
+        REQUIRE(map.size() == 4);
+        REQUIRE(map[1] == 5);
+        REQUIRE(map[2] == 7);
+        REQUIRE(map[0] == 3);
+        REQUIRE(map[6] == -32);
+        REQUIRE(map.find(4) == map.end());
+
+        map.erase(map.find(1));
+        map.erase(map.find(6));
+
+        REQUIRE(map.find(1) == map.end());
+        REQUIRE(map.find(6) == map.end());
+        REQUIRE(map[2] == 7);
+        REQUIRE(map[0] == 3);
+    }
+
+    SECTION("Random insertions and deletions")
+    {
+        std::uniform_int_distribution<int> key_dist(0, k_test_max_size - 1);
+        std::uniform_int_distribution<int> value_dist(INT_MIN, INT_MAX);
+
+        for (int i = 0; i < k_test_max_size; i++)
+        {
+            map[key_dist(GetRandom())] = value_dist(GetRandom());
+        }
+
+        for (auto it = map.begin(); it != map.end(); ++it)
+        {
+            REQUIRE(map.find(it->first) == it);
+        }
+
+        while (map.size() > 0)
+        {
+            int key = (map.begin() + map.size() / 2)->first;
+            map.erase(map.find(key));
+            REQUIRE(map.find(key) == map.end());
+        }
+    }
+}
+
+TEST_CASE("CPPCBB Sparse Set", "[CPPCBB]")
+{
+    SECTION("Paged")
+    {
+        cppcbb::cbb_sparse_set<int> set;
+        TestSparseSet(set);
+    }
+
+    SECTION("Static")
+    {
+        cppcbb::cbb_static_sparse_set<int, k_test_max_size> set;
+        TestSparseSet(set);
+    }
+
+    SECTION("Pages allocated on demand")
+    {
+        cppcbb::paged_sparse_storage<> storage;
+        REQUIRE(storage.allocated_pages() == 0);
+
+        storage.set(1000000, 4);
+        REQUIRE(storage.allocated_pages() == 1);
+        REQUIRE(storage.get(1000000) == 4);
+        REQUIRE(storage.get(0) == cppcbb::paged_sparse_storage<>::k_invalid_index);
+
+        storage.clear();
+        REQUIRE(storage.allocated_pages() == 0);
+    }
+
+    SECTION("Static keys past MaxKey are rejected")
+    {
+        cppcbb::static_sparse_storage<16> storage;
+        REQUIRE(!storage.set(16, 0));
+        REQUIRE(storage.get(16) == cppcbb::static_sparse_storage<16>::k_invalid_index);
+
+        cppcbb::cbb_static_sparse_set<int, 16> set;
+        REQUIRE(set.insert(15));
+        REQUIRE(!set.insert(16));
+        REQUIRE(!set.insert(1000000));
+        REQUIRE(set.size() == 1);
+        REQUIRE(!set.contains(16));
+    }
+}
+
+TEST_CASE("CPPCBB Sparse Map", "[CPPCBB]")
+{
+    SECTION("Paged")
+    {
+        cppcbb::cbb_sparse_map<int, int> map;
+        TestSparseMap(map);
+    }
+
+    SECTION("Static")
+    {
+        cppcbb::cbb_static_sparse_map<int, int, k_test_max_size> map;
+        TestSparseMap(map);
+    }
+}
+
+template<typename Queue>
+void TestPriorityQueue(Queue& queue)
+{
+    SECTION("Push & Pop")
+    {
+        queue.push(5);
+        queue.push(-1);
+        queue.emplace(7);
+        queue.push(3);
+
+        REQUIRE(queue.size() == 4);
+        REQUIRE(queue.top() == 7);
+        queue.pop_top();
+        REQUIRE(queue.top() == 5);
+        queue.pop_top();
+        REQUIRE(queue.top() == 3);
+        queue.pop_top();
+        REQUIRE(queue.top() == -1);
+        queue.pop_top();
+        REQUIRE(queue.empty());
+    }
+
+    SECTION("Random pushes and pops")
+    {
+        std::uniform_int_distribution<int> dist{ INT_MIN, INT_MAX };
+        std::vector<int> expected;
+
+        for (int j = 0; j < 10; j++)
+        {
+            while (expected.size() < (size_t)k_test_max_size)
+            {
+                int x = dist(GetRandom());
+                queue.push(x);
+                expected.push_back(x);
+            }
+            std::sort(expected.begin(), expected.end());
+
+            while (expected.size() > (size_t)k_test_max_size / 2)
+            {
+                REQUIRE(queue.top() == expected.back());
+                queue.pop_top();
+                expected.pop_back();
+            }
+            REQUIRE(queue.size() == expected.size());
+        }
+    }
+
+    SECTION("Erase If")
+    {
+        for (int i = 0; i < k_test_max_size; i++)
+        {
+            queue.push(i);
+        }
+
+        queue.erase_if([](int x) { return x % 2 == 1; });
+
+        for (int i = k_test_max_size - 1; i >= 0; i--)
+        {
+            if (i % 2 == 0)
+            {
+                REQUIRE(queue.top() == i);
+                queue.pop_top();
+            }
+        }
+        REQUIRE(queue.empty());
+    }
+}
+
+template<typename Heap>
+void TestIndexedHeap(Heap& heap)
+{
+    SECTION("Push & Pop")
+    {
+        heap.push(3, 5.0f);
+        heap.push(0, 1.0f);
+        heap.push(7, 3.0f);
+
+        REQUIRE(heap.contains(3));
+        REQUIRE(!heap.contains(1));
+        REQUIRE(heap.priority(7) == 3.0f);
+
+        REQUIRE(heap.top().id == 0);
+        heap.pop_top();
+        REQUIRE(heap.top().id == 7);
+        heap.pop_top();
+        REQUIRE(heap.top().id == 3);
+        heap.pop_top();
+        REQUIRE(heap.empty());
+        REQUIRE(!heap.contains(3));
+    }
+
+    SECTION("Decrease Key")
+    {
+        heap.push(1, 10.0f);
+        heap.push(2, 20.0f);
+        heap.push(3, 30.0f);
+
+        heap.decrease_key(3, 5.0f);
+        REQUIRE(heap.top().id == 3);
+        REQUIRE(heap.priority(3) == 5.0f);
+
+        heap.update(3, 25.0f);
+        REQUIRE(heap.top().id == 1);
+
+        REQUIRE(heap.erase(1));
+        REQUIRE(!heap.erase(1));
+        REQUIRE(heap.top().id == 2);
+    }
+
+    SECTION("Random updates")
+    {
+        std::uniform_real_distribution<float> dist(0.0f, 1000.0f);
+        std::vector<float> expected(k_test_max_size);
+
+        for (uint32_t id = 0; id < (uint32_t)k_test_max_size; id++)
+        {
+            expected[id] = dist(GetRandom());
+            heap.push(id, expected[id]);
+        }
+
+        for (int i = 0; i < k_test_max_size; i++)
+        {
+            uint32_t id = (uint32_t)(GetRandom()() % k_test_max_size);
+            expected[id] = dist(GetRandom());
+            heap.update(id, expected[id]);
+        }
+
+        float last = -1.0f;
+        while (!heap.empty())
+        {
+            REQUIRE(heap.top().priority >= last);
+            REQUIRE(heap.top().priority == expected[heap.top().id]);
+            last = heap.top().priority;
+            heap.pop_top();
+        }
+    }
+}
+
+TEST_CASE("CPPCBB Priority Queue", "[CPPCBB]")
+{
+    SECTION("Dynamic, Binary")
+    {
+        cppcbb::cbb_priority_queue<int> queue;
+        TestPriorityQueue(queue);
+    }
+
+    SECTION("Static, Binary")
+    {
+        cppcbb::cbb_static_priority_queue<int, k_test_max_size> queue;
+        TestPriorityQueue(queue);
+    }
+
+    SECTION("Dynamic, Quad")
+    {
+        cppcbb::cbb_quad_priority_queue<int> queue;
+        TestPriorityQueue(queue);
+    }
+
+    SECTION("Static, Quad")
+    {
+        cppcbb::cbb_static_quad_priority_queue<int, k_test_max_size> queue;
+        TestPriorityQueue(queue);
+    }
+
+    SECTION("Min heap")
+    {
+        cppcbb::cbb_quad_priority_queue<int, std::greater<int>> queue;
+        queue.push(5);
+        queue.push(-1);
+        queue.push(7);
+        REQUIRE(queue.top() == -1);
+    }
+}
+
+TEST_CASE("CPPCBB Indexed Heap", "[CPPCBB]")
+{
+    SECTION("Dynamic")
+    {
+        cppcbb::cbb_indexed_heap<float> heap;
+        TestIndexedHeap(heap);
+    }
+
+    SECTION("Static")
+    {
+        cppcbb::cbb_static_indexed_heap<float, k_test_max_size> heap;
+        TestIndexedHeap(heap);
+    }
+}
+
+/*
+
+    Each test uses its own tag, so counters don't leak between tests
+
+*/
+
+class vector_stats_tag { public: static const char* name() { return "test vector"; } };
+class static_vector_stats_tag { public: static const char* name() { return "test static vector"; } };
+class sorted_map_stats_tag { public: static const char* name() { return "test sorted map"; } };
+class unordered_map_stats_tag { public: static const char* name() { return "test unordered map"; } };
+class sparse_map_stats_tag { public: static const char* name() { return "test sparse map"; } };
+
+static_assert(std::is_same<cppcbb::cbb_with_stats<cppcbb::cbb_vector<int>, cppcbb::no_stats>, cppcbb::cbb_vector<int>>::value
+    , "Rebinding to no_stats gives back the default alias");
+
+template<typename Container>
+void TestVectorStats(Container& v, const cppcbb::container_stats& stats, bool allocates)
+{
+    for (int i = 0; i < k_test_max_size; i++)
+    {
+        v.push_back(i);
+    }
+    if (allocates)
+    {
+        REQUIRE(stats.allocations.load() > 0);
+        REQUIRE(stats.bytes_allocated.load() >= k_test_max_size * sizeof(int));
+        //Every growth moves the elements stored so far
+        REQUIRE(stats.moves.load() > 0);
+    }
+    else
+    {
+        REQUIRE(stats.allocations.load() == 0);
+        REQUIRE(stats.moves.load() == 0);
+    }
+    REQUIRE(stats.finds.load() == 0);
+
+    //Erasing the front of an ordered vector shifts everything after it
+    v.erase(v.begin());
+    REQUIRE(stats.erases.load() == 1);
+    REQUIRE(stats.erase_shifts.load() == k_test_max_size - 1);
+
+    //Erasing the back shifts nothing
+    v.erase(v.end() - 1);
+    REQUIRE(stats.erases.load() == 2);
+    REQUIRE(stats.erase_shifts.load() == k_test_max_size - 1);
+
+    //Elements are moved one at a time, the storage is never stolen
+    uint64_t moves = stats.moves.load();
+    Container moved(std::move(v));
+    REQUIRE(stats.moves.load() >= moves + (k_test_max_size - 2));
+}
+
+template<typename Map>
+void TestMapStats(Map& map, cppcbb::container_stats& stats, bool sorted)
+{
+    for (int i = 0; i < k_test_max_size; i++)
+    {
+        map[i * 2] = i;
+    }
+    //operator[] looks the key up first, every one was new
+    REQUIRE(stats.finds.load() == k_test_max_size);
+    REQUIRE(stats.misses.load() == k_test_max_size);
+    REQUIRE(stats.hits.load() == 0);
+
+    //The underlying vector counts under the same tag
+    REQUIRE(stats.allocations.load() > 0);
+
+    stats.reset();
+
+    for (int i = 0; i < k_test_max_size; i++)
+    {
+        REQUIRE(map.find(i * 2) != map.end());
+        REQUIRE(map.find(i * 2 + 1) == map.end());
+    }
+    REQUIRE(stats.finds.load() == 2 * k_test_max_size);
+    REQUIRE(stats.hits.load() == k_test_max_size);
+    REQUIRE(stats.misses.load() == k_test_max_size);
+    REQUIRE(stats.probes.load() >= 2 * k_test_max_size);
+
+    if (sorted)
+    {
+        //A binary search needs about log2(n) + 1 compares
+        REQUIRE(stats.probes.load() <= 2 * k_test_max_size * 11);
+    }
+
+    map.erase(map.find(0));
+    REQUIRE(stats.erases.load() == 1);
+}
+
+TEST_CASE("CPPCBB Stats", "[CPPCBB]")
+{
+    SECTION("Vector, Dynamic")
+    {
+        using Vector = cppcbb::cbb_with_stats<cppcbb::cbb_vector<int>, cppcbb::counting_stats<vector_stats_tag>>;
+        Vector v;
+        TestVectorStats(v, cppcbb::counting_stats<vector_stats_tag>::stats(), true);
+    }
+
+    SECTION("Vector, Static")
+    {
+        using Vector = cppcbb::cbb_with_stats<cppcbb::cbb_static_vector<int, k_test_max_size>, cppcbb::counting_stats<static_vector_stats_tag>>;
+        std::unique_ptr<Vector> v(new Vector());
+        TestVectorStats(*v, cppcbb::counting_stats<static_vector_stats_tag>::stats(), false);
+        REQUIRE(cppcbb::counting_stats<static_vector_stats_tag>::stats().allocations.load() == 0);
+    }
+
+    SECTION("Map, Sorted")
+    {
+        using Map = cppcbb::cbb_with_stats<cppcbb::cbb_sorted_vector_map<int, int>, cppcbb::counting_stats<sorted_map_stats_tag>>;
+        Map map;
+        TestMapStats(map, cppcbb::counting_stats<sorted_map_stats_tag>::stats(), true);
+        REQUIRE(cppcbb::counting_stats<sorted_map_stats_tag>::stats().erase_shifts.load() == k_test_max_size - 1);
+    }
+
+    SECTION("Map, Unordered")
+    {
+        using Map = cppcbb::cbb_with_stats<cppcbb::cbb_unordered_vector_map<int, int>, cppcbb::counting_stats<unordered_map_stats_tag>>;
+        Map map;
+        TestMapStats(map, cppcbb::counting_stats<unordered_map_stats_tag>::stats(), false);
+        REQUIRE(cppcbb::counting_stats<unordered_map_stats_tag>::stats().erase_shifts.load() == 1);
+    }
+
+    SECTION("Map, Sparse")
+    {
+        using Map = cppcbb::cbb_with_stats<cppcbb::cbb_sparse_map<int, int>, cppcbb::counting_stats<sparse_map_stats_tag>>;
+        Map map;
+        TestMapStats(map, cppcbb::counting_stats<sparse_map_stats_tag>::stats(), false);
+        //One probe per find, including the one for the erase
+        REQUIRE(cppcbb::counting_stats<sparse_map_stats_tag>::stats().probes.load() == 2 * k_test_max_size + 1);
+        REQUIRE(cppcbb::counting_stats<sparse_map_stats_tag>::stats().erases.load() == 1);
+    }
+
+    SECTION("Registry")
+    {
+        cppcbb::counting_stats<vector_stats_tag>::stats();
+        std::vector<cppcbb::container_stats*> entries = cppcbb::stats_registry::instance().entries();
+        REQUIRE(std::any_of(entries.begin(), entries.end(), [](const cppcbb::container_stats* entry) { return std::string(entry->name()) == "test vector"; }));
+
+        cppcbb::stats_registry::instance().reset();
+        for (const cppcbb::container_stats* entry : entries)
+        {
+            REQUIRE(entry->finds.load() == 0);
+            REQUIRE(entry->allocations.load() == 0);
+        }
+    }
+}
+
+/*
+
+    Static containers must never touch the heap
+
+*/
+
+using cppcbb_test::AllocatesNothing;
+using cppcbb_test::PercentileBelow;
+
+//Generous, only catches something pathological like an allocation or a full copy per push
+static constexpr uint64_t k_push_p999_bound_ns = 50000;
+static constexpr size_t k_latency_samples = 20000;
+
+template<typename Vector>
+void TestStaticVectorAllocations(Vector& v)
+{
+    REQUIRE_THAT([&]()
+    {
+        for (int i = 0; i < k_test_max_size / 2; i++)
+        {
+            v.push_back(i);
+        }
+        for (int i = 0; i < 10; i++)
+        {
+            v.insert(v.begin(), i);
+        }
+        for (int i = 0; i < 10; i++)
+        {
+            v.erase(v.begin());
+        }
+        v.erase_if([](int x) { return (x % 3) == 0; });
+        v.pop_back();
+        Vector copy = v;
+        v.clear();
+        v = std::move(copy);
+    }, AllocatesNothing());
+    REQUIRE(v.size() > 0);
+
+    v.clear();
+    cppcbb_test::latency_histogram histogram;
+    int next = 0;
+    cppcbb_test::record_latency(histogram, k_latency_samples, [&]()
+    {
+        if (v.size() == (size_t)k_test_max_size)
+        {
+            v.clear();
+        }
+        v.push_back(next++);
+    });
+    REQUIRE(histogram.count() == k_latency_samples);
+    REQUIRE_THAT(histogram, PercentileBelow(99.9, k_push_p999_bound_ns));
+}
+
+template<typename Map>
+void TestStaticMapAllocations(Map& map)
+{
+    REQUIRE_THAT([&]()
+    {
+        for (int i = 0; i < k_test_max_size; i++)
+        {
+            map[i] = i;
+        }
+        for (int i = 0; i < k_test_max_size; i += 2)
+        {
+            map.erase(map.find(i));
+        }
+        for (int i = 0; i < k_test_max_size; i++)
+        {
+            map[i] += 1;
+        }
+        map.clear();
+    }, AllocatesNothing());
+}
+
+template<typename Queue>
+void TestStaticQueueAllocations(Queue& queue)
+{
+    REQUIRE_THAT([&]()
+    {
+        for (int i = 0; i < k_test_max_size; i++)
+        {
+            queue.push((i * 7919) % k_test_max_size);
+        }
+        queue.erase_if([](int x) { return (x % 3) == 0; });
+        while (!queue.empty())
+        {
+            queue.pop_top();
+        }
+    }, AllocatesNothing());
+
+    cppcbb_test::latency_histogram histogram;
+    int next = 0;
+    cppcbb_test::record_latency(histogram, k_latency_samples, [&]()
+    {
+        if (queue.size() == (size_t)k_test_max_size)
+        {
+            queue.clear();
+        }
+        queue.push(next++);
+    });
+    REQUIRE_THAT(histogram, PercentileBelow(99.9, k_push_p999_bound_ns));
+}
+
+TEST_CASE("CPPCBB Latency Histogram", "[CPPCBB]")
+{
+    cppcbb_test::latency_histogram histogram;
+    for (uint64_t i = 1; i <= 1000; i++)
+    {
+        histogram.record(i);
+    }
+
+    REQUIRE(histogram.count() == 1000);
+    REQUIRE(histogram.min() == 1);
+    REQUIRE(histogram.max() == 1000);
+    REQUIRE(histogram.mean() == Approx(500.5));
+
+    //Exact below 128
+    REQUIRE(histogram.value_at_percentile(10.0) == 100);
+
+    //Within bucket precision above
+    REQUIRE(histogram.value_at_percentile(50.0) >= 500);
+    REQUIRE(histogram.value_at_percentile(50.0) <= 508);
+    REQUIRE(histogram.value_at_percentile(99.9) >= 999);
+    REQUIRE(histogram.value_at_percentile(100.0) == 1000);
+
+    histogram.record(UINT64_MAX);
+    REQUIRE(histogram.value_at_percentile(100.0) == UINT64_MAX);
+
+    REQUIRE_THAT(histogram, !PercentileBelow(100.0, 1000));
+
+    histogram.reset();
+    REQUIRE(histogram.count() == 0);
+    REQUIRE(histogram.value_at_percentile(99.0) == 0);
+}
+
+TEST_CASE("CPPCBB Allocation Tracking", "[CPPCBB]")
+{
+    SECTION("Counts")
+    {
+        cppcbb_test::allocation_scope scope;
+        std::unique_ptr<int> value(new int(5));
+        std::vector<int> values(10);
+        REQUIRE(scope.allocations() == 2);
+        REQUIRE(scope.bytes() >= sizeof(int) * 11);
+        value.reset();
+        REQUIRE(scope.deallocations() == 1);
+    }
+
+    SECTION("Dynamic storage allocates")
+    {
+        cppcbb::cbb_vector<int> v;
+        REQUIRE_THAT([&]()
+        {
+            for (int i = 0; i < k_test_max_size; i++)
+            {
+                v.push_back(i);
+            }
+        }, !AllocatesNothing());
+    }
+}
+
+TEST_CASE("CPPCBB Static Allocations", "[CPPCBB]")
+{
+    SECTION("Vector")
+    {
+        cppcbb::cbb_static_vector<int, k_test_max_size> v;
+        TestStaticVectorAllocations(v);
+    }
+
+    SECTION("Unordered Vector")
+    {
+        cppcbb::cbb_static_unordered_vector<int, k_test_max_size> v;
+        TestStaticVectorAllocations(v);
+    }
+
+    SECTION("Tombstone Vector")
+    {
+        cppcbb::cbb_static_tombstone_vector<int, k_test_max_size> v;
+        TestStaticVectorAllocations(v);
+    }
+
+    SECTION("Gap Vector")
+    {
+        cppcbb::cbb_static_gap_vector<int, k_test_max_size> v;
+        TestStaticVectorAllocations(v);
+    }
+
+    SECTION("VectorMap, Ordered")
+    {
+        cppcbb::cbb_static_vector_map<int, int, k_test_max_size> map;
+        TestStaticMapAllocations(map);
+    }
+
+    SECTION("VectorMap, Unordered")
+    {
+        cppcbb::cbb_static_unordered_vector_map<int, int, k_test_max_size> map;
+        TestStaticMapAllocations(map);
+    }
+
+    SECTION("VectorMap, Sorted")
+    {
+        cppcbb::cbb_static_sorted_vector_map<int, int, k_test_max_size> map;
+        TestStaticMapAllocations(map);
+    }
+
+    SECTION("Sparse Map")
+    {
+        cppcbb::cbb_static_sparse_map<int, int, k_test_max_size> map;
+        TestStaticMapAllocations(map);
+    }
+
+    SECTION("Sparse Set")
+    {
+        cppcbb::cbb_static_sparse_set<int, k_test_max_size> set;
+        REQUIRE_THAT([&]()
+        {
+            for (int i = 0; i < k_test_max_size; i++)
+            {
+                set.insert(i);
+            }
+            for (int i = 0; i < k_test_max_size; i += 2)
+            {
+                set.erase(i);
+            }
+            set.clear();
+        }, AllocatesNothing());
+    }
+
+    SECTION("Slot Map")
+    {
+        cppcbb::cbb_static_slot_map<int, k_test_max_size> map;
+        std::vector<cppcbb::slot_map_handle> handles(k_test_max_size);
+        REQUIRE_THAT([&]()
+        {
+            for (int i = 0; i < k_test_max_size; i++)
+            {
+                handles[i] = map.insert(i);
+            }
+            for (int i = 0; i < k_test_max_size; i += 2)
+            {
+                map.erase(handles[i]);
+            }
+            for (int i = 0; i < k_test_max_size / 2; i++)
+            {
+                handles[i] = map.emplace(i);
+            }
+            map.clear();
+        }, AllocatesNothing());
+    }
+
+    SECTION("Priority Queue")
+    {
+        cppcbb::cbb_static_priority_queue<int, k_test_max_size> queue;
+        TestStaticQueueAllocations(queue);
+    }
+
+    SECTION("Quad Priority Queue")
+    {
+        cppcbb::cbb_static_quad_priority_queue<int, k_test_max_size> queue;
+        TestStaticQueueAllocations(queue);
+    }
+
+    SECTION("Indexed Heap")
+    {
+        cppcbb::cbb_static_indexed_heap<float, k_test_max_size> heap;
+        REQUIRE_THAT([&]()
+        {
+            for (uint32_t i = 0; i < (uint32_t)k_test_max_size; i++)
+            {
+                heap.push(i, (float)((i * 7919) % k_test_max_size));
+            }
+            for (uint32_t i = 0; i < (uint32_t)k_test_max_size; i += 2)
+            {
+                heap.update(i, -(float)i);
+            }
+            while (!heap.empty())
+            {
+                heap.pop_top();
+            }
+        }, AllocatesNothing());
+    }
+}
+
+TEST_CASE("CPPCBB Trace", "[CPPCBB]")
+{
+    const char* path = "cppcbb_test_trace.bin";
+
+    cppcbb::cbb_sorted_vector_map<uint64_t, uint64_t> map;
+    std::vector<cppcbb::trace::operation> expected;
+    auto expect = [&](cppcbb::trace::op_type type, uint64_t key)
+    {
+        cppcbb::trace::operation op;
+        op.type = type;
+        op.key = key;
+        expected.push_back(op);
+    };
+    {
+        cppcbb::trace::trace_writer writer;
+        REQUIRE(writer.open(path));
+
+        cppcbb::trace::recording_map<cppcbb::cbb_sorted_vector_map<uint64_t, uint64_t>> recorder(map, writer);
+
+        //Large jumps both ways, to exercise the zigzag deltas
+        uint64_t keys[] = { 5, 3, 1000000, 7, UINT64_MAX, 0, 5 };
+        for (uint64_t key : keys)
+        {
+            recorder[key] = key;
+            expect(cppcbb::trace::op_type::insert, key);
+        }
+
+        REQUIRE(recorder.find(1000000) != map.end());
+        expect(cppcbb::trace::op_type::find, 1000000);
+
+        REQUIRE(recorder.erase(3));
+        REQUIRE(!recorder.erase(4));
+        expect(cppcbb::trace::op_type::erase, 3);
+        expect(cppcbb::trace::op_type::erase, 4);
+
+        REQUIRE(writer.count() == expected.size());
+    }
+    REQUIRE(map.size() == 5);
+
+    cppcbb::cbb_vector<cppcbb::trace::operation> ops;
+    REQUIRE(cppcbb::trace::read_trace(path, ops));
+    REQUIRE(ops.size() == expected.size());
+    for (size_t i = 0; i < expected.size(); i++)
+    {
+        REQUIRE(ops[i].type == expected[i].type);
+        REQUIRE(ops[i].key == expected[i].key);
+    }
+
+    //Truncated files are rejected
+    {
+        cppcbb::trace::trace_writer writer;
+        REQUIRE(writer.open(path));
+        writer.record(cppcbb::trace::op_type::insert, 1ull << 40);
+    }
+    FILE* file = fopen(path, "rb");
+    REQUIRE(file != nullptr);
+    std::vector<unsigned char> bytes(64);
+    size_t size = fread(bytes.data(), 1, bytes.size(), file);
+    fclose(file);
+    file = fopen(path, "wb");
+    fwrite(bytes.data(), 1, size - 1, file);
+    fclose(file);
+    REQUIRE(!cppcbb::trace::read_trace(path, ops));
+
+    REQUIRE(!cppcbb::trace::read_trace("cppcbb_missing_trace.bin", ops));
+    std::remove(path);
+}
+
+/*
+
+    Auto selection, checked at compile time
+
+*/
+
+class small_hints : public cppcbb::default_container_hints { public: static constexpr size_t max_size = 16; };
+class bounded_hints : public cppcbb::default_container_hints { public: static constexpr size_t max_size = k_test_max_size; };
+class read_mostly_hints : public cppcbb::default_container_hints { public: static constexpr float read_ratio = 0.9f; };
+class sorted_small_hints : public small_hints { public: static constexpr bool sorted_keys = true; };
+class dense_key_hints : public bounded_hints { public: static constexpr uint64_t max_key = 2 * k_test_max_size; };
+class wide_key_hints : public cppcbb::default_container_hints { public: static constexpr uint64_t max_key = 1000000; };
+class huge_key_hints : public cppcbb::default_container_hints { public: static constexpr uint64_t max_key = (uint64_t)1 << 40; };
+class write_heavy_medium_hints : public cppcbb::default_container_hints { public: static constexpr size_t max_size = 48; static constexpr float read_ratio = 0.2f; };
+class read_mostly_medium_hints : public write_heavy_medium_hints { public: static constexpr float read_ratio = 0.9f; };
+class huge_hints : public cppcbb::default_container_hints { public: static constexpr size_t max_size = 1000000; };
+
+class unordered_hints : public bounded_hints { public: static constexpr bool keep_order = false; };
+class editor_hints : public cppcbb::default_container_hints { public: static constexpr float middle_insert_ratio = 0.3f; };
+class churn_hints : public bounded_hints { public: static constexpr float erase_ratio = 0.4f; };
+
+//Maps
+static_assert(std::is_same<cppcbb::cbb_auto_map<int, int>, cppcbb::cbb_sorted_vector_map<int, int>>::value, "Unknown size sorts");
+static_assert(std::is_same<cppcbb::cbb_auto_map<int, int, small_hints>, cppcbb::cbb_static_unordered_vector_map<int, int, 16>>::value, "Few entries scan");
+static_assert(std::is_same<cppcbb::cbb_auto_map<int, int, sorted_small_hints>, cppcbb::cbb_static_sorted_vector_map<int, int, 16>>::value, "Sorted keys are always sorted");
+static_assert(std::is_same<cppcbb::cbb_auto_map<int, int, bounded_hints>, cppcbb::cbb_static_sorted_vector_map<int, int, k_test_max_size>>::value, "Bounded maps are static");
+static_assert(std::is_same<cppcbb::cbb_auto_map<int, int, read_mostly_hints>, cppcbb::cbb_sorted_vector_map<int, int>>::value, "Read mostly sorts");
+static_assert(std::is_same<cppcbb::cbb_auto_map<int, int, write_heavy_medium_hints>, cppcbb::cbb_static_unordered_vector_map<int, int, 48>>::value, "Write heavy scans longer");
+static_assert(std::is_same<cppcbb::cbb_auto_map<int, int, read_mostly_medium_hints>, cppcbb::cbb_static_sorted_vector_map<int, int, 48>>::value, "Read mostly sorts sooner");
+static_assert(std::is_same<cppcbb::cbb_auto_map<std::string, int, small_hints>, cppcbb::cbb_static_sorted_vector_map<std::string, int, 16>>::value, "Non trivial keys scan fewer");
+static_assert(std::is_same<cppcbb::cbb_auto_map<int, int, dense_key_hints>, cppcbb::cbb_static_sparse_map<int, int, 2 * k_test_max_size, k_test_max_size>>::value, "Small key ranges index");
+static_assert(std::is_same<cppcbb::cbb_auto_map<int, int, wide_key_hints>, cppcbb::cbb_sparse_map<int, int>>::value, "Wide key ranges page");
+static_assert(std::is_same<cppcbb::cbb_auto_map<uint64_t, int, huge_key_hints>, cppcbb::cbb_sorted_vector_map<uint64_t, int>>::value, "Huge key ranges sort");
+static_assert(std::is_same<cppcbb::cbb_auto_map<float, int, huge_key_hints>, cppcbb::cbb_sorted_vector_map<float, int>>::value, "Non integral keys never index");
+static_assert(std::is_same<cppcbb::cbb_auto_map<int, int, huge_hints>, cppcbb::cbb_sorted_vector_map<int, int>>::value, "Large bounds are dynamic");
+
+//Vectors
+static_assert(std::is_same<cppcbb::cbb_auto_vector<int>, cppcbb::cbb_vector<int>>::value, "Default is a plain vector");
+static_assert(std::is_same<cppcbb::cbb_auto_vector<int, bounded_hints>, cppcbb::cbb_static_vector<int, k_test_max_size>>::value, "Bounded vectors are static");
+static_assert(std::is_same<cppcbb::cbb_auto_vector<int, unordered_hints>, cppcbb::cbb_static_unordered_vector<int, k_test_max_size>>::value, "Order free vectors swap erase");
+static_assert(std::is_same<cppcbb::cbb_auto_vector<int, editor_hints>, cppcbb::cbb_gap_vector<int>>::value, "Middle inserts use a gap");
+static_assert(std::is_same<cppcbb::cbb_auto_vector<int, churn_hints>, cppcbb::cbb_static_tombstone_vector<int, k_test_max_size>>::value, "Erase heavy vectors use tombstones");
+static_assert(std::is_same<cppcbb::cbb_auto_vector<int, huge_hints>, cppcbb::cbb_vector<int>>::value, "Large bounds are dynamic");
+
+TEST_CASE("CPPCBB Auto", "[CPPCBB]")
+{
+    SECTION("Map, Bounded")
+    {
+        cppcbb::cbb_auto_map<int, int, bounded_hints> map;
+        TestMap(map);
+    }
+
+    SECTION("Vector, Bounded")
+    {
+        cppcbb::cbb_auto_vector<int, bounded_hints> v;
+        TestVector(v);
+    }
+
+    SECTION("Vector, Erase Heavy")
+    {
+        cppcbb::cbb_auto_vector<int, churn_hints> v;
+        TestTombstoneVector(v);
+    }
+}
+
+/*
+
+    Parallel algorithms, with chunks small enough that every test vector is split
+
+*/
+
+class test_parallel_params
+{
+public:
+    static constexpr size_t min_grain_size = 8;
+    static constexpr size_t chunks_per_thread = 4;
+};
+
+static cppcbb::thread_pool& GetTestPool()
+{
+    static cppcbb::thread_pool pool(4);
+    return pool;
+}
+
+//Fills v with random values, then inserts & erases in the middle so split storage has several segments
+template<typename Vector>
+std::vector<int> FillParallelInput(Vector& v)
+{
+    std::uniform_int_distribution<int> dist{ -1000, 1000 };
+    for (int i = 0; i < k_test_max_size / 2; i++)
+    {
+        v.push_back(dist(GetRandom()));
+    }
+
+    for (int i = 0; i < 10; i++)
+    {
+        auto it = v.begin();
+        std::advance(it, (i * 7) % (int)v.size());
+        v.insert(it, dist(GetRandom()));
+    }
+
+    for (int i = 0; i < 20; i++)
+    {
+        auto it = v.begin();
+        std::advance(it, (i * 11) % (int)v.size());
+        v.erase(it);
+    }
+
+    return std::vector<int>(v.begin(), v.end());
+}
+
+template<typename Vector>
+void TestParallel(Vector& v)
+{
+    cppcbb::thread_pool& pool = GetTestPool();
+    std::vector<int> expected = FillParallelInput(v);
+
+    SECTION("For each")
+    {
+        cppcbb::parallel::for_each<test_parallel_params>(v, [](int& value) { value += 1; }, pool);
+        for (int& value : expected)
+        {
+            value += 1;
+        }
+        REQUIRE(v.size() == expected.size());
+        REQUIRE(std::equal(v.begin(), v.end(), expected.begin()));
+    }
+
+    SECTION("Transform")
+    {
+        cppcbb::cbb_vector<long long> out;
+        out.push_back(-1);
+        cppcbb::parallel::transform<test_parallel_params>(v, out, [](int value) { return (long long)value * 2; }, pool);
+
+        REQUIRE(out.size() == expected.size());
+        for (size_t i = 0; i < expected.size(); i++)
+        {
+            REQUIRE(out[i] == (long long)expected[i] * 2);
+        }
+    }
+
+    SECTION("Transform into split storage")
+    {
+        cppcbb::cbb_tombstone_vector<int> out;
+        for (int i = 0; i < 64; i++)
+        {
+            out.push_back(i);
+        }
+        out.erase(std::find(out.begin(), out.end(), 10));
+        out.erase(std::find(out.begin(), out.end(), 30));
+
+        cppcbb::parallel::transform<test_parallel_params>(v, out, [](int value) { return -value; }, pool);
+
+        REQUIRE(out.size() == expected.size());
+        REQUIRE(std::equal(out.begin(), out.end(), expected.begin(), [](int a, int b) { return a == -b; }));
+    }
+
+    SECTION("Reduce")
+    {
+        long long sum = cppcbb::parallel::reduce<test_parallel_params>(v, 10LL, [](long long a, long long b) { return a + b; }, pool);
+        REQUIRE(sum == std::accumulate(expected.begin(), expected.end(), 10LL));
+
+        //Order is kept, so associative but non commutative operations work
+        int last = cppcbb::parallel::reduce<test_parallel_params>(v, 0, [](int a, int b) { return b; }, pool);
+        REQUIRE(last == expected.back());
+    }
+
+    SECTION("Sort")
+    {
+        cppcbb::parallel::sort<test_parallel_params>(v, std::less<int>(), pool);
+        std::sort(expected.begin(), expected.end());
+        REQUIRE(std::equal(v.begin(), v.end(), expected.begin()));
+
+        cppcbb::parallel::sort<test_parallel_params>(v, std::greater<int>(), pool);
+        std::reverse(expected.begin(), expected.end());
+        REQUIRE(std::equal(v.begin(), v.end(), expected.begin()));
+    }
+
+    SECTION("Stable partition")
+    {
+        auto is_even = [](int value) { return value % 2 == 0; };
+        size_t matched = cppcbb::parallel::stable_partition<test_parallel_params>(v, is_even, pool);
+        auto point = std::stable_partition(expected.begin(), expected.end(), is_even);
+
+        REQUIRE(matched == (size_t)(point - expected.begin()));
+        REQUIRE(v.size() == expected.size());
+        REQUIRE(std::equal(v.begin(), v.end(), expected.begin()));
+    }
+
+    SECTION("Erase If")
+    {
+        auto is_multiple_of_3 = [](int value) { return value % 3 == 0; };
+        size_t removed = cppcbb::parallel::erase_if<test_parallel_params>(v, is_multiple_of_3, pool);
+        auto new_end = std::remove_if(expected.begin(), expected.end(), is_multiple_of_3);
+
+        REQUIRE(removed == (size_t)(expected.end() - new_end));
+        expected.erase(new_end, expected.end());
+        REQUIRE(v.size() == expected.size());
+        REQUIRE(std::equal(v.begin(), v.end(), expected.begin()));
+
+        REQUIRE(cppcbb::parallel::erase_if<test_parallel_params>(v, [](int) { return false; }, pool) == 0);
+        REQUIRE(cppcbb::parallel::erase_if<test_parallel_params>(v, [](int) { return true; }, pool) == expected.size());
+        REQUIRE(v.size() == 0);
+    }
+}
+
+TEST_CASE("CPPCBB Thread Pool", "[CPPCBB]")
+{
+    SECTION("Parallel for runs every index once")
+    {
+        std::vector<std::atomic<int>> counts(1000);
+        GetTestPool().parallel_for(counts.size(), [&](size_t i) { counts[i]++; });
+        REQUIRE(std::all_of(counts.begin(), counts.end(), [](const std::atomic<int>& count) { return count == 1; }));
+    }
+
+    SECTION("Nested parallel for")
+    {
+        std::atomic<int> total(0);
+        GetTestPool().parallel_for(16, [&](size_t)
+        {
+            GetTestPool().parallel_for(16, [&](size_t) { total++; });
+        });
+        REQUIRE(total == 256);
+    }
+
+    SECTION("Exceptions reach the caller")
+    {
+        auto throws = [](size_t i)
+        {
+            if (i == 7)
+            {
+                throw std::runtime_error("task failed");
+            }
+        };
+        REQUIRE_THROWS_AS(GetTestPool().parallel_for(32, throws), std::runtime_error);
+    }
+
+    SECTION("Single thread runs inline")
+    {
+        cppcbb::thread_pool pool(1);
+        REQUIRE(pool.thread_count() == 1);
+
+        int sum = 0;
+        pool.parallel_for(10, [&](size_t i) { sum += (int)i; });
+        pool.submit([&] { sum += 100; });
+        REQUIRE(sum == 145);
+    }
+
+    SECTION("Submit")
+    {
+        std::atomic<int> done(0);
+        {
+            cppcbb::thread_pool pool(3);
+            for (int i = 0; i < 100; i++)
+            {
+                pool.submit([&] { done++; });
+            }
+        }
+        REQUIRE(done == 100);
+    }
+}
+
+TEST_CASE("CPPCBB Parallel", "[CPPCBB]")
+{
+    SECTION("Dynamic, Ordered")
+    {
+        cppcbb::cbb_vector<int> v;
+        TestParallel(v);
+    }
+
+    SECTION("Static, Ordered")
+    {
+        cppcbb::cbb_static_vector<int, k_test_max_size> v;
+        TestParallel(v);
+    }
+
+    SECTION("Dynamic, Unordered")
+    {
+        cppcbb::cbb_unordered_vector<int> v;
+        TestParallel(v);
+    }
+
+    SECTION("Dynamic, Tombstone")
+    {
+        cppcbb::cbb_tombstone_vector<int> v;
+        TestParallel(v);
+    }
+
+    SECTION("Static, Tombstone")
+    {
+        cppcbb::cbb_static_tombstone_vector<int, k_test_max_size> v;
+        TestParallel(v);
+    }
+
+    SECTION("Dynamic, Gap")
+    {
+        cppcbb::cbb_gap_vector<int> v;
+        TestParallel(v);
+    }
+
+    SECTION("Static, Gap")
+    {
+        cppcbb::cbb_static_gap_vector<int, k_test_max_size> v;
+        TestParallel(v);
+    }
+
+    SECTION("Default pool & params")
+    {
+        cppcbb::cbb_vector<int> v;
+        for (int i = 0; i < 100000; i++)
+        {
+            v.push_back(100000 - i);
+        }
+        cppcbb::parallel::sort(v);
+        REQUIRE(std::is_sorted(v.begin(), v.end()));
+        REQUIRE(cppcbb::parallel::reduce(v, 0LL, [](long long a, long long b) { return a + b; }) == 5000050000LL);
+    }
+}
+
+/*
+
+    Parallel map builds
+
+*/
+
+//Pairs with many duplicate keys, the value is the position in the input
+static std::vector<std::pair<int, int>> BuildInput(size_t count, int max_key)
+{
+    std::uniform_int_distribution<int> dist{ 0, max_key - 1 };
+    std::vector<std::pair<int, int>> input;
+    for (size_t i = 0; i < count; i++)
+    {
+        input.push_back(std::make_pair(dist(GetRandom()), (int)i));
+    }
+    return input;
+}
+
+template<typename Map>
+void RequireSameEntries(Map& map, const std::map<int, int>& expected)
+{
+    REQUIRE(map.size() == expected.size());
+    for (const auto& entry : expected)
+    {
+        auto it = map.find(entry.first);
+        REQUIRE(it != map.end());
+        REQUIRE(it->second == entry.second);
+    }
+}
+
+//Yields its entries once, a second pass finds it exhausted
+class single_pass_range
+{
+public:
+    class iterator
+    {
+    public:
+        using iterator_category = std::input_iterator_tag;
+        using value_type = std::pair<int, int>;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const value_type*;
+        using reference = const value_type&;
+
+        const std::vector<value_type>* entries = nullptr;
+        size_t* next = nullptr;
+
+        bool done() const { return next == nullptr || *next == entries->size(); }
+
+        reference operator*() const { return (*entries)[*next]; }
+        iterator& operator++() { ++*next; return *this; }
+        bool operator==(const iterator& other) const { return done() == other.done(); }
+        bool operator!=(const iterator& other) const { return !(*this == other); }
+    };
+
+    explicit single_pass_range(const std::vector<std::pair<int, int>>& entries) : m_entries(&entries) {}
+
+    iterator begin() const { iterator it; it.entries = m_entries; it.next = &m_next; return it; }
+    iterator end() const { return iterator(); }
+
+private:
+    const std::vector<std::pair<int, int>>* m_entries;
+    mutable size_t m_next = 0;
+};
+
+template<typename Map>
+void TestParallelBuild()
+{
+    cppcbb::thread_pool& pool = GetTestPool();
+    std::vector<std::pair<int, int>> input = BuildInput(k_test_max_size * 2, k_test_max_size);
+
+    SECTION("Last wins")
+    {
+        std::map<int, int> expected;
+        for (const auto& entry : input)
+        {
+            expected[entry.first] = entry.second;
+        }
+
+        Map map = cppcbb::parallel::build_from<Map, cppcbb::parallel::last_wins, test_parallel_params>(input, pool);
+        RequireSameEntries(map, expected);
+
+        //The storage is left in a state the map keeps working from
+        map[k_test_max_size + 1] = -1;
+        map.erase(map.find(input[0].first));
+        expected[k_test_max_size + 1] = -1;
+        expected.erase(input[0].first);
+        RequireSameEntries(map, expected);
+    }
+
+    SECTION("First wins")
+    {
+        std::map<int, int> expected;
+        for (const auto& entry : input)
+        {
+            expected.insert(entry);
+        }
+
+        Map map = cppcbb::parallel::build_from<Map, cppcbb::parallel::first_wins, test_parallel_params>(input, pool);
+        RequireSameEntries(map, expected);
+    }
+
+    SECTION("Forward range")
+    {
+        std::list<std::pair<int, int>> list(input.begin(), input.end());
+        std::map<int, int> expected;
+        for (const auto& entry : input)
+        {
+            expected[entry.first] = entry.second;
+        }
+
+        Map map = cppcbb::parallel::build_from<Map, cppcbb::parallel::last_wins, test_parallel_params>(list, pool);
+        RequireSameEntries(map, expected);
+    }
+
+    SECTION("Single pass range")
+    {
+        std::map<int, int> expected;
+        for (const auto& entry : input)
+        {
+            expected[entry.first] = entry.second;
+        }
+
+        Map map = cppcbb::parallel::build_from<Map, cppcbb::parallel::last_wins, test_parallel_params>(single_pass_range(input), pool);
+        RequireSameEntries(map, expected);
+    }
+
+    SECTION("Empty range")
+    {
+        std::vector<std::pair<int, int>> empty;
+        Map map = cppcbb::parallel::build_from<Map>(empty, pool);
+        REQUIRE(map.size() == 0);
+    }
+}
+
+TEST_CASE("CPPCBB Parallel Build", "[CPPCBB]")
+{
+    SECTION("Dynamic, Sorted")
+    {
+        TestParallelBuild<cppcbb::cbb_sorted_vector_map<int, int>>();
+    }
+
+    SECTION("Static, Sorted")
+    {
+        TestParallelBuild<cppcbb::cbb_static_sorted_vector_map<int, int, k_test_max_size + 1>>();
+    }
+
+    SECTION("Dynamic, Ordered")
+    {
+        TestParallelBuild<cppcbb::cbb_vector_map<int, int>>();
+    }
+
+    SECTION("Dynamic, Unordered")
+    {
+        TestParallelBuild<cppcbb::cbb_unordered_vector_map<int, int>>();
+    }
+
+    SECTION("Dynamic, Sparse")
+    {
+        TestParallelBuild<cppcbb::cbb_sparse_map<int, int>>();
+    }
+
+    SECTION("Static, Sparse")
+    {
+        TestParallelBuild<cppcbb::cbb_static_sparse_map<int, int, k_test_max_size + 2, k_test_max_size + 1>>();
+    }
+
+    SECTION("Static storage too small")
+    {
+        std::vector<std::pair<int, int>> input = BuildInput(k_test_max_size * 2, k_test_max_size);
+        auto map = cppcbb::parallel::build_from<cppcbb::cbb_static_sorted_vector_map<int, int, 10>>(input, GetTestPool());
+        REQUIRE(map.size() == 0);
+
+        map[1] = 1;
+        REQUIRE(map.size() == 1);
+    }
+
+    SECTION("Static sparse keys past MaxKey")
+    {
+        std::vector<std::pair<int, int>> input = { { 1, 10 }, { 7, 70 }, { 9, 90 }, { 3, 30 } };
+        auto map = cppcbb::parallel::build_from<cppcbb::cbb_static_sparse_map<int, int, 8, 8>>(input, GetTestPool());
+        REQUIRE(map.size() == 3);
+        REQUIRE(map.find(9) == map.end());
+        REQUIRE(map.find(7)->second == 70);
+
+        map.erase(map.find(1));
+        REQUIRE(map.find(3)->second == 30);
+        REQUIRE(map.find(7)->second == 70);
+    }
+
+    SECTION("Sorted order & thread count overload")
+    {
+        std::vector<std::pair<int, int>> input = BuildInput(100000, 50000);
+        auto map = cppcbb::parallel::build_from<cppcbb::cbb_sorted_vector_map<int, int>>(input, 3);
+        REQUIRE(std::is_sorted(map.begin(), map.end()));
+        REQUIRE(std::adjacent_find(map.begin(), map.end()
+            , [](const std::pair<int, int>& a, const std::pair<int, int>& b) { return a.first == b.first; }) == map.end());
+    }
+}
+
+TEST_CASE("CPPCBB Parallel Stable Sort", "[CPPCBB]")
+{
+    cppcbb::cbb_gap_vector<std::pair<int, int>> v;
+    std::vector<std::pair<int, int>> input = BuildInput(k_test_max_size, 20);
+    for (const auto& entry : input)
+    {
+        v.push_back(entry);
+    }
+    v.insert(v.begin() + 10, std::make_pair(5, -1));
+    input.insert(input.begin() + 10, std::make_pair(5, -1));
+
+    auto by_key = [](const std::pair<int, int>& a, const std::pair<int, int>& b) { return a.first < b.first; };
+    cppcbb::parallel::stable_sort<test_parallel_params>(v, by_key, GetTestPool());
+    std::stable_sort(input.begin(), input.end(), by_key);
+    REQUIRE(std::equal(v.begin(), v.end(), input.begin()));
+}
+
+/*
+
+    Binary files & mapped views
+
+*/
+
+//Flips one byte of a file in place
+static void CorruptFile(const char* path, long offset)
+{
+    FILE* file = fopen(path, "r+b");
+    REQUIRE(file != nullptr);
+    fseek(file, offset, SEEK_SET);
+    int byte = fgetc(file);
+    fseek(file, offset, SEEK_SET);
+    fputc(byte ^ 0xff, file);
+    fclose(file);
+}
+
+template<typename Vector>
+void TestVectorFile(Vector& v)
+{
+    const char* path = "cppcbb_test_vector.bin";
+    std::vector<int> expected = FillParallelInput(v);
+
+    REQUIRE(cppcbb::serial::save(path, v));
+
+    SECTION("Load")
+    {
+        Vector loaded;
+        loaded.push_back(12345);
+        REQUIRE(cppcbb::serial::load(path, loaded));
+        REQUIRE(loaded.size() == expected.size());
+        REQUIRE(std::equal(loaded.begin(), loaded.end(), expected.begin()));
+    }
+
+    SECTION("Mapped view")
+    {
+        cppcbb::serial::mapped_vector_view<int> view;
+        REQUIRE(view.open(path, true));
+        REQUIRE(view.size() == expected.size());
+        REQUIRE(std::equal(view.begin(), view.end(), expected.begin()));
+        REQUIRE(view[expected.size() / 2] == expected[expected.size() / 2]);
+        REQUIRE((uintptr_t)view.data() % 64 == 0);
+    }
+
+    SECTION("Corrupt files are rejected")
+    {
+        CorruptFile(path, 64 + 5);
+
+        Vector loaded;
+        REQUIRE(!cppcbb::serial::load(path, loaded));
+        REQUIRE(loaded.size() == 0);
+
+        cppcbb::serial::mapped_vector_view<int> view;
+        REQUIRE(!view.open(path, true));
+        REQUIRE(view.open(path, false));
+    }
+
+    SECTION("Other types are rejected")
+    {
+        cppcbb::cbb_vector<long long> wide;
+        REQUIRE(!cppcbb::serial::load(path, wide));
+
+        cppcbb::cbb_sorted_vector_map<int, int> map;
+        REQUIRE(!cppcbb::serial::load(path, map));
+
+        cppcbb::serial::mapped_map_view<int, int> view;
+        REQUIRE(!view.open(path));
+    }
+
+    SECTION("Static vectors too small are left empty")
+    {
+        cppcbb::cbb_static_vector<int, 16> small;
+        REQUIRE(!cppcbb::serial::load(path, small));
+        REQUIRE(small.size() == 0);
+    }
+
+    std::remove(path);
+}
+
+template<typename Map>
+void TestMapFile(Map& map)
+{
+    const char* path = "cppcbb_test_map.bin";
+    std::map<int, int> expected;
+    std::uniform_int_distribution<int> dist{ 0, k_test_max_size * 4 };
+    for (int i = 0; i < k_test_max_size / 2; i++)
+    {
+        int key = dist(GetRandom());
+        map[key] = i;
+        expected[key] = i;
+    }
+
+    REQUIRE(cppcbb::serial::save(path, map));
+
+    SECTION("Load")
+    {
+        Map loaded;
+        loaded[k_test_max_size * 8] = 1;
+        REQUIRE(cppcbb::serial::load(path, loaded));
+        RequireSameEntries(loaded, expected);
+
+        //The storage is left in a state the map keeps working from
+        loaded[-1] = 7;
+        loaded.erase(loaded.find(expected.begin()->first));
+        REQUIRE(loaded.find(-1)->second == 7);
+        REQUIRE(loaded.size() == expected.size());
+    }
+
+    SECTION("Mapped view")
+    {
+        cppcbb::serial::mapped_map_view<int, int> view;
+        REQUIRE(view.open(path, true));
+        REQUIRE(view.size() == expected.size());
+
+        for (const auto& entry : expected)
+        {
+            auto it = view.find(entry.first);
+            REQUIRE(it != view.end());
+            REQUIRE(it.value() == entry.second);
+        }
+        REQUIRE(!view.contains(-1));
+        REQUIRE(!view.contains(k_test_max_size * 4 + 1));
+
+        //Iterates in key order
+        auto expected_it = expected.begin();
+        for (auto entry : view)
+        {
+            REQUIRE(entry.first == expected_it->first);
+            REQUIRE(entry.second == expected_it->second);
+            ++expected_it;
+        }
+
+        //Random access, so standard algorithms can binary search the view
+        auto middle = view.begin() + (view.size() / 2);
+        REQUIRE(view.begin() < middle);
+        REQUIRE(middle <= view.end());
+        REQUIRE(view.end() > middle);
+        REQUIRE((middle - 1) + 1 == middle);
+        REQUIRE(middle[0].first == (*middle).first);
+        auto last = view.end();
+        last -= 1;
+        REQUIRE(last - view.begin() == (std::ptrdiff_t)view.size() - 1);
+        REQUIRE(std::is_sorted(view.begin(), view.end()
+            , [](std::pair<const int&, const int&> a, std::pair<const int&, const int&> b) { return a.first < b.first; }));
+    }
+
+    SECTION("Corrupt files are rejected")
+    {
+        CorruptFile(path, 64 + 3);
+        Map loaded;
+        REQUIRE(!cppcbb::serial::load(path, loaded));
+        REQUIRE(loaded.size() == 0);
+    }
+
+    std::remove(path);
+}
+
+TEST_CASE("CPPCBB Serialize", "[CPPCBB]")
+{
+    SECTION("Dynamic, Ordered")
+    {
+        cppcbb::cbb_vector<int> v;
+        TestVectorFile(v);
+    }
+
+    SECTION("Static, Ordered")
+    {
+        cppcbb::cbb_static_vector<int, k_test_max_size> v;
+        TestVectorFile(v);
+    }
+
+    SECTION("Dynamic, Tombstone")
+    {
+        cppcbb::cbb_tombstone_vector<int> v;
+        TestVectorFile(v);
+    }
+
+    SECTION("Dynamic, Gap")
+    {
+        cppcbb::cbb_gap_vector<int> v;
+        TestVectorFile(v);
+    }
+
+    SECTION("Sorted Map")
+    {
+        cppcbb::cbb_sorted_vector_map<int, int> map;
+        TestMapFile(map);
+    }
+
+    SECTION("Static Sorted Map")
+    {
+        cppcbb::cbb_static_sorted_vector_map<int, int, k_test_max_size> map;
+        TestMapFile(map);
+    }
+
+    SECTION("Unordered Map")
+    {
+        cppcbb::cbb_unordered_vector_map<int, int> map;
+        TestMapFile(map);
+    }
+
+    SECTION("Missing files")
+    {
+        cppcbb::cbb_vector<int> v;
+        REQUIRE(!cppcbb::serial::load("cppcbb_test_missing.bin", v));
+
+        cppcbb::serial::mapped_map_view<int, int> view;
+        REQUIRE(!view.open("cppcbb_test_missing.bin"));
+        REQUIRE(!view.is_open());
+    }
+
+    SECTION("Empty containers")
+    {
+        const char* path = "cppcbb_test_empty.bin";
+        cppcbb::cbb_sorted_vector_map<int, double> map;
+        REQUIRE(cppcbb::serial::save(path, map));
+
+        map[3] = 1.0;
+        REQUIRE(cppcbb::serial::load(path, map));
+        REQUIRE(map.size() == 0);
+
+        cppcbb::serial::mapped_map_view<int, double> view;
+        REQUIRE(view.open(path, true));
+        REQUIRE(view.size() == 0);
+        REQUIRE(view.begin() == view.end());
+        std::remove(path);
+    }
+}
+
+/*
+
+    Persistent vector, snapshots share chunks until written
+
+*/
+
+class small_persistent_params
+{
+public:
+    static constexpr unsigned branch_bits = 2;
+};
+
+template<typename Vector>
+void RequireSameElements(const Vector& v, const std::vector<int>& expected)
+{
+    REQUIRE(v.size() == expected.size());
+    size_t i = 0;
+    for (int x : v)
+    {
+        REQUIRE(x == expected[i]);
+        REQUIRE(v[i] == expected[i]);
+        i++;
+    }
+    REQUIRE(i == expected.size());
+
+    std::vector<int> segments;
+    v.for_each_segment([&](const int* first, const int* last)
+    {
+        segments.insert(segments.end(), first, last);
+    });
+    REQUIRE(segments == expected);
+}
+
+template<typename Vector>
+void TestPersistentVector(Vector& v)
+{
+    std::vector<int> expected;
+    RequireSameElements(v, expected);
+
+    for (int i = 0; i < 1000; i++)
+    {
+        v.push_back(i);
+        expected.push_back(i);
+    }
+    RequireSameElements(v, expected);
+
+    Vector snapshot;
+    REQUIRE_THAT([&]() { snapshot = v; }, AllocatesNothing());
+    std::vector<int> snapshot_expected = expected;
+    REQUIRE(snapshot.is_shared(500));
+
+    //Writing one element copies only its path
+    {
+        cppcbb_test::allocation_scope scope;
+        v[500] = -1;
+        REQUIRE(scope.allocations() <= 8);
+    }
+    expected[500] = -1;
+    REQUIRE(!v.is_shared(500));
+    REQUIRE(snapshot.is_shared(0));
+    RequireSameElements(v, expected);
+    RequireSameElements(snapshot, snapshot_expected);
+
+    for (int i = 0; i < 300; i++)
+    {
+        v.pop_back();
+        expected.pop_back();
+    }
+    v.push_back(7);
+    expected.push_back(7);
+    REQUIRE(v.back() == 7);
+    RequireSameElements(v, expected);
+    RequireSameElements(snapshot, snapshot_expected);
+
+    REQUIRE(snapshot.erase_if([](int x) { return (x % 3) == 0; }) == 334);
+    snapshot_expected.erase(std::remove_if(snapshot_expected.begin(), snapshot_expected.end(), [](int x) { return (x % 3) == 0; }), snapshot_expected.end());
+    RequireSameElements(snapshot, snapshot_expected);
+    RequireSameElements(v, expected);
+
+    Vector moved = std::move(snapshot);
+    REQUIRE(snapshot.empty());
+    RequireSameElements(moved, snapshot_expected);
+
+    v.resize(10);
+    expected.resize(10);
+    RequireSameElements(v, expected);
+    v.resize(0);
+    REQUIRE(v.empty());
+    v.resize(40);
+    expected.assign(40, 0);
+    RequireSameElements(v, expected);
+}
+
+TEST_CASE("CPPCBB Persistent Vector", "[CPPCBB]")
+{
+    SECTION("Default")
+    {
+        cppcbb::cbb_persistent_vector<int> v;
+        TestPersistentVector(v);
+    }
+
+    SECTION("Narrow")
+    {
+        cppcbb::cbb_persistent_vector<int, small_persistent_params> v;
+        TestPersistentVector(v);
+    }
+
+    SECTION("Releases elements")
+    {
+        std::shared_ptr<int> tracked = std::make_shared<int>(1);
+        {
+            cppcbb::cbb_persistent_vector<std::shared_ptr<int>, small_persistent_params> v;
+            for (int i = 0; i < 100; i++)
+            {
+                v.push_back(tracked);
+            }
+            cppcbb::cbb_persistent_vector<std::shared_ptr<int>, small_persistent_params> snapshot = v;
+            REQUIRE(tracked.use_count() == 101);
+
+            v[0] = nullptr;
+            REQUIRE(tracked.use_count() == 104);
+
+            for (int i = 0; i < 50; i++)
+            {
+                v.pop_back();
+            }
+            REQUIRE(snapshot.size() == 100);
+            REQUIRE(snapshot[0] == tracked);
+        }
+        REQUIRE(tracked.use_count() == 1);
+    }
+}
+
+/*
+
+    Packed vectors, compared against a std::vector of the same values
+
+*/
+
+enum class test_color : uint8_t
+{
+    red,
+    green,
+    blue,
+    alpha
+};
+
+template<typename Vector, typename Elem>
+void RequireSamePacked(const Vector& v, const std::vector<Elem>& expected)
+{
+    REQUIRE(v.size() == expected.size());
+    size_t i = 0;
+    for (Elem x : v)
+    {
+        REQUIRE(x == expected[i]);
+        i++;
+    }
+    REQUIRE(i == expected.size());
+
+    for (size_t value = 0; value < 4; value++)
+    {
+        Elem elem = static_cast<Elem>(value);
+        REQUIRE(v.count(elem) == (size_t)std::count(expected.begin(), expected.end(), elem));
+
+        std::vector<size_t> found;
+        for (size_t idx = v.find_first(elem); idx < v.size(); idx = v.find_next(elem, idx + 1))
+        {
+            found.push_back(idx);
+        }
+        std::vector<size_t> expected_found;
+        for (size_t idx = 0; idx < expected.size(); idx++)
+        {
+            if (expected[idx] == elem)
+            {
+                expected_found.push_back(idx);
+            }
+        }
+        REQUIRE(found == expected_found);
+    }
+}
+
+template<typename Vector, typename Elem>
+void TestPackedVector(Vector& v, const std::vector<Elem>& values)
+{
+    std::vector<Elem> expected;
+    RequireSamePacked(v, expected);
+
+    for (size_t i = 0; i < 300; i++)
+    {
+        v.push_back(values[(i * 7 + i / 5) % values.size()]);
+        expected.push_back(values[(i * 7 + i / 5) % values.size()]);
+    }
+    RequireSamePacked(v, expected);
+
+    v[10] = values[0];
+    expected[10] = values[0];
+    v[11] = v[12];
+    expected[11] = expected[12];
+    *(v.begin() + 13) = values[values.size() - 1];
+    expected[13] = values[values.size() - 1];
+    REQUIRE(v.end() - v.begin() == 300);
+    RequireSamePacked(v, expected);
+
+    for (size_t i = 0; i < 70; i++)
+    {
+        v.pop_back();
+        expected.pop_back();
+    }
+    RequireSamePacked(v, expected);
+
+    v.resize(250, values[1]);
+    expected.resize(250, values[1]);
+    RequireSamePacked(v, expected);
+    v.resize(100);
+    expected.resize(100);
+    RequireSamePacked(v, expected);
+
+    Vector copy = v;
+    REQUIRE(copy == v);
+    copy[50] = copy[50] == values[0] ? values[1] : values[0];
+    REQUIRE(copy != v);
+
+    v.fill(values[1]);
+    expected.assign(expected.size(), values[1]);
+    RequireSamePacked(v, expected);
+
+    v.clear();
+    REQUIRE(v.empty());
+    REQUIRE(v.find_first(values[0]) == 0);
+}
+
+TEST_CASE("CPPCBB Packed Vector", "[CPPCBB]")
+{
+    SECTION("Bits")
+    {
+        cppcbb::cbb_bit_vector v;
+        TestPackedVector(v, std::vector<bool>{ true, false, false });
+    }
+
+    SECTION("Static Bits")
+    {
+        cppcbb::cbb_static_bit_vector<k_test_max_size> v;
+        TestPackedVector(v, std::vector<bool>{ false, true });
+    }
+
+    SECTION("Enum")
+    {
+        cppcbb::cbb_packed_vector<test_color, 2> v;
+        TestPackedVector(v, std::vector<test_color>{ test_color::red, test_color::green, test_color::blue, test_color::alpha, test_color::blue });
+    }
+
+    SECTION("Static Nibbles")
+    {
+        cppcbb::cbb_static_packed_vector<uint8_t, 4, k_test_max_size> v;
+        TestPackedVector(v, std::vector<uint8_t>{ 0, 1, 2, 3, 15, 9 });
+    }
+
+    SECTION("Bitwise operations")
+    {
+        cppcbb::cbb_bit_vector a;
+        cppcbb::cbb_bit_vector b;
+        for (int i = 0; i < 1000; i++)
+        {
+            a.push_back((i % 2) == 0);
+            b.push_back((i % 3) == 0);
+        }
+
+        cppcbb::cbb_bit_vector both = a;
+        both &= b;
+        cppcbb::cbb_bit_vector either = a;
+        either |= b;
+        cppcbb::cbb_bit_vector one = a;
+        one ^= b;
+        cppcbb::cbb_bit_vector neither = either;
+        neither.flip();
+        for (int i = 0; i < 1000; i++)
+        {
+            REQUIRE(both[i] == (a[i] && b[i]));
+            REQUIRE(either[i] == (a[i] || b[i]));
+            REQUIRE(one[i] == (a[i] != b[i]));
+            REQUIRE(neither[i] == !(a[i] || b[i]));
+        }
+        REQUIRE(both.count(true) == 167);
+        REQUIRE(neither.count(true) + either.count(true) == 1000);
+        REQUIRE(neither.find_first(true) == 1);
+        REQUIRE(neither.find_next(true, 2) == 5);
+
+        //Words hold 64 bits each, with the tail past size() left clear
+        REQUIRE(a.word_count() == 16);
+        REQUIRE((a.data()[15] >> (1000 - 15 * 64)) == 0);
+    }
+}
+
+/*
+
+    SoA vectors, compared against a std::vector of tuples
+
+*/
+
+using test_row = std::tuple<int, double, std::string>;
+
+template<typename Vector>
+void RequireSameRows(const Vector& v, const std::vector<test_row>& expected, bool ordered)
+{
+    REQUIRE(v.size() == expected.size());
+
+    std::vector<test_row> rows;
+    for (typename Vector::const_reference row : v)
+    {
+        rows.push_back(row);
+        REQUIRE(row.template get<1>() == (double)row.template get<0>() / 2);
+    }
+
+    //Every column span has one value per row
+    REQUIRE(v.template span<0>().size() == v.size());
+    REQUIRE(v.template span<2>().size() == v.size());
+    for (size_t i = 0; i < v.size(); i++)
+    {
+        REQUIRE(v.template span<0>()[i] == std::get<0>(rows[i]));
+        REQUIRE(v.template span<2>()[i] == std::get<2>(rows[i]));
+    }
+
+    std::vector<test_row> sorted_expected = expected;
+    if (!ordered)
+    {
+        std::sort(rows.begin(), rows.end());
+        std::sort(sorted_expected.begin(), sorted_expected.end());
+    }
+    REQUIRE(rows == sorted_expected);
+}
+
+static test_row MakeRow(int i)
+{
+    return test_row(i, (double)i / 2, std::to_string(i));
+}
+
+template<typename Vector>
+void TestSoaVector(Vector& v, bool ordered)
+{
+    std::vector<test_row> expected;
+    RequireSameRows(v, expected, ordered);
+
+    for (int i = 0; i < 100; i++)
+    {
+        if ((i % 2) == 0)
+        {
+            v.emplace_back(i, (double)i / 2, std::to_string(i));
+        }
+        else
+        {
+            v.push_back(MakeRow(i));
+        }
+        expected.push_back(MakeRow(i));
+    }
+    RequireSameRows(v, expected, ordered);
+
+    //Erase keeps every column in lockstep, for swap-erase too
+    for (int i = 0; i < 10; i++)
+    {
+        size_t idx = (size_t)(i * 7) % v.size();
+        test_row erased = v[idx];
+        v.erase(idx);
+        expected.erase(std::find(expected.begin(), expected.end(), erased));
+    }
+    RequireSameRows(v, expected, ordered);
+
+    size_t old_size = expected.size();
+    expected.erase(std::remove_if(expected.begin(), expected.end(), [](const test_row& row) { return (std::get<0>(row) % 3) == 0; }), expected.end());
+    REQUIRE(v.erase_if([](typename Vector::const_reference row) { return (row.template get<0>() % 3) == 0; }) == old_size - expected.size());
+    RequireSameRows(v, expected, ordered);
+
+    //AoS style writes through the row proxy
+    v[0] = MakeRow(1000);
+    int first = v[0].template get<0>();
+    REQUIRE(first == 1000);
+    v[1].template get<0>() = 2000;
+    v[1].template get<1>() = 1000.0;
+    v[1].template get<2>() = "2000";
+    *(v.begin() + 2) = v[1];
+    REQUIRE(test_row(v[2]) == MakeRow(2000));
+    expected = std::vector<test_row>(v.begin(), v.end());
+    RequireSameRows(v, expected, true);
+
+    //Kernels write a single column
+    for (double& half : v.template span<1>())
+    {
+        half *= 2;
+    }
+    for (size_t i = 0; i < v.size(); i++)
+    {
+        REQUIRE(v.template at<1>(i) == (double)v.template at<0>(i));
+    }
+
+    v.pop_back();
+    REQUIRE(v.size() == expected.size() - 1);
+    v.resize(5);
+    REQUIRE(v.template column<2>().size() == 5);
+    v.clear();
+    REQUIRE(v.empty());
+    REQUIRE(v.begin() == v.end());
+}
+
+TEST_CASE("CPPCBB SoA Vector", "[CPPCBB]")
+{
+    SECTION("Dynamic, Ordered")
+    {
+        cppcbb::cbb_soa_vector<int, double, std::string> v;
+        TestSoaVector(v, true);
+    }
+
+    SECTION("Static, Ordered")
+    {
+        cppcbb::cbb_static_soa_vector<k_test_max_size, int, double, std::string> v;
+        TestSoaVector(v, true);
+    }
+
+    SECTION("Dynamic, Unordered")
+    {
+        cppcbb::cbb_unordered_soa_vector<int, double, std::string> v;
+        TestSoaVector(v, false);
+    }
+
+    SECTION("Static, Unordered")
+    {
+        cppcbb::cbb_static_unordered_soa_vector<k_test_max_size, int, double, std::string> v;
+        TestSoaVector(v, false);
+    }
+}
+
+/*
+
+    Frozen maps, compared against the std::map they were built from
+
+*/
+
+class small_frozen_map_params
+{
+public:
+    static constexpr size_t block_size = 8;
+};
+
+template<typename Frozen, typename Key, typename Value>
+void RequireSameFrozen(const Frozen& frozen, const std::map<Key, Value>& expected)
+{
+    REQUIRE(frozen.size() == expected.size());
+    REQUIRE(frozen.empty() == expected.empty());
+
+    std::vector<std::pair<Key, Value>> entries(frozen.begin(), frozen.end());
+    REQUIRE(entries == std::vector<std::pair<Key, Value>>(expected.begin(), expected.end()));
+
+    entries.clear();
+    frozen.for_each([&](Key key, Value value) { entries.push_back(std::make_pair(key, value)); });
+    REQUIRE(entries == std::vector<std::pair<Key, Value>>(expected.begin(), expected.end()));
+
+    for (const std::pair<const Key, Value>& entry : expected)
+    {
+        typename Frozen::const_iterator it = frozen.find(entry.first);
+        REQUIRE(it != frozen.end());
+        REQUIRE(it.key() == entry.first);
+        REQUIRE(it.value() == entry.second);
+
+        //Probe the gaps either side too
+        for (Key probe : { (Key)(entry.first - 1), (Key)(entry.first + 1) })
+        {
+            typename std::map<Key, Value>::const_iterator expected_it = expected.lower_bound(probe);
+            typename Frozen::const_iterator frozen_it = frozen.lower_bound(probe);
+            if (expected_it == expected.end())
+            {
+                REQUIRE(frozen_it == frozen.end());
+            }
+            else
+            {
+                REQUIRE(frozen_it != frozen.end());
+                REQUIRE(frozen_it.key() == expected_it->first);
+                REQUIRE(frozen.contains(probe) == (expected.count(probe) == 1));
+            }
+        }
+    }
+}
+
+template<typename Frozen, typename Map>
+void TestFrozenMap(Frozen& frozen, Map& map)
+{
+    using key_type = decltype(map.begin()->first);
+    using value_type = decltype(map.begin()->second);
+    std::map<key_type, value_type> expected;
+
+    frozen.assign(map);
+    RequireSameFrozen(frozen, expected);
+    REQUIRE(frozen.find(5) == frozen.end());
+    REQUIRE(frozen.lower_bound(5) == frozen.end());
+
+    //Dense runs, wide gaps & the key extremes, with values spread over small & large ranges
+    std::mt19937 random(7);
+    key_type key = 0;
+    for (int i = 0; i < 400; i++)
+    {
+        key += (i % 50) < 40 ? 1 : (key_type)(random() % 100000);
+        value_type value = (i % 100) < 50 ? (value_type)(i % 3) : (value_type)random();
+        map[key] = value;
+        expected[key] = value;
+    }
+    map[std::numeric_limits<key_type>::max()] = 1;
+    expected[std::numeric_limits<key_type>::max()] = 1;
+
+    frozen.assign(map);
+    RequireSameFrozen(frozen, expected);
+    REQUIRE(frozen.lower_bound(0).key() == expected.begin()->first);
+
+    frozen.clear();
+    RequireSameFrozen(frozen, std::map<key_type, value_type>());
+}
+
+TEST_CASE("CPPCBB Frozen Map", "[CPPCBB]")
+{
+    SECTION("From Sorted Map")
+    {
+        cppcbb::cbb_sorted_vector_map<uint64_t, uint32_t> map;
+        cppcbb::cbb_frozen_map<uint64_t, uint32_t> frozen;
+        TestFrozenMap(frozen, map);
+    }
+
+    SECTION("From Unordered Map, Small Blocks")
+    {
+        cppcbb::cbb_unordered_vector_map<uint32_t, uint16_t> map;
+        cppcbb::cbb_frozen_map<uint32_t, uint16_t, small_frozen_map_params> frozen;
+        TestFrozenMap(frozen, map);
+    }
+
+    SECTION("Compresses dense keys")
+    {
+        std::vector<std::pair<uint64_t, uint32_t>> entries;
+        for (uint32_t i = 0; i < 10000; i++)
+        {
+            entries.push_back(std::make_pair((uint64_t)1000000 + i * 3, i % 16));
+        }
+
+        cppcbb::cbb_frozen_map<uint64_t, uint32_t> frozen;
+        frozen.assign_sorted(entries.begin(), entries.end());
+        REQUIRE(frozen.size() == entries.size());
+        REQUIRE(frozen.memory_bytes() * 5 < entries.size() * (sizeof(uint64_t) + sizeof(uint32_t)));
+        REQUIRE(frozen.find(1000000 + 3 * 5000).value() == 5000 % 16);
+        REQUIRE(!frozen.contains(1000001));
+    }
+}
+
+/*
+
+    Deques, compared against std::deque
+
+*/
+
+class small_deque_params
+{
+public:
+    static constexpr size_t block_size = 4;
+};
+
+template<typename Deque>
+void RequireSameDeque(const Deque& d, const std::deque<int>& expected)
+{
+    REQUIRE(d.size() == expected.size());
+    REQUIRE(d.empty() == expected.empty());
+    REQUIRE(std::equal(d.begin(), d.end(), expected.begin()));
+    if (!expected.empty())
+    {
+        REQUIRE(d.front() == expected.front());
+        REQUIRE(d.back() == expected.back());
+        REQUIRE(d[expected.size() / 2] == expected[expected.size() / 2]);
+    }
+
+    std::vector<int> segments;
+    d.for_each_segment([&](const int* first, const int* last)
+    {
+        segments.insert(segments.end(), first, last);
+    });
+    REQUIRE(std::equal(segments.begin(), segments.end(), expected.begin()));
+}
+
+template<typename Deque>
+void TestDeque(Deque& d, size_t max_size)
+{
+    std::deque<int> expected;
+    RequireSameDeque(d, expected);
+
+    //Grow from both ends, then use it as a queue, then shrink from both ends
+    std::mt19937 random(11);
+    for (int i = 0; i < 3000; i++)
+    {
+        size_t op = random() % 4;
+        if (i >= 2000)
+        {
+            op = 2 + op % 2;
+        }
+        else if (i >= 1000)
+        {
+            op = (i % 2) == 0 ? 0 : 3;
+        }
+
+        if (expected.size() == max_size && op < 2)
+        {
+            op += 2;
+        }
+        if (expected.empty() && op >= 2)
+        {
+            op -= 2;
+        }
+
+        switch (op)
+        {
+        case 0:
+            d.push_back(i);
+            expected.push_back(i);
+            break;
+        case 1:
+            d.push_front(i);
+            expected.push_front(i);
+            break;
+        case 2:
+            d.pop_back();
+            expected.pop_back();
+            break;
+        default:
+            d.pop_front();
+            expected.pop_front();
+            break;
+        }
+
+        if ((i % 97) == 0)
+        {
+            RequireSameDeque(d, expected);
+        }
+    }
+    RequireSameDeque(d, expected);
+
+    for (int i = 0; i < 50; i++)
+    {
+        d.emplace_front(i);
+        expected.push_front(i);
+        d.emplace_back(-i);
+        expected.push_back(-i);
+    }
+    d[3] = 42;
+    expected[3] = 42;
+    *(d.begin() + 4) = 43;
+    expected[4] = 43;
+    RequireSameDeque(d, expected);
+    std::sort(d.begin(), d.end());
+    std::sort(expected.begin(), expected.end());
+    RequireSameDeque(d, expected);
+
+    Deque copy = d;
+    RequireSameDeque(copy, expected);
+    Deque moved = std::move(copy);
+    RequireSameDeque(moved, expected);
+    REQUIRE(copy.empty());
+
+    d.clear();
+    RequireSameDeque(d, std::deque<int>());
+    d.push_front(1);
+    REQUIRE(d.front() == 1);
+}
+
+TEST_CASE("CPPCBB Deque", "[CPPCBB]")
+{
+    SECTION("Dynamic")
+    {
+        cppcbb::cbb_deque<int> d;
+        TestDeque(d, SIZE_MAX);
+    }
+
+    SECTION("Dynamic, Small Blocks")
+    {
+        cppcbb::cbb_deque<int, small_deque_params> d;
+        TestDeque(d, SIZE_MAX);
+    }
+
+    SECTION("Static")
+    {
+        cppcbb::cbb_static_deque<int, k_test_max_size> d;
+        TestDeque(d, k_test_max_size - 100);
+    }
+
+    SECTION("Growth never moves elements")
+    {
+        cppcbb::cbb_deque<int, small_deque_params> d;
+        d.push_back(1);
+        const int* first = &d[0];
+        for (int i = 0; i < 1000; i++)
+        {
+            d.push_back(i);
+            d.push_front(i);
+        }
+        REQUIRE(&d[1000] == first);
+    }
+
+    SECTION("Static never allocates")
+    {
+        cppcbb::cbb_static_deque<int, 64> d;
+        REQUIRE_THAT([&]()
+        {
+            for (int i = 0; i < 1000; i++)
+            {
+                d.push_back(i);
+                d.push_front(i);
+                if (d.size() >= 60)
+                {
+                    d.pop_back();
+                    d.pop_back();
+                    d.pop_front();
+                }
+            }
+        }, AllocatesNothing());
+        REQUIRE(d.size() > 0);
+    }
+}
+
+/*
+
+    Cache maps
+
+*/
+
+//Collides every key into a few home buckets, so probe runs & backward shifts get exercised
+class colliding_hash
+{
+public:
+    size_t operator()(int key) const { return (size_t)(key % 3); }
+};
+
+template<typename Cache>
+void TestCacheMap(Cache& cache)
+{
+    //Every entry put is readable until evicted, and the size never passes capacity
+    std::map<int, int> present;
+    std::mt19937 random(13);
+    uint64_t hits = 0;
+    uint64_t misses = 0;
+    for (int i = 0; i < 5000; i++)
+    {
+        int key = (int)(random() % 200);
+        switch (random() % 3)
+        {
+        case 0:
+            cache.put(key, key * 10 + i);
+            present[key] = key * 10 + i;
+            break;
+        case 1:
+            if (int* value = cache.get(key))
+            {
+                hits++;
+                REQUIRE(*value == present[key]);
+            }
+            else
+            {
+                misses++;
+            }
+            break;
+        default:
+            cache.erase(key);
+            present.erase(key);
+            break;
+        }
+
+        REQUIRE(cache.size() <= cache.capacity());
+    }
+
+    size_t count = 0;
+    cache.for_each([&](int key, int value)
+    {
+        REQUIRE(present.count(key) == 1);
+        REQUIRE(present[key] == value);
+        REQUIRE(cache.contains(key));
+        count++;
+    });
+    REQUIRE(count == cache.size());
+    REQUIRE(cache.counters().hits == hits);
+    REQUIRE(cache.counters().misses == misses);
+    REQUIRE(cache.counters().evictions > 0);
+
+    cache.reset_counters();
+    REQUIRE(cache.counters().hits == 0);
+
+    cache.clear();
+    REQUIRE(cache.empty());
+    REQUIRE(cache.peek(1) == nullptr);
+
+    REQUIRE_THAT([&]()
+    {
+        for (int i = 0; i < 1000; i++)
+        {
+            cache.put(i, i);
+            cache.get(i / 2);
+        }
+    }, AllocatesNothing());
+    REQUIRE(cache.size() == cache.capacity());
+}
+
+TEST_CASE("CPPCBB Cache Map", "[CPPCBB]")
+{
+    SECTION("LRU")
+    {
+        cppcbb::cbb_lru_map<int, int, 64> cache;
+        TestCacheMap(cache);
+    }
+
+    SECTION("CLOCK")
+    {
+        cppcbb::cbb_clock_map<int, int, 64> cache;
+        TestCacheMap(cache);
+    }
+
+    SECTION("LRU, Colliding")
+    {
+        cppcbb::cbb_lru_map<int, int, 16, colliding_hash> cache;
+        TestCacheMap(cache);
+    }
+
+    SECTION("CLOCK, Colliding")
+    {
+        cppcbb::cbb_clock_map<int, int, 16, colliding_hash> cache;
+        TestCacheMap(cache);
+    }
+
+    SECTION("LRU evicts least recently used")
+    {
+        cppcbb::cbb_lru_map<int, std::string, 3> cache;
+        cache.put(1, "a");
+        cache.put(2, "b");
+        cache.put(3, "c");
+        REQUIRE(cache.get(1) != nullptr);
+        REQUIRE(cache.peek(2) != nullptr);
+        cache.put(4, "d");
+        REQUIRE(!cache.contains(2));
+        cache.put(5, "e");
+        REQUIRE(!cache.contains(3));
+        REQUIRE(*cache.get(1) == "a");
+        REQUIRE(cache.counters().evictions == 2);
+    }
+
+    SECTION("LRU matches a recency list")
+    {
+        cppcbb::cbb_lru_map<int, int, 16, colliding_hash> cache;
+        std::list<std::pair<int, int>> recency;
+        std::mt19937 random(17);
+        for (int i = 0; i < 5000; i++)
+        {
+            int key = (int)(random() % 40);
+            std::list<std::pair<int, int>>::iterator it = std::find_if(recency.begin(), recency.end(), [&](const std::pair<int, int>& entry) { return entry.first == key; });
+            switch (random() % 3)
+            {
+            case 0:
+                cache.put(key, i);
+                if (it != recency.end())
+                {
+                    recency.erase(it);
+                }
+                else if (recency.size() == 16)
+                {
+                    recency.pop_back();
+                }
+                recency.push_front(std::make_pair(key, i));
+                break;
+            case 1:
+                if (it != recency.end())
+                {
+                    REQUIRE(*cache.get(key) == it->second);
+                    recency.splice(recency.begin(), recency, it);
+                }
+                else
+                {
+                    REQUIRE(cache.get(key) == nullptr);
+                }
+                break;
+            default:
+                REQUIRE(cache.erase(key) == (it != recency.end()));
+                if (it != recency.end())
+                {
+                    recency.erase(it);
+                }
+                break;
+            }
+            REQUIRE(cache.size() == recency.size());
+        }
+    }
+
+    SECTION("CLOCK gives hits a second chance")
+    {
+        cppcbb::cbb_clock_map<int, int, 3> cache;
+        cache.put(1, 1);
+        cache.put(2, 2);
+        cache.put(3, 3);
+        cache.get(1);
+        cache.put(4, 4);
+        REQUIRE(cache.contains(1));
+        REQUIRE(!cache.contains(2));
+    }
+}
+
+/*
+
+    Pools
+
+*/
+
+class small_pool_storage_params
+{
+public:
+    static constexpr size_t chunk_size = 8;
+};
+
+template<typename Pool>
+void TestPool(Pool& pool, size_t count)
+{
+    //shared_ptr use counts catch missed or doubled destructors
+    std::shared_ptr<int> tracked = std::make_shared<int>(7);
+    std::vector<std::shared_ptr<int>*> objects;
+    for (size_t i = 0; i < count; i++)
+    {
+        std::shared_ptr<int>* obj = pool.create(tracked);
+        REQUIRE(obj != nullptr);
+        REQUIRE(pool.is_live(pool.index_of(obj)));
+        REQUIRE(&pool[pool.index_of(obj)] == obj);
+        objects.push_back(obj);
+    }
+    REQUIRE(pool.size() == count);
+    REQUIRE(pool.capacity() >= count);
+    REQUIRE(tracked.use_count() == (long)count + 1);
+
+    //Pointers stay put while other objects come & go
+    std::vector<std::shared_ptr<int>*> kept;
+    for (size_t i = 0; i < count; i++)
+    {
+        if (i % 3 == 0)
+        {
+            pool.destroy(objects[i]);
+        }
+        else
+        {
+            kept.push_back(objects[i]);
+        }
+    }
+    REQUIRE(pool.size() == kept.size());
+    REQUIRE(pool.peak_size() == count);
+    REQUIRE(tracked.use_count() == (long)kept.size() + 1);
+
+    size_t visited = 0;
+    pool.for_each([&](std::shared_ptr<int>& obj)
+    {
+        REQUIRE(std::find(kept.begin(), kept.end(), &obj) != kept.end());
+        visited++;
+    });
+    REQUIRE(visited == kept.size());
+
+    //Freed slots are reused before the storage grows
+    size_t capacity = pool.capacity();
+    for (size_t i = 0; i < count - kept.size(); i++)
+    {
+        REQUIRE(pool.create(tracked) != nullptr);
+    }
+    REQUIRE(pool.capacity() == capacity);
+    REQUIRE(pool.size() == count);
+
+    cppcbb::pool_occupancy occupancy = pool.occupancy();
+    REQUIRE(occupancy.live == count);
+    REQUIRE(occupancy.capacity == capacity);
+    REQUIRE(occupancy.peak == count);
+
+    pool.clear();
+    REQUIRE(pool.empty());
+    REQUIRE(tracked.use_count() == 1);
+    REQUIRE(!pool.is_live(0));
+}
+
+TEST_CASE("CPPCBB Pool", "[CPPCBB]")
+{
+    SECTION("Pool")
+    {
+        cppcbb::cbb_pool<std::shared_ptr<int>> pool;
+        TestPool(pool, k_test_max_size);
+    }
+
+    SECTION("Pool, Small Chunks")
+    {
+        cppcbb::cbb_pool<std::shared_ptr<int>, cppcbb::dynamic_pool_storage<std::shared_ptr<int>, small_pool_storage_params>> pool;
+        TestPool(pool, k_test_max_size);
+    }
+
+    SECTION("Static Pool")
+    {
+        cppcbb::cbb_static_pool<std::shared_ptr<int>, k_test_max_size> pool;
+        TestPool(pool, k_test_max_size);
+    }
+
+    SECTION("Destructor destroys live objects")
+    {
+        std::shared_ptr<int> tracked = std::make_shared<int>(1);
+        {
+            cppcbb::cbb_pool<std::shared_ptr<int>, cppcbb::dynamic_pool_storage<std::shared_ptr<int>, small_pool_storage_params>> pool;
+            for (int i = 0; i < 20; i++)
+            {
+                pool.create(tracked);
+            }
+        }
+        REQUIRE(tracked.use_count() == 1);
+    }
+
+    SECTION("Static pool runs out & never allocates")
+    {
+        cppcbb::cbb_static_pool<int, 4> pool;
+        REQUIRE_THAT([&]()
+        {
+            for (int i = 0; i < 100; i++)
+            {
+                int* a = pool.create(i);
+                int* b = pool.create(i + 1);
+                pool.destroy(a);
+                pool.destroy(b);
+            }
+        }, AllocatesNothing());
+
+        for (int i = 0; i < 4; i++)
+        {
+            REQUIRE(pool.create(i) != nullptr);
+        }
+        REQUIRE(pool.create(4) == nullptr);
+        REQUIRE(pool.size() == 4);
+    }
+
+    SECTION("Shared pool with per thread caches")
+    {
+        cppcbb::cbb_shared_pool<cppcbb::cbb_pool<std::pair<size_t, size_t>, cppcbb::dynamic_pool_storage<std::pair<size_t, size_t>, small_pool_storage_params>>> shared;
+        std::atomic<size_t> failures(0);
+        GetTestPool().parallel_for(8, [&](size_t task)
+        {
+            cppcbb::pool_cache<decltype(shared)> cache(shared);
+            std::vector<std::pair<size_t, size_t>*> live;
+            for (size_t i = 0; i < 2000; i++)
+            {
+                if (i % 5 < 3)
+                {
+                    live.push_back(cache.create(task, i));
+                }
+                else if (!live.empty())
+                {
+                    failures += live.back()->first == task ? 0 : 1;
+                    cache.destroy(live.back());
+                    live.pop_back();
+                }
+            }
+            for (std::pair<size_t, size_t>* obj : live)
+            {
+                failures += obj->first == task ? 0 : 1;
+                cache.destroy(obj);
+            }
+            failures += cache.cached() <= 2 * cppcbb::default_pool_cache_params::batch_size ? 0 : 1;
+        });
+
+        REQUIRE(failures == 0);
+        REQUIRE(shared.occupancy().live == 0);
+        REQUIRE(shared.occupancy().peak > 0);
+    }
+}
+
+/*
+
+    SIMD kernels, compared against scalar loops
+
+*/
+
+template<typename Vector>
+void TestSimdKernels(Vector& v)
+{
+    using Elem = typename Vector::value_type;
+    std::mt19937 random(23);
+
+    for (size_t size = 0; size < 150; size += 1 + size / 8)
+    {
+        v.clear();
+        std::vector<Elem> expected;
+        for (size_t i = 0; i < size; i++)
+        {
+            Elem value = (Elem)(random() % 50);
+            v.push_back(value);
+            expected.push_back(value);
+        }
+
+        //Leaves stale values past the end, which the kernels must mask out
+        if (size > 3)
+        {
+            v.pop_back();
+            expected.pop_back();
+        }
+
+        REQUIRE(cppcbb::simd::sum(v) == std::accumulate(expected.begin(), expected.end(), Elem()));
+        REQUIRE(cppcbb::simd::count(v, (Elem)7) == (size_t)std::count(expected.begin(), expected.end(), (Elem)7));
+        REQUIRE(cppcbb::simd::find(v, (Elem)7) == (size_t)(std::find(expected.begin(), expected.end(), (Elem)7) - expected.begin()));
+        REQUIRE(cppcbb::simd::find(v, (Elem)99) == v.size());
+        if (!expected.empty())
+        {
+            REQUIRE(cppcbb::simd::min_value(v) == *std::min_element(expected.begin(), expected.end()));
+            REQUIRE(cppcbb::simd::max_value(v) == *std::max_element(expected.begin(), expected.end()));
+        }
+
+        cppcbb::simd::fill(v, (Elem)3);
+        REQUIRE(v.size() == expected.size());
+        REQUIRE(std::all_of(v.begin(), v.end(), [](Elem value) { return value == (Elem)3; }));
+    }
+}
+
+template<typename Vector>
+void TestAlignedStorage(Vector& v, size_t alignment)
+{
+    using Elem = typename Vector::value_type;
+    for (int i = 0; i < 300; i++)
+    {
+        v.push_back((Elem)i);
+        REQUIRE((uintptr_t)&v[0] % alignment == 0);
+    }
+    REQUIRE(v[299] == (Elem)299);
+    size_t lanes = cppcbb::simd::storage_lanes<typename Vector::storage_type, Elem>::value;
+    REQUIRE(lanes == alignment / sizeof(Elem));
+}
+
+class small_aligned_params
+{
+public:
+    static constexpr size_t alignment = 32;
+    static constexpr size_t initial_capacity = 1;
+    static constexpr float growth_rate = 1.5f;
+};
+
+TEST_CASE("CPPCBB SIMD", "[CPPCBB]")
+{
+    SECTION("Aligned Vector, float")
+    {
+        cppcbb::cbb_aligned_vector<float> v;
+        TestAlignedStorage(v, 64);
+        TestSimdKernels(v);
+    }
+
+    SECTION("Aligned Vector, int, 32 byte")
+    {
+        cppcbb::cbb_aligned_vector<int, small_aligned_params> v;
+        TestAlignedStorage(v, 32);
+        TestSimdKernels(v);
+    }
+
+    SECTION("Aligned Vector, uint8_t")
+    {
+        cppcbb::cbb_aligned_vector<uint8_t> v;
+        TestSimdKernels(v);
+    }
+
+    SECTION("Aligned Vector, double")
+    {
+        cppcbb::cbb_aligned_vector<double> v;
+        TestSimdKernels(v);
+    }
+
+    SECTION("Static Aligned Vector")
+    {
+        cppcbb::cbb_static_aligned_vector<int, 300> v;
+        TestAlignedStorage(v, 64);
+        TestSimdKernels(v);
+    }
+
+    SECTION("Static Aligned Vector, masked tail")
+    {
+        //Padding past Capacity fills out the last block, the kernels must ignore it
+        cppcbb::cbb_static_aligned_vector<int, 3> v;
+        v.push_back(-5);
+        v.push_back(-3);
+        v.push_back(-4);
+
+        const int* storage = &v[0];
+        for (size_t i = 3; i < 16; i++)
+        {
+            REQUIRE(storage[i] == 0);
+        }
+        REQUIRE(cppcbb::simd::max_value(v) == -3);
+        REQUIRE(cppcbb::simd::min_value(v) == -5);
+        REQUIRE(cppcbb::simd::sum(v) == -12);
+    }
+
+    SECTION("Vector, scalar kernels")
+    {
+        cppcbb::cbb_vector<int> v;
+        size_t lanes = cppcbb::simd::storage_lanes<cppcbb::cbb_vector<int>::storage_type, int>::value;
+        REQUIRE(lanes == 1);
+        TestSimdKernels(v);
+    }
+
+    SECTION("Gap Vector, two segments")
+    {
+        cppcbb::cbb_vector_impl<int, cppcbb::default_traits<int>, cppcbb::aligned_vec_storage<int>, cppcbb::gap_vec_management<int>> v;
+        for (int i = 0; i < 100; i++)
+        {
+            v.push_back(i % 10);
+        }
+        v.insert(v.begin() + 37, 42);
+        v.insert(v.begin() + 38, 7);
+
+        REQUIRE(cppcbb::simd::find(v, 42) == 37);
+        REQUIRE(cppcbb::simd::find(v, 7) == 7);
+        REQUIRE(cppcbb::simd::count(v, 7) == 11);
+        REQUIRE(cppcbb::simd::sum(v) == 450 + 42 + 7);
+        REQUIRE(cppcbb::simd::max_value(v) == 42);
+
+        v.erase(v.begin() + 7);
+        REQUIRE(cppcbb::simd::find(v, 7) == 16);
+
+        cppcbb::simd::fill(v, 1);
+        REQUIRE(cppcbb::simd::sum(v) == (int)v.size());
+    }
+
+    SECTION("Tombstone Vector, live runs")
+    {
+        cppcbb::cbb_tombstone_vector<int> v;
+        for (int i = 0; i < 100; i++)
+        {
+            v.push_back(i);
+        }
+        v.erase(v.begin());
+        REQUIRE(cppcbb::simd::find(v, 50) == 49);
+        REQUIRE(cppcbb::simd::min_value(v) == 1);
+        REQUIRE(cppcbb::simd::sum(v) == 4950);
+    }
+}
+
+/*
+
+    B+ tree maps, compared against std::map
+
+*/
+
+//Smallest nodes, so a few hundred keys build a deep tree
+class small_btree_params
+{
+public:
+    static constexpr size_t node_bytes = 1;
+};
+
+template<typename Map>
+void RequireSameBTree(const Map& map, const std::map<int, int>& expected)
+{
+    REQUIRE(map.size() == expected.size());
+
+    auto it = map.begin();
+    for (const auto& entry : expected)
+    {
+        REQUIRE(it != map.end());
+        REQUIRE(it->first == entry.first);
+        REQUIRE(it->second == entry.second);
+        ++it;
+    }
+    REQUIRE(it == map.end());
+}
+
+template<typename Map>
+void TestBTreeMap(Map& map)
+{
+    std::map<int, int> expected;
+
+    SECTION("Random Insertions and Deletions match std::map")
+    {
+        std::uniform_int_distribution<int> key_dist(0, k_test_max_size * 2);
+        for (int i = 0; i < k_test_max_size * 20; i++)
+        {
+            int key = key_dist(GetRandom());
+            if (i % 3 == 2 && map.find(key) != map.end())
+            {
+                map.erase(map.find(key));
+                expected.erase(key);
+            }
+            else
+            {
+                map[key] = i;
+                expected[key] = i;
+            }
+        }
+        RequireSameBTree(map, expected);
+
+        //Drain in random order, so leaves & branches merge all the way back to an empty root
+        std::vector<int> keys;
+        for (const auto& entry : expected)
+        {
+            keys.push_back(entry.first);
+        }
+        std::shuffle(keys.begin(), keys.end(), GetRandom());
+        for (size_t i = 0; i < keys.size(); i++)
+        {
+            map.erase(map.find(keys[i]));
+            expected.erase(keys[i]);
+            if (i % 50 == 0)
+            {
+                RequireSameBTree(map, expected);
+            }
+        }
+        RequireSameBTree(map, expected);
+        REQUIRE(map.begin() == map.end());
+    }
+
+    SECTION("Ascending & descending insertions")
+    {
+        for (int i = 0; i < k_test_max_size; i++)
+        {
+            map[i] = i;
+            map[-i - 1] = i;
+            expected[i] = i;
+            expected[-i - 1] = i;
+        }
+        RequireSameBTree(map, expected);
+
+        //Erase from the front, so every leaf borrows from or merges with its right sibling
+        while (!expected.empty())
+        {
+            REQUIRE(map.begin()->first == expected.begin()->first);
+            map.erase(map.begin());
+            expected.erase(expected.begin());
+        }
+        REQUIRE(map.size() == 0);
+    }
+
+    SECTION("Bulk build from sorted entries")
+    {
+        auto& elements = map.bulk_elements(k_test_max_size);
+        for (int i = 0; i < k_test_max_size; i++)
+        {
+            elements[i] = std::make_pair(i * 3, i);
+            expected[i * 3] = i;
+        }
+        map.bulk_commit();
+        RequireSameBTree(map, expected);
+        REQUIRE(map.find(3 * 100)->second == 100);
+        REQUIRE(map.find(3 * 100 + 1) == map.end());
+
+        //The tree keeps working after a bulk build
+        for (int i = 0; i < k_test_max_size; i++)
+        {
+            map[i * 3 + 1] = -i;
+            expected[i * 3 + 1] = -i;
+            map.erase(map.find(i * 3));
+            expected.erase(i * 3);
+        }
+        RequireSameBTree(map, expected);
+    }
+
+    SECTION("Copy & move")
+    {
+        for (int i = 0; i < k_test_max_size; i++)
+        {
+            map[i * 7 % k_test_max_size] = i;
+            expected[i * 7 % k_test_max_size] = i;
+        }
+
+        Map copy = map;
+        copy[k_test_max_size] = 0;
+        RequireSameBTree(map, expected);
+
+        Map moved = std::move(copy);
+        expected[k_test_max_size] = 0;
+        RequireSameBTree(moved, expected);
+
+        map = moved;
+        RequireSameBTree(map, expected);
+
+        map.clear();
+        RequireSameBTree(map, std::map<int, int>());
+        RequireSameBTree(moved, expected);
+    }
+}
+
+TEST_CASE("CPPCBB BTree Map", "[CPPCBB]")
+{
+    SECTION("Map interface")
+    {
+        cppcbb::cbb_btree_map<int, int> map;
+        TestMap(map);
+    }
+
+    SECTION("Map interface, Small Nodes")
+    {
+        cppcbb::cbb_btree_map<int, int, small_btree_params> map;
+        TestMap(map);
+    }
+
+    SECTION("Default Nodes")
+    {
+        cppcbb::cbb_btree_map<int, int> map;
+        TestBTreeMap(map);
+    }
+
+    SECTION("Small Nodes")
+    {
+        cppcbb::cbb_btree_map<int, int, small_btree_params> map;
+        TestBTreeMap(map);
+    }
+
+    SECTION("Node sizes fit the params")
+    {
+        size_t leaf_capacity = cppcbb::btree_pair_storage<int, int>::leaf_capacity;
+        size_t small_capacity = cppcbb::btree_pair_storage<int, int, small_btree_params>::branch_capacity;
+        REQUIRE(leaf_capacity == 256 / sizeof(std::pair<int, int>));
+        REQUIRE(small_capacity == 4);
+    }
+}
+
+/*
+
+    Range queries & joins on sorted maps, compared against std::map
+
+*/
+
+template<typename Map>
+void FillSorted(Map& map, std::map<int, int>& expected, int count, int stride, int offset)
+{
+    for (int i = 0; i < count; i++)
+    {
+        map[i * stride + offset] = i;
+        expected[i * stride + offset] = i;
+    }
+}
+
+template<typename Map>
+void TestSortedRanges(Map& map)
+{
+    std::map<int, int> expected;
+    FillSorted(map, expected, k_test_max_size / 2, 3, 0);
+
+    SECTION("Bounds")
+    {
+        for (int key = -2; key < k_test_max_size * 2; key++)
+        {
+            auto lower = map.lower_bound(key);
+            auto expected_lower = expected.lower_bound(key);
+            REQUIRE((lower == map.end()) == (expected_lower == expected.end()));
+            if (lower != map.end())
+            {
+                REQUIRE(lower->first == expected_lower->first);
+            }
+
+            auto upper = map.upper_bound(key);
+            auto expected_upper = expected.upper_bound(key);
+            REQUIRE((upper == map.end()) == (expected_upper == expected.end()));
+            if (upper != map.end())
+            {
+                REQUIRE(upper->first == expected_upper->first);
+            }
+
+            auto range = map.equal_range(key);
+            REQUIRE(range.first == lower);
+            REQUIRE(range.second == upper);
+            REQUIRE((range.first != range.second) == (expected.count(key) == 1));
+        }
+    }
+
+    SECTION("Range erase")
+    {
+        std::uniform_int_distribution<int> key_dist(-10, k_test_max_size * 2);
+        std::uniform_int_distribution<int> span_dist(0, 50);
+        while (!expected.empty())
+        {
+            int low = key_dist(GetRandom());
+            int high = low + span_dist(GetRandom());
+
+            map.erase(map.lower_bound(low), map.upper_bound(high));
+            expected.erase(expected.lower_bound(low), expected.upper_bound(high));
+            RequireSameBTree(map, expected);
+        }
+
+        //Whole map & empty ranges
+        FillSorted(map, expected, k_test_max_size / 2, 3, 0);
+        map.erase(map.find(3), map.find(3));
+        RequireSameBTree(map, expected);
+        map.erase(map.begin(), map.end());
+        REQUIRE(map.size() == 0);
+    }
+}
+
+template<typename Left, typename Right>
+void TestSortedJoins(Left& left, Right& right)
+{
+    std::map<int, int> expected_left;
+    std::map<int, int> expected_right;
+
+    SECTION("Overlapping")
+    {
+        FillSorted(left, expected_left, k_test_max_size / 2, 2, 0);
+        FillSorted(right, expected_right, k_test_max_size / 2, 3, 1);
+    }
+
+    SECTION("Small against large")
+    {
+        FillSorted(left, expected_left, k_test_max_size, 1, 0);
+        FillSorted(right, expected_right, 10, 47, 5);
+    }
+
+    SECTION("Large against small")
+    {
+        FillSorted(left, expected_left, 10, 47, 5);
+        FillSorted(right, expected_right, k_test_max_size, 1, 0);
+    }
+
+    SECTION("Disjoint")
+    {
+        FillSorted(left, expected_left, k_test_max_size / 2, 1, 0);
+        FillSorted(right, expected_right, k_test_max_size / 2, 1, k_test_max_size);
+    }
+
+    SECTION("Empty")
+    {
+        FillSorted(left, expected_left, k_test_max_size / 2, 1, 0);
+    }
+
+    std::vector<std::pair<int, std::pair<int, int>>> joined;
+    cppcbb::sorted::intersect_join(left, right, [&](int key, int left_value, int right_value)
+    {
+        joined.push_back(std::make_pair(key, std::make_pair(left_value, right_value)));
+    });
+
+    std::vector<std::pair<int, std::pair<int, int>>> expected_joined;
+    std::map<int, int> expected_merge = expected_right;
+    std::map<int, int> expected_difference;
+    for (const auto& entry : expected_left)
+    {
+        auto found = expected_right.find(entry.first);
+        if (found != expected_right.end())
+        {
+            expected_joined.push_back(std::make_pair(entry.first, std::make_pair(entry.second, found->second)));
+            expected_merge[entry.first] = entry.second - found->second;
+        }
+        else
+        {
+            expected_merge[entry.first] = entry.second;
+            expected_difference[entry.first] = entry.second;
+        }
+    }
+    REQUIRE(joined == expected_joined);
+
+    Left merged = cppcbb::sorted::merge(left, right, [](int left_value, int right_value) { return left_value - right_value; });
+    RequireSameBTree(merged, expected_merge);
+
+    Left difference = cppcbb::sorted::difference(left, right);
+    RequireSameBTree(difference, expected_difference);
+
+    //Keys from below the first to past the last, in steps that both skip & repeat entries
+    std::vector<int> keys;
+    for (int key = -5; key < k_test_max_size * 3; key += 1 + (key + 7) % 3)
+    {
+        keys.push_back(key);
+        keys.push_back(key);
+    }
+    std::vector<typename Left::const_iterator> results;
+    cppcbb::sorted::find_sorted(left, keys, results);
+    REQUIRE(results.size() == keys.size());
+    for (size_t i = 0; i < keys.size(); i++)
+    {
+        REQUIRE(results[i] == left.find(keys[i]));
+    }
+}
+
+TEST_CASE("CPPCBB Sorted Ranges", "[CPPCBB]")
+{
+    SECTION("Sorted Vector Map")
+    {
+        cppcbb::cbb_sorted_vector_map<int, int> map;
+        TestSortedRanges(map);
+    }
+
+    SECTION("Static Sorted Vector Map")
+    {
+        cppcbb::cbb_static_sorted_vector_map<int, int, k_test_max_size> map;
+        TestSortedRanges(map);
+    }
+
+    SECTION("BTree Map")
+    {
+        cppcbb::cbb_btree_map<int, int> map;
+        TestSortedRanges(map);
+    }
+
+    SECTION("BTree Map, Small Nodes")
+    {
+        cppcbb::cbb_btree_map<int, int, small_btree_params> map;
+        TestSortedRanges(map);
+    }
+}
+
+TEST_CASE("CPPCBB Sorted Joins", "[CPPCBB]")
+{
+    SECTION("Sorted Vector Maps")
+    {
+        cppcbb::cbb_sorted_vector_map<int, int> left;
+        cppcbb::cbb_sorted_vector_map<int, int> right;
+        TestSortedJoins(left, right);
+    }
+
+    SECTION("Static Sorted Vector Map & BTree Map")
+    {
+        cppcbb::cbb_static_sorted_vector_map<int, int, k_test_max_size * 2> left;
+        cppcbb::cbb_btree_map<int, int, small_btree_params> right;
+        TestSortedJoins(left, right);
+    }
+
+    SECTION("BTree Map & Sorted Vector Map")
+    {
+        cppcbb::cbb_btree_map<int, int, small_btree_params> left;
+        cppcbb::cbb_sorted_vector_map<int, int> right;
+        TestSortedJoins(left, right);
+    }
+
+    SECTION("Merge into a full static map")
+    {
+        cppcbb::cbb_static_sorted_vector_map<int, int, 4> left;
+        cppcbb::cbb_static_sorted_vector_map<int, int, 4> right;
+        for (int key = 0; key < 4; key++)
+        {
+            left[key * 2] = key;
+            right[key * 2 + 1] = key;
+        }
+
+        auto merged = cppcbb::sorted::merge(left, right);
+        REQUIRE(merged.size() == 0);
+    }
+}
+
+/*
+
+    Batched lookups, compared against find
+
+*/
+
+class find_many_stats_tag { public: static const char* name() { return "test find_many"; } };
+
+template<typename Map>
+void TestFindMany(Map& map)
+{
+    std::vector<int> keys;
+    std::vector<typename Map::const_iterator> results;
+
+    SECTION("Empty map")
+    {
+        keys.assign(k_test_max_size / 10, 7);
+        map.find_many(keys, results);
+        REQUIRE(results.size() == keys.size());
+        REQUIRE(std::all_of(results.begin(), results.end(), [&](typename Map::const_iterator it) { return it == map.end(); }));
+    }
+
+    SECTION("Hits & misses")
+    {
+        for (int i = 0; i < k_test_max_size; i++)
+        {
+            map[i * 2 + 1] = i;
+        }
+
+        //Every key & the gaps between them, shuffled, with a count that isn't a whole number of groups
+        for (int key = 0; key < k_test_max_size * 2 + 3; key++)
+        {
+            keys.push_back(key);
+        }
+        std::shuffle(keys.begin(), keys.end(), GetRandom());
+
+        map.find_many(keys, results);
+        REQUIRE(results.size() == keys.size());
+        for (size_t i = 0; i < keys.size(); i++)
+        {
+            REQUIRE(results[i] == map.find(keys[i]));
+        }
+
+        //Fewer keys than a group, results are resized down
+        keys.resize(3);
+        map.find_many(keys, results);
+        REQUIRE(results.size() == 3);
+        for (size_t i = 0; i < keys.size(); i++)
+        {
+            REQUIRE(results[i] == map.find(keys[i]));
+        }
+    }
+}
+
+TEST_CASE("CPPCBB Find Many", "[CPPCBB]")
+{
+    SECTION("Sorted Vector Map")
+    {
+        cppcbb::cbb_sorted_vector_map<int, int> map;
+        TestFindMany(map);
+    }
+
+    SECTION("Static Sorted Vector Map")
+    {
+        cppcbb::cbb_static_sorted_vector_map<int, int, k_test_max_size> map;
+        TestFindMany(map);
+    }
+
+    SECTION("Unordered Vector Map")
+    {
+        cppcbb::cbb_unordered_vector_map<int, int> map;
+        TestFindMany(map);
+    }
+
+    SECTION("Sparse Map")
+    {
+        cppcbb::cbb_sparse_map<int, int> map;
+        TestFindMany(map);
+    }
+
+    SECTION("Static Sparse Map")
+    {
+        cppcbb::cbb_static_sparse_map<int, int, k_test_max_size * 4, k_test_max_size> map;
+        TestFindMany(map);
+    }
+
+    SECTION("BTree Map")
+    {
+        cppcbb::cbb_btree_map<int, int> map;
+        TestFindMany(map);
+    }
+
+    SECTION("BTree Map, Small Nodes")
+    {
+        cppcbb::cbb_btree_map<int, int, small_btree_params> map;
+        TestFindMany(map);
+    }
+
+    SECTION("Stats count every key")
+    {
+        using Map = cppcbb::cbb_with_stats<cppcbb::cbb_sorted_vector_map<int, int>, cppcbb::counting_stats<find_many_stats_tag>>;
+        cppcbb::container_stats& stats = cppcbb::counting_stats<find_many_stats_tag>::stats();
+
+        Map map;
+        for (int i = 0; i < k_test_max_size; i++)
+        {
+            map[i] = i;
+        }
+        stats.reset();
+
+        std::vector<int> keys = { 1, -1, 2, k_test_max_size };
+        std::vector<Map::const_iterator> results;
+        map.find_many(keys, results);
+        REQUIRE(stats.finds.load() == 4);
+        REQUIRE(stats.hits.load() == 2);
+        REQUIRE(stats.misses.load() == 2);
+        REQUIRE(stats.probes.load() > 0);
+    }
+}
@@ -0,0 +1,101 @@
+// Copyright(C) 2020 Henry Bullingham
+// This file is subject to the license terms in the LICENSE file
+// found in the top - level directory of this distribution.
+
+#include "cppcbb_test_support.hpp"
+
+#include <cstdlib>
+#include <new>
+
+/*
+
+    Replacement global allocation functions, counting per thread
+    Every form forwards to malloc / free
+
+*/
+
+namespace
+{
+    thread_local cppcbb_test::allocation_counts t_counts;
+
+    void* counted_allocate(size_t size)
+    {
+        t_counts.allocations++;
+        t_counts.bytes += size;
+        return std::malloc(size > 0 ? size : 1);
+    }
+
+    void counted_free(void* ptr)
+    {
+        if (ptr != nullptr)
+        {
+            t_counts.deallocations++;
+            std::free(ptr);
+        }
+    }
+}
+
+namespace cppcbb_test
+{
+    allocation_counts thread_allocation_counts()
+    {
+        return t_counts;
+    }
+}
+
+void* operator new(size_t size)
+{
+    void* ptr = counted_allocate(size);
+    if (ptr == nullptr)
+    {
+        throw std::bad_alloc();
+    }
+    return ptr;
+}
+
+void* operator new[](size_t size)
+{
+    return operator new(size);
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept
+{
+    return counted_allocate(size);
+}
+
+void* operator new[](size_t size, const std::nothrow_t&) noexcept
+{
+    return counted_allocate(size);
+}
+
+void operator delete(void* ptr) noexcept
+{
+    counted_free(ptr);
+}
+
+void operator delete[](void* ptr) noexcept
+{
+    counted_free(ptr);
+}
+
+void operator delete(void* ptr, const std::nothrow_t&) noexcept
+{
+    counted_free(ptr);
+}
+
+void operator delete[](void* ptr, const std::nothrow_t&) noexcept
+{
+    counted_free(ptr);
+}
+
+#if defined(__cpp_sized_deallocation)
+void operator delete(void* ptr, size_t) noexcept
+{
+    counted_free(ptr);
+}
+
+void operator delete[](void* ptr, size_t) noexcept
+{
+    counted_free(ptr);
+}
+#endif
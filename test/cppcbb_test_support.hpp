@@ -0,0 +1,291 @@
+// Copyright(C) 2020 Henry Bullingham
+// This file is subject to the license terms in the LICENSE file
+// found in the top - level directory of this distribution.
+
+#pragma once
+
+#if !defined (CPPCBB_TEST_CPPCBB_TEST_SUPPORT_H)
+#define CPPCBB_TEST_CPPCBB_TEST_SUPPORT_H
+
+#include "catch_amalgamated.hpp"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <sstream>
+#include <string>
+#include <vector>
+
+/*
+
+    Test support: allocation tracking & latency histograms
+    Global operator new / delete are replaced in cppcbb_test_support.cpp, counting per thread
+
+*/
+
+namespace cppcbb_test
+{
+    /// <summary>
+    /// Allocation counters of the calling thread since it started
+    /// </summary>
+    class allocation_counts
+    {
+    public:
+        uint64_t allocations = 0;
+        uint64_t deallocations = 0;
+        uint64_t bytes = 0;
+    };
+
+    /// <summary>
+    /// Current counters of the calling thread
+    /// </summary>
+    allocation_counts thread_allocation_counts();
+
+    /// <summary>
+    /// Counts the allocations made by the calling thread while the scope is alive
+    /// </summary>
+    class allocation_scope;
+
+    /// <summary>
+    /// Log-linear latency histogram, in the style of HdrHistogram
+    /// Values below 128 are exact, larger values are kept to 7 significant bits (under 1.6% error)
+    /// </summary>
+    class latency_histogram;
+
+    /// <summary>
+    /// Times each call to func and records it in nanoseconds
+    /// </summary>
+    template<typename Func>
+    void record_latency(latency_histogram& histogram, size_t iterations, Func func);
+
+    /// <summary>
+    /// Matches a block that makes no allocations, e.g. REQUIRE_THAT([&] { v.push_back(1); }, AllocatesNothing())
+    /// </summary>
+    class allocates_nothing_matcher;
+    inline allocates_nothing_matcher AllocatesNothing();
+
+    /// <summary>
+    /// Matches a histogram whose percentile is below a bound, e.g. REQUIRE_THAT(histogram, PercentileBelow(99.9, 1000))
+    /// </summary>
+    class percentile_below_matcher;
+    inline percentile_below_matcher PercentileBelow(double percentile, uint64_t max_ns);
+
+#if defined(CATCH_VERSION_MAJOR) && CATCH_VERSION_MAJOR >= 3
+    template<typename T>
+    using matcher_base = Catch::Matchers::MatcherBase<T>;
+#else
+    template<typename T>
+    using matcher_base = Catch::MatcherBase<T>;
+#endif
+}
+
+/*
+
+    Implementation details
+
+*/
+
+/// <summary>
+/// Allocation Scope
+/// </summary>
+namespace cppcbb_test
+{
+    class allocation_scope
+    {
+    private:
+        allocation_counts m_start;
+
+    public:
+        allocation_scope() : m_start(thread_allocation_counts()) {}
+
+        uint64_t allocations() const { return thread_allocation_counts().allocations - m_start.allocations; }
+        uint64_t deallocations() const { return thread_allocation_counts().deallocations - m_start.deallocations; }
+        uint64_t bytes() const { return thread_allocation_counts().bytes - m_start.bytes; }
+    };
+}
+
+/// <summary>
+/// Latency Histogram
+/// </summary>
+namespace cppcbb_test
+{
+    class latency_histogram
+    {
+    private:
+        static constexpr unsigned k_exact_bits = 7;
+        static constexpr uint64_t k_exact_count = (uint64_t)1 << k_exact_bits;
+        static constexpr uint64_t k_sub_bucket_count = k_exact_count / 2;
+        static constexpr size_t k_bucket_count = k_exact_count + (64 - k_exact_bits) * k_sub_bucket_count;
+
+        std::vector<uint64_t> m_counts;
+        uint64_t m_total = 0;
+        uint64_t m_min = UINT64_MAX;
+        uint64_t m_max = 0;
+        double m_sum = 0.0;
+
+        static unsigned highest_bit(uint64_t value)
+        {
+            unsigned bit = 0;
+            while (value >>= 1)
+            {
+                bit++;
+            }
+            return bit;
+        }
+
+        static size_t index_of(uint64_t value)
+        {
+            if (value < k_exact_count)
+            {
+                return (size_t)value;
+            }
+            //Keep the top k_exact_bits - 1 bits below the leading one
+            unsigned shift = highest_bit(value) - (k_exact_bits - 1);
+            return (size_t)(k_exact_count + (shift - 1) * k_sub_bucket_count + ((value >> shift) - k_sub_bucket_count));
+        }
+
+        //Largest value that lands in the bucket
+        static uint64_t highest_value_of(size_t idx)
+        {
+            if (idx < k_exact_count)
+            {
+                return idx;
+            }
+            unsigned shift = (unsigned)((idx - k_exact_count) / k_sub_bucket_count) + 1;
+            uint64_t sub_bucket = (idx - k_exact_count) % k_sub_bucket_count + k_sub_bucket_count;
+            return ((sub_bucket + 1) << shift) - 1;
+        }
+
+    public:
+        latency_histogram() : m_counts(k_bucket_count, 0) {}
+
+        void record(uint64_t value_ns)
+        {
+            m_counts[index_of(value_ns)]++;
+            m_total++;
+            m_sum += (double)value_ns;
+            if (value_ns < m_min) { m_min = value_ns; }
+            if (value_ns > m_max) { m_max = value_ns; }
+        }
+
+        uint64_t count() const { return m_total; }
+        uint64_t min() const { return m_total > 0 ? m_min : 0; }
+        uint64_t max() const { return m_max; }
+        double mean() const { return m_total > 0 ? m_sum / m_total : 0.0; }
+
+        //Smallest recorded value at or above the given percentile (0 - 100), to bucket precision
+        uint64_t value_at_percentile(double percentile) const
+        {
+            if (m_total == 0)
+            {
+                return 0;
+            }
+
+            uint64_t rank = (uint64_t)(percentile / 100.0 * m_total + 0.5);
+            if (rank < 1) { rank = 1; }
+            if (rank > m_total) { rank = m_total; }
+
+            uint64_t seen = 0;
+            for (size_t i = 0; i < m_counts.size(); i++)
+            {
+                seen += m_counts[i];
+                if (seen >= rank)
+                {
+                    uint64_t value = highest_value_of(i);
+                    return value < m_max ? value : m_max;
+                }
+            }
+            return m_max;
+        }
+
+        void reset()
+        {
+            std::fill(m_counts.begin(), m_counts.end(), 0);
+            m_total = 0;
+            m_min = UINT64_MAX;
+            m_max = 0;
+            m_sum = 0.0;
+        }
+    };
+
+    template<typename Func>
+    void record_latency(latency_histogram& histogram, size_t iterations, Func func)
+    {
+        using clock = std::chrono::steady_clock;
+        for (size_t i = 0; i < iterations; i++)
+        {
+            clock::time_point start = clock::now();
+            func();
+            clock::time_point end = clock::now();
+            histogram.record((uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count());
+        }
+    }
+}
+
+/// <summary>
+/// Matchers
+/// </summary>
+namespace cppcbb_test
+{
+    class allocates_nothing_matcher : public matcher_base<std::function<void()>>
+    {
+    private:
+        mutable uint64_t m_allocations = 0;
+
+    public:
+        bool match(const std::function<void()>& block) const override
+        {
+            allocation_scope scope;
+            block();
+            m_allocations = scope.allocations();
+            return m_allocations == 0;
+        }
+
+        std::string describe() const override
+        {
+            std::ostringstream description;
+            description << "allocates nothing (made " << m_allocations << " allocations)";
+            return description.str();
+        }
+    };
+
+    inline allocates_nothing_matcher AllocatesNothing()
+    {
+        return allocates_nothing_matcher();
+    }
+
+    class percentile_below_matcher : public matcher_base<latency_histogram>
+    {
+    private:
+        double m_percentile;
+        uint64_t m_max_ns;
+        mutable uint64_t m_value_ns = 0;
+
+    public:
+        percentile_below_matcher(double percentile, uint64_t max_ns)
+            : m_percentile(percentile)
+            , m_max_ns(max_ns)
+        {}
+
+        bool match(const latency_histogram& histogram) const override
+        {
+            m_value_ns = histogram.value_at_percentile(m_percentile);
+            return m_value_ns < m_max_ns;
+        }
+
+        std::string describe() const override
+        {
+            std::ostringstream description;
+            description << "has p" << m_percentile << " below " << m_max_ns << " ns (was " << m_value_ns << " ns)";
+            return description.str();
+        }
+    };
+
+    inline percentile_below_matcher PercentileBelow(double percentile, uint64_t max_ns)
+    {
+        return percentile_below_matcher(percentile, max_ns);
+    }
+}
+
+#endif //CPPCBB_TEST_CPPCBB_TEST_SUPPORT_H